@@ -0,0 +1,129 @@
+/* UART.c
+ *
+ * Hardware-independent half of the interrupt-driven UART0 driver:
+ * the receive and transmit ring buffers and the functions the program
+ * calls. The hardware half (UART_Init(), UART_StartTx() and the interrupt
+ * handler) is in low_level_funcs_tiva.c, so that all the register
+ * definitions stay in that module. On the host the same file is linked
+ * with host/uart_host.c instead.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "UART.h"
+#include "ring_buffer.h"
+#include <string.h>
+
+static unsigned char rx_storage[UART_RX_BUFFER_SIZE]; // Receive ring storage
+static unsigned char tx_storage[UART_TX_BUFFER_SIZE]; // Transmit ring storage
+static RingBuffer rx_ring;                            // Producer: interrupt. Consumer: program
+static RingBuffer tx_ring;                            // Producer: program. Consumer: interrupt
+static volatile unsigned long rx_hw_overruns;         // Hardware FIFO overruns reported by the interrupt
+
+// ------------------------ Program side ------------------------
+
+int UART_GetChar(unsigned char *data)
+{
+    return RingBufferGet(&rx_ring, data);
+} // UART_GetChar
+
+int UART_PutChar(unsigned char data)
+{
+    int queued = RingBufferPut(&tx_ring, data);
+
+    UART_StartTx(); // Make sure the interrupt is draining the ring
+    return queued;
+} // UART_PutChar
+
+int UART_Write(const unsigned char *data, int length)
+{
+    int space = RingBufferSpace(&tx_ring); // Can only grow while we work (the interrupt only removes)
+    int i;
+
+    if (length > space)
+    {
+        tx_ring.overruns += length - space; // Count the bytes we are about to drop
+        length = space;
+    }
+    for (i = 0; i < length; i++)
+    {
+        RingBufferPut(&tx_ring, data[i]);
+    }
+    UART_StartTx();
+    return length;
+} // UART_Write
+
+int UART_WriteString(const char *string)
+{
+    int length = strlen(string);
+
+    if (length > RingBufferSpace(&tx_ring)) // All or nothing, so a reply is never half-sent
+    {
+        tx_ring.overruns += length;
+        return 0;
+    }
+    UART_Write((const unsigned char *)string, length);
+    return 1;
+} // UART_WriteString
+
+unsigned char UART_InChar(void)
+{
+    unsigned char data;
+
+    while (!UART_GetChar(&data))
+    { // Wait for the interrupt to receive something
+    }
+    return data;
+} // UART_InChar
+
+void UART_OutChar(unsigned char data)
+{
+    while (RingBufferSpace(&tx_ring) == 0)
+    { // Wait for the interrupt to make room
+        UART_StartTx();
+    }
+    UART_PutChar(data);
+} // UART_OutChar
+
+int UART_RxCount(void)
+{
+    return RingBufferCount(&rx_ring);
+} // UART_RxCount
+
+int UART_TxSpace(void)
+{
+    return RingBufferSpace(&tx_ring);
+} // UART_TxSpace
+
+void UART_GetStats(UART_Stats *stats)
+{
+    stats->rx_overruns = rx_ring.overruns;
+    stats->rx_hw_overruns = rx_hw_overruns;
+    stats->tx_overruns = tx_ring.overruns;
+    stats->rx_high_water = rx_ring.high_water;
+    stats->tx_high_water = tx_ring.high_water;
+} // UART_GetStats
+
+// ------------------------ Interrupt side ------------------------
+
+void UART_InitBuffers(void)
+{
+    RingBufferInit(&rx_ring, rx_storage, UART_RX_BUFFER_SIZE);
+    RingBufferInit(&tx_ring, tx_storage, UART_TX_BUFFER_SIZE);
+    rx_hw_overruns = 0;
+} // UART_InitBuffers
+
+void UART_RxIsr(unsigned char data)
+{
+    RingBufferPut(&rx_ring, data); // If full the byte is lost and counted
+} // UART_RxIsr
+
+int UART_TxIsr(unsigned char *data)
+{
+    return RingBufferGet(&tx_ring, data);
+} // UART_TxIsr
+
+void UART_RxHwOverrun(void)
+{
+    rx_hw_overruns++;
+} // UART_RxHwOverrun
@@ -26,6 +26,15 @@
 // U0Rx (VCP receive) connected to PA0
 // U0Tx (VCP transmit) connected to PA1
 
+// Interrupt-driven version: UART_Init() and the UART0 interrupt handler are in
+// low_level_funcs_tiva.c, the software buffering is in UART.c.
+// Received bytes are moved from the hardware FIFO into a receive ring buffer by
+// the interrupt, and bytes to send are taken from a transmit ring buffer by it,
+// so the program only waits if it chooses to (UART_InChar, UART_OutChar).
+
+#ifndef UART_H
+#define UART_H
+
 // standard ASCII symbols
 #define CR   0x0D
 #define LF   0x0A
@@ -34,10 +43,11 @@
 #define SP   0x20
 #define DEL  0x7F
 
-//------------UART_InChar------------
-// Wait for new serial port input
+//------------UART_Init------------
 // Initialize the UART for 115,200 baud rate (assuming 80 MHz clock),
-// 8 bit word length, no parity bits, one stop bit, FIFOs enabled
+// 8 bit word length, no parity bits, one stop bit, FIFOs enabled,
+// receive and transmit interrupts armed
+// Must be called after InitDisplayPort(), which rewrites the Port A setup
 // Input: none
 // Output: none
 void UART_Init(void);
@@ -54,3 +64,82 @@ unsigned char UART_InChar(void);
 // Output: none
 void UART_OutChar(unsigned char data);
 
+// Ring buffer sizes (each must be a power of two).
+// 64 bytes of receive is 5.5 ms of continuous input at 115200 baud;
+// transmit is larger so a whole screen or reply line can be queued at once.
+#define UART_RX_BUFFER_SIZE 64
+#define UART_TX_BUFFER_SIZE 256
+
+//------------UART_GetChar------------
+// Get a received byte if there is one, without waiting
+// Input: pointer to where to store the byte
+// Output: 1 if a byte was read, 0 if none was waiting
+int UART_GetChar(unsigned char *data);
+
+//------------UART_PutChar------------
+// Queue a byte for sending, without waiting
+// Input: byte to send
+// Output: 1 if queued, 0 if the transmit buffer was full (byte dropped)
+int UART_PutChar(unsigned char data);
+
+//------------UART_Write------------
+// Queue as many bytes as there is room for, without waiting
+// Input: bytes to send and how many
+// Output: number actually queued (the rest are not sent)
+int UART_Write(const unsigned char *data, int length);
+
+//------------UART_WriteString------------
+// Queue a C-format string (without its null) all or nothing, without waiting
+// Input: string to send
+// Output: 1 if queued, 0 if there was not room for all of it
+int UART_WriteString(const char *string);
+
+//------------UART_RxCount------------
+// Output: number of received bytes waiting to be read
+int UART_RxCount(void);
+
+//------------UART_TxSpace------------
+// Output: number of bytes which UART_Write() could queue now
+int UART_TxSpace(void);
+
+// Counters for tuning the buffer sizes. Read with UART_GetStats().
+typedef struct
+{
+    unsigned long rx_overruns;     // Received bytes lost because the receive ring was full
+    unsigned long rx_hw_overruns;  // Received bytes lost because the hardware FIFO overflowed
+    unsigned long tx_overruns;     // Bytes refused because the transmit ring was full
+    unsigned short rx_high_water;  // Deepest the receive ring has been
+    unsigned short tx_high_water;  // Deepest the transmit ring has been
+} UART_Stats;
+
+//------------UART_GetStats------------
+// Copy the buffer counters
+// Input: pointer to where to store them
+void UART_GetStats(UART_Stats *stats);
+
+// ---- Interface between UART.c and the interrupt handler ----
+// These are called by the hardware-specific code, not by the program.
+
+//------------UART_InitBuffers------------
+// Empty both ring buffers and clear the counters. Called by UART_Init().
+void UART_InitBuffers(void);
+
+//------------UART_RxIsr------------
+// Called from the interrupt handler with each byte taken from the receive FIFO
+void UART_RxIsr(unsigned char data);
+
+//------------UART_TxIsr------------
+// Called from the interrupt handler for the next byte to put in the transmit FIFO
+// Output: 1 and the byte, or 0 if there is nothing more to send
+int UART_TxIsr(unsigned char *data);
+
+//------------UART_RxHwOverrun------------
+// Called from the interrupt handler when the hardware reports an overrun
+void UART_RxHwOverrun(void);
+
+//------------UART_StartTx------------
+// Provided by the hardware-specific code: start (or keep going) sending
+// from the transmit ring buffer. Called by UART.c whenever bytes are queued.
+void UART_StartTx(void);
+
+#endif // of #ifndef UART_H
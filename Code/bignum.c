@@ -0,0 +1,790 @@
+/* bignum.c
+ *
+ * Arbitrary-precision integers: 32-bit limbs in a static arena, Karatsuba
+ * multiplication, Knuth's long division and base 10^9 decimal conversion.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "bignum.h"
+#include <string.h>
+
+#define CHUNK 1000000000UL // 10^9: nine decimal digits, the most that fit in a limb
+#define CHUNK_DIGITS 9
+
+const char *big_error_line1[] = {"", "Syntax error    ", "Division by zero", "Out of memory   ",
+                                 "Too many digits ", "Factorial range "};
+const char *big_error_line2[] = {"", "Press any key   ", "Press any key   ", "Press any key   ",
+                                 "Press any key   ", "0 to 1000 only  "};
+
+static uint32_t arena[BIG_ARENA_LIMBS];
+static int arena_used;       // Limbs allocated
+static int arena_high_water; // Most limbs ever allocated at once
+static int karatsuba_threshold = BIG_KARATSUBA_THRESHOLD;
+
+// ----------------------------- Arena ------------------------------
+
+int BigArenaMark(void)
+{
+    return arena_used;
+} // BigArenaMark
+
+void BigArenaRelease(int mark)
+{
+    arena_used = mark;
+} // BigArenaRelease
+
+int BigArenaHighWater(void)
+{
+    return arena_high_water;
+} // BigArenaHighWater
+
+// Returns 0 if the arena is full
+static uint32_t *Allocate(int limbs)
+{
+    uint32_t *block;
+
+    if (limbs < 1)
+    {
+        limbs = 1; // So that even zero has somewhere to point
+    }
+    if (arena_used + limbs > BIG_ARENA_LIMBS)
+    {
+        return 0;
+    }
+    block = &arena[arena_used];
+    arena_used += limbs;
+    if (arena_used > arena_high_water)
+    {
+        arena_high_water = arena_used;
+    }
+    return block;
+} // Allocate
+
+// Give back the end of block, the last one allocated, keeping its first
+// used limbs: only the top of the stack can shrink
+static void Shrink(const uint32_t *block, int used)
+{
+    if (used < 1)
+    {
+        used = 1;
+    }
+    arena_used = (int)(block - arena) + used;
+} // Shrink
+
+// ---------------------- Magnitude arithmetic ----------------------
+// These work on limb arrays and lengths; leading zero limbs are allowed.
+
+static int Trim(const uint32_t *limbs, int length)
+{
+    while (length > 0 && limbs[length - 1] == 0)
+    {
+        length--;
+    }
+    return length;
+} // Trim
+
+static int CompareMagnitude(const uint32_t *a, int a_length, const uint32_t *b, int b_length)
+{
+    int i;
+
+    a_length = Trim(a, a_length);
+    b_length = Trim(b, b_length);
+    if (a_length != b_length)
+    {
+        return a_length > b_length ? 1 : -1;
+    }
+    for (i = a_length - 1; i >= 0; i--)
+    {
+        if (a[i] != b[i])
+        {
+            return a[i] > b[i] ? 1 : -1;
+        }
+    }
+    return 0;
+} // CompareMagnitude
+
+// result = a + b, which needs max(a_length, b_length) + 1 limbs.
+// Returns the length. result may be a.
+static int AddMagnitude(const uint32_t *a, int a_length, const uint32_t *b, int b_length, uint32_t *result)
+{
+    uint64_t sum = 0;
+    int i;
+
+    if (a_length < b_length)
+    {
+        const uint32_t *swap = a;
+        a = b;
+        b = swap;
+        i = a_length;
+        a_length = b_length;
+        b_length = i;
+    }
+    for (i = 0; i < a_length; i++)
+    {
+        sum += a[i];
+        if (i < b_length)
+        {
+            sum += b[i];
+        }
+        result[i] = (uint32_t)sum;
+        sum >>= 32;
+    }
+    result[a_length] = (uint32_t)sum;
+    return Trim(result, a_length + 1);
+} // AddMagnitude
+
+// result = a - b, where a >= b. Returns the length. result may be a.
+static int SubtractMagnitude(const uint32_t *a, int a_length, const uint32_t *b, int b_length, uint32_t *result)
+{
+    int64_t difference = 0;
+    int i;
+
+    for (i = 0; i < a_length; i++)
+    {
+        difference += a[i];
+        if (i < b_length)
+        {
+            difference -= b[i];
+        }
+        result[i] = (uint32_t)difference;
+        difference >>= 32; // 0 or -1 (the borrow)
+    }
+    return Trim(result, a_length);
+} // SubtractMagnitude
+
+// total[0..total_length) += part[0..part_length). The sum must fit.
+static void AddInto(uint32_t *total, int total_length, const uint32_t *part, int part_length)
+{
+    uint64_t sum = 0;
+    int i;
+
+    for (i = 0; i < total_length && (i < part_length || sum != 0); i++)
+    {
+        sum += total[i];
+        if (i < part_length)
+        {
+            sum += part[i];
+        }
+        total[i] = (uint32_t)sum;
+        sum >>= 32;
+    }
+} // AddInto
+
+// total[0..total_length) -= part[0..part_length). The result must not be negative.
+static void SubtractInto(uint32_t *total, int total_length, const uint32_t *part, int part_length)
+{
+    int64_t difference = 0;
+    int i;
+
+    for (i = 0; i < total_length && (i < part_length || difference != 0); i++)
+    {
+        difference += total[i];
+        if (i < part_length)
+        {
+            difference -= part[i];
+        }
+        total[i] = (uint32_t)difference;
+        difference >>= 32;
+    }
+} // SubtractInto
+
+// result[0..a_length + b_length) = a x b, by the schoolbook method.
+// result must not overlap a or b.
+static void MultiplySchoolbook(const uint32_t *a, int a_length, const uint32_t *b, int b_length, uint32_t *result)
+{
+    uint64_t product;
+    int i;
+    int j;
+
+    memset(result, 0, (a_length + b_length) * sizeof(uint32_t));
+    for (i = 0; i < a_length; i++)
+    {
+        product = 0;
+        for (j = 0; j < b_length; j++)
+        {
+            product = (uint64_t)a[i] * b[j] + result[i + j] + (product >> 32);
+            result[i + j] = (uint32_t)product;
+        }
+        result[i + b_length] = (uint32_t)(product >> 32);
+    }
+} // MultiplySchoolbook
+
+// result[0..a_length + b_length) = a x b, by Karatsuba's method when both
+// are long enough. result must not overlap a or b. Working space comes
+// from the arena and is freed again before returning.
+static int MultiplyMagnitude(const uint32_t *a, int a_length, const uint32_t *b, int b_length, uint32_t *result)
+{
+    const uint32_t *swap;
+    uint32_t *piece;
+    uint32_t *sum_a;
+    uint32_t *sum_b;
+    uint32_t *middle;
+    int sum_a_length;
+    int sum_b_length;
+    int middle_length;
+    int half;
+    int mark = BigArenaMark();
+    int error = BIG_OK;
+    int i;
+
+    if (a_length < b_length) // So that a is the longer
+    {
+        swap = a;
+        a = b;
+        b = swap;
+        i = a_length;
+        a_length = b_length;
+        b_length = i;
+    }
+    if (b_length < karatsuba_threshold)
+    {
+        MultiplySchoolbook(a, a_length, b, b_length, result);
+        return BIG_OK;
+    }
+
+    if (2 * b_length <= a_length)
+    {
+        // Very different lengths: split a into pieces as long as b and
+        // multiply each by b, so that each product is balanced
+        piece = Allocate(2 * b_length);
+        if (piece == 0)
+        {
+            return BIG_ERR_MEMORY;
+        }
+        memset(result, 0, (a_length + b_length) * sizeof(uint32_t));
+        for (i = 0; i < a_length && error == BIG_OK; i += b_length)
+        {
+            half = (a_length - i < b_length) ? a_length - i : b_length; // Length of this piece
+            error = MultiplyMagnitude(a + i, half, b, b_length, piece);
+            AddInto(result + i, a_length + b_length - i, piece, half + b_length);
+        }
+        BigArenaRelease(mark);
+        return error;
+    }
+
+    // a = a1 x B^half + a0 and b = b1 x B^half + b0, where B = 2^32. Then
+    // a x b = z2 x B^(2 half) + z1 x B^half + z0, where z0 = a0 x b0,
+    // z2 = a1 x b1 and z1 = (a0 + a1)(b0 + b1) - z0 - z2.
+    half = a_length / 2; // b is longer than half, so b1 is not empty
+    sum_a = Allocate(a_length - half + 1);
+    sum_b = Allocate(b_length + 1);
+    if (sum_a == 0 || sum_b == 0)
+    {
+        BigArenaRelease(mark);
+        return BIG_ERR_MEMORY;
+    }
+    sum_a_length = AddMagnitude(a, half, a + half, a_length - half, sum_a);
+    sum_b_length = AddMagnitude(b, half, b + half, b_length - half, sum_b);
+    middle_length = sum_a_length + sum_b_length;
+    middle = Allocate(middle_length);
+    if (middle == 0)
+    {
+        BigArenaRelease(mark);
+        return BIG_ERR_MEMORY;
+    }
+
+    error = MultiplyMagnitude(a, half, b, half, result); // z0, in the bottom of result
+    if (error == BIG_OK)
+    {
+        error = MultiplyMagnitude(a + half, a_length - half, b + half, b_length - half, result + 2 * half); // z2, above it
+    }
+    if (error == BIG_OK)
+    {
+        error = MultiplyMagnitude(sum_a, sum_a_length, sum_b, sum_b_length, middle);
+    }
+    if (error == BIG_OK)
+    {
+        SubtractInto(middle, middle_length, result, 2 * half);
+        SubtractInto(middle, middle_length, result + 2 * half, a_length + b_length - 2 * half);
+        AddInto(result + half, a_length + b_length - half, middle, Trim(middle, middle_length));
+    }
+    BigArenaRelease(mark);
+    return error;
+} // MultiplyMagnitude
+
+// number = number x factor + addend, in place. number must have room for
+// one more limb; returns the new length.
+static int MultiplyAddSmall(uint32_t *number, int length, uint32_t factor, uint32_t addend)
+{
+    uint64_t product = addend;
+    int i;
+
+    for (i = 0; i < length; i++)
+    {
+        product += (uint64_t)number[i] * factor;
+        number[i] = (uint32_t)product;
+        product >>= 32;
+    }
+    if (product != 0)
+    {
+        number[length++] = (uint32_t)product;
+    }
+    return length;
+} // MultiplyAddSmall
+
+// number = number / divisor, in place. Returns the remainder.
+static uint32_t DivideSmall(uint32_t *number, int length, uint32_t divisor)
+{
+    uint64_t remainder = 0;
+    int i;
+
+    for (i = length - 1; i >= 0; i--)
+    {
+        remainder = (remainder << 32) | number[i];
+        number[i] = (uint32_t)(remainder / divisor);
+        remainder %= divisor;
+    }
+    return (uint32_t)remainder;
+} // DivideSmall
+
+static int LeadingZeros(uint32_t x)
+{
+    int count = 0;
+
+    while ((x & 0x80000000UL) == 0)
+    {
+        x <<= 1;
+        count++;
+    }
+    return count;
+} // LeadingZeros
+
+// Knuth's algorithm D (The Art of Computer Programming, vol. 2, 4.3.1):
+// quotient[0..u_length - v_length] and remainder[0..v_length) of u / v,
+// where v has at least two limbs and u is at least as long.
+static int DivideMagnitude(const uint32_t *u, int u_length, const uint32_t *v, int v_length,
+                           uint32_t *quotient, uint32_t *remainder)
+{
+    uint32_t *un; // u and v shifted left so that the top bit of v is set
+    uint32_t *vn;
+    uint64_t estimate;
+    uint64_t estimate_remainder;
+    uint64_t product;
+    int64_t difference;
+    int64_t borrow;
+    int shift = LeadingZeros(v[v_length - 1]);
+    int mark = BigArenaMark();
+    int i;
+    int j;
+
+    un = Allocate(u_length + 1);
+    vn = Allocate(v_length);
+    if (un == 0 || vn == 0)
+    {
+        BigArenaRelease(mark);
+        return BIG_ERR_MEMORY;
+    }
+    for (i = v_length - 1; i > 0; i--)
+    {
+        vn[i] = (v[i] << shift) | (shift ? v[i - 1] >> (32 - shift) : 0);
+    }
+    vn[0] = v[0] << shift;
+    un[u_length] = shift ? u[u_length - 1] >> (32 - shift) : 0;
+    for (i = u_length - 1; i > 0; i--)
+    {
+        un[i] = (u[i] << shift) | (shift ? u[i - 1] >> (32 - shift) : 0);
+    }
+    un[0] = u[0] << shift;
+
+    for (j = u_length - v_length; j >= 0; j--)
+    {
+        // Estimate the quotient limb from the top two limbs, then correct
+        // it; it is then at most one too large
+        estimate = (((uint64_t)un[j + v_length] << 32) | un[j + v_length - 1]) / vn[v_length - 1];
+        estimate_remainder = (((uint64_t)un[j + v_length] << 32) | un[j + v_length - 1]) - estimate * vn[v_length - 1];
+        while (estimate >> 32 != 0 ||
+               estimate * vn[v_length - 2] > ((estimate_remainder << 32) | un[j + v_length - 2]))
+        {
+            estimate--;
+            estimate_remainder += vn[v_length - 1];
+            if (estimate_remainder >> 32 != 0)
+            {
+                break;
+            }
+        }
+
+        // Subtract estimate x vn from the top of un
+        borrow = 0;
+        for (i = 0; i < v_length; i++)
+        {
+            product = estimate * vn[i];
+            difference = (int64_t)un[i + j] - borrow - (int64_t)(product & 0xFFFFFFFFUL);
+            un[i + j] = (uint32_t)difference;
+            borrow = (int64_t)(product >> 32) - (difference >> 32);
+        }
+        difference = (int64_t)un[j + v_length] - borrow;
+        un[j + v_length] = (uint32_t)difference;
+
+        if (difference < 0) // The estimate was one too large: add vn back
+        {
+            estimate--;
+            AddInto(un + j, v_length + 1, vn, v_length); // Carries out of the top, which is wanted
+        }
+        quotient[j] = (uint32_t)estimate;
+    }
+
+    for (i = 0; i < v_length; i++) // Shift the remainder back
+    {
+        remainder[i] = (un[i] >> shift) | (shift ? un[i + 1] << (32 - shift) : 0);
+    }
+    BigArenaRelease(mark);
+    return BIG_OK;
+} // DivideMagnitude
+
+// ------------------------ Signed arithmetic -----------------------
+
+static int Make(BigNum *number, int limbs)
+{
+    number->limbs = Allocate(limbs);
+    number->length = 0;
+    number->negative = 0;
+    return number->limbs != 0 ? BIG_OK : BIG_ERR_MEMORY;
+} // Make
+
+static void Finish(BigNum *number, int length, int negative)
+{
+    number->length = Trim(number->limbs, length);
+    number->negative = (number->length != 0) && negative; // No negative zero
+} // Finish
+
+int BigFromDecimal(const char *digits, int count, BigNum *result)
+{
+    static const uint32_t powers_of_ten[CHUNK_DIGITS + 1] = {1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL,
+                                                            1000000UL, 10000000UL, 100000000UL, CHUNK};
+    uint32_t chunk;
+    int length = 0;
+    int take;
+    int i;
+
+    if (Make(result, count / CHUNK_DIGITS + 1) != BIG_OK)
+    {
+        return BIG_ERR_MEMORY;
+    }
+    while (count > 0)
+    {
+        // The first chunk takes the odd digits, the rest nine each
+        take = count % CHUNK_DIGITS ? count % CHUNK_DIGITS : CHUNK_DIGITS;
+        chunk = 0;
+        for (i = 0; i < take; i++)
+        {
+            chunk = chunk * 10 + (*digits++ - '0');
+        }
+        length = MultiplyAddSmall(result->limbs, length, powers_of_ten[take], chunk);
+        count -= take;
+    }
+    Finish(result, length, 0);
+    return BIG_OK;
+} // BigFromDecimal
+
+int BigToDecimal(const BigNum *number, char *text, int text_size)
+{
+    uint32_t *copy;
+    uint32_t chunk;
+    char *end = text + text_size - 1; // Digits are written backwards from here
+    char *start;
+    int length = number->length;
+    int mark = BigArenaMark();
+    int i;
+
+    copy = Allocate(length);
+    if (copy == 0)
+    {
+        return BIG_ERR_MEMORY;
+    }
+    memcpy(copy, number->limbs, length * sizeof(uint32_t));
+
+    *end = '\0';
+    start = end;
+    do
+    {
+        chunk = DivideSmall(copy, length, CHUNK); // Nine digits per pass over the limbs
+        length = Trim(copy, length);
+        for (i = 0; i < CHUNK_DIGITS && (length > 0 || chunk != 0 || start == end); i++)
+        {
+            if (start == text + number->negative) // No room for the digit (and sign)
+            {
+                BigArenaRelease(mark);
+                return BIG_ERR_TOO_LONG;
+            }
+            *--start = '0' + chunk % 10;
+            chunk /= 10;
+        }
+    } while (length > 0);
+    BigArenaRelease(mark);
+
+    if (number->negative)
+    {
+        *--start = '-';
+    }
+    memmove(text, start, end - start + 1);
+    return BIG_OK;
+} // BigToDecimal
+
+int BigAdd(const BigNum *a, const BigNum *b, BigNum *result)
+{
+    int length = (a->length > b->length ? a->length : b->length) + 1;
+
+    if (Make(result, length) != BIG_OK)
+    {
+        return BIG_ERR_MEMORY;
+    }
+    if (a->negative == b->negative)
+    {
+        Finish(result, AddMagnitude(a->limbs, a->length, b->limbs, b->length, result->limbs), a->negative);
+    }
+    else if (CompareMagnitude(a->limbs, a->length, b->limbs, b->length) >= 0)
+    {
+        Finish(result, SubtractMagnitude(a->limbs, a->length, b->limbs, b->length, result->limbs), a->negative);
+    }
+    else
+    {
+        Finish(result, SubtractMagnitude(b->limbs, b->length, a->limbs, a->length, result->limbs), b->negative);
+    }
+    return BIG_OK;
+} // BigAdd
+
+int BigSubtract(const BigNum *a, const BigNum *b, BigNum *result)
+{
+    BigNum minus_b = *b;
+
+    minus_b.negative = (b->length != 0) && !b->negative;
+    return BigAdd(a, &minus_b, result);
+} // BigSubtract
+
+int BigMultiply(const BigNum *a, const BigNum *b, BigNum *result)
+{
+    int error;
+
+    if (Make(result, a->length + b->length) != BIG_OK)
+    {
+        return BIG_ERR_MEMORY;
+    }
+    if (a->length == 0 || b->length == 0)
+    {
+        Finish(result, 0, 0);
+        return BIG_OK;
+    }
+    error = MultiplyMagnitude(a->limbs, a->length, b->limbs, b->length, result->limbs);
+    Finish(result, a->length + b->length, a->negative != b->negative);
+    return error;
+} // BigMultiply
+
+int BigDivide(const BigNum *a, const BigNum *b, BigNum *quotient, BigNum *remainder)
+{
+    BigNum q;
+    BigNum r;
+    int error = BIG_OK;
+
+    if (b->length == 0)
+    {
+        return BIG_ERR_DIV_ZERO;
+    }
+    // The quotient has at most a->length - b->length + 1 limbs
+    if (Make(&q, (a->length > b->length) ? a->length - b->length + 1 : 1) != BIG_OK ||
+        Make(&r, b->length) != BIG_OK)
+    {
+        return BIG_ERR_MEMORY;
+    }
+    if (CompareMagnitude(a->limbs, a->length, b->limbs, b->length) < 0)
+    {
+        memcpy(r.limbs, a->limbs, a->length * sizeof(uint32_t)); // Quotient 0, remainder a
+        Finish(&q, 0, 0);
+        Finish(&r, a->length, a->negative);
+    }
+    else if (b->length == 1)
+    {
+        memcpy(q.limbs, a->limbs, a->length * sizeof(uint32_t));
+        r.limbs[0] = DivideSmall(q.limbs, a->length, b->limbs[0]);
+        Finish(&q, a->length, a->negative != b->negative);
+        Finish(&r, 1, a->negative);
+    }
+    else
+    {
+        error = DivideMagnitude(a->limbs, a->length, b->limbs, b->length, q.limbs, r.limbs);
+        Finish(&q, a->length - b->length + 1, a->negative != b->negative);
+        Finish(&r, b->length, a->negative);
+    }
+    if (quotient != 0)
+    {
+        *quotient = q;
+    }
+    if (remainder != 0)
+    {
+        *remainder = r;
+    }
+    return error;
+} // BigDivide
+
+int BigFactorial(const BigNum *n, BigNum *result)
+{
+    uint32_t count;
+    uint32_t factor;
+    uint32_t i;
+    int bits = 1;
+    int length = 1;
+
+    if (n->negative || n->length > 1 || (n->length == 1 && n->limbs[0] > BIG_MAX_FACTORIAL))
+    {
+        return BIG_ERR_FACTORIAL;
+    }
+    count = (n->length == 0) ? 0 : n->limbs[0];
+    while ((1UL << bits) <= count)
+    {
+        bits++;
+    }
+    if (Make(result, count * bits / 32 + 2) != BIG_OK) // n! < n^n = 2^(n log2 n)
+    {
+        return BIG_ERR_MEMORY;
+    }
+    result->limbs[0] = 1;
+    for (i = 2; i <= count; i++)
+    {
+        // Multiply in as many factors at once as fit in a limb
+        factor = i;
+        while (i < count && (uint64_t)factor * (i + 1) <= 0xFFFFFFFFUL)
+        {
+            factor *= ++i;
+        }
+        length = MultiplyAddSmall(result->limbs, length, factor, 0);
+    }
+    Finish(result, length, 0);
+    Shrink(result->limbs, result->length); // The bound is loose (314 limbs for 1000!, which needs 267)
+    return BIG_OK;
+} // BigFactorial
+
+void BigSetKaratsubaThreshold(int limbs)
+{
+    // Below 2 limbs the halves would be empty
+    karatsuba_threshold = (limbs == 0) ? BIG_KARATSUBA_THRESHOLD : (limbs < 2 ? 2 : limbs);
+} // BigSetKaratsubaThreshold
+
+int BigGetKaratsubaThreshold(void)
+{
+    return karatsuba_threshold;
+} // BigGetKaratsubaThreshold
+
+// --------------------------- Evaluator ----------------------------
+
+static const char *next; // Next character to evaluate
+
+static int IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+} // IsDigit
+
+// postfix := digits {!}
+static int EvaluatePostfix(BigNum *value)
+{
+    const char *start = next;
+    BigNum operand;
+    int error;
+
+    while (IsDigit(*next))
+    {
+        next++;
+    }
+    if (next == start)
+    {
+        return BIG_ERR_SYNTAX;
+    }
+    error = BigFromDecimal(start, next - start, value);
+    while (error == BIG_OK && *next == '!')
+    {
+        next++;
+        operand = *value;
+        error = BigFactorial(&operand, value);
+    }
+    return error;
+} // EvaluatePostfix
+
+// unary := {-|+} postfix
+static int EvaluateUnary(BigNum *value)
+{
+    int negate = 0;
+    int error;
+
+    while (*next == '-' || *next == '+')
+    {
+        negate ^= (*next++ == '-');
+    }
+    error = EvaluatePostfix(value);
+    if (negate && value->length != 0)
+    {
+        value->negative = !value->negative;
+    }
+    return error;
+} // EvaluateUnary
+
+// product := unary {(x|/|%) unary}
+static int EvaluateProduct(BigNum *value)
+{
+    BigNum left;
+    BigNum right;
+    char op;
+    int error = EvaluateUnary(value);
+
+    while (error == BIG_OK && (*next == 'x' || *next == '/' || *next == '%'))
+    {
+        op = *next++;
+        left = *value;
+        error = EvaluateUnary(&right);
+        if (error == BIG_OK)
+        {
+            if (op == 'x')
+            {
+                error = BigMultiply(&left, &right, value);
+            }
+            else if (op == '/')
+            {
+                error = BigDivide(&left, &right, value, 0);
+            }
+            else
+            {
+                error = BigDivide(&left, &right, 0, value);
+            }
+        }
+    }
+    return error;
+} // EvaluateProduct
+
+// sum := product {(+|-) product}
+static int EvaluateSum(BigNum *value)
+{
+    BigNum left;
+    BigNum right;
+    char op;
+    int error = EvaluateProduct(value);
+
+    while (error == BIG_OK && (*next == '+' || *next == '-'))
+    {
+        op = *next++;
+        left = *value;
+        error = EvaluateProduct(&right);
+        if (error == BIG_OK)
+        {
+            error = (op == '+') ? BigAdd(&left, &right, value) : BigSubtract(&left, &right, value);
+        }
+    }
+    return error;
+} // EvaluateSum
+
+int BigEvaluate(const char *input, char *text, int text_size)
+{
+    BigNum value;
+    int mark = BigArenaMark();
+    int error;
+
+    next = input;
+    error = EvaluateSum(&value);
+    if (error == BIG_OK && *next != '\0')
+    {
+        error = BIG_ERR_SYNTAX;
+    }
+    if (error == BIG_OK)
+    {
+        error = BigToDecimal(&value, text, text_size);
+    }
+    BigArenaRelease(mark);
+    return error;
+} // BigEvaluate
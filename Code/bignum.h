@@ -0,0 +1,137 @@
+/*! \file bignum.h
+ *
+ * Arbitrary-precision integers, for exact results too large for a double
+ * (which is only exact up to 2^53): factorials, long products, remainders.
+ *
+ * A number is a sign and a magnitude held as 32-bit limbs, least
+ * significant first. The limbs live in one statically sized arena, used
+ * as a stack: BigArenaMark() notes how much is in use and
+ * BigArenaRelease() frees everything allocated since. There is no
+ * malloc(), so the memory used can never be more than \a BIG_ARENA_LIMBS
+ * limbs, and running out is an ordinary error (BIG_ERR_MEMORY).
+ *
+ * Multiplication is schoolbook for short numbers and Karatsuba (three
+ * half-size products instead of four) once both are at least
+ * BigGetKaratsubaThreshold() limbs long. Conversion to decimal divides
+ * by 10^9 at a time, so each pass over the limbs yields nine digits.
+ *
+ * See host/bignum_bench.c for timings of 100 to 1000 digit operations.
+ */
+
+#ifndef BIGNUM_H
+#define BIGNUM_H
+
+#include <stdint.h>
+
+/*! Size of the arena, in 32-bit limbs (6 kbytes). 1000! needs 267 limbs,
+ * and multiplying two 1000-digit numbers about 600 including Karatsuba's
+ * working space. Two factorials up to \a BIG_MAX_FACTORIAL combined by
+ * + - / or % (e.g. 1000!/999!, with the division's working space) take
+ * at most about 1340. Their product, or three of them near that size
+ * (e.g. 1000!+999!+998!), do not fit, and give BIG_ERR_MEMORY; the
+ * product would be too long to show anyway.
+ */
+#define BIG_ARENA_LIMBS 1536
+
+/*! Default number of limbs above which multiplication uses Karatsuba
+ * (about 300 digits). See host/bignum_bench.c for how it was chosen.
+ */
+#define BIG_KARATSUBA_THRESHOLD 32
+
+/*! Largest n for which n! is calculated. 1000! has 2568 digits. */
+#define BIG_MAX_FACTORIAL 1000
+
+/*! Size of a buffer for any result BigEvaluate() can give from one
+ * line of input, e.g. 1000!, including the trailing null.
+ */
+#define BIG_TEXT_SIZE 2600
+
+//! \name Error numbers
+//@{
+#define BIG_OK 0            //!< No error
+#define BIG_ERR_SYNTAX 1    //!< Not a valid integer expression
+#define BIG_ERR_DIV_ZERO 2  //!< Division (or remainder) by zero
+#define BIG_ERR_MEMORY 3    //!< The arena is full
+#define BIG_ERR_TOO_LONG 4  //!< The result has too many digits for the text buffer
+#define BIG_ERR_FACTORIAL 5 //!< Factorial of a negative number or one above \a BIG_MAX_FACTORIAL
+//@}
+
+/*! Error messages for the error numbers above, one per display line. */
+extern const char *big_error_line1[];
+extern const char *big_error_line2[]; //!< \copydoc big_error_line1
+
+/*! An integer. \a limbs points into the arena. */
+typedef struct
+{
+    uint32_t *limbs; // Magnitude, least significant limb first
+    int length;      // Limbs in use, with no leading zero limbs; 0 for zero
+    int negative;    // 1 if less than zero
+} BigNum;
+
+/*! \return A mark, for BigArenaRelease(): the number of limbs in use.
+ */
+int BigArenaMark( void );
+
+/*! Free everything allocated since \a mark was taken.
+ */
+void BigArenaRelease( int mark );
+
+/*! \return The largest number of limbs ever in use at once.
+ */
+int BigArenaHighWater( void );
+
+/*! Read a number written in decimal digits (with no sign).
+ *
+ * \param [in] digits The digits.
+ * \param [in] count How many there are.
+ * \param [out] result The number.
+ * \return BIG_OK or BIG_ERR_MEMORY.
+ */
+int BigFromDecimal( const char *digits, int count, BigNum *result );
+
+/*! Write a number in decimal, with a leading - if negative.
+ *
+ * \param [in] number The number.
+ * \param [out] text A C-format string.
+ * \param [in] text_size Size of \a text, including the trailing null.
+ * \return BIG_OK, BIG_ERR_MEMORY or BIG_ERR_TOO_LONG.
+ */
+int BigToDecimal( const BigNum *number, char *text, int text_size );
+
+//! \name Arithmetic
+//! Each allocates its result in the arena and returns BIG_OK or an error.
+//@{
+int BigAdd( const BigNum *a, const BigNum *b, BigNum *result );
+int BigSubtract( const BigNum *a, const BigNum *b, BigNum *result );
+int BigMultiply( const BigNum *a, const BigNum *b, BigNum *result );
+/*! Quotient rounded towards zero, and remainder with the sign of \a a,
+ * as in C. Either output may be 0 if it is not wanted. */
+int BigDivide( const BigNum *a, const BigNum *b, BigNum *quotient, BigNum *remainder );
+int BigFactorial( const BigNum *n, BigNum *result );
+//@}
+
+/*! Change the Karatsuba threshold (for benchmarking).
+ *
+ * \param [in] limbs The new threshold; 0 for the default.
+ */
+void BigSetKaratsubaThreshold( int limbs );
+
+/*! \return The Karatsuba threshold in use.
+ */
+int BigGetKaratsubaThreshold( void );
+
+/*! Evaluate an integer expression and write the result in decimal.
+ *
+ * \param [in] input A C-format string: decimal integers with + - x,
+ * 		/ (quotient, rounded towards zero), % (remainder), unary
+ * 		minus and ! (factorial, after its operand). x / and % are
+ * 		done before + and -, and ! before everything.
+ * \param [out] text The result.
+ * \param [in] text_size Size of \a text, including the trailing null.
+ * \return BIG_OK or an error number.
+ *
+ * The whole arena is freed again before it returns.
+ */
+int BigEvaluate( const char *input, char *text, int text_size );
+
+#endif // of #ifndef BIGNUM_H
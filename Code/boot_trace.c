@@ -0,0 +1,82 @@
+/* boot_trace.c
+ *
+ * Timestamped trace of the stages of start-up.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "TExaS.h"
+#include "boot_trace.h"
+#include "low_level_funcs_tiva.h"
+#include "UART.h"
+
+static const char *trace_stage[BOOT_TRACE_SIZE];      // Name of each stage
+static unsigned long trace_microsec[BOOT_TRACE_SIZE]; // Time from the start to each mark
+static int trace_count = 0;                           // Marks recorded
+
+static unsigned long last_cycles;   // ReadCycleCounter() at the last mark
+static unsigned long last_clock_hz; // GetCoreClockHz() at the last mark
+static int dump_line = -1;          // Next line of the dump to send (-1 when not dumping)
+
+void BootTraceMark(const char *stage)
+{
+    unsigned long now = ReadCycleCounter();
+
+    if (trace_count >= BOOT_TRACE_SIZE)
+    {
+        return;
+    }
+    if (trace_count == 0)
+    {
+        trace_microsec[0] = now / (GetCoreClockHz() / 1000000); // Counter started at 0
+    }
+    else
+    {
+        // The stage just ended ran at the clock in force when it started
+        trace_microsec[trace_count] = trace_microsec[trace_count - 1] + (now - last_cycles) / (last_clock_hz / 1000000);
+    }
+    trace_stage[trace_count] = stage;
+    trace_count++;
+    last_cycles = now;
+    last_clock_hz = GetCoreClockHz();
+} // BootTraceMark
+
+int BootTraceCount(void)
+{
+    return trace_count;
+} // BootTraceCount
+
+unsigned long BootTraceMicrosec(int index)
+{
+    if (index < 0 || index >= trace_count)
+    {
+        return 0;
+    }
+    return trace_microsec[index];
+} // BootTraceMicrosec
+
+void BootTraceDump(void)
+{
+    dump_line = 0;
+} // BootTraceDump
+
+void BootTraceTask(void)
+{
+    char line[64];
+
+    if (dump_line < 0)
+    {
+        return;
+    }
+    if (dump_line >= trace_count)
+    {
+        dump_line = -1; // All sent
+        return;
+    }
+    sprintf(line, "BOOT %7lu us %+7ld %s\r\n", trace_microsec[dump_line],
+            (long)(trace_microsec[dump_line] - BootTraceMicrosec(dump_line - 1)), trace_stage[dump_line]);
+    if (UART_WriteString(line)) // All or nothing: try again next time if there is no room
+    {
+        dump_line++;
+    }
+} // BootTraceTask
@@ -0,0 +1,55 @@
+/*! \file boot_trace.h
+ *
+ * Timestamped trace of the stages of start-up, to show where the time
+ * goes between reset and the calculator being usable.
+ *
+ * Each call to BootTraceMark() records the time since the cycle counter
+ * was started (the first thing InitAllHardware() does, so the trace
+ * leaves out only the C start-up code before main()). Times are
+ * converted from cycles using the core clock in force at the previous
+ * mark, so the stages before PLL_Init() are timed at 16 MHz.
+ *
+ * Once start-up is complete BootTraceDump() sends the trace over the
+ * serial port, one line per stage:
+ *
+ * 	BOOT    1234 us  +1200 pll
+ *
+ * giving the time since the start and the length of the stage which
+ * ended at that mark.
+ */
+
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+/*! Maximum number of marks recorded. Any more are ignored. */
+#define BOOT_TRACE_SIZE 12
+
+/*! Record that a stage of start-up has ended.
+ *
+ * \param [in] stage Name of the stage. It must be a string constant (only
+ * 		the pointer is kept).
+ *
+ * Takes a few cycles, so may be called anywhere.
+ */
+void BootTraceMark( const char *stage );
+
+/*! \return The number of marks recorded.
+ */
+int BootTraceCount( void );
+
+/*! \return Microseconds from the start to mark \a index (counting from 0),
+ * 		or 0 if there is no such mark.
+ */
+unsigned long BootTraceMicrosec( int index );
+
+/*! Queue the trace to be sent over the serial port by BootTraceTask().
+ * The serial port must have been initialised.
+ */
+void BootTraceDump( void );
+
+/*! Background task (see scheduler.h) which sends the next line of a
+ * dump, if one is waiting and the serial transmit buffer has room.
+ */
+void BootTraceTask( void );
+
+#endif // of #ifndef BOOT_TRACE_H
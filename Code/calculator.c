@@ -0,0 +1,310 @@
+/* calculator.c
+ *
+ * The calculator proper: calculating entries, macro replay, and RPN and
+ * statistics modes. Moved here from main.c, so that the host harness
+ * runs the same code.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "calculator.h"
+#include "high_level_funcs.h"
+#include "mid_level_funcs.h"
+#include "low_level_funcs_tiva.h"
+#include "calculate_answer.h"
+#include "expression.h"
+#include "result_cache.h"
+#include "rpn.h"
+#include "bignum.h"
+#include "event_trace.h"
+#include "mem_guard.h"
+#include "macro.h"
+#include "radix.h"
+#include "stats.h"
+#include <stddef.h>
+
+static char *input_buffer;                           // The user's input, from CalculatorInit()
+static int input_size;                               // Its size
+static int app_state = APP_INPUT;                    // APP_INPUT, APP_RPN or APP_STATS
+static double answer = 0.0;                          // Initialise in case ReadDoubleFromFlash() does nothing
+static char big_result[GUARDED_SIZE(BIG_TEXT_SIZE)]; // Last result in integer mode (see bignum.h), or in hex, octal or binary
+static uint64_t radix_answer = 0;                    // Last result in hex, octal or binary mode (see radix.h)
+static ExprProgram last_program;                     // Holds the last operation of the last entry, which = repeats
+
+// Calculate and display the answer to the input just completed, then go on
+// to the next input (or to the error message). Returns 1 if there was no error.
+static int CalculateAndDisplay(void)
+{
+    int error_ref_no = 0;     // Init in case just = is entered as the first entry
+    int expr_error = EXPR_OK;  // Error from expression.c
+    double previous_answer = answer;
+    CalcResult result;
+    int big_error = BIG_OK;
+    int radix_error = RADIX_OK;
+    uint64_t radix_value = radix_answer;
+    char hex[RADIX_TEXT_SIZE];
+
+    if (RadixDigitBits(GetInputNumberMode()) != 0)
+    {
+        // Hex, octal or binary: 64-bit two's complement. = on its own shows
+        // the last result again, in the base now in use, so changing mode
+        // and pressing = converts it.
+        TraceRecord(TRACE_EVAL_START, TRACE_EVAL_RADIX);
+        if (input_buffer[0] != '\0')
+        {
+            radix_error = RadixEvaluate(input_buffer, GetInputNumberMode(), &radix_value);
+        }
+        TraceRecord(TRACE_EVAL_END, radix_error);
+        if (radix_error == RADIX_OK)
+        {
+            radix_answer = radix_value;
+            RadixFormat(radix_answer, GetInputNumberMode(), big_result);
+            RadixFormat(radix_answer, NUMBER_MODE_HEX, hex);
+            DisplayRadixResult(big_result, hex);
+        }
+        else
+        {
+            DisplayErrorMessage(radix_error_line1[radix_error], radix_error_line2[radix_error]);
+        }
+        StartReadAndEchoInput(input_buffer, input_size);
+        return radix_error == RADIX_OK;
+    }
+
+    if (GetInputNumberMode() == NUMBER_MODE_INTEGER)
+    {
+        // Exact integers. The result is only shown, not kept as the answer,
+        // which is a double; = on its own shows it again.
+        TraceRecord(TRACE_EVAL_START, TRACE_EVAL_INTEGER);
+        if (input_buffer[0] != '\0')
+        {
+            big_error = BigEvaluate(input_buffer, big_result, BIG_TEXT_SIZE);
+        }
+        TraceRecord(TRACE_EVAL_END, big_error);
+        if (big_error == BIG_OK)
+        {
+            DisplayBigResult(big_result);
+        }
+        else
+        {
+            big_result[0] = '\0';
+            DisplayErrorMessage(big_error_line1[big_error], big_error_line2[big_error]);
+        }
+        StartReadAndEchoInput(input_buffer, input_size);
+        return big_error == BIG_OK;
+    }
+
+    if (input_buffer[0] == '\0')
+    {
+        // The user typed equals immediately (indicated by an empty buffer):
+        // repeat the last operation on the answer, without parsing anything.
+        // If there is none, the previous answer is displayed unchanged.
+        TraceRecord(TRACE_EVAL_START, TRACE_EVAL_REPEAT);
+        expr_error = ExprRepeat(&last_program, answer, &answer);
+    }
+    else
+    {
+        // Calls CalculateAnswer(), or expression.c for entries using ANS,
+        // unless the result is already cached
+        TraceRecord(TRACE_EVAL_START, TRACE_EVAL_DECIMAL);
+        ResultCacheCalculate(input_buffer, input_size, NUMBER_MODE_DECIMAL, answer, &result);
+        error_ref_no = result.error_ref_no;
+        expr_error = result.expr_error;
+        if (error_ref_no == 0 && expr_error == EXPR_OK)
+        {
+            answer = result.value;
+            last_program.last_op = result.last_op;
+            last_program.last_operand = result.last_operand;
+        }
+    }
+    TraceRecord(TRACE_EVAL_END, (expr_error != EXPR_OK) ? TRACE_EXPR_ERROR + expr_error : error_ref_no);
+    if (answer != previous_answer)
+    {
+        ResultCacheInvalidateAns(); // Cached ANS results are stale
+    }
+    if (error_ref_no == 0 && expr_error == EXPR_OK)
+    {
+        DisplayResult(answer);
+        WriteDoubleToFlash(answer);
+    }
+    else if (expr_error != EXPR_OK)
+    {
+        DisplayErrorMessage(expr_error_line1[expr_error], expr_error_line2[expr_error]);
+    }
+    else
+    {
+        DisplayErrorMessage(error_message_line1[error_ref_no], error_message_line2[error_ref_no]);
+    }
+    // The error message is an overlay, so input can start at once: the
+    // first key dismisses it
+    StartReadAndEchoInput(input_buffer, input_size);
+    return error_ref_no == 0 && expr_error == EXPR_OK;
+} // CalculateAndDisplay
+
+// Replay the macro started by MacroStartReplay() (see macro.h): each of its
+// entries is calculated straight away, as if typed, until it ends, an error
+// stops it, or the user must type a parameter
+static void ContinueMacro(void)
+{
+    for (;;)
+    {
+        switch (MacroReplay(input_buffer, input_size))
+        {
+        case MACRO_ENTRY:
+            if (!CalculateAndDisplay())
+            {
+                MacroStopReplay(); // The error is shown
+                return;
+            }
+            break;
+        case MACRO_PARAMETER_NEEDED: // Carries on when * is pressed
+            ContinueReadAndEchoInput("Value, then *");
+            return;
+        default: // Finished. Anything left over is for the user to finish.
+            if (input_buffer[0] != '\0')
+            {
+                ContinueReadAndEchoInput(NULL);
+            }
+            return;
+        }
+    }
+} // ContinueMacro
+
+// Back to ordinary entry from RPN or statistics mode, with result (if there
+// is one) as the answer
+static void ReturnToInput(int have_result, double result)
+{
+    if (have_result && result != answer)
+    {
+        answer = result;
+        ResultCacheInvalidateAns();
+        WriteDoubleToFlash(answer);
+    }
+    DisplayResult(answer);
+    StartReadAndEchoInput(input_buffer, input_size);
+    app_state = APP_INPUT;
+} // ReturnToInput
+
+void CalculatorInit(char *input, int size)
+{
+    input_buffer = input;
+    input_size = size;
+    input_buffer[0] = '\0';
+    app_state = APP_INPUT;
+    answer = 0.0;
+    radix_answer = 0;
+    big_result[0] = '\0';
+    last_program.last_op = 0;
+    last_program.last_operand = 0.0;
+    MemGuardRegister(big_result, BIG_TEXT_SIZE, "big_result");
+} // CalculatorInit
+
+void StartCalculator(void)
+{
+    StartReadAndEchoInput(input_buffer, input_size);
+    app_state = APP_INPUT;
+} // StartCalculator
+
+void CalculatorEvent(const Event *event)
+{
+    double result;
+    int have_result;
+
+    switch (app_state)
+    {
+    case APP_INPUT:
+        switch (ReadAndEchoInputEvent(event))
+        {
+        case INPUT_END:
+            if (MacroReplaying())
+            {
+                ContinueMacro(); // With the parameter just typed
+            }
+            else
+            {
+                CalculateAndDisplay();
+            }
+            break;
+        case INPUT_MACRO:
+            ContinueMacro();
+            break;
+        case INPUT_RPN:
+            MacroStopReplay();
+            StartRpnMode(answer); // X starts as the answer
+            app_state = APP_RPN;
+            break;
+        case INPUT_STATS:
+            MacroStopReplay();
+            StartStatsMode();
+            app_state = APP_STATS;
+            break;
+        }
+        break;
+    case APP_RPN:
+        if (RpnEvent(event))
+        {
+            ReturnToInput(1, RpnGetX()); // X becomes the answer
+        }
+        break;
+    case APP_STATS:
+        if (StatsEvent(event))
+        {
+            have_result = StatsGetResult(&result); // The result shown, if any
+            ReturnToInput(have_result, result);
+        }
+        break;
+    }
+} // CalculatorEvent
+
+int CalculatorState(void)
+{
+    return app_state;
+} // CalculatorState
+
+double CalculatorGetAnswer(void)
+{
+    return answer;
+} // CalculatorGetAnswer
+
+void CalculatorSetAnswer(double new_answer)
+{
+    if (new_answer != answer)
+    {
+        answer = new_answer;
+        ResultCacheInvalidateAns();
+    }
+} // CalculatorSetAnswer
+
+void CalculatorSaveState(PowerSession *session)
+{
+    session->app_state = app_state;
+    session->answer = answer;
+    session->last_op = last_program.last_op;
+    session->last_operand = last_program.last_operand;
+    SaveInputState(&session->input);
+    RpnSaveState(&session->rpn);
+    StatsSaveState(&session->stats);
+} // CalculatorSaveState
+
+int CalculatorResume(const PowerSession *session)
+{
+    answer = session->answer;
+    last_program.last_op = session->last_op;
+    last_program.last_operand = session->last_operand;
+    ResultCacheInvalidateAns();
+    switch (session->app_state)
+    {
+    case APP_INPUT:
+        ResumeReadAndEchoInput(input_buffer, input_size, &session->input);
+        break;
+    case APP_RPN:
+        RpnResume(&session->rpn);
+        break;
+    case APP_STATS:
+        StatsResume(&session->stats);
+        break;
+    default: // The welcome screen or the password
+        return 0;
+    }
+    app_state = session->app_state;
+    return 1;
+} // CalculatorResume
@@ -0,0 +1,82 @@
+/*! \file calculator.h
+ *
+ * The calculator proper, once the password has been accepted: ordinary
+ * entry, with = calculating the entry in the number mode in use, macro
+ * replay, and the switches into and out of RPN mode and statistics mode.
+ * It keeps the answer (ANS) and the last operation, which = on its own
+ * repeats.
+ *
+ * main.c passes it the events for as long as it has the screen, after
+ * OverlayEvent() (see mid_level_funcs.h) has seen them. The host harness
+ * host/fuzz_calc.c links the same code, so what it fuzzes is what runs
+ * on the board.
+ */
+
+#ifndef CALCULATOR_H
+#define CALCULATOR_H
+
+#include "scheduler.h"
+#include "power_down.h"
+
+//! \name What the program is doing (which state machine gets the events)
+//! These are saved in a PowerSession, so must not change.
+//@{
+#define APP_WELCOME 0  //!< Welcome animation (main.c)
+#define APP_PASSWORD 1 //!< Asking for the password (main.c)
+#define APP_INPUT 2    //!< Reading the user's input
+#define APP_RPN 3      //!< RPN entry mode
+#define APP_STATS 4    //!< Statistics mode
+//@}
+
+/*! Set up the calculator, with an answer of 0 and no last operation.
+ * Call once at start-up, before any other function here.
+ *
+ * \param [in] input_buffer Buffer for the input typed by the user.
+ * \param [in] size Its size, including the trailing null.
+ */
+void CalculatorInit( char *input_buffer, int size );
+
+/*! Start ordinary entry, with an empty input (the state is APP_INPUT).
+ */
+void StartCalculator( void );
+
+/*! Deal with one event: a key, or a timer of the input, RPN mode or
+ * statistics mode. An entry is calculated, and its result or error shown,
+ * as soon as its = is pressed.
+ *
+ * \param [in] event The event.
+ */
+void CalculatorEvent( const Event *event );
+
+/*! \return Which of APP_INPUT, APP_RPN and APP_STATS the calculator is in.
+ */
+int CalculatorState( void );
+
+/*! \return The answer (ANS).
+ */
+double CalculatorGetAnswer( void );
+
+/*! Set the answer, e.g. to the one read from flash at start-up.
+ *
+ * \param [in] answer The answer.
+ */
+void CalculatorSetAnswer( double answer );
+
+/*! Save what the calculator needs to carry on, for a session (see
+ * power_down.h): the state, the answer, the last operation and the state
+ * of the input, RPN mode and statistics mode. The screen is not saved.
+ *
+ * \param [out] session The session.
+ */
+void CalculatorSaveState( PowerSession *session );
+
+/*! Carry on from a saved session, with the answer and last operation it
+ * had. The screen is not restored: see SetScreenState().
+ *
+ * \param [in] session Session saved by CalculatorSaveState().
+ * \return 1 if the calculator has carried on, or 0 if the session was
+ * 		saved outside it (the welcome screen or the password).
+ */
+int CalculatorResume( const PowerSession *session );
+
+#endif // of #ifndef CALCULATOR_H
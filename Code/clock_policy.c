@@ -0,0 +1,104 @@
+/* clock_policy.c
+ *
+ * Slow clock while idle, fast clock while busy, and the time in each.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "TExaS.h"
+#include "clock_policy.h"
+#include "low_level_funcs_tiva.h"
+#include "mid_level_funcs.h"
+#include <stdio.h>
+
+static int clock_fast = 1;                 // 1 at 80 MHz (as PLL_Init() leaves it), 0 at 16 MHz
+static int hold_count = 0;                 // ClockPolicyHold() calls not yet released
+static unsigned long last_wake_millisec;   // GetTickMillisec() at the last ClockPolicyWake() or release
+static unsigned long last_count_millisec;  // GetTickMillisec() when the time in the state was last counted
+static ClockStats stats;
+
+// Add the time since last counted to whichever state the clock is in
+static void CountTime(void)
+{
+    unsigned long now = GetTickMillisec();
+
+    if (clock_fast)
+    {
+        stats.fast_millisec += now - last_count_millisec;
+    }
+    else
+    {
+        stats.slow_millisec += now - last_count_millisec;
+    }
+    last_count_millisec = now;
+} // CountTime
+
+static void SwitchClock(int fast)
+{
+    CountTime(); // What went before was at the old speed
+    SetCoreClock(fast);
+    clock_fast = fast;
+    stats.switches++;
+} // SwitchClock
+
+void ClockPolicyWake(void)
+{
+    last_wake_millisec = GetTickMillisec();
+    if (!clock_fast)
+    {
+        SwitchClock(1);
+    }
+} // ClockPolicyWake
+
+void ClockPolicyHold(void)
+{
+    hold_count++;
+    ClockPolicyWake();
+} // ClockPolicyHold
+
+void ClockPolicyRelease(void)
+{
+    if (hold_count > 0)
+    {
+        hold_count--;
+    }
+    last_wake_millisec = GetTickMillisec();
+} // ClockPolicyRelease
+
+int ClockPolicyHeld(void)
+{
+    return hold_count > 0;
+} // ClockPolicyHeld
+
+void ClockPolicyTask(void)
+{
+    CountTime();
+    if (hold_count > 0 || !clock_fast)
+    {
+        return;
+    }
+    if (GetTickMillisec() - last_wake_millisec < CLOCK_IDLE_MILLISEC || DisplayFlushPending())
+    {
+        return; // Still busy, or the display is still being drawn
+    }
+    SwitchClock(0);
+} // ClockPolicyTask
+
+void ClockPolicyGetStats(ClockStats *result)
+{
+    CountTime();
+    *result = stats;
+} // ClockPolicyGetStats
+
+void ClockPolicyReport(char *text, int text_size)
+{
+    ClockStats now;
+    // Energy in mJ = mA * mV * ms / 10^6
+    double millijoules_per_fast_ms = CLOCK_FAST_MILLIAMPS * (double)CLOCK_SUPPLY_MILLIVOLTS / 1e6;
+    double millijoules_per_slow_ms = CLOCK_SLOW_MILLIAMPS * (double)CLOCK_SUPPLY_MILLIVOLTS / 1e6;
+
+    ClockPolicyGetStats(&now);
+    snprintf(text, text_size, "CLK fast %.1fs %.0fmJ slow %.1fs %.0fmJ sw %lu", now.fast_millisec / 1000.0,
+             now.fast_millisec * millijoules_per_fast_ms, now.slow_millisec / 1000.0,
+             now.slow_millisec * millijoules_per_slow_ms, now.switches);
+} // ClockPolicyReport
@@ -0,0 +1,92 @@
+/*! \file clock_policy.h
+ *
+ * Runs the core from the 16 MHz crystal while the calculator is waiting
+ * for a key, and from the PLL at 80 MHz while it is calculating and
+ * drawing.
+ *
+ * Almost all the time the program is scanning the keypad, which needs
+ * no speed at all. ClockPolicyWake(), called before every event is
+ * handled, switches to the fast clock; ClockPolicyTask() switches back
+ * once there have been no events for \a CLOCK_IDLE_MILLISEC and the
+ * display has been brought up to date. The PLL is only bypassed, not
+ * stopped, so the switch is immediate both ways (see SetCoreClock()),
+ * and everything timed (the tick, waits, UART baud rate, the event
+ * trace) follows the clock.
+ *
+ * ClockPolicyHold() keeps the clock fast until the matching
+ * ClockPolicyRelease(), e.g. while starting up and in serial batch mode.
+ *
+ * The time spent in each state is counted, and the energy used in each
+ * estimated from the typical currents below. The report
+ * (ClockPolicyReport()) is the reply to "?C" in serial batch mode.
+ *
+ * Compiled with HOST_SIM defined, the low level clock functions are
+ * replaced by the virtual clock in host/clock_host.c, so the policy can
+ * be run and checked on the host (see host_sim.h).
+ */
+
+#ifndef CLOCK_POLICY_H
+#define CLOCK_POLICY_H
+
+/*! Milliseconds without an event before the clock is slowed. Long
+ * enough that a burst of events (a key, then its timers) is handled at
+ * one speed. */
+#define CLOCK_IDLE_MILLISEC 20
+
+//! \name Estimated supply current of the TM4C123 in each state
+//! (datasheet run mode figures, peripherals in use on); with the supply
+//! voltage, for the energy estimates
+//@{
+#define CLOCK_FAST_MILLIAMPS 45     //!< 80 MHz from the PLL
+#define CLOCK_SLOW_MILLIAMPS 15     //!< 16 MHz crystal, PLL bypassed but running
+#define CLOCK_SUPPLY_MILLIVOLTS 3300
+//@}
+
+/*! Time spent in each state since power-on. */
+typedef struct
+{
+    unsigned long fast_millisec; //!< At 80 MHz
+    unsigned long slow_millisec; //!< At 16 MHz
+    unsigned long switches;      //!< Changes of clock, either way
+} ClockStats;
+
+/*! Switch to the fast clock (if not already on it) and restart the idle
+ * time. Called before each event is handled, and by anything else which
+ * is about to need speed.
+ */
+void ClockPolicyWake( void );
+
+/*! Keep the clock fast until ClockPolicyRelease() is called as many times
+ * as this has been.
+ */
+void ClockPolicyHold( void );
+
+/*! Undo one ClockPolicyHold(). The idle time starts again from now.
+ */
+void ClockPolicyRelease( void );
+
+/*! \return 1 while ClockPolicyHold() is in force, else 0. The calculator 
+ * is not powered down meanwhile either (see power_down.h).
+ */
+int ClockPolicyHeld( void );
+
+/*! Background task (see scheduler.h) which counts the time spent in the
+ * present state and slows the clock when the program is idle.
+ */
+void ClockPolicyTask( void );
+
+/*! \param [out] stats Time spent in each state, up to now.
+ */
+void ClockPolicyGetStats( ClockStats *stats );
+
+/*! Write a one-line report, e.g.
+ * 	CLK fast 12.3s 1827mJ slow 567.8s 28106mJ sw 57
+ * (seconds and estimated millijoules at each speed, and the number of
+ * switches).
+ *
+ * \param [out] text The report, without a line ending.
+ * \param [in] text_size Size of \a text, including the trailing null.
+ */
+void ClockPolicyReport( char *text, int text_size );
+
+#endif // of #ifndef CLOCK_POLICY_H
@@ -0,0 +1,80 @@
+/* event_trace.c
+ *
+ * Ring of timestamped events, and its dump over the serial port.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "TExaS.h"
+#include "event_trace.h"
+#include "low_level_funcs_tiva.h"
+#include "UART.h"
+#include <stdio.h>
+
+typedef struct
+{
+    unsigned long microsec; // GetTickMicrosec()
+    unsigned char type;     // One of the TRACE_ constants
+    unsigned char data;
+} TraceEntry;
+
+static TraceEntry trace[TRACE_SIZE];
+static unsigned long trace_head = 0; // Entries ever recorded; the next goes in trace[trace_head % TRACE_SIZE]
+static int dump_line = -1;           // Next line of the dump: -1 when not dumping, 0 for the heading,
+                                     // 1 to count for the entries, count + 1 for END
+static unsigned long dump_first;     // trace_head of the oldest entry dumped
+static int dump_count;               // Entries dumped
+
+void TraceRecord(unsigned char type, unsigned char data)
+{
+    TraceEntry *entry;
+
+    if (dump_line >= 0)
+    {
+        return; // Frozen until the dump has been sent
+    }
+    entry = &trace[trace_head & (TRACE_SIZE - 1)];
+    trace_head++;
+    entry->microsec = GetTickMicrosec();
+    entry->type = type;
+    entry->data = data;
+} // TraceRecord
+
+void TraceDump(void)
+{
+    dump_count = (trace_head < TRACE_SIZE) ? (int)trace_head : TRACE_SIZE;
+    dump_first = trace_head - dump_count;
+    dump_line = 0;
+} // TraceDump
+
+void TraceTask(void)
+{
+    char line[32];
+    const TraceEntry *entry;
+
+    if (dump_line < 0)
+    {
+        return;
+    }
+    if (dump_line == 0)
+    {
+        sprintf(line, "TRACE %d %lu\r\n", dump_count, 1000000UL); // Timestamps per second
+    }
+    else if (dump_line <= dump_count)
+    {
+        entry = &trace[(dump_first + dump_line - 1) & (TRACE_SIZE - 1)];
+        sprintf(line, "%08lX %02X %02X\r\n", entry->microsec, entry->type, entry->data);
+    }
+    else
+    {
+        sprintf(line, "END\r\n");
+    }
+    if (UART_WriteString(line)) // All or nothing: try again next time if there is no room
+    {
+        dump_line++;
+        if (dump_line > dump_count + 1)
+        {
+            dump_line = -1; // All sent: recording starts again
+        }
+    }
+} // TraceTask
@@ -0,0 +1,93 @@
+/*! \file event_trace.h
+ *
+ * A flight recorder: the last \a TRACE_SIZE things that happened, each
+ * with its time, kept in a ring in RAM so that when something goes wrong
+ * ("it missed my key", "the screen glitched") there is a record of what
+ * led up to it.
+ *
+ * Each entry is 8 bytes: the time in microseconds (GetTickMicrosec(),
+ * which stays right when clock_policy.c changes the clock), a type, one
+ * byte of data and padding. Recording one is a few loads and stores, with no
+ * formatting and no waiting, so it is always on. The oldest entries are
+ * overwritten.
+ *
+ * TraceDump() (?T in serial batch mode) sends the whole ring over the
+ * serial port as text, oldest first:
+ *
+ * 	TRACE 256 1000000
+ * 	0003C5D1 02 35
+ * 	...
+ * 	END
+ *
+ * i.e. the number of entries and the rate of the timestamps (per second),
+ * then one line per entry of time, type and data in hex. host/trace_decode.c
+ * turns that into a timeline. Recording stops while the dump is sent, so
+ * the dump is of one moment.
+ *
+ * TraceRecord() must only be called from the main program, not from
+ * interrupt handlers.
+ */
+
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+/*! Number of entries kept (a power of 2). */
+#define TRACE_SIZE 256
+
+//! \name Entry types, and what their data is
+//@{
+#define TRACE_START 1         //!< The program has started. 0.
+#define TRACE_KEY_SCAN 2      //!< A keypad column read differently from last time. Column (from 0) in bits 7:4, rows read in bits 3:0.
+#define TRACE_KEY 3           //!< A key press was posted. The character on the key.
+#define TRACE_KEY_REPEAT 4    //!< A held key was posted again. The character on the key.
+#define TRACE_LCD_COMMAND 5   //!< An instruction was sent to the LCD. The instruction byte.
+#define TRACE_EVAL_START 6    //!< An entry is being calculated. One of the TRACE_EVAL_ constants.
+#define TRACE_EVAL_END 7      //!< The calculation is finished. 0, or the error number from CalculateAnswer(), bignum.c or radix.c, or TRACE_EXPR_ERROR + the one from expression.c.
+#define TRACE_FLASH_ERASE 8   //!< The answer block in flash is being erased. 0, or TRACE_FLASH_SESSION, TRACE_FLASH_MACROS or TRACE_FLASH_STATS for the session, macro or statistics block.
+#define TRACE_FLASH_WRITE 9   //!< An answer is being written to flash. The slot number, plus TRACE_FLASH_SESSION for a session, TRACE_FLASH_MACROS for the macros or TRACE_FLASH_STATS for the statistics.
+#define TRACE_CLOCK 10        //!< The core clock has been changed (clock_policy.h). 1 for fast, 0 for slow.
+#define TRACE_POWER 11        //!< Power-down (power_down.h). 1 going to sleep, 0 woken by a key.
+//@}
+
+/*! Added to the data of TRACE_FLASH_ERASE and TRACE_FLASH_WRITE for the
+ * saved session (see power_down.h), rather than the answers. */
+#define TRACE_FLASH_SESSION 0x80
+
+/*! Added to the data of TRACE_FLASH_ERASE and TRACE_FLASH_WRITE for the
+ * macros (see macro.h). It includes TRACE_FLASH_SESSION's bit. */
+#define TRACE_FLASH_MACROS 0xC0
+
+/*! Added to the data of TRACE_FLASH_ERASE and TRACE_FLASH_WRITE for the
+ * statistics (see stats.h). It includes TRACE_FLASH_SESSION's bit, and
+ * leaves three bits for the slot. */
+#define TRACE_FLASH_STATS 0xA0
+
+//! \name Data of TRACE_EVAL_START
+//@{
+#define TRACE_EVAL_DECIMAL 0 //!< An ordinary entry
+#define TRACE_EVAL_INTEGER 1 //!< An entry in exact integer mode
+#define TRACE_EVAL_REPEAT 2  //!< = on its own: the last operation again
+#define TRACE_EVAL_RADIX 3   //!< An entry in hex, octal or binary mode
+//@}
+
+/*! Added to expression.c's error numbers in TRACE_EVAL_END. */
+#define TRACE_EXPR_ERROR 0x80
+
+/*! Record that something has happened (unless a dump is being sent).
+ *
+ * \param [in] type One of the TRACE_ constants.
+ * \param [in] data Depends on the type (see above).
+ */
+void TraceRecord( unsigned char type, unsigned char data );
+
+/*! Queue the trace to be sent over the serial port by TraceTask().
+ * Nothing more is recorded until it has all been sent.
+ */
+void TraceDump( void );
+
+/*! Background task (see scheduler.h) which sends the next line of a
+ * dump, if one is waiting and the serial transmit buffer has room.
+ */
+void TraceTask( void );
+
+#endif // of #ifndef EVENT_TRACE_H
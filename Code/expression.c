@@ -0,0 +1,487 @@
+/* expression.c
+ *
+ * Expression compiler and evaluator: recursive descent into a list of
+ * steps in reverse Polish order, then a small stack machine.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "expression.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#define NUMBER_SIZE 20         // Longest number text, including the trailing null
+#define WHOLE_DIGITS 9         // Longest number converted without strtod(): always fits in an int32_t
+#define WHOLE_FACTOR_MAX 0x7FFFFFFFLL // Largest factor multiplied in whole numbers: the product fits in an int64_t
+#define WHOLE_FORMAT_MAX 1000000.0    // Whole results below this are printed by FormatWhole(), as %G would
+
+const char *const expr_error_line1[] = {"", "Syntax error    ", "Division by zero", "Out of range    ", "Too complex     "};
+const char *const expr_error_line2[] = {"", "Press any key   ", "Press any key   ", "Press any key   ", "Press any key   "};
+
+static const char step_ops[] = {0, 0, '+', '-', 'x', '/'}; // Operator for each binary step code
+
+// Compiler state, passed down the recursive descent rather than kept in
+// statics, so that entries can be compiled on several threads at once
+typedef struct
+{
+    const char *next;     // Next character to compile
+    ExprProgram *program; // Program being compiled
+    int error;            // First error found, or EXPR_OK
+} Compiler;
+
+static int IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+} // IsDigit
+
+// Returns the step added, or NULL if there was no room
+static ExprStep *AddStep(Compiler *c, unsigned char op, double value)
+{
+    ExprProgram *program = c->program;
+    ExprStep *step;
+
+    if (program->length >= EXPR_MAX_STEPS)
+    {
+        if (c->error == EXPR_OK)
+        {
+            c->error = EXPR_ERR_TOO_LONG;
+        }
+        return NULL;
+    }
+    step = &program->steps[program->length++];
+    step->op = op;
+    step->integer = 0;
+    step->value = value;
+    return step;
+} // AddStep
+
+static void SyntaxError(Compiler *c)
+{
+    if (c->error == EXPR_OK)
+    {
+        c->error = EXPR_ERR_SYNTAX;
+    }
+} // SyntaxError
+
+// number := digits [. digits] [E [+|-] digits], with at least one digit
+// before the E. Scanned here rather than by strtod() alone, which would
+// also take e.g. "0x5" (meaning 0 times 5) as hexadecimal.
+static void CompileNumber(Compiler *c)
+{
+    char text[NUMBER_SIZE];
+    const char *start = c->next;
+    const char *next = start;
+    int digits = 0;
+    int32_t integer = 0;
+    double value;
+    ExprStep *step;
+
+    while (IsDigit(*next))
+    {
+        next++;
+        digits++;
+    }
+    if (*next == '.')
+    {
+        next++;
+        while (IsDigit(*next))
+        {
+            next++;
+            digits++;
+        }
+    }
+    c->next = next; // As far as scanned, even if it is not a number
+    if (digits == 0)
+    {
+        SyntaxError(c);
+        return;
+    }
+    if (*next == 'E')
+    {
+        next++;
+        if (*next == '+' || *next == '-')
+        {
+            next++;
+        }
+        c->next = next;
+        if (!IsDigit(*next))
+        {
+            SyntaxError(c);
+            return;
+        }
+        while (IsDigit(*next))
+        {
+            next++;
+        }
+    }
+    c->next = next;
+    if (next - start >= NUMBER_SIZE)
+    {
+        SyntaxError(c);
+        return;
+    }
+    if (next - start == digits && digits <= WHOLE_DIGITS) // Whole, and short: no need for strtod()
+    {
+        while (start < next)
+        {
+            integer = integer * 10 + (*start++ - '0');
+        }
+        value = integer;
+    }
+    else
+    {
+        memcpy(text, start, next - start);
+        text[next - start] = '\0';
+        value = strtod(text, NULL);
+        if (value <= INT32_MAX && value == (int32_t)value) // e.g. 2.0 or 1E3
+        {
+            integer = (int32_t)value;
+        }
+        else
+        {
+            c->program->whole = 0;
+        }
+    }
+    step = AddStep(c, STEP_NUMBER, value);
+    if (step != NULL)
+    {
+        step->integer = integer;
+    }
+} // CompileNumber
+
+// factor := {+|-} (number | ANS)
+static void CompileFactor(Compiler *c)
+{
+    int negate = 0;
+
+    while (*c->next == '+' || *c->next == '-')
+    {
+        negate ^= (*c->next == '-');
+        c->next++;
+    }
+    if (*c->next == ANS_CHAR)
+    {
+        c->next++;
+        AddStep(c, STEP_ANS, 0.0);
+    }
+    else
+    {
+        CompileNumber(c);
+    }
+    if (negate)
+    {
+        AddStep(c, STEP_NEG, 0.0);
+    }
+} // CompileFactor
+
+// product := factor {(x|/) factor}
+static void CompileProduct(Compiler *c)
+{
+    char op;
+
+    CompileFactor(c);
+    while (*c->next == 'x' || *c->next == '/')
+    {
+        op = *c->next++;
+        CompileFactor(c);
+        AddStep(c, op == 'x' ? STEP_MUL : STEP_DIV, 0.0);
+    }
+} // CompileProduct
+
+// sum := product {(+|-) product}
+static void CompileSum(Compiler *c)
+{
+    char op;
+
+    CompileProduct(c);
+    while (*c->next == '+' || *c->next == '-')
+    {
+        op = *c->next++;
+        CompileProduct(c);
+        AddStep(c, op == '+' ? STEP_ADD : STEP_SUB, 0.0);
+    }
+} // CompileSum
+
+static int IsOperator(char c)
+{
+    return c == '+' || c == '-' || c == 'x' || c == '/';
+} // IsOperator
+
+int ExprUsesAns(const char *input)
+{
+    return IsOperator(input[0]) || strchr(input, ANS_CHAR) != NULL;
+} // ExprUsesAns
+
+int ExprCompile(const char *input, ExprProgram *program)
+{
+    Compiler compiler;
+    Compiler *c = &compiler;
+    char op;
+
+    c->program = program;
+    c->error = EXPR_OK;
+    c->next = input;
+    program->length = 0;
+    program->whole = 1; // Until a number which is not
+    program->last_op = 0;
+
+    if (IsOperator(*c->next)) // Continue from ANS: the first operand is ANS
+    {
+        AddStep(c, STEP_ANS, 0.0);
+        while (IsOperator(*c->next) && c->error == EXPR_OK)
+        {
+            // The same loops as CompileSum() and CompileProduct(), but
+            // with ANS as the left-hand side of the first operator
+            op = *c->next++;
+            if (op == 'x' || op == '/')
+            {
+                CompileFactor(c);
+                AddStep(c, op == 'x' ? STEP_MUL : STEP_DIV, 0.0);
+            }
+            else
+            {
+                CompileProduct(c);
+                AddStep(c, op == '+' ? STEP_ADD : STEP_SUB, 0.0);
+            }
+        }
+    }
+    else
+    {
+        CompileSum(c);
+    }
+    if (*c->next != '\0') // Something left over which does not fit
+    {
+        SyntaxError(c);
+    }
+    return c->error;
+} // ExprCompile
+
+int ExprApply(char op, double left, double right, double *result)
+{
+    double value;
+
+    switch (op)
+    {
+    case '+':
+        value = left + right;
+        break;
+    case '-':
+        value = left - right;
+        break;
+    case 'x':
+        value = left * right;
+        break;
+    default: // '/'
+        if (right == 0.0)
+        {
+            return EXPR_ERR_DIV_ZERO;
+        }
+        value = left / right;
+    }
+    if (value != value || value > DBL_MAX || value < -DBL_MAX) // NaN or infinite
+    {
+        return EXPR_ERR_RANGE;
+    }
+    *result = value;
+    return EXPR_OK;
+} // ExprApply
+
+int ExprEvaluateWhole(ExprProgram *program, double ans, double *result)
+{
+    int64_t stack[EXPR_MAX_STEPS];
+    int64_t left;
+    int64_t right;
+    int64_t value;
+    int64_t last_operand = 0;
+    char last_op = 0;
+    int depth = 0;
+    int i;
+    const ExprStep *step;
+
+    if (!program->whole)
+    {
+        return 0;
+    }
+    for (i = 0; i < program->length; i++)
+    {
+        step = &program->steps[i];
+        switch (step->op)
+        {
+        case STEP_NUMBER:
+            stack[depth++] = step->integer;
+            break;
+        case STEP_ANS:
+            // Tested first, as converting a value beyond an int64_t is undefined
+            if (!(ans >= -EXPR_WHOLE_LIMIT && ans <= EXPR_WHOLE_LIMIT) || (ans == 0.0 && signbit(ans)))
+            {
+                return 0;
+            }
+            value = (int64_t)ans;
+            if (value != ans)
+            {
+                return 0; // Not whole
+            }
+            stack[depth++] = value;
+            break;
+        case STEP_NEG:
+            if (stack[depth - 1] == 0)
+            {
+                return 0; // -0 in doubles
+            }
+            stack[depth - 1] = -stack[depth - 1];
+            break;
+        default: // Binary operation
+            depth--;
+            left = stack[depth - 1];
+            right = stack[depth];
+            switch (step->op)
+            {
+            case STEP_ADD:
+                value = left + right; // Both within EXPR_WHOLE_LIMIT, so it cannot overflow
+                break;
+            case STEP_SUB:
+                value = left - right;
+                break;
+            case STEP_MUL:
+                if (left < -WHOLE_FACTOR_MAX || left > WHOLE_FACTOR_MAX || right < -WHOLE_FACTOR_MAX || right > WHOLE_FACTOR_MAX)
+                {
+                    return 0; // The product might overflow
+                }
+                value = left * right;
+                break;
+            default: // STEP_DIV
+                if (right == 0 || left % right != 0)
+                {
+                    return 0; // ExprEvaluate() reports division by zero
+                }
+                value = left / right;
+            }
+            if (value < -EXPR_WHOLE_LIMIT || value > EXPR_WHOLE_LIMIT)
+            {
+                return 0;
+            }
+            if (value == 0 && (step->op == STEP_MUL || step->op == STEP_DIV) && (left < 0 || right < 0))
+            {
+                return 0; // -0 in doubles, e.g. 0x-5
+            }
+            stack[depth - 1] = value;
+            last_op = step_ops[step->op]; // The last one done is the one kept
+            last_operand = right;
+        }
+    }
+    program->last_op = last_op;
+    program->last_operand = (double)last_operand;
+    *result = (double)stack[0];
+    return 1;
+} // ExprEvaluateWhole
+
+int ExprEvaluate(ExprProgram *program, double ans, double *result)
+{
+    double stack[EXPR_MAX_STEPS];
+    int depth = 0;
+    int error;
+    int i;
+    const ExprStep *step;
+
+    if (ExprEvaluateWhole(program, ans, result))
+    {
+        return EXPR_OK; // Exact, and the same as below, without any double arithmetic
+    }
+    program->last_op = 0;
+    program->last_operand = 0.0;
+    for (i = 0; i < program->length; i++)
+    {
+        step = &program->steps[i];
+        switch (step->op)
+        {
+        case STEP_NUMBER:
+            stack[depth++] = step->value;
+            break;
+        case STEP_ANS:
+            stack[depth++] = ans;
+            break;
+        case STEP_NEG:
+            stack[depth - 1] = -stack[depth - 1];
+            break;
+        default: // Binary operation
+            depth--;
+            error = ExprApply(step_ops[step->op], stack[depth - 1], stack[depth], &stack[depth - 1]);
+            if (error != EXPR_OK)
+            {
+                return error;
+            }
+            program->last_op = step_ops[step->op]; // The last one done is the one kept
+            program->last_operand = stack[depth];
+        }
+    }
+    if (stack[0] > DBL_MAX || stack[0] < -DBL_MAX) // e.g. 1E999 typed on its own
+    {
+        return EXPR_ERR_RANGE;
+    }
+    *result = stack[0];
+    return EXPR_OK;
+} // ExprEvaluate
+
+// Print a whole number as %G would, if it is below WHOLE_FORMAT_MAX: all
+// its digits, with no point. Returns the length, or 0 if it is not such
+// a number (or -0, which %G prints as such).
+static int FormatWhole(double value, char *text)
+{
+    char digits[8];
+    int32_t whole;
+    int length = 0;
+    int count = 0;
+
+    if (!(value > -WHOLE_FORMAT_MAX && value < WHOLE_FORMAT_MAX) || (value == 0.0 && signbit(value)))
+    {
+        return 0;
+    }
+    whole = (int32_t)value;
+    if (whole != value)
+    {
+        return 0;
+    }
+    if (whole < 0)
+    {
+        text[length++] = '-';
+        whole = -whole;
+    }
+    do
+    {
+        digits[count++] = '0' + whole % 10;
+        whole /= 10;
+    } while (whole != 0);
+    while (count > 0)
+    {
+        text[length++] = digits[--count];
+    }
+    text[length] = '\0';
+    return length;
+} // FormatWhole
+
+int ExprFormat(double value, char *text, int text_size)
+{
+    char whole[EXPR_RESULT_SIZE];
+    int length = FormatWhole(value, whole);
+
+    if (length > 0 && length < text_size)
+    {
+        memcpy(text, whole, length + 1);
+        return 1;
+    }
+    // %G: scientific form when >= 1000000 or < 0.0001, six significant figures
+    return snprintf(text, text_size, "%G", value) < text_size;
+} // ExprFormat
+
+int ExprRepeat(const ExprProgram *program, double ans, double *result)
+{
+    if (program->last_op == 0) // Nothing to repeat
+    {
+        *result = ans;
+        return EXPR_OK;
+    }
+    return ExprApply(program->last_op, ans, program->last_operand, result);
+} // ExprRepeat
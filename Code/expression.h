@@ -0,0 +1,180 @@
+/*! \file expression.h
+ *
+ * The calculator's own expression compiler, used for entries which refer
+ * to the previous answer (ANS).
+ *
+ * CalculateAnswer() only sees the text typed, so the only way to reuse a
+ * result was to type it in again as printed by DisplayResult(), i.e. to
+ * six significant figures. Here an entry is instead compiled once into a
+ * short program (a list of steps in reverse Polish order), which is then
+ * evaluated with ANS standing for the binary \a answer itself, at full
+ * double precision.
+ *
+ * An entry uses ANS if:
+ * 	- it contains \a ANS_CHAR (Shift 4 on the keypad), or
+ * 	- it starts with an operator (+ - x /), which then continues from
+ * 		ANS: "x2" means "ANSx2". (So "-5" is ANS-5; a negative number
+ * 		on its own is typed as "0-5".)
+ *
+ * The grammar is the keypad's: numbers with an optional decimal point
+ * and exponent (e.g. 1.5E-3), + - x / with the usual precedence (x and /
+ * first, then left to right) and unary minus.
+ *
+ * Evaluating a program also records its last operation: the operator
+ * applied last and the value of its right-hand operand (e.g. + and 6
+ * for "5+3x2"). ExprRepeat() applies that to a new value without
+ * compiling anything, which is how = on its own repeats a calculation
+ * ("constant mode": 2, x3 = 6, = 18, = 54, ...).
+ *
+ * Most entries are whole numbers, and there is no hardware for double
+ * arithmetic (the FPU only does single precision), so each double
+ * operation is a call to a library routine. ExprEvaluate() therefore
+ * first tries ExprEvaluateWhole(), which works in int64_t, and only
+ * uses doubles if that gives up: on a number which is not whole, on a
+ * division with a remainder, or on a value beyond \a EXPR_WHOLE_LIMIT.
+ * Up to that limit doubles hold whole numbers exactly, so the result is
+ * the same either way, to the last bit (even the sign of a zero).
+ * ExprFormat() prints whole results with integer arithmetic as well.
+ *
+ * Nothing here keeps any state between calls, so it is reentrant: it is
+ * also the engine of the host library in host/calc_lib.h, which
+ * evaluates on many threads at once. It needs no hardware.
+ */
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <stdint.h>
+
+/*! Character for ANS in the input buffer (and on the display). */
+#define ANS_CHAR 'A'
+
+/*! Most steps in a compiled program. An entry of 16 characters, plus
+ * the implicit ANS, needs at most 17.
+ */
+#define EXPR_MAX_STEPS 24
+
+/*! Largest value, either way, which ExprEvaluateWhole() keeps: 2 to the
+ * power 53. Every whole number up to it is exact in a double. */
+#define EXPR_WHOLE_LIMIT 9007199254740992LL
+
+//! \name Error numbers
+//@{
+#define EXPR_OK 0           //!< No error
+#define EXPR_ERR_SYNTAX 1   //!< Not a valid expression
+#define EXPR_ERR_DIV_ZERO 2 //!< Division by zero
+#define EXPR_ERR_RANGE 3    //!< Result too large (or not a number)
+#define EXPR_ERR_TOO_LONG 4 //!< More than \a EXPR_MAX_STEPS steps
+//@}
+
+/*! Error messages for the error numbers above, one per display line. */
+extern const char *const expr_error_line1[];
+extern const char *const expr_error_line2[]; //!< \copydoc expr_error_line1
+
+/*! Size of the text of a result from ExprFormat(), including the
+ * trailing null: at most 13 characters, e.g. -1.23457E-100. */
+#define EXPR_RESULT_SIZE 14
+
+//! \name Step codes
+//! What each step of a program does, to a stack of values. (Only
+//! expression.c and host/expr_batch.c need to know.)
+//@{
+#define STEP_NUMBER 0 //!< Push value
+#define STEP_ANS 1    //!< Push ANS
+#define STEP_ADD 2    //!< Pop two, push the result
+#define STEP_SUB 3    //!< \copydoc STEP_ADD
+#define STEP_MUL 4    //!< \copydoc STEP_ADD
+#define STEP_DIV 5    //!< \copydoc STEP_ADD
+#define STEP_NEG 6    //!< Negate the top of the stack
+//@}
+
+/*! One step of a compiled program. */
+typedef struct
+{
+    unsigned char op; // What the step does: one of the STEP_ codes
+    int32_t integer;  // The same number, if whole (fits in the padding before value)
+    double value;     // The number pushed, for a number step
+} ExprStep;
+
+/*! A compiled expression. */
+typedef struct
+{
+    ExprStep steps[EXPR_MAX_STEPS];
+    int length;          // Number of steps
+    unsigned char whole; // 1 if every number is whole and in \a integer (so ExprEvaluateWhole() can try)
+    char last_op;        // Last operation evaluated (+ - x /), or 0 if none
+    double last_operand; // Its right-hand operand
+} ExprProgram;
+
+/*! \return 1 if the entry refers to ANS (see above), else 0.
+ *
+ * \param [in] input A C-format string, as typed.
+ */
+int ExprUsesAns( const char *input );
+
+/*! Compile an entry.
+ *
+ * \param [in] input A C-format string, as typed. A leading operator
+ * 		continues from ANS.
+ * \param [out] program The compiled program. Its last operation is
+ * 		cleared.
+ * \return EXPR_OK, EXPR_ERR_SYNTAX or EXPR_ERR_TOO_LONG.
+ */
+int ExprCompile( const char *input, ExprProgram *program );
+
+/*! Evaluate a compiled program and record its last operation.
+ *
+ * \param [in,out] program The program.
+ * \param [in] ans The value of ANS.
+ * \param [out] result The value. Only set if there was no error.
+ * \return EXPR_OK, EXPR_ERR_DIV_ZERO or EXPR_ERR_RANGE.
+ */
+int ExprEvaluate( ExprProgram *program, double ans, double *result );
+
+/*! Evaluate a compiled program in whole numbers, if it can be done
+ * exactly, and record its last operation as ExprEvaluate() does.
+ *
+ * \param [in,out] program The program.
+ * \param [in] ans The value of ANS.
+ * \param [out] result The value. Only set if it returns 1.
+ * \return 1 if evaluated, with the same result as ExprEvaluate(). 0 if
+ * 		ExprEvaluate() is needed: a number (or ANS) is not whole, a
+ * 		value goes beyond \a EXPR_WHOLE_LIMIT or would be -0, or a
+ * 		division has a remainder or is by zero.
+ */
+int ExprEvaluateWhole( ExprProgram *program, double ans, double *result );
+
+/*! Apply a program's last operation again (constant mode).
+ *
+ * \param [in] program A program which has been evaluated.
+ * \param [in] ans The value to apply it to (normally the last answer).
+ * \param [out] result \a ans with the operation applied, or \a ans itself
+ * 		if the program has no last operation. Only set if there was
+ * 		no error; may point to \a ans's own variable.
+ * \return EXPR_OK, EXPR_ERR_DIV_ZERO or EXPR_ERR_RANGE.
+ */
+int ExprRepeat( const ExprProgram *program, double ans, double *result );
+
+/*! Apply one operation, with the same checks as ExprEvaluate().
+ *
+ * \param [in] op The operator: + - x or /.
+ * \param [in] left Its left-hand operand.
+ * \param [in] right Its right-hand operand.
+ * \param [out] result The result. Only set if there was no error.
+ * \return EXPR_OK, EXPR_ERR_DIV_ZERO or EXPR_ERR_RANGE.
+ */
+int ExprApply( char op, double left, double right, double *result );
+
+/*! Write a result as the calculator shows it: %G, i.e. six significant
+ * figures, in scientific form when it is 1000000 or more or below 0.0001.
+ * Whole numbers below 1000000 are printed without the C library.
+ *
+ * \param [in] value The result.
+ * \param [out] text Its text.
+ * \param [in] text_size Size of \a text, including the trailing null;
+ * 		\a EXPR_RESULT_SIZE is always enough.
+ * \return 1 if it fitted, 0 if it was cut short.
+ */
+int ExprFormat( double value, char *text, int text_size );
+
+#endif // of #ifndef EXPRESSION_H
@@ -0,0 +1,55 @@
+/* gpio_pins.c
+ *
+ * The LCD and keypad signal functions: the only code which changes or
+ * reads their pins once the ports are set up. They reach the pins only
+ * through gpio_pins.h, so the same file runs on the host against the
+ * port model in host/gpio_host.c (see host/gpio_check.c). The rest of
+ * the drivers are in low_level_funcs_tiva.c.
+ *
+ * For documentation, see low_level_funcs_tiva.h and gpio_pins.h.
+ */
+
+#include "low_level_funcs_tiva.h"
+#include "gpio_pins.h"
+
+// ------------------------ Keyboard functions ------------------------
+
+void WriteKeyboardCol(unsigned char nibble)
+{
+    // Port D is columns
+    // When a nibble (e.g. 0010) is written, the column where the 1 is will be made high.
+    // When polling the columns, the row that is high (pressed) can be used to determine
+    // which button has been pressed
+    // By AND'ing Port D with the nibble
+
+    KEYPAD_SET_COLS(nibble); // Only PD0-3 change: one store to their masked address
+                             // Nibble chooses which row in mid level
+} // WriteKeyboardCol
+
+unsigned char ReadKeyboardRow(void)
+{
+    // Port E is rows
+    // When a button is pressed, and a column is made high by
+    // WriteKeyboardCol, the row of the row/column combination
+    // will be made high
+    // (due to pull down resistors - positive logic)
+    // By selectively making columns high, reading the row/column
+    // combination allows the pressed button to be deduced
+    // All this function has to do is read the value from the rows to
+    // check which row is high.
+
+    return KEYPAD_GET_ROWS(); // PE0-3 only: the masked address reads the other bits as 0
+} // ReadKeyboardRow
+
+// ------------------------ Display functions ------------------------
+
+void SendDisplayNibble(unsigned char byte, unsigned char instruction_or_data)
+{
+    // Each signal is one store to its masked address (see gpio_pins.h),
+    // so no other pin of port A or B is touched
+    LCD_SET_RS(instruction_or_data); // RS is 0 for an instruction, 1 for data
+    LCD_SET_DATA(byte & 0x0F);       // Set Port B[2:5] with the nibble
+    LCD_SET_EN(1);                   // Set EN
+    Wait_12_5_Nanosec(36);           //wait for 450 ns (36*12.5ns) i.e. Pulse line for 450 ns
+    LCD_SET_EN(0);                   // Clear EN
+} // SendDisplayNibble
@@ -0,0 +1,82 @@
+/*! \file gpio_pins.h
+ *
+ * The port pins used by the LCD and keypad, and access to them which
+ * leaves every other pin alone.
+ *
+ * A write to GPIO_PORTx_DATA_R sets all eight pins of the port, and
+ * setting one pin with |= or &= reads the port, changes the copy and
+ * writes it back, so an interrupt in between which changes another pin
+ * has its change undone. The Tiva avoids both: bits 9:2 of the address
+ * used to reach a port's data register are a mask, and a write changes
+ * only the pins whose mask bits are 1 (and a read returns 0 for the
+ * others). Each signal here is given the address whose mask is just its
+ * own pins, so changing it is a single store, with no read, which can
+ * never disturb anything else on the port (such as UART0 on PA0 and PA1).
+ *
+ * Bit-band aliases were not used: on a peripheral register the core
+ * turns a bit-band write into a locked read-modify-write of the whole
+ * register, which is slower and no safer than a masked store.
+ *
+ * Compiled with HOST_SIM defined, the accesses go to the model of the
+ * ports in host/gpio_host.c instead, which applies the masks as the
+ * hardware does (see host_sim.h).
+ */
+
+#ifndef GPIO_PINS_H
+#define GPIO_PINS_H
+
+//! \name Port base addresses
+//@{
+#define GPIO_PORTA_BASE 0x40004000UL
+#define GPIO_PORTB_BASE 0x40005000UL
+#define GPIO_PORTD_BASE 0x40007000UL
+#define GPIO_PORTE_BASE 0x40024000UL
+//@}
+
+/*! Address of the data register of the port at \a base, masked so that
+ * only the pins set in \a pins are read or written. */
+#define GPIO_DATA_MASKED(base, pins) ((base) + ((unsigned long)(pins) << 2))
+
+//! \name Pins, as bit masks within their port
+//@{
+#define LCD_RS_PIN 0x08      //!< PA3: RS (Register Select) of the LCD
+#define LCD_EN_PIN 0x04      //!< PA2: EN (ENable data transfer) of the LCD
+#define LCD_DATA_PINS 0x3C   //!< PB2 to PB5: DB4 to DB7 of the LCD
+#define LCD_DATA_SHIFT 2     //!< Position of DB4 in port B
+#define KEYPAD_COL_PINS 0x0F //!< PD0 to PD3: keypad column outputs
+#define KEYPAD_ROW_PINS 0x0F //!< PE0 to PE3: keypad row inputs (pulled down)
+//@}
+
+//! \name Masked data addresses of the signals
+//@{
+#define LCD_RS GPIO_DATA_MASKED(GPIO_PORTA_BASE, LCD_RS_PIN)
+#define LCD_EN GPIO_DATA_MASKED(GPIO_PORTA_BASE, LCD_EN_PIN)
+#define LCD_DATA GPIO_DATA_MASKED(GPIO_PORTB_BASE, LCD_DATA_PINS)
+#define KEYPAD_COLS GPIO_DATA_MASKED(GPIO_PORTD_BASE, KEYPAD_COL_PINS)
+#define KEYPAD_ROWS GPIO_DATA_MASKED(GPIO_PORTE_BASE, KEYPAD_ROW_PINS)
+//@}
+
+//! \name Raw access to a (masked) data address
+//@{
+#ifdef HOST_SIM
+#include "host_sim.h"
+#define GPIO_WRITE(address, value) GpioHostWrite((address), (value))
+#define GPIO_READ(address) GpioHostRead(address)
+#else
+#define GPIO_WRITE(address, value) (*((volatile unsigned long *)(address)) = (value))
+#define GPIO_READ(address) (*((volatile unsigned long *)(address)))
+#endif
+//@}
+
+//! \name Signal access
+//! Each is one store (or load) touching only the pins named.
+//@{
+#define LCD_SET_RS(level) GPIO_WRITE(LCD_RS, (level) ? 0xFF : 0)   //!< 1 for data, 0 for an instruction
+#define LCD_SET_EN(level) GPIO_WRITE(LCD_EN, (level) ? 0xFF : 0)
+#define LCD_SET_DATA(nibble) GPIO_WRITE(LCD_DATA, (unsigned long)(nibble) << LCD_DATA_SHIFT) //!< DB7-DB4 from bits 3-0
+#define KEYPAD_SET_COLS(cols) GPIO_WRITE(KEYPAD_COLS, (cols))      //!< Bit n high drives column n + 1
+#define KEYPAD_GET_COLS() ((unsigned char)GPIO_READ(KEYPAD_COLS)) //!< The columns as last set
+#define KEYPAD_GET_ROWS() ((unsigned char)GPIO_READ(KEYPAD_ROWS)) //!< Bit n high if a key in row n + 1 is down
+//@}
+
+#endif // of #ifndef GPIO_PINS_H
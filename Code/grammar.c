@@ -0,0 +1,219 @@
+/* grammar.c
+ *
+ * Keystroke-time syntax check of the input: the automaton's tables.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "grammar.h"
+#include "expression.h"
+#include "result_cache.h"
+
+// Kinds of character: the columns of the table
+#define K_BIT 0      // 0 1
+#define K_OCTAL 1    // 2 to 7
+#define K_DIGIT 2    // 8 9
+#define K_POINT 3    // .
+#define K_EXP 4      // E (also a hex digit)
+#define K_SIGN 5     // + -
+#define K_MULDIV 6   // x /
+#define K_ANS 7      // ANS_CHAR (also a hex digit)
+#define K_BANG 8     // ! (factorial)
+#define K_PERCENT 9  // % (remainder)
+#define K_HEX 10     // The other hex digits: B C D F
+#define K_BITOP 11   // & | ^ < > (see radix.h)
+#define K_NOT 12     // ~
+#define K_OTHER 13   // Anything else
+#define KIND_COUNT 14
+
+// States: the rows. The D_ states are decimal mode's, the I_ integer mode's,
+// and the H_, O_ and B_ hex, octal and binary modes'.
+#define D_START 0      // Nothing typed
+#define D_OPERAND 1    // After an operator or unary sign: a number or ANS must follow
+#define D_INT 2        // In the digits of a number
+#define D_POINT 3      // After a point with no digits before it
+#define D_FRAC 4       // After the point of a number with digits
+#define D_EXP 5        // After E
+#define D_EXP_SIGN 6   // After the sign of an exponent
+#define D_EXP_DIGITS 7 // In the digits of an exponent
+#define D_ANS 8        // After ANS
+#define I_START 9      // Nothing typed
+#define I_OPERAND 10   // After an operator or unary sign: a number must follow
+#define I_NUM 11       // In the digits of a number
+#define I_BANG 12      // After !
+#define H_START 13     // Nothing typed
+#define H_OPERAND 14   // After an operator or unary sign or ~: a number must follow
+#define H_NUM 15       // In the digits of a number
+#define O_START 16     // As H_START
+#define O_OPERAND 17   // As H_OPERAND
+#define O_NUM 18       // As H_NUM
+#define B_START 19     // As H_START
+#define B_OPERAND 20   // As H_OPERAND
+#define B_NUM 21       // As H_NUM
+#define BROKEN 22      // After a character which was not valid: only Rubout helps
+#define STATE_COUNT 23
+
+#define R GRAMMAR_REJECT
+
+static const unsigned char next_state[STATE_COUNT][KIND_COUNT] = {
+    //  0 1           2-7           8 9           .        E             + -         x /        ANS    !       %          B-D F  bit op     ~          other
+    {D_INT,        D_INT,        D_INT,        D_POINT, R,            D_OPERAND,  D_OPERAND, D_ANS, R,      R,         R,     R,         R,         R}, // D_START
+    {D_INT,        D_INT,        D_INT,        D_POINT, R,            D_OPERAND,  R,         D_ANS, R,      R,         R,     R,         R,         R}, // D_OPERAND
+    {D_INT,        D_INT,        D_INT,        D_FRAC,  D_EXP,        D_OPERAND,  D_OPERAND, R,     R,      R,         R,     R,         R,         R}, // D_INT
+    {D_FRAC,       D_FRAC,       D_FRAC,       R,       R,            R,          R,         R,     R,      R,         R,     R,         R,         R}, // D_POINT
+    {D_FRAC,       D_FRAC,       D_FRAC,       R,       D_EXP,        D_OPERAND,  D_OPERAND, R,     R,      R,         R,     R,         R,         R}, // D_FRAC
+    {D_EXP_DIGITS, D_EXP_DIGITS, D_EXP_DIGITS, R,       R,            D_EXP_SIGN, R,         R,     R,      R,         R,     R,         R,         R}, // D_EXP
+    {D_EXP_DIGITS, D_EXP_DIGITS, D_EXP_DIGITS, R,       R,            R,          R,         R,     R,      R,         R,     R,         R,         R}, // D_EXP_SIGN
+    {D_EXP_DIGITS, D_EXP_DIGITS, D_EXP_DIGITS, R,       R,            D_OPERAND,  D_OPERAND, R,     R,      R,         R,     R,         R,         R}, // D_EXP_DIGITS
+    {R,            R,            R,            R,       R,            D_OPERAND,  D_OPERAND, R,     R,      R,         R,     R,         R,         R}, // D_ANS
+    {I_NUM,        I_NUM,        I_NUM,        R,       R,            I_OPERAND,  R,         R,     R,      R,         R,     R,         R,         R}, // I_START
+    {I_NUM,        I_NUM,        I_NUM,        R,       R,            I_OPERAND,  R,         R,     R,      R,         R,     R,         R,         R}, // I_OPERAND
+    {I_NUM,        I_NUM,        I_NUM,        R,       R,            I_OPERAND,  I_OPERAND, R,     I_BANG, I_OPERAND, R,     R,         R,         R}, // I_NUM
+    {R,            R,            R,            R,       R,            I_OPERAND,  I_OPERAND, R,     I_BANG, I_OPERAND, R,     R,         R,         R}, // I_BANG
+    {H_NUM,        H_NUM,        H_NUM,        R,       H_NUM,        H_OPERAND,  R,         H_NUM, R,      R,         H_NUM, R,         H_OPERAND, R}, // H_START
+    {H_NUM,        H_NUM,        H_NUM,        R,       H_NUM,        H_OPERAND,  R,         H_NUM, R,      R,         H_NUM, R,         H_OPERAND, R}, // H_OPERAND
+    {H_NUM,        H_NUM,        H_NUM,        R,       H_NUM,        H_OPERAND,  H_OPERAND, H_NUM, R,      H_OPERAND, H_NUM, H_OPERAND, R,         R}, // H_NUM
+    {O_NUM,        O_NUM,        R,            R,       R,            O_OPERAND,  R,         R,     R,      R,         R,     R,         O_OPERAND, R}, // O_START
+    {O_NUM,        O_NUM,        R,            R,       R,            O_OPERAND,  R,         R,     R,      R,         R,     R,         O_OPERAND, R}, // O_OPERAND
+    {O_NUM,        O_NUM,        R,            R,       R,            O_OPERAND,  O_OPERAND, R,     R,      O_OPERAND, R,     O_OPERAND, R,         R}, // O_NUM
+    {B_NUM,        R,            R,            R,       R,            B_OPERAND,  R,         R,     R,      R,         R,     R,         B_OPERAND, R}, // B_START
+    {B_NUM,        R,            R,            R,       R,            B_OPERAND,  R,         R,     R,      R,         R,     R,         B_OPERAND, R}, // B_OPERAND
+    {B_NUM,        R,            R,            R,       R,            B_OPERAND,  B_OPERAND, R,     R,      B_OPERAND, R,     B_OPERAND, R,         R}, // B_NUM
+    {R,            R,            R,            R,       R,            R,          R,         R,     R,      R,         R,     R,         R,         R}, // BROKEN
+};
+
+// 1 where the entry may end: = on its own, or after a complete operand
+static const unsigned char complete[STATE_COUNT] = {1, 0, 1, 0, 1, 0, 0, 1, 1, 1, 0, 1, 1,
+                                                    1, 0, 1, 1, 0, 1, 1, 0, 1, 0};
+
+static const char *const hint[STATE_COUNT] = {
+    "Need a number",     // D_START
+    "Need a number",     // D_OPERAND
+    "Need an operator",  // D_INT
+    "Need a digit",      // D_POINT
+    "Need an operator",  // D_FRAC
+    "Need an exponent",  // D_EXP
+    "Need an exponent",  // D_EXP_SIGN
+    "Need an operator",  // D_EXP_DIGITS
+    "Need an operator",  // D_ANS
+    "Need an integer",   // I_START
+    "Need an integer",   // I_OPERAND
+    "Need an operator",  // I_NUM
+    "Need an operator",  // I_BANG
+    "Need hex digits",   // H_START
+    "Need hex digits",   // H_OPERAND
+    "Need an operator",  // H_NUM
+    "Need digits 0-7",   // O_START
+    "Need digits 0-7",   // O_OPERAND
+    "Need 0-7 or op",    // O_NUM
+    "Need 0 or 1",       // B_START
+    "Need 0 or 1",       // B_OPERAND
+    "Need 0, 1 or op",   // B_NUM
+    "Rub out to fix",    // BROKEN
+};
+
+static unsigned char Kind(char c)
+{
+    if (c >= '0' && c <= '1')
+    {
+        return K_BIT;
+    }
+    if (c >= '2' && c <= '7')
+    {
+        return K_OCTAL;
+    }
+    switch (c)
+    {
+    case '8':
+    case '9':
+        return K_DIGIT;
+    case '.':
+        return K_POINT;
+    case 'E':
+        return K_EXP;
+    case '+':
+    case '-':
+        return K_SIGN;
+    case 'x':
+    case '/':
+        return K_MULDIV;
+    case ANS_CHAR:
+        return K_ANS;
+    case '!':
+        return K_BANG;
+    case '%':
+        return K_PERCENT;
+    case 'B':
+    case 'C':
+    case 'D':
+    case 'F':
+        return K_HEX;
+    case '&':
+    case '|':
+    case '^':
+    case '<':
+    case '>':
+        return K_BITOP;
+    case '~':
+        return K_NOT;
+    default:
+        return K_OTHER;
+    }
+} // Kind
+
+unsigned char GrammarStart(int number_mode)
+{
+    switch (number_mode)
+    {
+    case NUMBER_MODE_INTEGER:
+        return I_START;
+    case NUMBER_MODE_HEX:
+        return H_START;
+    case NUMBER_MODE_OCTAL:
+        return O_START;
+    case NUMBER_MODE_BINARY:
+        return B_START;
+    default:
+        return D_START;
+    }
+} // GrammarStart
+
+unsigned char GrammarNext(unsigned char state, char c)
+{
+    if (state >= STATE_COUNT)
+    {
+        return R;
+    }
+    return next_state[state][Kind(c)];
+} // GrammarNext
+
+int GrammarComplete(unsigned char state)
+{
+    return state < STATE_COUNT && complete[state];
+} // GrammarComplete
+
+const char *GrammarHint(unsigned char state)
+{
+    return hint[(state < STATE_COUNT) ? state : BROKEN];
+} // GrammarHint
+
+int GrammarScan(const char *text, int number_mode, unsigned char *states)
+{
+    int accepted = -1; // Characters before the first rejected one, once there is one
+    int i;
+
+    states[0] = GrammarStart(number_mode);
+    for (i = 0; text[i] != '\0'; i++)
+    {
+        states[i + 1] = GrammarNext(states[i], text[i]);
+        if (states[i + 1] == R)
+        {
+            states[i + 1] = BROKEN;
+            if (accepted < 0)
+            {
+                accepted = i;
+            }
+        }
+    }
+    return (accepted < 0) ? i : accepted;
+} // GrammarScan
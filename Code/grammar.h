@@ -0,0 +1,66 @@
+/*! \file grammar.h
+ *
+ * Checks the input as it is typed, so that a key which cannot be part
+ * of a valid entry is refused at once, with a hint on line 2, rather
+ * than accepted and only rejected after End Input (*) by a two-second
+ * error message and a retype.
+ *
+ * The check is a finite automaton: one table row per state, one column
+ * per kind of character, giving the state after that character or
+ * GRAMMAR_REJECT. Each key costs one table lookup. There is a set of
+ * states for each number mode, matching what the evaluators accept:
+ * 	- Decimal (expression.c): numbers with an optional point and
+ * 		exponent (1.5E-3), ANS, + - x / and unary + and -, and a
+ * 		leading operator which continues from ANS.
+ * 	- Integer (bignum.c): whole numbers with ! after them, + - x / %
+ * 		and unary + and -.
+ * 	- Hex, octal and binary (radix.c): numbers in the base, + - x / %,
+ * 		the bitwise operators & | ^ < > and unary + - and ~. A and
+ * 		E are hex digits here, not ANS and an exponent.
+ * The entry is complete (may be ended with *) only in some states, e.g.
+ * not after an operator, a point on its own or an E without digits.
+ *
+ * Rubout needs no work from here: the caller keeps the state after each
+ * character typed, and goes back to the one before.
+ */
+
+#ifndef GRAMMAR_H
+#define GRAMMAR_H
+
+/*! Returned by GrammarNext() for a character which may not come next. */
+#define GRAMMAR_REJECT 0xFF
+
+/*! \param [in] number_mode One of the NUMBER_MODE_ constants (see result_cache.h).
+ * \return The state of an empty entry in that mode.
+ */
+unsigned char GrammarStart( int number_mode );
+
+/*! \param [in] state The state after the characters so far.
+ * \param [in] c The next character, as in the input buffer.
+ * \return The state after \a c, or GRAMMAR_REJECT if \a c may not come next.
+ */
+unsigned char GrammarNext( unsigned char state, char c );
+
+/*! \return 1 if an entry which has reached \a state is complete, else 0.
+ */
+int GrammarComplete( unsigned char state );
+
+/*! \return What may come next in \a state, as a hint of at most 16
+ * 		characters for the display, e.g. "Need a digit".
+ */
+const char *GrammarHint( unsigned char state );
+
+/*! Find the state after each character of a whole entry, e.g. after the
+ * number mode has changed.
+ *
+ * \param [in] text The entry, a C-format string.
+ * \param [in] number_mode One of the NUMBER_MODE_ constants.
+ * \param [out] states states[i] is the state after the first i characters,
+ * 		for i from 0 to strlen(text). From the first character
+ * 		rejected on, it is a state in which only Rubout helps.
+ * \return The number of characters accepted: strlen(text) if it is all
+ * 		valid so far.
+ */
+int GrammarScan( const char *text, int number_mode, unsigned char *states );
+
+#endif // of #ifndef GRAMMAR_H
@@ -1,10 +1,10 @@
 /* high_level_funcs.c
  *
- * Set of functions at high level (above mid level but below main)  
+ * Set of functions at high level (above mid level but below main)
  * for the 3662 calculator mini-project.
- * 
+ *
  * For documentation, see the corresponding .h file.
- * 
+ *
  * Dr Chris Trayner, 2019 September
  */
 
@@ -12,17 +12,182 @@
 #include "high_level_funcs.h"
 #include "mid_level_funcs.h"
 #include "low_level_funcs_tiva.h"
+#include "serial_calc.h"
+#include "lcd_mirror.h"
+#include "expression.h"
+#include "result_cache.h"
+#include "mem_guard.h"
+#include "clock_policy.h"
+#include "grammar.h"
+#include "macro.h"
+#include "radix.h"
+
+// States of the input state machine
+#define INPUT_TYPING 0       // Waiting for keys
+#define INPUT_SERIAL 1       // In serial mode until a key is pressed
+
+// States of the password state machine
+#define PW_ENTRY 0          // Waiting for the next digit
+#define PW_WRONG_PAUSE 1    // Short pause before "Incorrect PIN"
+#define PW_CORRECT_PAUSE 2  // Short pause before the calculator starts
+
+#define ERROR_OVERLAY_MILLISEC 2000     // How long an error message is shown, unless a key is pressed
+#define FULL_OVERLAY_MILLISEC 1000      // DISPLAY FULL
+#define PASSWORD_OVERLAY_MILLISEC 1000  // Each password message
+#define MODE_OVERLAY_MILLISEC 1000      // "Integer mode", "Hex mode", ...
+#define HINT_OVERLAY_MILLISEC 1000      // What may come next, after a key which may not, and macro messages
+#define SCROLL_STEP_MILLISEC 300        // Long results move one place this often
+#define SCROLL_PAUSE_MILLISEC 1500      // and pause this long at each end
+
+// Input state (kept between key events)
+static char *echo_buffer;      // The caller's input buffer
+static int echo_buffer_size;   // Its size, including the trailing null
+static int chars_on_display;   // By incrementing this each time a character is printed to the
+                               // display, this variable represents the number of characters on the display
+static int shifted;            // 1 when the Shift key (D) has just been pressed, 2 after it twice, 3 after Shift then C in a base mode
+static int input_state;        // One of the INPUT_ constants
+static int input_number_mode;  // One of the NUMBER_MODE_ constants (see result_cache.h)
+static unsigned char input_states[DISPLAY_WIDTH + 1]; // input_states[i] is the grammar state after i characters (see grammar.h)
+
+// Shown when Shift then 7 changes to each number mode
+static const char *const mode_names[] = {"Decimal mode    ", "Integer mode    ", "Hex mode        ",
+                                         "Octal mode      ", "Binary mode     "};
+
+// Scrolling of a result too long for the display
+static const char *scroll_text; // The result, or 0 if nothing is scrolling
+static int scroll_length;       // Its length
+static int scroll_pos;          // Index of the character shown at the left
+
+// Serial mode state
+static int serial_active = 0;          // 1 while SerialModeTask() should serve the port
+static int serial_mirror_was_on;       // Whether the LCD mirror was on before serial mode
+static unsigned long serial_lines;     // Lines dealt with when EVENT_UART_LINE was last posted
+static unsigned long shown_count;      // Count last displayed
+static int status_waiting;             // 1 when the status line needs redrawing once the LCD has caught up
+
+// Welcome screen state
+static int welcome_frame; // Animation frames shown so far
+
+// Password state
+static const char *pw_password;                               // The correct password
+static char password_buffer[GUARDED_SIZE(DISPLAY_WIDTH + 1)]; // Asterisks echoed for the digits entered
+static int pw_state;                                          // One of the PW_ constants
+static int pw_digit;                                          // Digit being entered (counting from 0)
+static int password_correct;                                  // 1 while the digits entered match the password (boolean)
+static int wrong_entry = 0;                                   // Variable to hold the number of incorrect entries
+
+static void StartSerialMode(void);
+static void ScrollBigResult(void);
+static void EndSerialMode(void);
+static void ShowSerialStatus(void);
+static void PrintHint(const char *hint);
 
 // ------------------------ Keyboard functions ---------------------
 
-void ReadAndEchoInput(char *input_buffer, int input_buffer_size)
+void StartReadAndEchoInput(char *input_buffer, int input_buffer_size)
 {
-    // INITIALISE VARIOUS VARIABLES USED WITHIN FUNCTION //
+    echo_buffer = input_buffer;
+    echo_buffer_size = input_buffer_size;
+    chars_on_display = 0; // Nothing typed yet
+    echo_buffer[0] = '\0'; // So * on its own gives an empty entry, not the last one again
+    shifted = 0;
+    input_state = INPUT_TYPING;
+    input_states[0] = GrammarStart(input_number_mode);
+
+    SetCursorPosition(1, 1); // Set print positon to top left of screen
+    SetCursorOnOff(1);       // Turn cursor on
+} // StartReadAndEchoInput
+
+void SaveInputState(InputSession *saved)
+{
+    // Nothing may have been typed yet (e.g. at the password prompt)
+    snprintf(saved->buffer, sizeof(saved->buffer), "%s", (echo_buffer != 0) ? echo_buffer : "");
+    saved->shifted = shifted;
+    saved->number_mode = input_number_mode;
+} // SaveInputState
 
-    int chars_on_display = 0; // Counter variable. By incrementing this each time a character is printed to the
-                              // display, this variable represents the number of characters on the display
+void ResumeReadAndEchoInput(char *input_buffer, int input_buffer_size, const InputSession *saved)
+{
+    StartReadAndEchoInput(input_buffer, input_buffer_size);
+    snprintf(echo_buffer, echo_buffer_size, "%.*s", DISPLAY_WIDTH, saved->buffer);
+    chars_on_display = strlen(echo_buffer); // Everything typed is on the display
+    shifted = saved->shifted;
+    input_number_mode = (saved->number_mode <= NUMBER_MODE_BINARY) ? saved->number_mode : NUMBER_MODE_DECIMAL;
+    GrammarScan(echo_buffer, input_number_mode, input_states);
+    if (scroll_text != 0) // The result it belonged to is gone
+    {
+        scroll_text = 0;
+        StopTimer(TIMER_SCREEN);
+    }
+} // ResumeReadAndEchoInput
 
-    int end_input = 0;            // Variable to check whether to leave function (boolean)
+void ContinueReadAndEchoInput(const char *hint)
+{
+    char line[DISPLAY_WIDTH + 1];
+
+    chars_on_display = strlen(echo_buffer); // Everything in the buffer is now typed
+    shifted = 0;
+    input_state = INPUT_TYPING;
+    GrammarScan(echo_buffer, input_number_mode, input_states);
+    snprintf(line, sizeof(line), "%-16s", echo_buffer); // Line 2 (e.g. the last result) is left as it is
+    PrintString(1, 1, line);
+    SetCursorPosition(1, chars_on_display + 1);
+    SetCursorOnOff(1);
+    if (hint != 0)
+    {
+        PrintHint(hint);
+    }
+} // ContinueReadAndEchoInput
+
+// Deal with a key pressed after Shift twice: the macro keys (see macro.h).
+// Returns INPUT_MACRO if a macro is to be replayed.
+static int HandleMacroKey(char key_pressed)
+{
+    const char *hint = 0; // What happened, for line 2
+
+    if (key_pressed == '*' && !MacroRecording())
+    {
+        MacroStartRecording();
+        hint = "Recording macro";
+    }
+    else if (key_pressed >= '1' && key_pressed <= '9' && MacroRecording())
+    {
+        hint = MacroSave(key_pressed - '0') ? "Macro saved" : "Nothing to save";
+    }
+    else if (key_pressed >= '1' && key_pressed <= '9')
+    {
+        if (MacroStartReplay(key_pressed - '0'))
+        {
+            return INPUT_MACRO; // Replayed by the caller, from what is typed so far
+        }
+        hint = "No such macro";
+    }
+    else if (key_pressed == 'A' && MacroRecording())
+    {
+        MacroMarkParameter(chars_on_display);
+        hint = "Next no. = param";
+    }
+    else if (key_pressed == '#' && MacroRecording())
+    {
+        MacroCancelRecording();
+        hint = "Macro dropped";
+    }
+    ClearScreen();                  // Clear the macro keys from line 2
+    PrintString(1, 1, echo_buffer); // Re-print buffer to display without modification
+    if (hint != 0)
+    {
+        PrintHint(hint);
+    }
+    return 0;
+} // HandleMacroKey
+
+// Deal with one key press while typing. This is the body of the old
+// ReadAndEchoInput() loop; the Shift key now just sets 'shifted' and
+// the next key press (a separate event) is then treated as shifted.
+// Returns 1 if the key ended the input.
+static int HandleInputKey(char key_pressed)
+{
+    int end_input = 0;            // Variable to check whether input is complete (boolean)
     int valid_output = 1;         // Variable to check whether to output character to display (boolean)
     int maths_constant_check = 0; // Variable to check which mathematical constant is required to be printed (boolean)
 
@@ -33,141 +198,188 @@ void ReadAndEchoInput(char *input_buffer, int input_buffer_size)
                               // (just to make the code easier read)
                               // Makes more sense to have a load of nulls everywhere than have a load of ('\0')'s
 
-    char key_pressed = null; // Variable to hold pressed button character (Initialised to null)
     char output_char = null; // Variable to hold character to be output to display (Initialised to null)
 
-    SetPrintPosition(1, 1); // Set print positon to top left of screen
-    TurnCursorOnOff(1);     // Turn cursor on
+    // CHECK FOR ANY INPUT //
+
+    // The switches below take in any valid button press and either set
+    // the output_char variable to the correct character, depending
+    // on what key is pressed, OR carry out specific instructions
+    // depending on what function is required (e.g. #, rubout).
+    // The press for 'D', shift, makes the next key use the switch
+    // of its own, allowing for different functions/keys to be selected.
 
-    // EXTERNAL (ALL INPUTS) LOOP //
-    // Enter loop to decipher what character to print
-    // to screen or what action to do (e.g. '*', 'D')
-    while (end_input == 0)
+    if (shifted == 2)
+    {
+        shifted = 0; // Shift twice only applies to one key
+        return HandleMacroKey(key_pressed);
+    }
+    else if (shifted == 3)
+    {
+        // Shift then C in hex, octal or binary mode: the operators (see radix.h)
+        shifted = 0;
+        output_char = (key_pressed >= '1' && key_pressed <= '7') ? "&|^~<>%"[key_pressed - '1'] : null;
+        valid_output = (output_char != null);
+    }
+    else if (shifted && RadixDigitBits(input_number_mode) != 0 && key_pressed >= '1' && key_pressed <= '6')
+    {
+        // Shift then 1 to 6 in a base mode: the hex digits A to F, in place of the constants
+        shifted = 0;
+        output_char = 'A' + (key_pressed - '1'); // The grammar refuses them in octal and binary
+    }
+    else if (shifted && RadixDigitBits(input_number_mode) != 0 && key_pressed == 'C')
     {
-        maths_constant_check = 0; // Initialise maths_constant check to 0 (don't print maths if normal char)
-        valid_output = 1;         // Initialise valid_output boolean to 1
+        // Shift then C in a base mode (where there is no exponent): the operators
+        PrintString(2, 1, "1&2|3^4~5<6>7%^^");
+        SetCursorPosition(1, chars_on_display + 1); // Put the cursor back at the next position
+        shifted = 3;
+        return 0;
+    }
+    else if (shifted)
+    {
+        // ====================== SHIFTED PRESSES =============================
+        shifted = 0; // Shift only applies to one key
 
-        // Stay in loop until a key_pressed is pressed
-        while (key_pressed == null)
-        //
+        // SHIFT FUNCTIONS //
+        switch (key_pressed)
         {
-            key_pressed = GetKeyboardChar(); //Read the button pressed
-            WaitMillisec(200);               // Short wait to stop double presses
-        }
+        case '*':             // End input (User needs to be able to end when shifted or not)
+            end_input = GrammarComplete(input_states[chars_on_display]) ? INPUT_END : 0; // Only a complete entry
+            valid_output = 0; // This is not a valid output, so, set value to 0
+            break;
+
+        case 'A':
+            output_char = 'x'; // Shifted character (valid_output already set to 1)
+            break;
+
+        case 'B':
+            output_char = '/'; // Shifted character (valid_output already set to 1)
+            break;
+
+        case 'C':
+            output_char = 'E'; // Shifted character (valid_output already set to 1)
+            break;
+
+        case 'D':
+            // Shift twice: the macro keys (see macro.h)
+            PrintString(2, 1, MacroRecording() ? "1-9=Save A=Var^^" : "1-9=Run *=Rec ^^");
+            SetCursorPosition(1, chars_on_display + 1); // Put the cursor back at the next position
+            shifted = 2;
+            return 0;
+            // SPECIAL CASES FOR MATHS CONSTANTS
+        case '1':
+            valid_output = 0;         // This is not a valid output, so, set value to 0
+            maths_constant_check = 1; // Sets the constant to PI
+            ClearScreen();            // Clear display
+            break;
 
-        // Leave loop and decipher what character to print
-        // to screen or what action to do (e.g. '*', 'D')
+        case '2':
+            valid_output = 0;         // This is not a valid output, so, set value to 0
+            maths_constant_check = 2; // Sets the constant to e
+            ClearScreen();            // Clear display
+            break;
 
-        end_input = 0; // Initalise the end_input variable to 0 (check for input)
+        case '3':
+            valid_output = 0;         // This is not a valid output, so, set value to 0
+            maths_constant_check = 3; // Sets the constant to root 2
+            ClearScreen();            // Clear display
+            break;
 
-        // CHECK FOR ANY INPUT //
+        case '4':
+            output_char = ANS_CHAR; // The previous answer, at full precision (see expression.h)
+            break;
 
-        // The switch below takes in any valid button press and either sets
-        // the output_char variable to the correct character, depending
-        // on what key is pressed, OR carries out specific instructions
-        // depending on what function is required (e.g. #, rubout).
-        // The press for 'D', shift opens up a switch of its own,
-        // allowing for different functions/keys to be selected.
+        case '5':
+        case '6':
+            if (key_pressed == '6' && input_number_mode == NUMBER_MODE_DECIMAL)
+            {
+                return INPUT_STATS; // Shifted 6 in decimal mode switches to statistics mode (see stats.h)
+            }
+            // Factorial and remainder, only for exact integers (see bignum.h)
+            valid_output = (input_number_mode == NUMBER_MODE_INTEGER);
+            output_char = (key_pressed == '5') ? '!' : '%';
+            break;
 
+        case '7':
+            // Shifted 7 goes on to the next number mode: decimal, exact integer, hex, octal, binary
+            input_number_mode = (input_number_mode == NUMBER_MODE_BINARY) ? NUMBER_MODE_DECIMAL : input_number_mode + 1;
+            OpenOverlay(MODE_OVERLAY_MILLISEC);
+            OverlayString(2, 1, mode_names[input_number_mode]);
+            GrammarScan(echo_buffer, input_number_mode, input_states); // What was typed may not suit the new mode
+            valid_output = 0; // This is not a valid output, so, set value to 0
+            break;
+
+        case '0':
+            // Shifted 0 hands the calculator over to the serial port until a key is pressed
+            StartSerialMode(); // The next key press ends it
+            return 0;
+
+        case '8':
+            // Shifted 8 switches to RPN entry (see rpn.h)
+            return INPUT_RPN;
+
+        case '9':
+            // Shifted 9 turns the serial terminal mirror of the display on or off
+            LcdMirrorEnable(!LcdMirrorIsEnabled());
+            valid_output = 0; // This is not a valid output, so, set value to 0
+            break;
+
+        case '#':
+            // Shifted version clears the entire input
+            ClearInputBuffer(echo_buffer, echo_buffer_size); // Clear input buffer
+            ClearScreen();                                   // Clear display
+            chars_on_display = 0;                            // Reset counter
+            MacroRubout(0);                                  // Any parameters marked are gone too
+            valid_output = 0;                                // This is not a valid output, so, set value to 0
+            break;
+
+        default:
+            // When valid_output set to zero, pressing a number (otherwise
+            // valid character, while shifted will not work. This could (validly in
+            // my opinion) be set to 1 meaning that a shifted number press will
+            // just return the number
+            valid_output = 0;
+            output_char = null; // Reset pressed button
+                                // If valid_output set to zero, output_char would need to be set to the character pressed
+        }
+        // ================= END OF SHIFTED FUNCTIONS ======================== //
+    }
+    else
+    {
         switch (key_pressed) // Choose what to do depending on what key is pressed
         {
-            // ====================== SHIFTED PRESSES =============================
-            // Wait for another input //
-        case 'D': // If D is pressed, wait for another input
+        case 'D': // If D is pressed, the next key is shifted
 
             if (chars_on_display == 0) // Counter has been reset and answer is displayed on
                 // This prevents a press of the shift button causing
                 // the last input string being displayed on the display
             {
-                ClearInputBuffer(input_buffer, input_buffer_size); // Clear input buffer
+                ClearInputBuffer(echo_buffer, echo_buffer_size); // Clear input buffer
             }
-            key_pressed = null;              // Reset key_pressed boolean so can check for new input
-            PrintString(1, 1, input_buffer); // Re-print last input_buffer to screen
-                                             // On the line below, when shifted, the custom shift
-                                             // functions are displayed, as well as the '^' character
-                                             // So that the user knows the shift button has been pressed
-
-            PrintString(2, 1, "1= 2=e 3=$2   ^");     // On the line below, print the text shift
-            SetPrintPosition(1, chars_on_display + 1); // Put the cursor back at the next position
-
-            // Wait for another input - Stay in loop until a key_pressed is pressed
-            while (key_pressed == null)
-            //
+            PrintString(1, 1, echo_buffer); // Re-print last input_buffer to screen
+                                            // On the line below, when shifted, the custom shift
+                                            // functions are displayed, as well as the '^' character
+                                            // So that the user knows the shift button has been pressed
+
+            if (input_number_mode == NUMBER_MODE_INTEGER) // On the line below, print the text shift
             {
-                key_pressed = GetKeyboardChar(); //Read the button pressed
-                WaitMillisec(200);               // Short wait to stop double presses
+                PrintString(2, 1, "5=! 6=% 7=hex  ^");
             }
-            // SHIFT FUNCTIONS //
-            switch (key_pressed)
+            else if (RadixDigitBits(input_number_mode) != 0)
             {
-            case '*':             // End input (User needs to be able to end when shifted or not)
-                end_input = 1;    // Set end input variable to 1
-                valid_output = 0; // This is not a valid output, so, set value to 0
-                break;
-
-            case 'A':
-                output_char = 'x'; // Shifted character (valid_output already set to 1)
-                break;
-
-            case 'B':
-                output_char = '/'; // Shifted character (valid_output already set to 1)
-                break;
-
-            case 'C':
-                output_char = 'E'; // Shifted character (valid_output already set to 1)
-                break;
-
-            case 'D':
-                key_pressed = null; // Reset pressed button
-                valid_output = 0;   // This is not a valid output, so, set value to 0
-                ClearDisplay();     // Clear display
-                break;
-                // SPECIAL CASES FOR MATHS CONSTANTS
-            case '1':
-                key_pressed = null;       // Reset pressed button
-                valid_output = 0;         // This is not a valid output, so, set value to 0
-                maths_constant_check = 1; // Sets the constant to PI
-                ClearDisplay();           // Clear display
-                break;
-
-            case '2':
-                key_pressed = null;       // Reset pressed button
-                valid_output = 0;         // This is not a valid output, so, set value to 0
-                maths_constant_check = 2; // Sets the constant to e
-                ClearDisplay();           // Clear display
-                break;
-
-            case '3':
-                key_pressed = null;       // Reset pressed button
-                valid_output = 0;         // This is not a valid output, so, set value to 0
-                maths_constant_check = 3; // Sets the constant to root 2
-                ClearDisplay();           // Clear display
-                break;
-
-            case '#':
-                // Shifted version clears the entire input
-                ClearInputBuffer(input_buffer, input_buffer_size); // Clear input buffer
-                ClearDisplay();                                    // Clear display
-                chars_on_display = 0;                              // Reset counter
-                valid_output = 0;                                  // This is not a valid output, so, set value to 0
-                key_pressed = null;                                // Reset pressed button
-                break;
-
-            default:
-                // When valid_output set to zero, pressing a number (otherwise
-                // valid character, while shifted will not work. This could (validly in
-                // my opinion) be set to 1 meaning that a shifted number press will
-                // just return the number
-                valid_output = 0;
-                output_char = null; // Reset pressed button
-                                    // If valid_output set to zero, output_char would need to be set to the character pressed
+                PrintString(2, 1, "1-6=A-F C=ops  ^");
             }
-            break;
-            // ================= END OF SHIFTED FUNCTIONS ======================== //
+            else
+            {
+                PrintString(2, 1, "1 2e 3$2 4Ans ^");
+            }
+            SetCursorPosition(1, chars_on_display + 1); // Put the cursor back at the next position
+            shifted = 1;                                // The next key press is shifted
+            return 0;
 
             //==================== NON-SHIFTED FUNCTIONS ========================//
         case '*':             // End input
-            end_input = 1;    // Set to 1 so leave loop and calculate_answer
+            end_input = GrammarComplete(input_states[chars_on_display]) ? INPUT_END : 0; // So the answer is calculated, if complete
             valid_output = 0; // // This is not a valid output, so, set value to 0
             break;
 
@@ -186,272 +398,505 @@ void ReadAndEchoInput(char *input_buffer, int input_buffer_size)
         case '#':
             if (chars_on_display >= 1) // If there is user input on the screen, rubout the last character
             {
-                input_buffer[chars_on_display - 1] = null; // Clears previous character
-                ClearDisplay();                            // Clear display
-                chars_on_display--;                        // Decrements chars_on_display to move back one space
+                echo_buffer[chars_on_display - 1] = null; // Clears previous character
+                ClearScreen();                            // Clear display
+                chars_on_display--;                       // Decrements chars_on_display to move back one space
+                MacroRubout(chars_on_display);            // Forget a parameter marked there
             }
             else
-            {                                                      // If chars_on_display = 0 (answer has been output to screen), clear buffer
-                ClearInputBuffer(input_buffer, input_buffer_size); // Clear buffer
-                ClearDisplay();                                    // Clear display
+            {                                                    // If chars_on_display = 0 (answer has been output to screen), clear buffer
+                ClearInputBuffer(echo_buffer, echo_buffer_size); // Clear buffer
+                ClearScreen();                                   // Clear display
             }
-            valid_output = 0;   // This is not a valid output, so, set value to 0
-            key_pressed = null; // Reset pressed button
+            valid_output = 0; // This is not a valid output, so, set value to 0
             break;
 
         default:
             output_char = key_pressed; // The number keys are printed exactly as they appear on the keyboard,
         }                              // No conversion is needed
+    }
 
-        // ================== PRINTING TO DISPLAY ======================= //
-        // The lines of code below print the relevant text to the display
-        // They check whether the character to be printed is a mathematical
-        // constant (printing a series of chars), whether the required output
-        // will fit on the screen and whether to output anything to the display at all
-        if (maths_constant_check) // If a mathematical constant is to be displayed
+    // ================== PRINTING TO DISPLAY ======================= //
+    // The lines of code below print the relevant text to the display
+    // They check whether the character to be printed is a mathematical
+    // constant (printing a series of chars), whether the required output
+    // will fit on the screen and whether to output anything to the display at all
+    if (maths_constant_check) // If a mathematical constant is to be displayed
+    {
+        // Print constant to screen and append to buffer
+        int accepted = chars_on_display; // Characters of the input and constant the grammar accepts
+        while (accepted < chars_on_display + 7 && accepted < DISPLAY_WIDTH &&
+               (input_states[accepted + 1] = GrammarNext(input_states[accepted], maths_constants[maths_constant_check - 1][accepted - chars_on_display])) != GRAMMAR_REJECT)
         {
-            // Print constant to screen and append to buffer
-            if (chars_on_display <= 9) // If there is enough room on the screen to display the 7 digit long constant (16-7 = 9)
-            {
-                ClearDisplay();              // Clear the display
-                for (int i = 0; i <= 6; i++) // Iterate 7 times, once for each character of the string
-                {
-                    ClearDisplay();                                                                // Clear display
-                    input_buffer[chars_on_display] = maths_constants[maths_constant_check - 1][i]; // Set current element to desired character
-                    chars_on_display++;                                                            // Increment counter // increase value for characters on the screen
-                }
-                input_buffer[chars_on_display + 1] = null; // Append trailling null
-                PrintString(1, 1, input_buffer);           // Print the buffer
-            }
-            else // If there isn't enough room to display the entire constant on the display
+            accepted++;
+        }
+
+        if (chars_on_display <= 9 && chars_on_display + 7 < echo_buffer_size && accepted < chars_on_display + 7) // Room for it, but it may not come next
+        {
+            PrintString(1, 1, echo_buffer); // Put the input back (the shift text was cleared)
+            PrintHint(GrammarHint(input_states[accepted]));
+        }
+        else if (chars_on_display <= 9 && chars_on_display + 7 < echo_buffer_size) // If there is enough room on the screen (16-7 = 9) and in the buffer for the 7 digit long constant
+        {
+            ClearScreen();               // Clear the display
+            for (int i = 0; i <= 6; i++) // Iterate 7 times, once for each character of the string
             {
-                PrintDisplayFull(input_buffer); // Print display full
+                echo_buffer[chars_on_display] = maths_constants[maths_constant_check - 1][i]; // Set current element to desired character
+                chars_on_display++;                                                           // Increment counter // increase value for characters on the screen
             }
+            echo_buffer[chars_on_display] = null; // Append trailling null (chars_on_display is already past the constant)
+            PrintString(1, 1, echo_buffer);       // Print the buffer
+        }
+        else // If there isn't enough room to display the entire constant on the display
+        {
+            PrintDisplayFull(); // Print display full
         }
+    }
 
-        else if (valid_output == 1 && chars_on_display < 16)
-        // If a valid character is to be printed to the screen AND the display isn't already full
+    else if (valid_output == 1 && chars_on_display < 16 && chars_on_display + 1 < echo_buffer_size &&
+             GrammarNext(input_states[chars_on_display], output_char) == GRAMMAR_REJECT)
+    // If the character may not come next: refuse it at once, rather than after *
+    {
+        ClearScreen();                  // Clear display
+        PrintString(1, 1, echo_buffer); // Re-print buffer to display without modification
+        PrintHint(GrammarHint(input_states[chars_on_display]));
+    }
+    else if (valid_output == 1 && chars_on_display < 16 && chars_on_display + 1 < echo_buffer_size)
+    // If a valid character is to be printed to the screen AND the display isn't already full
+    {
+        input_states[chars_on_display + 1] = GrammarNext(input_states[chars_on_display], output_char);
+        ClearScreen();                               // Clear display
+        echo_buffer[chars_on_display] = output_char; // Set current element to desired character
+        echo_buffer[chars_on_display + 1] = null;    // Append trailling null
+        PrintString(1, 1, echo_buffer);              // Print the buffer
+        chars_on_display++;                          // Increment character
+    }
+    else if (valid_output == 1)
+    // If a valid character is to be printed BUT the display (or the buffer) is full
+    {
+        if (chars_on_display == 16) // As chars_on_display increments everytime a character is added, chars_on_display == 16 represents, 16 characters on the screen
+        {
+            PrintDisplayFull(); // Print display full
+        }
+    }
+    else // If no character is to be printed to screen
+    {
+        ClearScreen();                  // Clear display
+        PrintString(1, 1, echo_buffer); // Re-print buffer to display without modification
+        if (key_pressed == '*' && end_input == 0)
         {
-            ClearDisplay();                               // Clear display
-            input_buffer[chars_on_display] = output_char; // Set current element to desired character
-            input_buffer[chars_on_display + 1] = null;    // Append trailling null
-            PrintString(1, 1, input_buffer);              // Print the buffer
-            chars_on_display++;                           // Increment character
+            PrintHint(GrammarHint(input_states[chars_on_display])); // Not complete yet
         }
-        else if (valid_output == 1 && chars_on_display >= 16)
-        // If a valid character is to be printed BUT the display is full
+    }
+    if (end_input == INPUT_END && !MacroRecordEntry(echo_buffer, input_number_mode)) // If a macro is being recorded
+    {
+        PrintHint("Macro too long");
+    }
+    return end_input;
+} // HandleInputKey
+
+int ReadAndEchoInputEvent(const Event *event)
+{
+    switch (input_state)
+    {
+    case INPUT_TYPING:
+        if (event->type == EVENT_KEY)
         {
-            if (chars_on_display == 16) // As chars_on_display increments everytime a character is added, chars_on_display == 16 represents, 16 characters on the screen
+            if (scroll_text != 0) // Typing takes over the display
             {
-                PrintDisplayFull(input_buffer); // Print display full
+                scroll_text = 0;
+                StopTimer(TIMER_SCREEN);
             }
+            return HandleInputKey(event->data);
+        }
+        if (event->type == EVENT_TIMER && event->data == TIMER_SCREEN && scroll_text != 0)
+        {
+            ScrollBigResult();
+        }
+        break;
+
+    case INPUT_SERIAL:
+        if (event->type == EVENT_KEY)
+        {
+            EndSerialMode(); // Any key ends serial mode, and is not used as input
         }
-        else // If no character is to be printed to screen
+        else if (event->type == EVENT_UART_LINE || event->type == EVENT_LCD_FLUSH)
         {
-            ClearDisplay();                  // Clear display
-            PrintString(1, 1, input_buffer); // Re-print buffer to display without modification
+            ShowSerialStatus();
         }
-        key_pressed = null; // // Reset pressed button
+        break;
     }
-} // ReadAndEchoInput
+    return 0;
+} // ReadAndEchoInputEvent
 
 // ------------------------ Display functions ------------------------
 
 void DisplayResult(double answer)
 {
-    TurnCursorOnOff(0); // Turn cursor off
-    ClearDisplay();     // Clear display
-
-    char converted[] = "";            // Declare empty string
-    sprintf(converted, "%G", answer); // convert double to string in standard form
-                                      // "%G" produces a number in scientific form when >= 1000000 or < 0.0001
-                                      // I deem this produce a suitable output
-    PrintString(2, 1, converted);     // Print the converted string to display on line 2
+    SetCursorOnOff(0);  // Turn cursor off
+    ClearScreen();      // Clear display
+
+    char converted[EXPR_RESULT_SIZE];                   // At most 13 characters, e.g. -1.23457E-100
+    ExprFormat(answer, converted, sizeof(converted));   // convert double to string in standard form
+                                                        // "%G" produces a number in scientific form when >= 1000000 or < 0.0001
+                                                        // I deem this produce a suitable output
+    PrintString(2, 1, converted);                       // Print the converted string to display on line 2
 } // DisplayResult
 
+// Show the next part of a long result on line 2
+static void ScrollBigResult(void)
+{
+    char line[DISPLAY_WIDTH + 1];
+
+    if (scroll_pos + DISPLAY_WIDTH >= scroll_length) // Shown the end: pause, then back to the start
+    {
+        scroll_pos = 0;
+        StartTimer(TIMER_SCREEN, SCROLL_PAUSE_MILLISEC);
+    }
+    else
+    {
+        scroll_pos++;
+        StartTimer(TIMER_SCREEN, (scroll_pos + DISPLAY_WIDTH == scroll_length) ? SCROLL_PAUSE_MILLISEC : SCROLL_STEP_MILLISEC);
+    }
+    sprintf(line, "%-16.16s", scroll_text + scroll_pos);
+    PrintString(2, 1, line);
+    SetCursorPosition(1, chars_on_display + 1); // Put the cursor back where typing will go
+} // ScrollBigResult
+
+// Show a result on line 2, scrolling through it if it is too long.
+// Returns 1 if it scrolls, when line 1 is the caller's to fill.
+static int StartResult(const char *digits)
+{
+    int length = strlen(digits);
+
+    SetCursorOnOff(0);
+    ClearScreen();
+    scroll_text = 0;
+    StopTimer(TIMER_SCREEN);
+    PrintString(2, 1, digits); // As DisplayResult(), clipped to the first 16 if longer
+    if (length <= DISPLAY_WIDTH)
+    {
+        return 0;
+    }
+    scroll_text = digits;
+    scroll_length = length;
+    scroll_pos = 0;
+    StartTimer(TIMER_SCREEN, SCROLL_PAUSE_MILLISEC);
+    return 1;
+} // StartResult
+
+void DisplayBigResult(const char *digits)
+{
+    char line[DISPLAY_WIDTH + 1];
+    char exponent[13]; // "E" and any int, e.g. "E-2147483648"
+    int sign = (digits[0] == '-');
+    int kept; // Digits after the point in the scientific form
+
+    if (StartResult(digits))
+    {
+        // Line 1: the first digits, in scientific form (truncated, not rounded)
+        snprintf(exponent, sizeof(exponent), "E%d", (int)strlen(digits) - sign - 1);
+        kept = DISPLAY_WIDTH - sign - 2 - strlen(exponent); // Room left after sign, first digit and point
+        sprintf(line, "%.*s%c.%.*s%s", sign, digits, digits[sign], kept, digits + sign + 1, exponent);
+        PrintString(1, 1, line);
+    }
+} // DisplayBigResult
+
+void DisplayRadixResult(const char *digits, const char *hex)
+{
+    char line[DISPLAY_WIDTH + 1];
+
+    if (StartResult(digits))
+    {
+        // Line 1: the same value in hex, which always fits, marked h if there is room
+        snprintf(line, sizeof(line), (strlen(hex) < DISPLAY_WIDTH) ? "%sh" : "%s", hex);
+        PrintString(1, 1, line);
+    }
+} // DisplayRadixResult
+
+int GetInputNumberMode(void)
+{
+    return input_number_mode;
+} // GetInputNumberMode
+
 void DisplayErrorMessage(const char *error_message_line1,
                          const char *error_message_line2)
 {
-    ClearDisplay(); // Clear display
-    if (strlen(error_message_line1) <= 17 && strlen(error_message_line2) <= 17 && error_message_line1 != 0 && error_message_line2 != 0)
+    char line[DISPLAY_WIDTH + 1]; // One line of the message, padded to cover the whole line
+
+    if (error_message_line1 != 0 && error_message_line2 != 0 && strlen(error_message_line1) <= 17 && strlen(error_message_line2) <= 17)
     // Check if the length of the error messages (including the trailling null) will fit on the display
     {
-        PrintString(1, 1, error_message_line1); // Print first line of error on line 1
-        PrintString(2, 1, error_message_line2); // Print second line of error on line 2
-        TurnCursorOnOff(0);                     // Turn cursor off
-        WaitSec(2);                             // Wait for two seconds (to read error), function from low level
-        ClearDisplay();                         // Clear display
+        OpenOverlay(ERROR_OVERLAY_MILLISEC); // Two seconds (to read error), or until a key is pressed
+        sprintf(line, "%-16.16s", error_message_line1);
+        OverlayString(1, 1, line); // Print first line of error on line 1
+        sprintf(line, "%-16.16s", error_message_line2);
+        OverlayString(2, 1, line); // Print second line of error on line 2
     }
 } // DisplayErrorMessage
 
 // ------------- CUSTOM FUNCTIONS ----------- //
-void WelcomeScreen()
+
+// Up to version 2.0 the welcome screen then waited for input to advance
+// ("Press any key" / "to calculate"). Now, the password check acts as
+// the intermediary between starting the device and using the calculator.
+// It makes no sense to have two barriers to using the calculator
+// The welcome screen now simply serves as a fun animation (and hopefully a demonstration
+// of good programming skill)
+void StartWelcomeScreen()
 {
-    WaitMillisec(50);         // Short wait
-    const char null = ('\0'); // Variable to hold value for null
-    char key_pressed = null;  // Reset pressed button
-
-    for (int i = 1; i <= 4; i++) // Loop a set number of times for animation
-    {
-        TurnCursorOnOff(0); // Make sure the cursor is off
-        ClearDisplay();     // Clear the display
-
-        PrintString(1, i + 2, " Kamal's ");    // Print text to display (moving from left to right)
-        PrintString(2, 5 - i, " Calculator "); // Print text to display (moving from right to left)
-        WaitMillisec(150);                       // Short wait between movements to convey motion
-    }
-    WaitMillisec(200); // Another wait at the end of the animation
-    WaitMillisec(200); // Another wait at the end of the animation
-    WaitMillisec(200); // Another wait at the end of the animation
-    ClearDisplay();    // Clear the display
-
-    // With if(1), the function waits until input from the user to advance to next funtion
-    // In Version 2.0 (before the password functionality), this made more sense
-    // Now, the CheckPassword() function acts as the intermediary between starting the device
-    // and using the calculator.
-    // It makes no sense to have two barriers to using the calculator
-    // WelcomeScreen() now simply serves as a fun animation (and hopefully a demonstration
-    // of good programming skill)
-#if 0
-    PrintString(1, 1, "Press any key"); // Print text to display
-    PrintString(2, 1, "to calculate");  // Print text to display
-		
-
-    // wait for input
-    while (key_pressed == null) // While there is no key pressed
-    //
-    {
-        key_pressed = GetKeyboardChar(); //Read the button pressed
-        WaitMillisec(200);               // Short wait to stop double presses
-    }
-#endif
-}
+    welcome_frame = 0;
+    StartTimer(TIMER_SCREEN, 50); // Short wait
+} // StartWelcomeScreen
+
+int WelcomeScreenEvent(const Event *event)
+{
+    if (event->type == EVENT_KEY || (event->type == EVENT_TIMER && event->data == TIMER_SCREEN && welcome_frame == 4))
+    // A key skips the rest of the animation, otherwise it ends when the end has been shown for long enough
+    {
+        StopTimer(TIMER_SCREEN);
+        ClearScreen(); // Clear the display
+        return 1;
+    }
+    if (event->type != EVENT_TIMER || event->data != TIMER_SCREEN)
+    {
+        return 0;
+    }
+
+    welcome_frame++;    // Next frame of the animation
+    SetCursorOnOff(0);  // Make sure the cursor is off
+    ClearScreen();      // Clear the display
+
+    PrintString(1, welcome_frame + 2, " Kamal's ");    // Print text to display (moving from left to right)
+    PrintString(2, 5 - welcome_frame, " Calculator "); // Print text to display (moving from right to left)
+
+    if (welcome_frame < 4)
+    {
+        StartTimer(TIMER_SCREEN, 150); // Short wait between movements to convey motion
+    }
+    else
+    {
+        StartTimer(TIMER_SCREEN, 150 + 600); // Another wait at the end of the animation
+    }
+    return 0;
+} // WelcomeScreenEvent
+
+static void StartSerialMode()
+{
+    serial_mirror_was_on = LcdMirrorIsEnabled(); // The mirror would mix with the replies
+    LcdMirrorEnable(0);
+
+    SetCursorOnOff(0);                    // Turn cursor off
+    ClearScreen();                        // Clear display
+    PrintString(1, 1, "SERIAL MODE");     // Print text to display
+    PrintString(2, 1, "Any key to exit"); // Print text to display
+    SerialCalcInit();                     // Start a new batch
+    ClockPolicyHold();                    // Lines are evaluated as they arrive, not as events
+
+    serial_lines = 0;
+    shown_count = 1; // 1 so that the first update always happens
+    status_waiting = 0;
+    serial_active = 1;
+    input_state = INPUT_SERIAL;
+} // StartSerialMode
+
+static void EndSerialMode()
+{
+    serial_active = 0;
+    ClockPolicyRelease();
+    if (serial_mirror_was_on)
+    {
+        LcdMirrorEnable(1); // Redraws the terminal
+    }
+    SetCursorOnOff(1);              // Turn cursor back on
+    ClearScreen();                  // Clear display
+    PrintString(1, 1, echo_buffer); // Re-print buffer to display without modification
+    input_state = INPUT_TYPING;
+} // EndSerialMode
+
+static void ShowSerialStatus()
+{
+    SerialCalcStats stats; // Counters from the serial module
+    char status[17];       // Line 2 text: count and rate
+
+    // Redraw only once the LCD has caught up with the last redraw, so a
+    // fast stream of lines costs one redraw per LCD update, not one per line
+    if (DisplayFlushPending())
+    {
+        status_waiting = 1;
+        return;
+    }
+    SerialCalcGetStats(&stats);
+    if (stats.expressions == shown_count)
+    {
+        status_waiting = 0;
+        return;
+    }
+    snprintf(status, sizeof(status), "%lu %lu/s", stats.expressions, SerialCalcRate()); // Cut to the line if the counts are huge
+    ClearScreen();                    // Clear display
+    PrintString(1, 1, "SERIAL MODE"); // Re-print heading
+    PrintString(2, 1, status);        // Print count and throughput
+    shown_count = stats.expressions;
+    status_waiting = 0;
+} // ShowSerialStatus
+
+void SerialModeTask()
+{
+    SerialCalcStats stats; // Counters from the serial module
+
+    if (!serial_active)
+    {
+        return;
+    }
+    SerialCalcPoll(); // At most one line or reply
+    SerialCalcGetStats(&stats);
+    if (stats.expressions + stats.rejected != serial_lines)
+    {
+        serial_lines = stats.expressions + stats.rejected;
+        PostEvent(EVENT_UART_LINE, 0);
+    }
+} // SerialModeTask
 
 void ClearInputBuffer(char *input_buffer, int input_buffer_size)
 {
     const char null = ('\0');                    // Variable to hold value for null
-    for (int i = 0; i <= input_buffer_size; i++) // For as long as the input buffer is
+    for (int i = 0; i < input_buffer_size; i++) // For as long as the input buffer is
     {
         input_buffer[i] = null; // Clear the bit in the current position
     }
-    ClearDisplay(); // Clear the display
+    ClearScreen(); // Clear the display
 }
 
-void PrintDisplayFull(char *input_buffer)
+void PrintDisplayFull()
 {
-
-    PrintString(2, 1, "DISPLAY FULL"); // Print full display on the screen
-    TurnCursorOnOff(0);                // Turn cursor off
-    WaitSec(1);                        // Display text on screen for 1 second
-    TurnCursorOnOff(1);                // Turn cursor back on
-    ClearDisplay();                    // Clear display
-    PrintString(1, 1, input_buffer);   // Re-print buffer to display without modification
+    OpenOverlay(FULL_OVERLAY_MILLISEC);  // Display text on screen for 1 second, or until a key is pressed
+    OverlayString(2, 1, "DISPLAY FULL"); // Print full display on the screen
 }
 
-void CheckPassword(char *password, char *input_buffer)
+// Show a hint on line 2, e.g. what may come next after a key which may not
+static void PrintHint(const char *hint)
 {
-    TurnCursorOnOff(0); // Ensure cursor is off
-
-    const char null = ('\0');               // Variable to hold value for null
-    char key_pressed = null;                // Variable to hold the current pressed character
-    char *output_char;                      // = null; // Variable to hold character to be output to display
-    int password_correct = 0;               // Variable (boolean) to hold the value of whether the password is being entered correctly or not
-    char password_buffer[] = "";            // Empty buffer to hold the value of the password
-    int password_length = strlen(password); // Variable to hold the length of the password
-    int wrong_entry = 0;                    // Variable to hold the number of incorrect entries
-
-    ClearDisplay();         // Clear the display
-    SetPrintPosition(1, 1); // Set print position to top left of display
-
-    // Stay in loop while the password has not been entered correctly
-    while (!password_correct)
-    {
-        key_pressed = null;                    // Clear pressed key
-        ClearInputBuffer(password_buffer, 16); // Clear the entire password buffer
-        ClearInputBuffer(input_buffer, 16);    // Clear the entire password buffer
-        password_correct = 1;                  // Set password to correct (true)
-                                               // By starting with the value 1, the loop below can simply check whether the
-                                               // input matches the password by checking each character entered against
-                                               // the corresponding character of the password
-                                               // If the input character doesn't match the password's character,
-                                               // the password MUST be incorrect
-
-        for (int i = 0; i <= password_length - 1; i++)
-        {
+    char line[DISPLAY_WIDTH + 1];
 
-            PrintString(1, 1, "Enter Password:"); // Print string to display
-                                                  // Wait for input
-            while (key_pressed == null)
-            {
-                SetPrintPosition(2, i + 1);      // Put the cursor at the next position (number being put in)
-                TurnCursorOnOff(1);              // Turn cursor on
-                key_pressed = GetKeyboardChar(); //Read the button pressed
-                WaitMillisec(200);
-                TurnCursorOnOff(0); // Turn cursor off (only show cursor when inputting data)
-                // Short wait to stop double presses
-
-                if (key_pressed == '#')
-                // If the pressed key is #, display a hint
-                {
-                    TurnCursorOnOff(0);          // Turn Cursor off
-                    ClearDisplay();              // Clear the display
-                    PrintString(1, 1, "HINT: "); // Print text to display
-                    PrintString(1, 6, password); // Print the password to the display at the end of the text
-                    WaitSec(1);                  // Small wait so user can read hint
-
-                    ClearDisplay();                       // Clear the display
-                    PrintString(1, 1, "Enter Password:"); // Re-print original text to display
-                    PrintString(2, 1, password_buffer);   // Re-print the password buffer to display
-                    key_pressed = null;                   // Reset the key_pressed variable
-                }
-            }
+    snprintf(line, sizeof(line), "%-16s", hint); // Padded, to cover the whole line
+    OpenOverlay(HINT_OVERLAY_MILLISEC);
+    OverlayString(2, 1, line);
+} // PrintHint
 
-            if (key_pressed != password[i])
-            // If any key has been entered incorrectly
-            {
-                password_correct = 0; // Password is incorrect
-            }
+// Start (or restart) entering the password
+static void StartPasswordAttempt()
+{
+    ClearInputBuffer(password_buffer, DISPLAY_WIDTH + 1); // Clear the entire password buffer
+    password_correct = 1;                                 // Set password to correct (true)
+                                                          // By starting with the value 1, each key can simply be checked
+                                                          // against the corresponding character of the password
+                                                          // If the input character doesn't match the password's character,
+                                                          // the password MUST be incorrect
+    pw_digit = 0;
+    pw_state = PW_ENTRY;
+
+    PrintString(1, 1, "Enter Password:"); // Print string to display
+    SetCursorPosition(2, 1);              // Put the cursor at the next position (number being put in)
+    SetCursorOnOff(1);                    // Turn cursor on
+} // StartPasswordAttempt
+
+void StartCheckPassword(const char *password)
+{
+    pw_password = password;
+    MemGuardRegister(password_buffer, DISPLAY_WIDTH + 1, "password_buffer");
+    SetCursorOnOff(0); // Ensure cursor is off
+    StartPasswordAttempt();
+} // StartCheckPassword
 
-            password_buffer[i] = '*';           // Print an asterisk
-            password_buffer[i + 1] = null;      // Append trailing null
-            PrintString(2, 1, password_buffer); // Print the buffer
+int CheckPasswordEvent(const Event *event)
+{
+    int password_length = strlen(pw_password); // Variable to hold the length of the password
+    char hint[DISPLAY_WIDTH + 1];              // The hint, padded to cover the whole line
 
-            key_pressed = null; // Reset pressed key variable (stay in loop)
+    if (event->type == EVENT_KEY)
+    {
+        if (pw_state != PW_ENTRY)
+        {
+            return 0; // Keys are ignored during the short pauses
         }
-
-        if (password_correct == 0) // If the password has been entered incorrectly
+        if (event->data == '#')
+        // If the pressed key is #, display a hint over "Enter Password:"
         {
-            WaitMillisec(200); // Short wait so screen doesn't jump to next thing too suddenly
-            ClearDisplay();    // Clear the display
-
-            PrintString(1, 1, "Incorrect PIN"); // Print text to display
+            OpenOverlay(PASSWORD_OVERLAY_MILLISEC); // Small wait so user can read hint
+            sprintf(hint, "HINT: %-10.10s", pw_password);
+            OverlayString(1, 1, hint); // Print the password to the display at the end of the text
+            return 0;
+        }
+        SetCursorOnOff(0); // Turn cursor off (only show cursor when inputting data)
 
-            WaitSec(1); // Short wait to allow user to read text
+        if (event->data != pw_password[pw_digit])
+        // If any key has been entered incorrectly
+        {
+            password_correct = 0; // Password is incorrect
+        }
 
-            // The two if statements below mean that every 4 incorrect entries (starting
-            // starting with the 2nd), causes the user to be prompted to press '#'
-            // for the hint. This stops a new user
-            // Of course, this isn't optimally secure, so a real life interperetation of
-            // this wouldn't include this functionality, or at least the hint wouldn't
-            // be the password itself.
+        if (pw_digit < DISPLAY_WIDTH) // A longer password is checked but not all echoed
+        {
+            password_buffer[pw_digit] = '*';      // Print an asterisk
+            password_buffer[pw_digit + 1] = '\0'; // Append trailing null
+            PrintString(2, 1, password_buffer);   // Print the buffer
+        }
+        pw_digit++;
 
-            wrong_entry++;        // Increment wrong entry counter
-            if (wrong_entry == 2) // Every second input
-            {
-                ClearDisplay();                        // Clear the display
-                PrintString(2, 1, "Press # for hint"); // Print text to display
-                                                       // Prompt user to check the hint
-                WaitSec(1);                            // Short wait to allow user to read
-            }
-            if (wrong_entry > 3) // Every 4 wrong entries...
-            {
-                wrong_entry = 0; // ...Reset counter back to 0
-            }
+        if (pw_digit < password_length)
+        {
+            SetCursorPosition(2, (pw_digit < DISPLAY_WIDTH) ? pw_digit + 1 : DISPLAY_WIDTH); // Put the cursor at the next position
+            SetCursorOnOff(1);                  // Turn cursor on
+        }
+        else if (password_correct == 0) // If the password has been entered incorrectly
+        {
+            pw_state = PW_WRONG_PAUSE;
+            StartTimer(TIMER_SCREEN, 200); // Short wait so screen doesn't jump to next thing too suddenly
         }
         else // If the password is correct
         {
-            WaitMillisec(200); // Short wait so screen doesn't jump to next thing too suddenly
+            pw_state = PW_CORRECT_PAUSE;
+            StartTimer(TIMER_SCREEN, 200); // Short wait so screen doesn't jump to next thing too suddenly
+        }
+        return 0;
+    }
+
+    if (event->type != EVENT_TIMER || event->data != TIMER_SCREEN)
+    {
+        return 0;
+    }
+    switch (pw_state)
+    {
+    case PW_WRONG_PAUSE:
+        // The next attempt starts at once, under a message saying the last
+        // was wrong. Typing the first digit dismisses the message.
+        StartPasswordAttempt();
+        OpenOverlay(PASSWORD_OVERLAY_MILLISEC); // Short wait to allow user to read text
+        OverlayString(1, 1, "Incorrect PIN   "); // Print text to display
+
+        // The two if statements below mean that every 4 incorrect entries (starting
+        // starting with the 2nd), causes the user to be prompted to press '#'
+        // for the hint. This stops a new user
+        // Of course, this isn't optimally secure, so a real life interperetation of
+        // this wouldn't include this functionality, or at least the hint wouldn't
+        // be the password itself.
+
+        wrong_entry++;        // Increment wrong entry counter
+        if (wrong_entry == 2) // Every second input
+        {
+            OverlayString(2, 1, "Press # for hint"); // Print text to display
+                                                     // Prompt user to check the hint
+            StartTimer(TIMER_OVERLAY, 2 * PASSWORD_OVERLAY_MILLISEC); // Two messages to read
         }
+        if (wrong_entry > 3) // Every 4 wrong entries...
+        {
+            wrong_entry = 0; // ...Reset counter back to 0
+        }
+        break;
+
+    case PW_CORRECT_PAUSE:
+        ClearScreen(); // Clear the display
+        return 1;
     }
-    ClearDisplay(); // Clear the display
-}
\ No newline at end of file
+    return 0;
+} // CheckPasswordEvent
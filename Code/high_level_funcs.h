@@ -39,11 +39,26 @@
 #ifndef HIGH_LEVEL_FUNCS_H
 #define HIGH_LEVEL_FUNCS_H
 
+#include "scheduler.h"
+#include "low_level_funcs_tiva.h" // For DISPLAY_WIDTH
+
+/* Event-driven operation
+ * 
+ * None of these functions waits. Each screen or dialogue is a state 
+ * machine: a Start...() function draws it and sets it going, and the 
+ * matching ...Event() function is given every event from the scheduler 
+ * (see scheduler.h) while it is active. The ...Event() function returns 
+ * 1 when the screen or dialogue has finished, otherwise 0. Where the old 
+ * functions waited (e.g. two seconds for an error message) they now start 
+ * TIMER_SCREEN and carry on when its EVENT_TIMER arrives, so the times the 
+ * user sees are unchanged but the program is free meanwhile.
+ */
+
 //! \name Keyboard functions
 //@{
 
 /*! Read characters from the keyboard and echo them on the LCD. Assemble them 
- * into a C-format string and return this when the End Input (*) key is pressed.
+ * into a C-format string, which is complete when the End Input (*) key is pressed.
  * 
  * \param [out] input_buffer An array of \a char to be used as a C-format 
  * 		string. When the function exits, this must contain the 
@@ -51,7 +66,10 @@
  * \param [in] input_buffer_size The size of \a input_buffer, including 
  * 		the trailing null.
  * 
- * The function must wait until the first key is pressed. Until then,  
+ * This function starts the input. Each event must then be passed to 
+ * ReadAndEchoInputEvent() until it returns 1.
+ * 
+ * The input must wait until the first key is pressed. Until then,  
  * the user may be reading the previous answer. Once the first key is pressed, 
  * the display line used to echo input is cleared and a cursor is placed 
  * at the start of that line. (You might decide to clear the other line too.)
@@ -102,11 +120,64 @@
  * 	| B		|		-		| /	|
  * 	| C		| 	.		| E	|
  * D is the shift key, End Input is asterik (*) and Rubout is hash (#).
+ * Shift then 4 enters \a ANS_CHAR, which stands for the previous answer 
+ * (see expression.h). Shift twice gives the macro keys (see macro.h).
+ * In hex, octal and binary modes Shift then 1 to 6 enters the hex digits 
+ * A to F, and Shift then C gives the operators (see radix.h): then 1 to 7 
+ * enter & | ^ ~ < > and %.
  * 
  * This function will presumably call functions in \a mid_level_funcs to 
  * read each character from keyboard and print it to the LCD.
  */
-void ReadAndEchoInput( char *input_buffer, int input_buffer_size );
+void StartReadAndEchoInput( char *input_buffer, int input_buffer_size );
+
+//! \name Values returned by ReadAndEchoInputEvent()
+//@{
+#define INPUT_END 1 //!< End Input (*) pressed: \a input_buffer is complete
+#define INPUT_RPN 2 //!< Shift then 8 pressed: the user wants RPN mode (see rpn.h)
+#define INPUT_MACRO 3 //!< Shift twice then 1 to 9 pressed: the macro has been started with MacroStartReplay(), to go on from \a input_buffer (see macro.h)
+#define INPUT_STATS 4 //!< Shift then 6 pressed in decimal mode: the user wants statistics mode (see stats.h)
+//@}
+
+/*! Deal with one event during input started by StartReadAndEchoInput().
+ * 
+ * \param [in] event The event.
+ * \return INPUT_END, INPUT_RPN, INPUT_MACRO or INPUT_STATS if the input has 
+ * 		finished (see above), else 0.
+ */
+int ReadAndEchoInputEvent( const Event *event );
+
+/*! The state of the input, for saving a session (see power_down.h). */
+typedef struct
+{
+    char buffer[DISPLAY_WIDTH + 1]; //!< What has been typed, as a C-format string
+    unsigned char shifted;          //!< 1 if Shift has just been pressed, 2 if twice (see macro.h), 3 after Shift then C in a base mode
+    unsigned char number_mode;      //!< As GetInputNumberMode()
+} InputSession;
+
+/*! Copy the state of the input started by StartReadAndEchoInput().
+ * 
+ * \param [out] saved The state.
+ */
+void SaveInputState( InputSession *saved );
+
+/*! As StartReadAndEchoInput(), but carry on from a saved state, as if 
+ * the keys had just been typed. The screen is not redrawn.
+ * 
+ * \param [out] input_buffer As StartReadAndEchoInput().
+ * \param [in] input_buffer_size As StartReadAndEchoInput().
+ * \param [in] saved State saved by SaveInputState().
+ */
+void ResumeReadAndEchoInput( char *input_buffer, int input_buffer_size, 
+			     const InputSession *saved );
+
+/*! Carry on with the input after the caller has added to \a input_buffer 
+ * (e.g. a macro being replayed, see macro.h), as if it had all been 
+ * typed. Line 1 is redrawn; line 2 is left as it is.
+ * 
+ * \param [in] hint Shown on line 2 for a moment (as a hint), or NULL.
+ */
+void ContinueReadAndEchoInput( const char *hint );
 
 //@}
 // End of Keyboard functions
@@ -175,6 +246,12 @@ void DisplayResult( double answer );
  * 16 characters long, they should start at the left-hand end of the line. 
  * No cursor should be displayed.
  * 
+ * The message is an overlay (see mid_level_funcs.h): it is drawn over 
+ * the screen for two seconds, or until a key is pressed, and then the 
+ * screen underneath comes back. A key which dismisses it is used as 
+ * input as usual, so the user need not wait to start the next calculation. 
+ * The caller must pass each event to OverlayEvent() first.
+ * 
  * These error messages are provided by the system and you may assume they 
  * are no more than 17 chars long (including the trailing null). I wrote 
  * these messages, and I never make misstakes.
@@ -190,9 +267,55 @@ void DisplayErrorMessage( const char *error_message_line1,
 // End of Display functions
 
 // =============== CUSTOM FUNCTIONS =========== //
+/* ! Display an exact integer result (see bignum.h), given as a string of digits.
+ *
+ * If it fits, it is shown on line 2 as DisplayResult() would. If not, line 1
+ * shows it in scientific form, truncated to 16 characters, and line 2 scrolls
+ * through all its digits until a key is pressed (using TIMER_SCREEN, so
+ * events must go on being passed to ReadAndEchoInputEvent()). The string
+ * must stay unchanged until then.
+*/
+void DisplayBigResult(const char *digits);
+
+/* ! Display a result in hex, octal or binary (see radix.h), given as a string of digits.
+ *
+ * As DisplayBigResult(), except that if it is too long to fit (e.g. 64
+ * binary digits), line 1 shows it in hex, given as \a hex, instead.
+*/
+void DisplayRadixResult(const char *digits, const char *hex);
+
+/* ! Number mode chosen with Shift then 7 while entering input, which goes
+ * round them in turn: NUMBER_MODE_DECIMAL (the usual), NUMBER_MODE_INTEGER
+ * (exact integers, see bignum.h), then NUMBER_MODE_HEX, NUMBER_MODE_OCTAL
+ * and NUMBER_MODE_BINARY (see radix.h). In integer mode Shift then 5
+ * enters ! (factorial) and Shift then 6 enters % (remainder); in decimal
+ * mode Shift then 6 switches to statistics mode (see stats.h).
+*/
+int GetInputNumberMode(void);
+
 /* ! Displays a short welcome screen to the user (and in versions < 3 waits for input to advance)
+ *
+ * Pass each event to WelcomeScreenEvent() until it returns 1 (after about 1.3 s,
+ * or at once if a key is pressed; the key may then be used as input).
 */
-void WelcomeScreen();
+void StartWelcomeScreen();
+int WelcomeScreenEvent(const Event *event);
+
+/* ! Serial batch-evaluation mode (Shift then 0 while entering input)
+ *
+ * Evaluates expressions sent over the serial port (see serial_calc.h)
+ * until any key is pressed. Line 2 shows how many have been evaluated
+ * and the throughput. The key which ends the mode is not used as input.
+ *
+ * The mode is part of the input state machine; SerialModeTask() is the
+ * background task which serves the port while it is on, and must be
+ * added to the scheduler.
+ */
+void SerialModeTask();
+
+// Shift then 9 while entering input turns the serial mirror of the
+// display on or off (see lcd_mirror.h). The mirror is turned off in
+// serial mode, where it would mix with the replies.
 
 /* ! Clear the input_buffer
  *
@@ -205,22 +328,20 @@ void ClearInputBuffer(char *input_buffer,int input_buffer_size);
 
 /* ! Prints the text 'DISPLAY FULL' to display
  *
- * \param [in] *input_buffer Uses the input buffer
- * to print text to the screen.
+ * Shown as an overlay on line 2 for 1 second, or until a key is pressed
+ * (e.g. Rubout, which is then dealt with as usual).
  */
-void PrintDisplayFull(char *input_buffer);
+void PrintDisplayFull();
 
-/* ! Prints the text 'DISPLAY FULL' to display
- *
- * \param [in] *input_buffer The input buffer so that the
- * text can be redisplayed after display full has been printed
- */
-void CheckPassword(char *password, char *input_buffer);
-/* ! Prints the text 'DISPLAY FULL' to display
+/* ! Ask for the password until it is entered correctly
  *
  * \param [in] *password A string containing the correct password
  * Stored in main.c currently (a future revision would have
  * password stored in flash)
- * \param [in] *input_buffer The input buffer so that the
+ * Pass each event to CheckPasswordEvent() until it returns 1.
+ * The hint and "Incorrect PIN" are overlays, so the user can carry on
+ * typing without waiting for them.
  */
+void StartCheckPassword(const char *password);
+int CheckPasswordEvent(const Event *event);
 #endif // of #ifndef HIGH_LEVEL_FUNCS_H
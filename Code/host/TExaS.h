@@ -0,0 +1,14 @@
+/* TExaS.h
+ *
+ * Host stand-in for the course's TExaS.h, which is not in this tree. On
+ * the Tiva it brings in the grader and the C library headers the firmware
+ * leans on; on the host only the latter are needed.
+ */
+
+#ifndef TEXAS_H
+#define TEXAS_H
+
+#include <stdio.h>
+#include <string.h>
+
+#endif // of #ifndef TEXAS_H
@@ -0,0 +1,980 @@
+/* accuracy_oracle.c
+ *
+ * Host (Linux) program which checks the calculator's answers against
+ * reference arithmetic: how far each result is from the exact value of
+ * the entry, in units in the last place (ULPs), and whether the digits
+ * DisplayResult() puts on the LCD are the exact value's, correctly
+ * rounded.
+ *
+ * Entries are compiled by expression.c as on the calculator. Each number
+ * in them is then read again from its decimal text into a 113-bit
+ * __float128, and the program evaluated in that precision with a bound
+ * on its own error kept alongside every value (each rounding error is
+ * found exactly, with TwoSum and Dekker's product). An entry whose reference
+ * could be out by more than REFERENCE_RESOLUTION of an ULP (e.g.
+ * 1E40+1-1E40, which cancels more than 113 bits) is counted as
+ * unresolved rather than scored. The text shown is read off the LCD
+ * copy in host/display_host.c after the real DisplayResult() and
+ * display flush.
+ *
+ * The entries are random (the default), adversarial (-a: cancellation,
+ * results on a rounding boundary of the 6 digits shown, the points where
+ * %G changes form, decimals with no exact binary value, overflow and
+ * subnormals), or read from a file, one per line. They are at most 16
+ * characters, as typed, unless -l says otherwise. ANS is a random value
+ * for generated entries and 0.1 for those from a file.
+ *
+ * -m chooses the arithmetic checked:
+ * 	double	ExprEvaluate(), as the calculator does it (the default)
+ * 	float	The same programs in single precision, which the Tiva's FPU
+ * 		does in hardware, with strtof() for the numbers. ULPs are
+ * 		then single-precision ones.
+ * Both paths (compile, evaluate and format), and the reference, are
+ * timed. -u and -d set an accuracy budget: the program exits with 1 if
+ * any scored error is over -u ULPs or more than -d entries are shown
+ * wrong, so a faster mode can be accepted on measured figures.
+ *
+ * Usage:
+ *     accuracy_oracle [-n count] [-s seed] [-a] [-l length] [-m double|float]
+ *                     [-u ulps] [-d count] [file]
+ *
+ * The host's strtod() and printf() are correctly rounded; the Keil
+ * library's may not be, so this checks expression.c and the formatting
+ * rule, not the Tiva's C library.
+ *
+ * Build, from the Code directory:
+ *     gcc -O2 -DHOST_SIM -I. -Ihost -o accuracy_oracle host/accuracy_oracle.c \
+ *         high_level_funcs.c mid_level_funcs.c rpn.c bignum.c expression.c grammar.c macro.c radix.c \
+ *         result_cache.c scheduler.c ring_buffer.c lcd_mirror.c serial_calc.c UART.c event_trace.c \
+ *         mem_guard.c clock_policy.c host/uart_host.c host/stack_host.c host/clock_host.c \
+ *         host/display_host.c host/calculate_answer_host.c host/flash_host.c
+ */
+
+#include "high_level_funcs.h"
+#include "mid_level_funcs.h"
+#include "low_level_funcs_tiva.h"
+#include "expression.h"
+#include "host_sim.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ENTRY_SIZE 40               // Longest entry read or generated, including the trailing null
+#define DEFAULT_COUNT 200000
+#define DEFAULT_LENGTH 16           // Longest entry typed on the keypad
+#define FILE_ANS 0.1                // ANS for entries read from a file
+#define REFERENCE_RESOLUTION 0.01   // The reference must be known to within this many ULPs to score an entry
+#define BUCKETS 24                  // ULP histogram: 0, then up to 1/2, 1, 2, 4 ... 2^20, more
+#define WORST_KEPT 10               // Examples listed of each kind of failure
+#define SHOWN_SIZE (DISPLAY_WIDTH + 1)
+
+typedef __float128 Quad;
+
+// A reference value and a bound on how far it is from the exact one
+typedef struct
+{
+    Quad value;
+    Quad error;
+} Reference;
+
+typedef struct
+{
+    char text[ENTRY_SIZE];
+    double ans;
+} Entry;
+
+// What evaluating an entry came to
+#define OUTCOME_VALUE 0 // A number (as opposed to one of expression.c's errors)
+
+// The arithmetic being checked
+typedef struct
+{
+    const char *name;
+    int mantissa_bits; // Including the hidden bit
+    int min_exponent;  // Of the smallest subnormal's ULP
+    double max;        // Largest finite value
+    int (*evaluate)(const ExprProgram *program, const char *text, double ans, double *result);
+} Mode;
+
+typedef struct
+{
+    char text[ENTRY_SIZE];
+    double ans;
+    double ulps;
+    char shown[SHOWN_SIZE];
+    char expected[SHOWN_SIZE];
+} Example;
+
+static const Quad quad_epsilon = 1.0 / 10384593717069655257060992658440192.0; // 2^-113, the unit roundoff
+
+static unsigned long long random_state = 88172645463325252ULL;
+
+static Entry *entries;
+static int entry_count = 0;
+static const Mode *mode;
+
+// Results
+static long invalid = 0;                // Entries which do not compile
+static long outcome_mismatches = 0;     // Error where the exact value is a number, or the other way round
+static long scored = 0;                 // Entries with a ULP error
+static long unresolved = 0;             // Entries whose reference is not precise enough
+static long histogram[BUCKETS];
+static double max_ulps = 0.0;
+static long shown_wrong = 0;            // Digits on the LCD which are not the exact value's
+static long shown_boundary = 0;         // The exact value is too close to a rounding boundary to say
+static Example worst;                   // The largest ULP error
+static Example mismatch_examples[WORST_KEPT];
+static Example wrong_examples[WORST_KEPT];
+
+// ------------------------ Helpers ------------------------
+
+static unsigned long Random(void) // xorshift64
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return (unsigned long)(random_state >> 11);
+}
+
+static int RandomBelow(int n)
+{
+    return (int)(Random() % n);
+}
+
+static Quad QuadAbs(Quad x)
+{
+    return (x < 0) ? -x : x;
+}
+
+static double CpuMicrosec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+static int IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Find the next number in an entry, as CompileNumber() scans it: the
+// numbers appear in a compiled program in the order they are written.
+// Returns a pointer just past it, with its text copied to number.
+static const char *NextNumber(const char *text, char *number)
+{
+    const char *start;
+
+    while (*text != '\0' && !IsDigit(*text) && *text != '.')
+    {
+        text++;
+    }
+    start = text;
+    while (IsDigit(*text) || *text == '.')
+    {
+        text++;
+    }
+    if (*text == 'E')
+    {
+        text++;
+        if (*text == '+' || *text == '-')
+        {
+            text++;
+        }
+        while (IsDigit(*text))
+        {
+            text++;
+        }
+    }
+    memcpy(number, start, text - start);
+    number[text - start] = '\0';
+    return text;
+}
+
+// ------------------------ Reference arithmetic ------------------------
+
+// The rounding error of a + b, exactly (Knuth's TwoSum)
+static Quad SumError(Quad a, Quad b, Quad sum)
+{
+    Quad b_part = sum - a;
+    Quad a_part = sum - b_part;
+
+    return (a - a_part) + (b - b_part);
+}
+
+// Split a into two halves of 56 bits, whose products are exact (Veltkamp)
+static void Split(Quad a, Quad *high, Quad *low)
+{
+    Quad c = a * 144115188075855873.0Q; // 2^57 + 1
+
+    *high = c - (c - a);
+    *low = a - *high;
+}
+
+// The rounding error of a x b, exactly (Dekker's TwoProduct)
+static Quad ProductError(Quad a, Quad b, Quad product)
+{
+    Quad a_high, a_low, b_high, b_low;
+
+    Split(a, &a_high, &a_low);
+    Split(b, &b_high, &b_low);
+    return ((a_high * b_high - product) + a_high * b_low + a_low * b_high) + a_low * b_low;
+}
+
+static Reference ReferenceAdd(Reference a, Reference b)
+{
+    Reference sum;
+
+    sum.value = a.value + b.value;
+    sum.error = a.error + b.error + QuadAbs(SumError(a.value, b.value, sum.value));
+    return sum;
+}
+
+static Reference ReferenceMultiply(Reference a, Reference b)
+{
+    Reference product;
+
+    product.value = a.value * b.value;
+    product.error = QuadAbs(a.value) * b.error + QuadAbs(b.value) * a.error + a.error * b.error;
+    if (product.value - product.value == 0) // Finite: the exact rounding error can be found
+    {
+        product.error += QuadAbs(ProductError(a.value, b.value, product.value));
+    }
+    return product;
+}
+
+// b must not be zero
+static Reference ReferenceDivide(Reference a, Reference b)
+{
+    Reference quotient;
+
+    quotient.value = a.value / b.value;
+    if (QuadAbs(b.value) <= b.error) // Might be zero: unknowable
+    {
+        quotient.error = 1e4000Q;
+    }
+    else
+    {
+        quotient.error = (a.error + QuadAbs(quotient.value) * b.error) / (QuadAbs(b.value) - b.error) +
+                         QuadAbs(quotient.value) * quad_epsilon;
+    }
+    return quotient;
+}
+
+// A number's decimal text. Every digit is kept: a number is at most
+// NUMBER_SIZE - 1 characters, so its digits fit in 113 bits exactly.
+static Reference ReferenceNumber(const char *text)
+{
+    Reference number;
+    Reference power;
+    Reference square;
+    int exponent = 0;
+    int exponent_sign = 1;
+    int fraction = 0;
+    int point = 0;
+    int n;
+
+    number.value = 0;
+    number.error = 0;
+    for (; IsDigit(*text) || *text == '.'; text++)
+    {
+        if (*text == '.')
+        {
+            point = 1;
+        }
+        else
+        {
+            number.value = number.value * 10 + (*text - '0');
+            fraction += point;
+        }
+    }
+    if (*text == 'E')
+    {
+        text++;
+        if (*text == '+' || *text == '-')
+        {
+            exponent_sign = (*text == '-') ? -1 : 1;
+            text++;
+        }
+        for (; IsDigit(*text); text++)
+        {
+            if (exponent < 100000)
+            {
+                exponent = exponent * 10 + (*text - '0');
+            }
+        }
+    }
+    exponent = exponent_sign * exponent - fraction;
+    if (number.value == 0)
+    {
+        return number;
+    }
+    if (exponent < -4900 || exponent > 4900) // Beyond __float128: far beyond double
+    {
+        number.value = (exponent < 0) ? 0 : 1e4900Q;
+        number.error = (exponent < 0) ? 1e-4900Q : 1e4900Q;
+        return number;
+    }
+
+    // 10^|exponent| by squaring
+    power.value = 1;
+    power.error = 0;
+    square.value = 10;
+    square.error = 0;
+    for (n = (exponent < 0) ? -exponent : exponent; n > 0; n >>= 1)
+    {
+        if (n & 1)
+        {
+            power = ReferenceMultiply(power, square);
+        }
+        if (n > 1)
+        {
+            square = ReferenceMultiply(square, square);
+        }
+    }
+    return (exponent < 0) ? ReferenceDivide(number, power) : ReferenceMultiply(number, power);
+}
+
+// Evaluate a compiled program in reference arithmetic. Returns
+// OUTCOME_VALUE, or EXPR_ERR_DIV_ZERO for an exact division by zero.
+static int ReferenceEvaluate(const ExprProgram *program, const char *text, double ans, Reference *result)
+{
+    Reference stack[EXPR_MAX_STEPS];
+    char number[ENTRY_SIZE];
+    int depth = 0;
+    int i;
+
+    for (i = 0; i < program->length; i++)
+    {
+        switch (program->steps[i].op)
+        {
+        case STEP_NUMBER:
+            text = NextNumber(text, number);
+            stack[depth++] = ReferenceNumber(number);
+            break;
+        case STEP_ANS:
+            stack[depth].value = ans;
+            stack[depth++].error = 0;
+            break;
+        case STEP_NEG:
+            stack[depth - 1].value = -stack[depth - 1].value;
+            break;
+        case STEP_ADD:
+            depth--;
+            stack[depth - 1] = ReferenceAdd(stack[depth - 1], stack[depth]);
+            break;
+        case STEP_SUB:
+            depth--;
+            stack[depth].value = -stack[depth].value;
+            stack[depth - 1] = ReferenceAdd(stack[depth - 1], stack[depth]);
+            break;
+        case STEP_MUL:
+            depth--;
+            stack[depth - 1] = ReferenceMultiply(stack[depth - 1], stack[depth]);
+            break;
+        default:
+            depth--;
+            if (stack[depth].value == 0 && stack[depth].error == 0)
+            {
+                return EXPR_ERR_DIV_ZERO;
+            }
+            stack[depth - 1] = ReferenceDivide(stack[depth - 1], stack[depth]);
+        }
+    }
+    *result = stack[0];
+    if (result->value == 0)
+    {
+        result->value = 0; // No negative zero: the exact value has no sign
+    }
+    return OUTCOME_VALUE;
+}
+
+// The ULP of the mode's arithmetic at the magnitude of value
+static Quad ModeUlp(Quad value)
+{
+    int exponent;
+
+    frexpl((long double)QuadAbs(value), &exponent);
+    if (exponent - mode->mantissa_bits < mode->min_exponent)
+    {
+        exponent = mode->min_exponent + mode->mantissa_bits;
+    }
+    return ldexpl(1.0L, exponent - mode->mantissa_bits);
+}
+
+// ------------------------ The arithmetic checked ------------------------
+
+static int EvaluateDouble(const ExprProgram *program, const char *text, double ans, double *result)
+{
+    ExprProgram copy = *program;
+
+    (void)text;
+    return ExprEvaluate(&copy, ans, result);
+}
+
+// As ExprEvaluate() and ExprApply(), in single precision
+static int EvaluateFloat(const ExprProgram *program, const char *text, double ans, double *result)
+{
+    float stack[EXPR_MAX_STEPS];
+    char number[ENTRY_SIZE];
+    float value;
+    float right;
+    int depth = 0;
+    int i;
+
+    for (i = 0; i < program->length; i++)
+    {
+        switch (program->steps[i].op)
+        {
+        case STEP_NUMBER:
+            text = NextNumber(text, number);
+            stack[depth++] = strtof(number, NULL);
+            break;
+        case STEP_ANS:
+            stack[depth++] = (float)ans;
+            break;
+        case STEP_NEG:
+            stack[depth - 1] = -stack[depth - 1];
+            break;
+        default:
+            right = stack[--depth];
+            switch (program->steps[i].op)
+            {
+            case STEP_ADD:
+                value = stack[depth - 1] + right;
+                break;
+            case STEP_SUB:
+                value = stack[depth - 1] - right;
+                break;
+            case STEP_MUL:
+                value = stack[depth - 1] * right;
+                break;
+            default:
+                if (right == 0.0f)
+                {
+                    return EXPR_ERR_DIV_ZERO;
+                }
+                value = stack[depth - 1] / right;
+            }
+            if (value != value || value > FLT_MAX || value < -FLT_MAX)
+            {
+                return EXPR_ERR_RANGE;
+            }
+            stack[depth - 1] = value;
+        }
+    }
+    if (stack[0] > FLT_MAX || stack[0] < -FLT_MAX)
+    {
+        return EXPR_ERR_RANGE;
+    }
+    *result = stack[0];
+    return EXPR_OK;
+}
+
+static const Mode modes[] = {
+    {"double", DBL_MANT_DIG, -1074, DBL_MAX, EvaluateDouble},
+    {"float", FLT_MANT_DIG, -149, FLT_MAX, EvaluateFloat},
+};
+
+// ------------------------ The display ------------------------
+
+// What DisplayResult() puts on line 2, without the trailing spaces
+static void ShowResult(double value, char *shown)
+{
+    int end = DISPLAY_WIDTH;
+
+    DisplayResult(value);
+    while (DisplayFlushPending())
+    {
+        DisplayFlushTask();
+        ClockHostAdvance(50);
+    }
+    memcpy(shown, GetDisplayShadow(2), DISPLAY_WIDTH);
+    while (end > 0 && shown[end - 1] == ' ')
+    {
+        end--;
+    }
+    shown[end] = '\0';
+}
+
+// The text DisplayResult() should show for an exact value
+static void FormatReference(Quad value, char *text)
+{
+    snprintf(text, SHOWN_SIZE, "%LG", (long double)value); // As ExprFormat()
+}
+
+// ------------------------ Entries ------------------------
+
+// A random number as it might be typed
+static void RandomNumber(char *text)
+{
+    int digits = 1 + RandomBelow(RandomBelow(4) == 0 ? 12 : 6);
+    int point = RandomBelow(3) == 0 ? -1 : RandomBelow(digits + 1);
+    int i;
+
+    for (i = 0; i < digits; i++)
+    {
+        if (i == point)
+        {
+            *text++ = '.';
+        }
+        *text++ = (char)('0' + (i == 0 && digits > 1 ? 1 + RandomBelow(9) : RandomBelow(10)));
+    }
+    if (RandomBelow(6) == 0)
+    {
+        text += sprintf(text, "E%s%d", RandomBelow(2) ? "-" : "", RandomBelow(5) == 0 ? 280 + RandomBelow(50) : RandomBelow(25));
+    }
+    *text = '\0';
+}
+
+static void RandomEntry(char *text)
+{
+    static const char ops[] = "+-x/";
+    int factors = 1 + RandomBelow(5);
+    int i;
+
+    text[0] = '\0';
+    if (RandomBelow(20) == 0) // Continue from ANS
+    {
+        sprintf(text, "%c", ops[RandomBelow(4)]);
+    }
+    for (i = 0; i < factors; i++)
+    {
+        if (i > 0)
+        {
+            sprintf(text + strlen(text), "%c", ops[RandomBelow(4)]);
+        }
+        if (RandomBelow(10) == 0)
+        {
+            strcat(text, "-");
+        }
+        if (RandomBelow(10) == 0)
+        {
+            sprintf(text + strlen(text), "%c", ANS_CHAR);
+        }
+        else
+        {
+            RandomNumber(text + strlen(text));
+        }
+    }
+}
+
+static double RandomAns(void)
+{
+    char number[ENTRY_SIZE];
+    double ans;
+
+    do // The answer is always a finite number
+    {
+        RandomNumber(number);
+        ans = strtod(number, NULL);
+    } while (ans > DBL_MAX || ans < -DBL_MAX);
+    return ans;
+}
+
+// Six random significant digits, then text, e.g. "3.14159" + "5"
+static void SixDigits(char *text, const char *after)
+{
+    sprintf(text, "%d.%05d%s", 1 + RandomBelow(9), RandomBelow(100000), after);
+}
+
+// Entries chosen to be hard to get right
+static void AdversarialEntry(char *text)
+{
+    static const char *const fixed[] = {
+        "0.1+0.2", "0.1x3", "1/3x3", "2/3-1/3", "1E16+1-1E16", "1E22+1-1E22", "9007199254740993",
+        "999999.5", "999999.4", "999999.49999", "0.0001", "0.000099999949", "0.00009999995", "9.999995",
+        "1E308x10/10", "1E-308/1E10", "4.9E-324", "2.5E-324", "1E-320x1E20", "1.7976931348E308x1",
+        "1/1E-400", "1E400/1E400", "0.3-0.1-0.2", "1.1x1.1x1.1x1.1", "100/7x7", "1E300x1E10/1E10",
+    };
+    char a[ENTRY_SIZE];
+    char b[ENTRY_SIZE];
+    int k;
+
+    switch (RandomBelow(7))
+    {
+    case 0:
+        sprintf(text, "%s", fixed[RandomBelow(sizeof(fixed) / sizeof(fixed[0]))]);
+        break;
+    case 1: // Cancellation: big + small - big
+        k = 10 + RandomBelow(20);
+        RandomNumber(b);
+        sprintf(text, "1E%d+%s-1E%d", k, b, k);
+        break;
+    case 2: // A 6-digit rounding boundary, typed
+        SixDigits(text, "5");
+        break;
+    case 3: // and reached by arithmetic
+        SixDigits(a, "5");
+        k = 2 + RandomBelow(8);
+        sprintf(text, "%.10gx%d/%d", strtod(a, NULL), k, k);
+        break;
+    case 4: // Where %G changes form, and nearby
+        if (RandomBelow(2))
+        {
+            sprintf(text, "99999%d.%d", 8 + RandomBelow(2), RandomBelow(10));
+        }
+        else
+        {
+            sprintf(text, "0.0000999%d%02d", RandomBelow(10), RandomBelow(100));
+        }
+        break;
+    case 5: // Decimals with no exact binary value, combined
+        sprintf(text, "0.%d+0.%d-0.%d", 1 + RandomBelow(9), 1 + RandomBelow(9), 1 + RandomBelow(9));
+        break;
+    default: // Near overflow or among the subnormals
+        sprintf(text, "%dE%s%d/%d", 1 + RandomBelow(9), RandomBelow(2) ? "" : "-", 300 + RandomBelow(24),
+                1 + RandomBelow(99));
+    }
+}
+
+static void AddEntry(const char *text, double ans)
+{
+    Entry *entry = &entries[entry_count++];
+
+    snprintf(entry->text, ENTRY_SIZE, "%s", text);
+    entry->ans = ans;
+}
+
+static void GenerateEntries(int count, int adversarial, int max_length)
+{
+    char text[4 * ENTRY_SIZE];
+
+    while (entry_count < count)
+    {
+        if (adversarial)
+        {
+            AdversarialEntry(text);
+        }
+        else
+        {
+            RandomEntry(text);
+        }
+        if ((int)strlen(text) <= max_length && (int)strlen(text) < ENTRY_SIZE)
+        {
+            AddEntry(text, RandomAns());
+        }
+    }
+}
+
+static void ReadEntries(const char *path, int max_count)
+{
+    FILE *file = fopen(path, "r");
+    char line[4 * ENTRY_SIZE];
+
+    if (file == NULL)
+    {
+        perror(path);
+        exit(2);
+    }
+    while (entry_count < max_count && fgets(line, sizeof(line), file) != NULL)
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] != '\0' && strlen(line) < ENTRY_SIZE)
+        {
+            AddEntry(line, FILE_ANS);
+        }
+    }
+    fclose(file);
+}
+
+// ------------------------ Checking ------------------------
+
+static void Keep(Example *examples, long count, const Entry *entry, double ulps, const char *shown,
+                 const char *expected)
+{
+    Example *example;
+
+    if (count >= WORST_KEPT)
+    {
+        return;
+    }
+    example = &examples[count];
+    snprintf(example->text, ENTRY_SIZE, "%s", entry->text);
+    example->ans = entry->ans;
+    example->ulps = ulps;
+    snprintf(example->shown, SHOWN_SIZE, "%s", shown);
+    snprintf(example->expected, SHOWN_SIZE, "%s", expected);
+}
+
+static void CheckEntry(const Entry *entry)
+{
+    ExprProgram program;
+    Reference reference;
+    Quad ulp;
+    Quad slack;
+    double value;
+    double ulps;
+    int outcome;
+    int expected;
+    int bucket;
+    char shown[SHOWN_SIZE];
+    char correct[SHOWN_SIZE];
+    char low[SHOWN_SIZE];
+    char high[SHOWN_SIZE];
+
+    if (ExprCompile(entry->text, &program) != EXPR_OK)
+    {
+        invalid++;
+        return;
+    }
+    outcome = mode->evaluate(&program, entry->text, entry->ans, &value);
+    expected = ReferenceEvaluate(&program, entry->text, entry->ans, &reference);
+    if (expected == OUTCOME_VALUE && QuadAbs(reference.value) - reference.error > mode->max) // Rounds to infinity
+    {
+        expected = EXPR_ERR_RANGE;
+    }
+    if (expected == OUTCOME_VALUE && QuadAbs(reference.value) + reference.error > mode->max)
+    {
+        unresolved++; // On the edge of the range: either is right
+        return;
+    }
+    if (outcome != expected)
+    {
+        FormatReference(reference.value, correct);
+        Keep(mismatch_examples, outcome_mismatches, entry, 0.0,
+             outcome == EXPR_OK ? "number" : expr_error_line1[outcome],
+             expected == OUTCOME_VALUE ? correct : expr_error_line1[expected]);
+        outcome_mismatches++;
+        return;
+    }
+    if (outcome != EXPR_OK)
+    {
+        return; // The same error
+    }
+
+    ulp = ModeUlp(reference.value);
+    if (reference.error > ulp * REFERENCE_RESOLUTION)
+    {
+        unresolved++;
+        return;
+    }
+    ulps = (double)(QuadAbs((Quad)value - reference.value) / ulp);
+    for (bucket = 0; bucket < BUCKETS - 1 && ulps > ((bucket == 0) ? 0.0 : ldexp(1.0, bucket - 2)); bucket++)
+    {
+    }
+    histogram[bucket]++;
+    scored++;
+    if (ulps > max_ulps || scored == 1)
+    {
+        max_ulps = ulps;
+        Keep(&worst, 0, entry, ulps, "", "");
+    }
+
+    ShowResult(value, shown);
+    FormatReference(reference.value, correct);
+    if (strcmp(shown, correct) != 0)
+    {
+        // Wrong, unless the exact value could be on the other side of a
+        // rounding boundary (counting long double's rounding for printf)
+        slack = reference.error + QuadAbs(reference.value) * (1.0 / 4611686018427387904.0); // 2^-62
+        FormatReference(reference.value - slack, low);
+        FormatReference(reference.value + slack, high);
+        if (strcmp(low, high) != 0)
+        {
+            shown_boundary++;
+        }
+        else
+        {
+            Keep(wrong_examples, shown_wrong, entry, ulps, shown, correct);
+            shown_wrong++;
+        }
+    }
+}
+
+// Time a path over all the entries: microseconds per entry
+static double TimePath(int reference)
+{
+    ExprProgram program;
+    Reference exact;
+    char text[SHOWN_SIZE];
+    double value;
+    double start = CpuMicrosec();
+    int i;
+
+    for (i = 0; i < entry_count; i++)
+    {
+        if (ExprCompile(entries[i].text, &program) != EXPR_OK)
+        {
+            continue;
+        }
+        if (reference)
+        {
+            if (ReferenceEvaluate(&program, entries[i].text, entries[i].ans, &exact) == OUTCOME_VALUE)
+            {
+                FormatReference(exact.value, text);
+            }
+        }
+        else if (mode->evaluate(&program, entries[i].text, entries[i].ans, &value) == EXPR_OK)
+        {
+            ExprFormat(value, text, EXPR_RESULT_SIZE);
+        }
+    }
+    return (CpuMicrosec() - start) / entry_count;
+}
+
+static void PrintExample(const char *label, const Example *example)
+{
+    printf("    %-16s ANS=%-23.17G", example->text, example->ans);
+    if (label != NULL)
+    {
+        printf("  %s %.3g", label, example->ulps);
+    }
+    if (example->shown[0] != '\0' || example->expected[0] != '\0')
+    {
+        printf("  shown \"%s\", should be \"%s\"", example->shown, example->expected);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = NULL;
+    double ulp_budget = -1.0;
+    long wrong_budget = -1;
+    double mode_microsec;
+    double reference_microsec;
+    char label[20];
+    int count = DEFAULT_COUNT;
+    int max_length = DEFAULT_LENGTH;
+    int adversarial = 0;
+    int failed = 0;
+    int bucket;
+    int i;
+
+    mode = &modes[0];
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            count = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            random_state = strtoull(argv[++i], NULL, 0) | 1;
+        }
+        else if (strcmp(argv[i], "-a") == 0)
+        {
+            adversarial = 1;
+        }
+        else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+        {
+            max_length = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            i++;
+            mode = (strcmp(argv[i], "float") == 0) ? &modes[1] : &modes[0];
+        }
+        else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc)
+        {
+            ulp_budget = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+        {
+            wrong_budget = atol(argv[++i]);
+        }
+        else if (argv[i][0] != '-' && path == NULL)
+        {
+            path = argv[i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: accuracy_oracle [-n count] [-s seed] [-a] [-l length] [-m double|float] "
+                            "[-u ulps] [-d count] [file]\n");
+            return 2;
+        }
+    }
+    if (count < 1)
+    {
+        count = 1;
+    }
+    entries = malloc(count * sizeof(Entry));
+    if (entries == NULL)
+    {
+        perror("entries");
+        return 2;
+    }
+    if (path != NULL)
+    {
+        ReadEntries(path, count);
+    }
+    else
+    {
+        GenerateEntries(count, adversarial, max_length);
+    }
+    if (entry_count == 0)
+    {
+        fprintf(stderr, "no entries\n");
+        return 2;
+    }
+
+    for (i = 0; i < entry_count; i++)
+    {
+        CheckEntry(&entries[i]);
+    }
+    mode_microsec = TimePath(0);
+    reference_microsec = TimePath(1);
+
+    printf("%d entries (%s), %ld not valid, arithmetic: %s\n", entry_count,
+           path != NULL ? path : adversarial ? "adversarial" : "random", invalid, mode->name);
+    printf("time per entry: %.3f us compiled, evaluated and formatted; reference %.3f us (%.1fx)\n\n",
+           mode_microsec, reference_microsec, reference_microsec / mode_microsec);
+
+    printf("error of %ld results, in %s ULPs:\n", scored, mode->name);
+    for (bucket = 0; bucket < BUCKETS; bucket++)
+    {
+        if (histogram[bucket] == 0)
+        {
+            continue;
+        }
+        if (bucket == 0)
+        {
+            sprintf(label, "0");
+        }
+        else if (bucket == BUCKETS - 1)
+        {
+            sprintf(label, "> %g", ldexp(1.0, bucket - 3));
+        }
+        else
+        {
+            sprintf(label, "<= %g", ldexp(1.0, bucket - 2));
+        }
+        printf("    %-14s", label);
+        printf("%10ld  %7.3f%%\n", histogram[bucket], 100.0 * histogram[bucket] / scored);
+    }
+    if (scored > 0)
+    {
+        printf("  largest:\n");
+        PrintExample("ULPs", &worst);
+    }
+    printf("  %ld unresolved (the reference is not precise enough, or on the edge of the range)\n\n", unresolved);
+
+    printf("%ld errors where the exact value is a number, or numbers where it is an error\n", outcome_mismatches);
+    for (i = 0; i < outcome_mismatches && i < WORST_KEPT; i++)
+    {
+        PrintExample(NULL, &mismatch_examples[i]);
+    }
+    printf("%ld shown with a wrong digit, %ld too close to a rounding boundary to tell\n", shown_wrong,
+           shown_boundary);
+    for (i = 0; i < shown_wrong && i < WORST_KEPT; i++)
+    {
+        PrintExample("ULPs", &wrong_examples[i]);
+    }
+
+    if (ulp_budget >= 0.0 && max_ulps > ulp_budget)
+    {
+        printf("\nOVER BUDGET: %.3g ULPs (budget %g)\n", max_ulps, ulp_budget);
+        failed = 1;
+    }
+    if (wrong_budget >= 0 && shown_wrong > wrong_budget)
+    {
+        printf("\nOVER BUDGET: %ld shown wrong (budget %ld)\n", shown_wrong, wrong_budget);
+        failed = 1;
+    }
+    return failed;
+}
@@ -0,0 +1,166 @@
+/* bignum_bench.c
+ *
+ * Host (Linux) benchmark for the arbitrary-precision integer engine
+ * (bignum.h): times addition, multiplication (schoolbook and Karatsuba),
+ * division and decimal conversion of 100 to 1000 digit numbers, and
+ * factorials, using exactly the code and arena size of the firmware.
+ * It also checks that expressions combining two factorials up to
+ * BIG_MAX_FACTORIAL (e.g. 1000!/999!) fit in the arena and give the right
+ * result; a failure makes the exit status 1.
+ *
+ * The Karatsuba column is with the firmware's threshold; the schoolbook
+ * column has Karatsuba turned off. Where the two cross is where
+ * BIG_KARATSUBA_THRESHOLD should be. Times on the board are much longer
+ * (there is no 64-bit divide, and the clock is 80 MHz), but the ratios
+ * are much the same.
+ *
+ * Build and run, from the Code directory:
+ *     gcc -O2 -I. -o bignum_bench host/bignum_bench.c bignum.c
+ *     ./bignum_bench
+ */
+
+#include "bignum.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_DIGITS 1000
+#define MIN_TIME 0.2 // Seconds each measurement runs for, at least
+
+typedef int (*Operation)(const BigNum *a, const BigNum *b, BigNum *result);
+
+static BigNum a;
+static BigNum b;
+static char text[BIG_TEXT_SIZE];
+
+static double Now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+// Make a random number with exactly this many digits
+static void MakeNumber(int digits, BigNum *number)
+{
+    char text[MAX_DIGITS];
+    int i;
+
+    text[0] = '1' + rand() % 9;
+    for (i = 1; i < digits; i++)
+    {
+        text[i] = '0' + rand() % 10;
+    }
+    if (BigFromDecimal(text, digits, number) != BIG_OK)
+    {
+        fprintf(stderr, "arena full making a %d-digit number\n", digits);
+        exit(1);
+    }
+}
+
+static int Divide(const BigNum *a, const BigNum *b, BigNum *result)
+{
+    return BigDivide(a, b, result, 0);
+}
+
+static int ToDecimal(const BigNum *a, const BigNum *b, BigNum *result)
+{
+    (void)b; // Operation's other operand and result: not needed here
+    (void)result;
+    return BigToDecimal(a, text, sizeof(text));
+}
+
+static int Factorial(const BigNum *a, const BigNum *b, BigNum *result)
+{
+    (void)b;
+    return BigFactorial(a, result);
+}
+
+// Microseconds per call of the operation
+static double Time(Operation operation, const BigNum *x, const BigNum *y)
+{
+    BigNum result;
+    int mark = BigArenaMark();
+    long count = 0;
+    long calls = 1;
+    double start = Now();
+    double elapsed;
+    long i;
+
+    do
+    {
+        for (i = 0; i < calls; i++)
+        {
+            if (operation(x, y, &result) != BIG_OK)
+            {
+                fprintf(stderr, "operation failed (arena full?)\n");
+                exit(1);
+            }
+            BigArenaRelease(mark);
+        }
+        count += calls;
+        calls *= 2;
+        elapsed = Now() - start;
+    } while (elapsed < MIN_TIME);
+    return elapsed / count * 1e6;
+}
+
+int main(void)
+{
+    static const int sizes[] = {100, 200, 300, 500, 700, 1000};
+    static const int factorials[] = {100, 250, 500, 1000};
+    static const char *const combined[][2] = {{"1000!/999!", "1000"}, {"1000!%999!", "0"},
+                                              {"1000!/998!", "999000"}, {"950!/949!", "950"},
+                                              {"1000!-1000x999!", "0"}, {"999!/1000!", "0"}};
+    int failures = 0;
+    BigNum n;
+    BigNum half;
+    double schoolbook;
+    double karatsuba;
+    unsigned int i;
+
+    printf("Karatsuba threshold %d limbs, arena %d limbs\n\n", BigGetKaratsubaThreshold(), BIG_ARENA_LIMBS);
+    printf("digits      add us   multiply us  (schoolbook)   divide us  to decimal us\n");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        MakeNumber(sizes[i], &a);
+        MakeNumber(sizes[i], &b);
+        MakeNumber(sizes[i] / 2, &half);
+
+        karatsuba = Time(BigMultiply, &a, &b);
+        BigSetKaratsubaThreshold(1000000);
+        schoolbook = Time(BigMultiply, &a, &b);
+        BigSetKaratsubaThreshold(0);
+
+        printf("%6d %11.2f %13.2f %13.2f %11.2f %14.2f\n", sizes[i], Time(BigAdd, &a, &b), karatsuba, schoolbook,
+               Time(Divide, &a, &half), Time(ToDecimal, &a, 0));
+        BigArenaRelease(0);
+    }
+
+    printf("\n    n!  digits  factorial us  to decimal us\n");
+    for (i = 0; i < sizeof(factorials) / sizeof(factorials[0]); i++)
+    {
+        sprintf(text, "%d", factorials[i]);
+        BigFromDecimal(text, strlen(text), &n);
+        BigFactorial(&n, &a);
+        BigToDecimal(&a, text, sizeof(text));
+        printf("%6d %7d %13.2f %14.2f\n", factorials[i], (int)strlen(text), Time(Factorial, &n, 0),
+               Time(ToDecimal, &a, 0));
+        BigArenaRelease(0);
+    }
+
+    printf("\n");
+    for (i = 0; i < sizeof(combined) / sizeof(combined[0]); i++)
+    {
+        if (BigEvaluate(combined[i][0], text, sizeof(text)) != BIG_OK || strcmp(text, combined[i][1]) != 0)
+        {
+            printf("FAILED: %s is not %s\n", combined[i][0], combined[i][1]);
+            failures++;
+        }
+    }
+    printf(failures ? "%d FAILURES\n" : "expressions of two factorials fit the arena\n", failures);
+    printf("\narena high-water mark %d limbs\n", BigArenaHighWater());
+    return failures != 0;
+}
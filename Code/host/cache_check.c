@@ -0,0 +1,98 @@
+/* cache_check.c
+ *
+ * Host (Linux) check that the result cache (result_cache.c) never gives
+ * an entry a result cached for a different one.
+ *
+ * Each pair is a valid entry and an invalid one which would share its key
+ * if the invalid one were normalised too (e.g. "1E2" and "1E2.0"). The
+ * keypad grammar refuses the invalid ones, but serial batch mode passes
+ * the text from the wire straight to the cache. Each is looked up after
+ * the other has been cached, in both orders, and must give what it gives
+ * on its own. Numbers written differently in valid entries ("02.50x4",
+ * "2.5x4") must still share an entry.
+ *
+ * Any difference is reported and makes the exit status 1.
+ *
+ * Build and run, from the Code directory:
+ *     gcc -O2 -DHOST_SIM -I. -Ihost -o cache_check host/cache_check.c result_cache.c expression.c \
+ *         host/calculate_answer_host.c -lm
+ *     ./cache_check
+ */
+
+#include "result_cache.h"
+#include "expression.h"
+#include <stdio.h>
+#include <string.h>
+
+#define ENTRY_SIZE 17
+
+static int failures = 0;
+
+// Look up text in the cache as it stands
+static void Calculate(const char *text, CalcResult *result)
+{
+    char entry[ENTRY_SIZE];
+
+    strcpy(entry, text);
+    ResultCacheCalculate(entry, ENTRY_SIZE, NUMBER_MODE_DECIMAL, 0.0, result);
+}
+
+static int Same(const CalcResult *a, const CalcResult *b)
+{
+    if (a->error_ref_no != b->error_ref_no || a->expr_error != b->expr_error)
+    {
+        return 0;
+    }
+    return a->error_ref_no != 0 || a->expr_error != EXPR_OK || a->value == b->value;
+}
+
+// Look up second with first cached, and check it gives what it does alone
+static void CheckAfter(const char *first, const char *second)
+{
+    CalcResult alone;
+    CalcResult cached;
+
+    ResultCacheClear();
+    Calculate(second, &alone);
+    ResultCacheClear();
+    Calculate(first, &cached);
+    Calculate(second, &cached);
+    if (!Same(&alone, &cached))
+    {
+        printf("FAILED: \"%s\" after \"%s\": error %d/%d, %G; on its own error %d/%d, %G\n", second, first,
+               cached.error_ref_no, cached.expr_error, cached.value, alone.error_ref_no, alone.expr_error,
+               alone.value);
+        failures++;
+    }
+}
+
+int main(void)
+{
+    static const char *const pairs[][2] = {
+        {"1E2", "1E2.0"}, {"0", "."}, {"5x0", "5x."}, {"2+3", "2+3.."},
+        {"1.5+1", "1.5.0+1"}, {"7", "07."}, {"4-1E1", "4-1E1.00"},
+    };
+    ResultCacheStats stats;
+    CalcResult first;
+    CalcResult second;
+    int i;
+
+    for (i = 0; i < (int)(sizeof(pairs) / sizeof(pairs[0])); i++)
+    {
+        CheckAfter(pairs[i][0], pairs[i][1]);
+        CheckAfter(pairs[i][1], pairs[i][0]);
+    }
+
+    ResultCacheClear();
+    Calculate("02.50x4", &first);
+    Calculate("2.5x4", &second);
+    ResultCacheGetStats(&stats);
+    if (stats.hits != 1 || !Same(&first, &second) || first.value != 10.0)
+    {
+        printf("FAILED: \"02.50x4\" and \"2.5x4\": %lu hit(s), %G and %G\n", stats.hits, first.value, second.value);
+        failures++;
+    }
+
+    printf(failures ? "%d FAILURES\n" : "all result cache checks passed\n", failures);
+    return failures != 0;
+}
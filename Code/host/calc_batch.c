@@ -0,0 +1,463 @@
+/* calc_batch.c
+ *
+ * Host (Linux) program which evaluates keypad entries in bulk, one per
+ * line, exactly as the calculator would (calc_lib.h), and writes one
+ * result line per entry, in the same order:
+ *     calc_batch [-j threads] [-s] [file]
+ * e.g.
+ *     printf '1+2\n8/0\n2x3.5\n' | calc_batch
+ * gives 3, ERR Division by zero and 7. A file is memory-mapped and read
+ * in place; without one, the entries are streamed from stdin. -j sets the
+ * number of worker threads (default: one per online core) and -s reports
+ * the number of entries and the rate on stderr.
+ *
+ * The input is taken in batches of about BATCH_BYTES. Each batch is cut
+ * into blocks of BLOCK_LINES entries, which are shared out among the
+ * workers' queues; a worker whose queue is empty steals from the far end
+ * of another's, so they all finish together however uneven the work. The
+ * results go into a slot per entry, so the order never depends on which
+ * thread did what. While the workers evaluate one batch, the main thread
+ * writes out the one before and reads the one after, so neither the
+ * input nor the output holds them up.
+ *
+ * Build, from the Code directory:
+ *     gcc -O2 -pthread -I. -Ihost -o calc_batch host/calc_batch.c host/calc_lib.c expression.c
+ */
+
+#include "calc_lib.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BATCH_BYTES (1 << 20) // Input taken at once (more if a line is longer)
+#define BLOCK_LINES 256       // Entries a worker takes, or steals, at once
+#define MAX_THREADS 256
+
+typedef struct
+{
+    char *buffer;         // Input read from stdin (not used for a mapped file)
+    size_t buffer_size;   // Bytes allocated
+    const char *text;     // Start of the batch's input
+    size_t size;          // Bytes in it, up to the end of the last whole line
+    size_t held;          // Bytes read into buffer, including any incomplete line after those
+    const char **line;    // Start of each entry
+    int *length;          // and its length, without the line ending
+    char (*output)[CALC_OUTPUT_SIZE]; // Result of each entry
+    int lines;            // Entries in the batch
+    int capacity;         // Entries the arrays have room for
+    int blocks;           // Blocks of BLOCK_LINES entries
+} Batch;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    Batch *batch; // Batch the blocks are of
+    int begin;    // Blocks [begin, end) of it are still to be done
+    int end;
+} WorkQueue;
+
+static WorkQueue queues[MAX_THREADS];
+static int thread_count;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER; // A new batch has been given out
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;  // A worker has run out of blocks
+static Batch *pool_batch;          // Batch being evaluated
+static unsigned long generation;   // Batches given out so far
+static int busy_workers;           // Workers still on the present batch
+static int blocks_done;            // Blocks of it finished
+
+static void *Allocate(void *memory, size_t size)
+{
+    memory = realloc(memory, size);
+    if (memory == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    return memory;
+}
+
+static double Now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+// ------------------------ Worker threads ------------------------
+
+// The next block for worker self: from the front of its own queue, or
+// else from the back of someone else's. 0 when there is none left. The
+// batch comes with the block, as a worker which was slow to start may
+// only find blocks of the batch after the one it woke for.
+static int TakeBlock(int self, Batch **batch, int *block)
+{
+    WorkQueue *queue;
+    int i;
+
+    for (i = 0; i < thread_count; i++)
+    {
+        queue = &queues[(self + i) % thread_count];
+        pthread_mutex_lock(&queue->lock);
+        if (queue->begin < queue->end)
+        {
+            *block = (i == 0) ? queue->begin++ : --queue->end;
+            *batch = queue->batch;
+            pthread_mutex_unlock(&queue->lock);
+            return 1;
+        }
+        pthread_mutex_unlock(&queue->lock);
+    }
+    return 0;
+}
+
+static void EvaluateBlock(Batch *batch, int block)
+{
+    int first = block * BLOCK_LINES;
+    int last = first + BLOCK_LINES;
+    int i;
+
+    if (last > batch->lines)
+    {
+        last = batch->lines;
+    }
+    for (i = first; i < last; i++)
+    {
+        CalcEvaluate(batch->line[i], batch->length[i], batch->output[i], CALC_OUTPUT_SIZE, NULL);
+    }
+}
+
+static void *Worker(void *argument)
+{
+    int self = (int)(long)argument;
+    unsigned long seen = 0; // Generation last worked on
+    Batch *batch;
+    int block;
+    int done;
+
+    while (1)
+    {
+        pthread_mutex_lock(&pool_lock);
+        while (generation == seen)
+        {
+            pthread_cond_wait(&work_ready, &pool_lock);
+        }
+        seen = generation;
+        busy_workers++;
+        pthread_mutex_unlock(&pool_lock);
+
+        done = 0;
+        while (TakeBlock(self, &batch, &block))
+        {
+            EvaluateBlock(batch, block);
+            done++;
+        }
+
+        pthread_mutex_lock(&pool_lock);
+        blocks_done += done;
+        busy_workers--;
+        pthread_cond_signal(&work_done);
+        pthread_mutex_unlock(&pool_lock);
+    }
+    return NULL;
+}
+
+static void StartWorkers(int count)
+{
+    pthread_t thread;
+    int i;
+
+    thread_count = count;
+    for (i = 0; i < count; i++)
+    {
+        pthread_mutex_init(&queues[i].lock, NULL);
+        if (pthread_create(&thread, NULL, Worker, (void *)(long)i) != 0)
+        {
+            fprintf(stderr, "cannot start thread %d\n", i);
+            exit(1);
+        }
+        pthread_detach(thread);
+    }
+}
+
+// Share the batch's blocks out in equal runs, one run per worker, and wake them.
+// Only called once the workers have finished the batch before (WaitForWorkers()).
+static void GiveOut(Batch *batch)
+{
+    int i;
+
+    pthread_mutex_lock(&pool_lock);
+    for (i = 0; i < thread_count; i++)
+    {
+        pthread_mutex_lock(&queues[i].lock);
+        queues[i].batch = batch;
+        queues[i].begin = (int)((long)batch->blocks * i / thread_count);
+        queues[i].end = (int)((long)batch->blocks * (i + 1) / thread_count);
+        pthread_mutex_unlock(&queues[i].lock);
+    }
+    pool_batch = batch;
+    blocks_done = 0;
+    generation++;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+}
+
+// Until every block is done and no worker can still be looking at the batch
+static void WaitForWorkers(void)
+{
+    pthread_mutex_lock(&pool_lock);
+    while (blocks_done < pool_batch->blocks || busy_workers > 0)
+    {
+        pthread_cond_wait(&work_done, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
+
+// ------------------------ Input and output ------------------------
+
+// Find the entries in batch->text. The last one is only taken if it ends
+// with a newline, or if there is no more input (at_end).
+static void SplitLines(Batch *batch, size_t available, int at_end)
+{
+    const char *p = batch->text;
+    const char *end = batch->text + available;
+    const char *newline;
+    int length;
+
+    batch->lines = 0;
+    while (p < end)
+    {
+        newline = memchr(p, '\n', end - p);
+        if (newline == NULL && !at_end)
+        {
+            break; // Incomplete: it goes with the next batch
+        }
+        if (newline == NULL)
+        {
+            newline = end;
+        }
+        if (batch->lines == batch->capacity)
+        {
+            batch->capacity = batch->capacity ? 2 * batch->capacity : 4096;
+            batch->line = Allocate(batch->line, batch->capacity * sizeof(batch->line[0]));
+            batch->length = Allocate(batch->length, batch->capacity * sizeof(batch->length[0]));
+            batch->output = Allocate(batch->output, batch->capacity * sizeof(batch->output[0]));
+        }
+        length = (int)(newline - p);
+        if (length > 0 && p[length - 1] == '\r')
+        {
+            length--;
+        }
+        batch->line[batch->lines] = p;
+        batch->length[batch->lines] = length;
+        batch->lines++;
+        p = (newline < end) ? newline + 1 : end;
+    }
+    batch->size = p - batch->text;
+    batch->blocks = (batch->lines + BLOCK_LINES - 1) / BLOCK_LINES;
+}
+
+// The next batch from a mapped file, starting at *position. 0 at the end.
+static int MapBatch(Batch *batch, const char *map, size_t map_size, size_t *position)
+{
+    size_t available = map_size - *position;
+
+    if (available == 0)
+    {
+        return 0;
+    }
+    batch->text = map + *position;
+    if (available > BATCH_BYTES)
+    {
+        // As far as the first newline after BATCH_BYTES
+        const char *newline = memchr(batch->text + BATCH_BYTES, '\n', available - BATCH_BYTES);
+
+        if (newline != NULL)
+        {
+            available = newline + 1 - batch->text;
+        }
+    }
+    SplitLines(batch, available, *position + available == map_size);
+    *position += batch->size;
+    return 1;
+}
+
+// The next batch from stdin: what was left over from the batch before
+// (an incomplete last line), then as much more as there is room for.
+// 0 at the end.
+static int ReadBatch(Batch *batch, const char *carry, size_t carry_size)
+{
+    size_t filled = carry_size;
+    ssize_t got = 1;
+
+    if (batch->buffer_size < carry_size + BATCH_BYTES)
+    {
+        batch->buffer_size = carry_size + BATCH_BYTES;
+        batch->buffer = Allocate(batch->buffer, batch->buffer_size);
+    }
+    memmove(batch->buffer, carry, carry_size);
+    batch->text = batch->buffer;
+    while (1)
+    {
+        while (filled < batch->buffer_size && (got = read(STDIN_FILENO, batch->buffer + filled, batch->buffer_size - filled)) > 0)
+        {
+            filled += got;
+        }
+        if (got < 0)
+        {
+            perror("stdin");
+            exit(1);
+        }
+        batch->held = filled;
+        SplitLines(batch, filled, got == 0);
+        if (batch->lines > 0 || got == 0)
+        {
+            break;
+        }
+        // Full, without a whole line: a very long line, so make room for more
+        batch->buffer_size *= 2;
+        batch->buffer = Allocate(batch->buffer, batch->buffer_size);
+        batch->text = batch->buffer;
+    }
+    return batch->lines > 0;
+}
+
+static void WriteBatch(const Batch *batch, char **out, size_t *out_size)
+{
+    size_t needed = (size_t)batch->lines * CALC_OUTPUT_SIZE;
+    size_t used = 0;
+    size_t length;
+    int i;
+
+    if (*out_size < needed)
+    {
+        *out_size = needed;
+        *out = Allocate(*out, needed);
+    }
+    for (i = 0; i < batch->lines; i++)
+    {
+        length = strlen(batch->output[i]);
+        memcpy(*out + used, batch->output[i], length);
+        used += length;
+        (*out)[used++] = '\n';
+    }
+    if (fwrite(*out, 1, used, stdout) != used)
+    {
+        perror("stdout");
+        exit(1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Batch batches[2];
+    Batch *current;
+    Batch *next;
+    const char *map = NULL;
+    size_t map_size = 0;
+    size_t position = 0;
+    char *out = NULL;
+    size_t out_size = 0;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int report = 0;
+    int have_next;
+    long total = 0;
+    double start = Now();
+    double seconds;
+    struct stat status;
+    int option;
+    int file;
+
+    while ((option = getopt(argc, argv, "j:s")) != -1)
+    {
+        switch (option)
+        {
+        case 'j':
+            threads = atoi(optarg);
+            break;
+        case 's':
+            report = 1;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-j threads] [-s] [file]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+    if (threads > MAX_THREADS)
+    {
+        threads = MAX_THREADS;
+    }
+    if (optind < argc)
+    {
+        file = open(argv[optind], O_RDONLY);
+        if (file < 0 || fstat(file, &status) != 0)
+        {
+            perror(argv[optind]);
+            return 1;
+        }
+        map_size = status.st_size;
+        if (map_size > 0)
+        {
+            map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (map == MAP_FAILED)
+            {
+                perror(argv[optind]);
+                return 1;
+            }
+            madvise((void *)map, map_size, MADV_SEQUENTIAL);
+        }
+        close(file);
+    }
+
+    memset(batches, 0, sizeof(batches));
+    StartWorkers(threads);
+    current = &batches[0];
+    have_next = map ? MapBatch(current, map, map_size, &position) : (optind < argc ? 0 : ReadBatch(current, NULL, 0));
+    if (have_next)
+    {
+        GiveOut(current);
+    }
+    while (have_next)
+    {
+        // Read the next batch while the workers evaluate this one...
+        next = (current == &batches[0]) ? &batches[1] : &batches[0];
+        if (map)
+        {
+            have_next = MapBatch(next, map, map_size, &position);
+        }
+        else
+        {
+            have_next = ReadBatch(next, current->text + current->size, current->held - current->size);
+        }
+        WaitForWorkers();
+        if (have_next)
+        {
+            GiveOut(next);
+        }
+        // ...and write this one while they evaluate the next
+        WriteBatch(current, &out, &out_size);
+        total += current->lines;
+        current = next;
+    }
+    fflush(stdout);
+
+    if (report)
+    {
+        seconds = Now() - start;
+        fprintf(stderr, "%ld entries in %.3f s with %d threads: %.0f/s\n", total, seconds, threads,
+                seconds > 0 ? total / seconds : 0.0);
+    }
+    return 0;
+}
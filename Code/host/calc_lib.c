@@ -0,0 +1,69 @@
+/* calc_lib.c
+ *
+ * Reentrant evaluation of keypad entries for host programs.
+ *
+ * For documentation, see calc_lib.h.
+ */
+
+#include "calc_lib.h"
+#include "expression.h"
+#include <stdio.h>
+#include <string.h>
+
+#define EXPR_ERROR_COUNT 5 // Entries in expr_error_line1 and 2
+
+int CalcEvaluate(const char *input, int length, char *output, int output_size, double *value)
+{
+    char entry[CALC_INPUT_SIZE];
+    ExprProgram program;
+    double result;
+    int error;
+    int end;
+
+    if (length > CALC_INPUT_SIZE - 1)
+    {
+        snprintf(output, output_size, "ERR LONG");
+        return CALC_ERR_LONG;
+    }
+    memcpy(entry, input, length);
+    entry[length] = '\0';
+
+    error = ExprCompile(entry, &program);
+    if (error == EXPR_OK)
+    {
+        error = ExprEvaluate(&program, 0.0, &result);
+    }
+    if (error != EXPR_OK)
+    {
+        // The first line of the message, without the padding
+        end = snprintf(output, output_size, "ERR %s", CalcErrorText(error, 1));
+        if (end >= output_size)
+        {
+            end = output_size - 1;
+        }
+        while (end > 0 && output[end - 1] == ' ')
+        {
+            output[--end] = '\0';
+        }
+        return error;
+    }
+    ExprFormat(result, output, output_size);
+    if (value != NULL)
+    {
+        *value = result;
+    }
+    return EXPR_OK;
+}
+
+const char *CalcErrorText(int error, int line)
+{
+    if (error == CALC_ERR_LONG)
+    {
+        return (line == 1) ? "Too long        " : "Press any key   ";
+    }
+    if (error < 0 || error >= EXPR_ERROR_COUNT)
+    {
+        return "";
+    }
+    return (line == 1) ? expr_error_line1[error] : expr_error_line2[error];
+}
@@ -0,0 +1,63 @@
+/*! \file calc_lib.h
+ *
+ * The calculator's decimal arithmetic and result format as a library
+ * for host (Linux) programs, e.g. to check a large number of keypad
+ * calculations in bulk on a server.
+ *
+ * An entry is evaluated exactly as the keypad would: at most
+ * \a CALC_INPUT_SIZE - 1 characters, compiled and evaluated by
+ * expression.c in double precision, and shown with its %G format
+ * (ExprFormat()). Each entry stands alone: ANS (or a leading operator)
+ * is taken as 0, as in serial batch mode.
+ *
+ * Every function is reentrant. There are no static variables and no
+ * shared buffers: all the working space is on the caller's stack and
+ * all the output goes to the caller's buffers, and the error messages
+ * are read-only. So any number of threads may call them at once.
+ *
+ * Build it with expression.c, from the Code directory, e.g.
+ *     gcc -O2 -I. -Ihost my_program.c host/calc_lib.c expression.c
+ */
+
+#ifndef CALC_LIB_H
+#define CALC_LIB_H
+
+/*! Longest entry accepted, plus one: the keypad's input buffer
+ * (INPUT_BUFFER_SIZE in main.c). */
+#define CALC_INPUT_SIZE 17
+
+/*! Size of the text of any outcome (see CalcEvaluate()), including the
+ * trailing null. */
+#define CALC_OUTPUT_SIZE 24
+
+/*! Error number for an entry too long to type. The others are
+ * expression.c's EXPR_ERR_ numbers. */
+#define CALC_ERR_LONG 100
+
+/*! Evaluate one entry.
+ *
+ * \param [in] input The entry, in the characters the keypad puts in the
+ * 		input buffer (digits, + - x / . E and ANS_CHAR). It need not be
+ * 		null-terminated.
+ * \param [in] length Number of characters in \a input.
+ * \param [out] output What the calculator would show, as one line:
+ * 		the result, as DisplayResult() shows it, or ERR and the first
+ * 		line of the error message, e.g. "ERR Division by zero", or
+ * 		"ERR LONG".
+ * \param [in] output_size Size of \a output; \a CALC_OUTPUT_SIZE is
+ * 		always enough.
+ * \param [out] value The result, if there was no error. May be null.
+ * \return 0 (EXPR_OK), an EXPR_ERR_ number or \a CALC_ERR_LONG.
+ */
+int CalcEvaluate( const char *input, int length, char *output, int output_size, double *value );
+
+/*! \return The two lines of the error message for an error number
+ * from CalcEvaluate() (each \a DISPLAY_WIDTH characters), or empty
+ * strings for 0.
+ *
+ * \param [in] error The error number.
+ * \param [in] line 1 or 2.
+ */
+const char *CalcErrorText( int error, int line );
+
+#endif // of #ifndef CALC_LIB_H
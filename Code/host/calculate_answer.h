@@ -0,0 +1,19 @@
+/* calculate_answer.h
+ *
+ * Host stand-in for the course's calculate_answer.h, which is not in this
+ * tree. host/calculate_answer_host.c implements it with expression.c.
+ */
+
+#ifndef CALCULATE_ANSWER_H
+#define CALCULATE_ANSWER_H
+
+/* Evaluate the entry in input_buffer (a C string of at most
+ * input_buffer_size - 1 characters). Sets *error_ref_no to 0, or to an
+ * index into the tables below, whose messages are each at most 16
+ * characters. */
+double CalculateAnswer(char *input_buffer, int input_buffer_size, int *error_ref_no);
+
+extern const char *error_message_line1[];
+extern const char *error_message_line2[];
+
+#endif // of #ifndef CALCULATE_ANSWER_H
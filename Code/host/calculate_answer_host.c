@@ -0,0 +1,39 @@
+/* calculate_answer_host.c
+ *
+ * Host stand-in for CalculateAnswer(), for programs which link the
+ * firmware's own modules (e.g. host/fuzz_calc.c). It evaluates with
+ * expression.c, taking ANS as 0, and its error numbers are expression.c's.
+ *
+ * For documentation, see host/calculate_answer.h.
+ */
+
+#include "calculate_answer.h"
+#include "expression.h"
+
+const char *error_message_line1[] = {"", "Syntax error    ", "Division by zero", "Out of range    ",
+                                     "Too complex     "}; // As expr_error_line1
+const char *error_message_line2[] = {"", "Press any key   ", "Press any key   ", "Press any key   ",
+                                     "Press any key   "};
+
+double CalculateAnswer(char *input_buffer, int input_buffer_size, int *error_ref_no)
+{
+    ExprProgram program;
+    double result = 0.0;
+    int error = EXPR_ERR_TOO_LONG;
+    int i;
+
+    for (i = 0; i < input_buffer_size; i++) // An unterminated buffer is "too complex" rather than read past its end
+    {
+        if (input_buffer[i] == '\0')
+        {
+            error = ExprCompile(input_buffer, &program);
+            if (error == EXPR_OK)
+            {
+                error = ExprEvaluate(&program, 0.0, &result);
+            }
+            break;
+        }
+    }
+    *error_ref_no = error;
+    return (error == EXPR_OK) ? result : 0.0;
+} // CalculateAnswer
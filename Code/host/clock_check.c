@@ -0,0 +1,191 @@
+/* clock_check.c
+ *
+ * Host (Linux) check of the clock policy (clock_policy.c) against the
+ * virtual clock of host/clock_host.c, run by the scheduler as on the
+ * board: ClockPolicyTask() is a background task, and each event is
+ * handled after ClockPolicyWake(), as HandleEvent() in main.c does.
+ *
+ * Every change of clock is noted, with the time it happened, and the
+ * sequence is compared with what the policy should do:
+ * 	- idle from power-on: slow after CLOCK_IDLE_MILLISEC;
+ * 	- a key: fast at once, then slow again CLOCK_IDLE_MILLISEC after
+ * 		it, but not while the display is still being drawn;
+ * 	- keys closer together than that: fast all the while;
+ * 	- ClockPolicyHold() (serial mode): fast until the release, then
+ * 		slow CLOCK_IDLE_MILLISEC after it.
+ * The number of switches is checked against both ClockHostSwitchCount()
+ * and the policy's own count, and the time it says it spent at each
+ * speed against the virtual time.
+ *
+ * Any difference is reported and makes the exit status 1.
+ *
+ * Build and run, from the Code directory:
+ *     gcc -O2 -DHOST_SIM -I. -Ihost -o clock_check host/clock_check.c clock_policy.c scheduler.c \
+ *         ring_buffer.c host/clock_host.c
+ *     ./clock_check
+ */
+
+#include "clock_policy.h"
+#include "scheduler.h"
+#include "low_level_funcs_tiva.h"
+#include "host_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+#define STEP_MICROSEC 100 // Virtual time between passes of the scheduler
+#define MAX_SWITCHES 16
+
+static int flush_pending = 0; // What DisplayFlushPending() says
+static unsigned long last_hz;
+static char sequence[MAX_SWITCHES + 1]; // 'F' or 'S' for each change of clock
+static unsigned long switch_millisec[MAX_SWITCHES];
+static int switch_count = 0;
+static int keys = 0;
+static int failures = 0;
+
+// Stands in for the one in mid_level_funcs.c, so a case can keep the display busy
+int DisplayFlushPending(void)
+{
+    return flush_pending;
+}
+
+static void HandleEvent(const Event *event)
+{
+    ClockPolicyWake(); // As main.c, before each event
+    if (event->type == EVENT_KEY)
+    {
+        keys++;
+    }
+}
+
+// Run the scheduler for a time, noting each change of clock
+static void Run(unsigned long millisec)
+{
+    unsigned long end = GetTickMillisec() + millisec;
+
+    while ((long)(GetTickMillisec() - end) < 0)
+    {
+        SchedulerPass(HandleEvent);
+        if (GetCoreClockHz() != last_hz)
+        {
+            last_hz = GetCoreClockHz();
+            if (switch_count < MAX_SWITCHES)
+            {
+                sequence[switch_count] = (last_hz == CLOCK_HOST_FAST_HZ) ? 'F' : 'S';
+                switch_millisec[switch_count] = GetTickMillisec();
+            }
+            switch_count++;
+        }
+        ClockHostAdvance(STEP_MICROSEC);
+    }
+}
+
+static void Key(void)
+{
+    PostEvent(EVENT_KEY, '5');
+}
+
+// Check the changes of clock since the last call: the speeds, and the times (from start) they happened
+static void Expect(const char *what, const char *speeds, const unsigned long *at, unsigned long start)
+{
+    int n = strlen(speeds);
+    int i;
+    int ok = (switch_count == n && strncmp(sequence, speeds, n) == 0);
+
+    for (i = 0; ok && i < n; i++)
+    {
+        ok = (switch_millisec[i] - start == at[i]);
+    }
+    if (!ok)
+    {
+        printf("FAILED: %s: expected %s at", what, speeds);
+        for (i = 0; i < n; i++)
+        {
+            printf(" %lu", at[i]);
+        }
+        printf(" ms; got %.*s at", switch_count < MAX_SWITCHES ? switch_count : MAX_SWITCHES, sequence);
+        for (i = 0; i < switch_count && i < MAX_SWITCHES; i++)
+        {
+            printf(" %lu", switch_millisec[i] - start);
+        }
+        printf(" ms\n");
+        failures++;
+    }
+    switch_count = 0;
+}
+
+int main(void)
+{
+    static const unsigned long power_on[] = {CLOCK_IDLE_MILLISEC};
+    static const unsigned long one_key[] = {100, 100 + CLOCK_IDLE_MILLISEC};
+    static const unsigned long flushing[] = {100, 150};
+    static const unsigned long typing[] = {100, 100 + 4 * 15 + CLOCK_IDLE_MILLISEC};
+    static const unsigned long held[] = {100, 600 + CLOCK_IDLE_MILLISEC};
+    unsigned long total_switches = 0;
+    unsigned long start;
+    ClockStats stats;
+    int i;
+
+    InitScheduler();
+    AddBackgroundTask(ClockPolicyTask);
+    last_hz = GetCoreClockHz();
+
+    start = GetTickMillisec();
+    Run(500);
+    total_switches += switch_count;
+    Expect("idle from power-on", "S", power_on, start);
+
+    start = GetTickMillisec();
+    Run(100);
+    Key();
+    Run(400);
+    total_switches += switch_count;
+    Expect("a key", "FS", one_key, start);
+
+    start = GetTickMillisec();
+    Run(100);
+    Key();
+    flush_pending = 1; // The display is being drawn for 50 ms
+    Run(50);
+    flush_pending = 0;
+    Run(350);
+    total_switches += switch_count;
+    Expect("a key, with the display still being drawn", "FS", flushing, start);
+
+    start = GetTickMillisec();
+    Run(100);
+    for (i = 0; i < 5; i++) // 15 ms apart: never idle for long enough
+    {
+        Key();
+        Run(15);
+    }
+    Run(400);
+    total_switches += switch_count;
+    Expect("keys typed quickly", "FS", typing, start);
+
+    start = GetTickMillisec();
+    Run(100);
+    ClockPolicyHold();
+    Run(500);
+    ClockPolicyRelease();
+    Run(400);
+    total_switches += switch_count;
+    Expect("held", "FS", held, start);
+
+    ClockPolicyGetStats(&stats);
+    if (keys != 7 || ClockHostSwitchCount() != total_switches || stats.switches != total_switches)
+    {
+        printf("FAILED: %d keys, %lu switches (host clock), %lu (policy), not 7, %lu\n", keys, ClockHostSwitchCount(),
+               stats.switches, total_switches);
+        failures++;
+    }
+    if (stats.fast_millisec + stats.slow_millisec != GetTickMillisec())
+    {
+        printf("FAILED: %lu ms fast and %lu ms slow, in %lu ms\n", stats.fast_millisec, stats.slow_millisec,
+               GetTickMillisec());
+        failures++;
+    }
+
+    printf(failures ? "%d FAILURES\n" : "all clock policy checks passed\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,99 @@
+/* clock_host.c
+ *
+ * Linux stand-in for the core clock and the time kept from it
+ * (SetCoreClock(), GetCoreClockHz(), ReadCycleCounter(), GetTickMillisec(),
+ * GetTickMicrosec() and the waits in low_level_funcs_tiva.c), so that
+ * clock_policy.c can be run against a virtual clock. Nothing moves by
+ * itself: the host program advances time with ClockHostAdvance() (waiting)
+ * or ClockHostRun() (working, so it takes five times as long at the slow
+ * clock as at the fast one), and the cycle counter and tick follow at
+ * whatever the clock is at the time. The waits let exactly the time asked
+ * for pass, except Wait_12_5_Nanosec(), which counts cycles as on the
+ * board.
+ *
+ * Example build, from the Code directory:
+ *     gcc -I. -Ihost clock_policy.c host/clock_host.c my_program.c
+ *
+ * For documentation, see host_sim.h and low_level_funcs_tiva.h.
+ */
+
+#include "low_level_funcs_tiva.h"
+#include "host_sim.h"
+
+static unsigned long host_clock_hz = CLOCK_HOST_FAST_HZ; // As PLL_Init() leaves it
+static unsigned long host_microsec = 0;                  // Virtual time
+static unsigned long host_cycles = 0;                    // Cycles counted in it
+static unsigned long host_spare_cycles = 0;              // Cycles run but not yet a whole microsecond
+static unsigned long host_switches = 0;
+
+void SetCoreClock(int fast)
+{
+    unsigned long hz = fast ? CLOCK_HOST_FAST_HZ : CLOCK_HOST_SLOW_HZ;
+
+    if (hz != host_clock_hz)
+    {
+        host_clock_hz = hz;
+        host_spare_cycles = 0;
+        host_switches++;
+    }
+} // SetCoreClock
+
+unsigned long GetCoreClockHz(void)
+{
+    return host_clock_hz;
+} // GetCoreClockHz
+
+unsigned long ReadCycleCounter(void)
+{
+    return host_cycles;
+} // ReadCycleCounter
+
+unsigned long GetTickMillisec(void)
+{
+    return host_microsec / 1000;
+} // GetTickMillisec
+
+unsigned long GetTickMicrosec(void)
+{
+    return host_microsec;
+} // GetTickMicrosec
+
+void ClockHostAdvance(unsigned long microsec)
+{
+    host_microsec += microsec;
+    host_cycles += microsec * (host_clock_hz / 1000000);
+} // ClockHostAdvance
+
+void ClockHostRun(unsigned long cycles)
+{
+    host_cycles += cycles;
+    host_spare_cycles += cycles;
+    host_microsec += host_spare_cycles / (host_clock_hz / 1000000);
+    host_spare_cycles %= host_clock_hz / 1000000;
+} // ClockHostRun
+
+unsigned long ClockHostSwitchCount(void)
+{
+    return host_switches;
+} // ClockHostSwitchCount
+
+void WaitMicrosec(long int wait_microsecs)
+{
+    if (wait_microsecs > 0)
+    {
+        ClockHostAdvance(wait_microsecs);
+    }
+} // WaitMicrosec
+
+void WaitMillisec(long int wait_millisecs)
+{
+    WaitMicrosec(wait_millisecs * 1000);
+} // WaitMillisec
+
+void Wait_12_5_Nanosec(long int wait_nanosecs)
+{
+    if (wait_nanosecs > 0)
+    {
+        ClockHostRun(wait_nanosecs); // Cycles: 12.5 ns each at the fast clock, longer at the slow
+    }
+} // Wait_12_5_Nanosec
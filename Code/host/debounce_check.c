@@ -0,0 +1,137 @@
+/* debounce_check.c
+ *
+ * Host (Linux) check of the keypad debouncer in KeyboardTask()
+ * (mid_level_funcs.c), driven through the keypad of host/display_host.c
+ * with the virtual time of host/clock_host.c.
+ *
+ * The keypad is scanned as on the board, a column about every quarter of
+ * a millisecond, except where a case holds the scan up (a stall: a flash
+ * erase, a long calculation or a clock switch does this on the board).
+ * Each case counts the EVENT_KEYs posted:
+ * 	- a clean press and release, and one which bounces at both ends,
+ * 		give one key each;
+ * 	- a single pressed reading (a bounce, or noise) just after a stall
+ * 		gives none;
+ * 	- a key which bounces across several stalls gives one.
+ *
+ * Any difference is reported and makes the exit status 1.
+ *
+ * Build and run, from the Code directory:
+ *     gcc -O2 -DHOST_SIM -I. -Ihost -o debounce_check host/debounce_check.c mid_level_funcs.c \
+ *         scheduler.c event_trace.c lcd_mirror.c UART.c ring_buffer.c host/uart_host.c \
+ *         host/display_host.c host/clock_host.c
+ *     ./debounce_check
+ */
+
+#include "mid_level_funcs.h"
+#include "scheduler.h"
+#include "host_sim.h"
+#include <stdio.h>
+
+#define STEP_MICROSEC 125 // Between calls of KeyboardTask(): 8 calls (4 columns) a millisecond
+#define STALL_MICROSEC 20000
+
+static int keys_posted;
+static char last_key;
+static int failures = 0;
+
+static void CountKeys(const Event *event)
+{
+    if (event->type == EVENT_KEY)
+    {
+        keys_posted++;
+        last_key = event->data;
+    }
+}
+
+// Scan the whole keypad once (each column written, then read), about a millisecond
+static void Scan(void)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        KeyboardTask();
+        ClockHostAdvance(STEP_MICROSEC);
+    }
+    while (SchedulerPass(CountKeys) > 0)
+    {
+    }
+}
+
+// Hold key (0 for none) for a number of scans
+static void Hold(char key, int scans)
+{
+    KeypadHostSetKey(key);
+    while (scans-- > 0)
+    {
+        Scan();
+    }
+}
+
+// Hold the scan up, with key held down (or not) all the while
+static void Stall(char key)
+{
+    KeypadHostSetKey(key);
+    ClockHostAdvance(STALL_MICROSEC);
+}
+
+static void Expect(const char *what, int keys)
+{
+    if (keys_posted != keys || (keys > 0 && last_key != '5'))
+    {
+        printf("FAILED: %s: %d key(s) (last '%c'), not %d\n", what, keys_posted, last_key, keys);
+        failures++;
+    }
+    keys_posted = 0;
+    last_key = 0;
+}
+
+int main(void)
+{
+    static const char bounce[] = "5.5.55..5.555"; // One reading each: '5' pressed, '.' released
+    int i;
+
+    InitScheduler();
+    Hold(0, 20); // Every column read at least once
+
+    Hold('5', 30);
+    Hold(0, 30);
+    Expect("clean press", 1);
+
+    for (i = 0; bounce[i] != '\0'; i++)
+    {
+        Hold(bounce[i] == '5' ? '5' : 0, 1);
+    }
+    Hold('5', 30);
+    for (i = 0; bounce[i] != '\0'; i++)
+    {
+        Hold(bounce[i] == '5' ? 0 : '5', 1);
+    }
+    Hold(0, 30);
+    Expect("bouncing press and release", 1);
+
+    Stall(0);
+    Hold('5', 1);
+    Hold(0, 30);
+    Expect("one pressed reading after a stall", 0);
+
+    Stall(0); // Each stall ends in one reading of a bounce
+    Hold('5', 1);
+    Stall('5');
+    Hold(0, 1);
+    Stall(0);
+    Hold('5', 1);
+    Stall(0);
+    Hold(0, 1);
+    Stall('5');
+    Hold('5', 30);
+    Stall(0);
+    Hold('5', 1);
+    Stall(0);
+    Hold(0, 30);
+    Expect("bouncing across stalls", 1);
+
+    printf(failures ? "%d FAILURES\n" : "all debounce checks passed\n", failures);
+    return failures != 0;
+}
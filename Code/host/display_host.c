@@ -0,0 +1,179 @@
+/* display_host.c
+ *
+ * Linux stand-in for the LCD and keypad drivers in low_level_funcs_tiva.c,
+ * so that mid_level_funcs.c and high_level_funcs.c can be run on the host
+ * (e.g. by host/fuzz_calc.c). The LCD is a copy of the display kept as
+ * the driver keeps its shadow, with each byte taking 37 us (Clear Display
+ * 1.52 ms) of the virtual time of host/clock_host.c.
+ *
+ * It is stricter than the LCD: anything the driver would quietly clip or
+ * mis-time is a fault, reported on stderr before abort(), so that a
+ * fuzzer or sanitizer run stops at the call which did it:
+ * 	- a byte sent without waiting while the last one is still executing,
+ * 	- a position off the display (other than just after the end of a line),
+ * 	- a character printed beyond the end of a line.
+ *
+ * No key is down on the keypad unless a host program holds one with
+ * KeypadHostSetKey() (e.g. to test KeyboardTask()); otherwise it posts
+ * EVENT_KEY events itself.
+ *
+ * Example build, from the Code directory:
+ *     gcc -I. -Ihost host/display_host.c host/clock_host.c my_program.c
+ *
+ * For documentation, see host_sim.h and low_level_funcs_tiva.h.
+ */
+
+#include "low_level_funcs_tiva.h"
+#include "host_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BYTE_MICROSEC 37    // Execution time of a character or most instructions
+#define CLEAR_MICROSEC 1520 // and of Clear Display
+
+static char shadow[2][DISPLAY_WIDTH];
+static short int shadow_line = 0;  // Counting from 0
+static short int shadow_col = 0;
+static short int shadow_cursor_on = 0;
+static unsigned long changes = 0;
+static unsigned long ready_microsec = 0; // GetTickMicrosec() when the last byte has been executed
+static unsigned long bytes_sent = 0;
+static int key_held = -1;          // Key held down, numbered as in KeyboardTask(), or -1
+static unsigned char key_cols = 0; // Columns last made high
+
+static void Fault(const char *what, int value)
+{
+    fprintf(stderr, "display_host: %s (%d)\n", what, value);
+    abort();
+} // Fault
+
+// One byte sent to the LCD, which then executes it for execution_time
+static void SendByte(unsigned long execution_time)
+{
+    if (DisplayBusy())
+    {
+        Fault("byte sent while the LCD is busy", (int)(ready_microsec - GetTickMicrosec()));
+    }
+    ready_microsec = GetTickMicrosec() + execution_time;
+    bytes_sent++;
+} // SendByte
+
+// As the driver's busy loops
+static void WaitUntilReady(void)
+{
+    if (DisplayBusy())
+    {
+        ClockHostAdvance(ready_microsec - GetTickMicrosec());
+    }
+} // WaitUntilReady
+
+int DisplayBusy(void)
+{
+    return (long)(GetTickMicrosec() - ready_microsec) < 0;
+} // DisplayBusy
+
+int DisplayReady(void)
+{
+    return 1; // Started at once
+} // DisplayReady
+
+void ClearDisplay(void)
+{
+    WaitUntilReady();
+    SendByte(CLEAR_MICROSEC);
+    WaitUntilReady();
+    ClockHostAdvance(BYTE_MICROSEC); // The driver's extra wait
+    memset(shadow, ' ', sizeof(shadow));
+    shadow_line = 0;
+    shadow_col = 0;
+    changes++;
+} // ClearDisplay
+
+void TurnCursorOnOffNoWait(short int on)
+{
+    SendByte(BYTE_MICROSEC);
+    shadow_cursor_on = (on != 0);
+} // TurnCursorOnOffNoWait
+
+short int GetCursorOnOff(void)
+{
+    return shadow_cursor_on;
+} // GetCursorOnOff
+
+void SetPrintPositionNoWait(short int line, short int char_pos)
+{
+    if (line != 1 && line != 2)
+    {
+        Fault("no such line", line);
+    }
+    if (char_pos < 1 || char_pos > DISPLAY_WIDTH + 1)
+    {
+        Fault("position off the display", char_pos);
+    }
+    SendByte(BYTE_MICROSEC);
+    shadow_line = line - 1;
+    shadow_col = char_pos - 1;
+} // SetPrintPositionNoWait
+
+void PrintCharNoWait(char ch)
+{
+    if (shadow_col >= DISPLAY_WIDTH)
+    {
+        Fault("character printed beyond the end of the line", shadow_col + 1);
+    }
+    SendByte(BYTE_MICROSEC);
+    shadow[shadow_line][shadow_col] = ch;
+    shadow_col++;
+    changes++;
+} // PrintCharNoWait
+
+void PrintChar(char ch)
+{
+    WaitUntilReady();
+    PrintCharNoWait(ch);
+    WaitUntilReady();
+} // PrintChar
+
+void GetDisplayShadowPosition(short int *line, short int *char_pos)
+{
+    *line = shadow_line + 1;
+    *char_pos = shadow_col + 1;
+} // GetDisplayShadowPosition
+
+const char *GetDisplayShadow(short int line)
+{
+    return shadow[(line == 2) ? 1 : 0];
+} // GetDisplayShadow
+
+unsigned long GetDisplayChangeCount(void)
+{
+    return changes;
+} // GetDisplayChangeCount
+
+unsigned long DisplayHostByteCount(void)
+{
+    return bytes_sent;
+} // DisplayHostByteCount
+
+void KeypadHostSetKey(char key)
+{
+    static const char keys[] = "123A456B789C*0#D"; // Row by row
+    const char *found = (key != '\0') ? strchr(keys, key) : NULL;
+
+    key_held = (found != NULL) ? found - keys : -1;
+} // KeypadHostSetKey
+
+void WriteKeyboardCol(unsigned char nibble)
+{
+    key_cols = nibble;
+} // WriteKeyboardCol
+
+unsigned char ReadKeyboardRow(void)
+{
+    if (key_held >= 0 && (key_cols & (1 << (key_held % 4))) != 0)
+    {
+        return 1 << (key_held / 4); // Its column is high, so its row is
+    }
+    return 0;
+} // ReadKeyboardRow
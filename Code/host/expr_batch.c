@@ -0,0 +1,371 @@
+/* expr_batch.c
+ *
+ * Column-wise evaluation of one program for many values of ANS, with
+ * SSE2 and AVX2 kernels.
+ *
+ * For documentation, see expr_batch.h.
+ */
+
+#include "expr_batch.h"
+#include <float.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86 1
+#include <immintrin.h>
+#else
+#define HAVE_X86 0
+#endif
+
+#define PAD_VALUE 1.0 // ANS for the unused lanes of a last, short tile (their results are not copied out)
+
+// A tile's stack: one column of values per stack level
+typedef double Column[EXPR_BATCH_TILE];
+
+typedef void (*Kernel)(const ExprProgram *program, Column *stack, unsigned char *errors);
+
+static int kernel_used = -1; // One of the EXPR_BATCH_ constants, once chosen
+
+// Mark the lanes in mask (bit n for lane first + n) with error, unless
+// they already have one: ExprEvaluate() stops at the first.
+static void MarkErrors(unsigned char *errors, int first, int mask, unsigned char error)
+{
+    while (mask != 0)
+    {
+        if (mask & 1)
+        {
+            if (errors[first] == EXPR_OK)
+            {
+                errors[first] = error;
+            }
+        }
+        mask >>= 1;
+        first++;
+    }
+}
+
+// ------------------------ Plain C ------------------------
+
+static void KernelScalar(const ExprProgram *program, Column *stack, unsigned char *errors)
+{
+    const ExprStep *step;
+    double *left;
+    double *right;
+    double value;
+    int depth = 1; // stack[0] already holds ANS
+    int s;
+    int i;
+
+    for (s = 0; s < program->length; s++)
+    {
+        step = &program->steps[s];
+        switch (step->op)
+        {
+        case STEP_NUMBER:
+            for (i = 0; i < EXPR_BATCH_TILE; i++)
+            {
+                stack[depth][i] = step->value;
+            }
+            depth++;
+            break;
+        case STEP_ANS:
+            memcpy(stack[depth], stack[0], sizeof(Column));
+            depth++;
+            break;
+        case STEP_NEG:
+            for (i = 0; i < EXPR_BATCH_TILE; i++)
+            {
+                stack[depth - 1][i] = -stack[depth - 1][i];
+            }
+            break;
+        default: // Binary operation, checked as ExprApply() does
+            depth--;
+            left = stack[depth - 1];
+            right = stack[depth];
+            for (i = 0; i < EXPR_BATCH_TILE; i++)
+            {
+                switch (step->op)
+                {
+                case STEP_ADD:
+                    value = left[i] + right[i];
+                    break;
+                case STEP_SUB:
+                    value = left[i] - right[i];
+                    break;
+                case STEP_MUL:
+                    value = left[i] * right[i];
+                    break;
+                default:
+                    if (right[i] == 0.0 && errors[i] == EXPR_OK)
+                    {
+                        errors[i] = EXPR_ERR_DIV_ZERO;
+                    }
+                    value = left[i] / right[i];
+                }
+                if ((value != value || value > DBL_MAX || value < -DBL_MAX) && errors[i] == EXPR_OK)
+                {
+                    errors[i] = EXPR_ERR_RANGE;
+                }
+                left[i] = value;
+            }
+        }
+    }
+    for (i = 0; i < EXPR_BATCH_TILE; i++) // The result is in stack[1]
+    {
+        if ((stack[1][i] > DBL_MAX || stack[1][i] < -DBL_MAX) && errors[i] == EXPR_OK)
+        {
+            errors[i] = EXPR_ERR_RANGE;
+        }
+    }
+}
+
+#if HAVE_X86
+
+// ------------------------ SSE2: 2 lanes ------------------------
+
+static void KernelSse2(const ExprProgram *program, Column *stack, unsigned char *errors)
+{
+    const __m128d sign = _mm_set1_pd(-0.0);
+    const __m128d max = _mm_set1_pd(DBL_MAX);
+    const __m128d zero = _mm_setzero_pd();
+    const ExprStep *step;
+    double *left;
+    double *right;
+    __m128d a;
+    __m128d b;
+    __m128d value;
+    __m128d bad;
+    int depth = 1;
+    int s;
+    int i;
+
+    for (s = 0; s < program->length; s++)
+    {
+        step = &program->steps[s];
+        switch (step->op)
+        {
+        case STEP_NUMBER:
+            value = _mm_set1_pd(step->value);
+            for (i = 0; i < EXPR_BATCH_TILE; i += 2)
+            {
+                _mm_store_pd(&stack[depth][i], value);
+            }
+            depth++;
+            break;
+        case STEP_ANS:
+            memcpy(stack[depth], stack[0], sizeof(Column));
+            depth++;
+            break;
+        case STEP_NEG:
+            for (i = 0; i < EXPR_BATCH_TILE; i += 2)
+            {
+                _mm_store_pd(&stack[depth - 1][i], _mm_xor_pd(_mm_load_pd(&stack[depth - 1][i]), sign));
+            }
+            break;
+        default:
+            depth--;
+            left = stack[depth - 1];
+            right = stack[depth];
+            for (i = 0; i < EXPR_BATCH_TILE; i += 2)
+            {
+                a = _mm_load_pd(&left[i]);
+                b = _mm_load_pd(&right[i]);
+                switch (step->op)
+                {
+                case STEP_ADD:
+                    value = _mm_add_pd(a, b);
+                    break;
+                case STEP_SUB:
+                    value = _mm_sub_pd(a, b);
+                    break;
+                case STEP_MUL:
+                    value = _mm_mul_pd(a, b);
+                    break;
+                default:
+                    bad = _mm_cmpeq_pd(b, zero);
+                    if (_mm_movemask_pd(bad))
+                    {
+                        MarkErrors(errors, i, _mm_movemask_pd(bad), EXPR_ERR_DIV_ZERO);
+                    }
+                    value = _mm_div_pd(a, b);
+                }
+                // NaN or infinite: |value| not <= DBL_MAX (true if unordered)
+                bad = _mm_cmpnle_pd(_mm_andnot_pd(sign, value), max);
+                if (_mm_movemask_pd(bad))
+                {
+                    MarkErrors(errors, i, _mm_movemask_pd(bad), EXPR_ERR_RANGE);
+                }
+                _mm_store_pd(&left[i], value);
+            }
+        }
+    }
+    for (i = 0; i < EXPR_BATCH_TILE; i += 2)
+    {
+        bad = _mm_cmpgt_pd(_mm_andnot_pd(sign, _mm_load_pd(&stack[1][i])), max); // Infinite, but not NaN
+        if (_mm_movemask_pd(bad))
+        {
+            MarkErrors(errors, i, _mm_movemask_pd(bad), EXPR_ERR_RANGE);
+        }
+    }
+}
+
+// ------------------------ AVX2: 4 lanes ------------------------
+
+__attribute__((target("avx2"))) static void KernelAvx2(const ExprProgram *program, Column *stack, unsigned char *errors)
+{
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d max = _mm256_set1_pd(DBL_MAX);
+    const __m256d zero = _mm256_setzero_pd();
+    const ExprStep *step;
+    double *left;
+    double *right;
+    __m256d a;
+    __m256d b;
+    __m256d value;
+    __m256d bad;
+    int depth = 1;
+    int s;
+    int i;
+
+    for (s = 0; s < program->length; s++)
+    {
+        step = &program->steps[s];
+        switch (step->op)
+        {
+        case STEP_NUMBER:
+            value = _mm256_set1_pd(step->value);
+            for (i = 0; i < EXPR_BATCH_TILE; i += 4)
+            {
+                _mm256_store_pd(&stack[depth][i], value);
+            }
+            depth++;
+            break;
+        case STEP_ANS:
+            memcpy(stack[depth], stack[0], sizeof(Column));
+            depth++;
+            break;
+        case STEP_NEG:
+            for (i = 0; i < EXPR_BATCH_TILE; i += 4)
+            {
+                _mm256_store_pd(&stack[depth - 1][i], _mm256_xor_pd(_mm256_load_pd(&stack[depth - 1][i]), sign));
+            }
+            break;
+        default:
+            depth--;
+            left = stack[depth - 1];
+            right = stack[depth];
+            for (i = 0; i < EXPR_BATCH_TILE; i += 4)
+            {
+                a = _mm256_load_pd(&left[i]);
+                b = _mm256_load_pd(&right[i]);
+                switch (step->op)
+                {
+                case STEP_ADD:
+                    value = _mm256_add_pd(a, b);
+                    break;
+                case STEP_SUB:
+                    value = _mm256_sub_pd(a, b);
+                    break;
+                case STEP_MUL:
+                    value = _mm256_mul_pd(a, b);
+                    break;
+                default:
+                    bad = _mm256_cmp_pd(b, zero, _CMP_EQ_OQ);
+                    if (_mm256_movemask_pd(bad))
+                    {
+                        MarkErrors(errors, i, _mm256_movemask_pd(bad), EXPR_ERR_DIV_ZERO);
+                    }
+                    value = _mm256_div_pd(a, b);
+                }
+                bad = _mm256_cmp_pd(_mm256_andnot_pd(sign, value), max, _CMP_NLE_UQ);
+                if (_mm256_movemask_pd(bad))
+                {
+                    MarkErrors(errors, i, _mm256_movemask_pd(bad), EXPR_ERR_RANGE);
+                }
+                _mm256_store_pd(&left[i], value);
+            }
+        }
+    }
+    for (i = 0; i < EXPR_BATCH_TILE; i += 4)
+    {
+        bad = _mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_load_pd(&stack[1][i])), max, _CMP_GT_OQ);
+        if (_mm256_movemask_pd(bad))
+        {
+            MarkErrors(errors, i, _mm256_movemask_pd(bad), EXPR_ERR_RANGE);
+        }
+    }
+}
+
+#endif // HAVE_X86
+
+static int BestKernel(void)
+{
+#if HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return EXPR_BATCH_AVX2;
+    }
+    return EXPR_BATCH_SSE2; // Every x86-64 has SSE2
+#else
+    return EXPR_BATCH_SCALAR;
+#endif
+}
+
+int ExprBatchKernel(void)
+{
+    if (kernel_used < 0)
+    {
+        kernel_used = BestKernel();
+    }
+    return kernel_used;
+}
+
+int ExprBatchSetKernel(int kernel)
+{
+    int best = BestKernel();
+
+    kernel_used = (kernel >= EXPR_BATCH_SCALAR && kernel <= best) ? kernel : best;
+    return kernel_used;
+}
+
+void ExprEvaluateBatch(const ExprProgram *program, const double *ans, double *results, unsigned char *errors,
+                       int count)
+{
+    // Stack level 0 holds ANS; the program's own stack starts at level 1.
+    // Aligned for the vector loads and stores.
+    Column stack[EXPR_MAX_STEPS + 1] __attribute__((aligned(32)));
+    unsigned char tile_errors[EXPR_BATCH_TILE];
+    Kernel kernel = KernelScalar;
+    int first;
+    int n;
+    int i;
+
+#if HAVE_X86
+    switch (ExprBatchKernel())
+    {
+    case EXPR_BATCH_AVX2:
+        kernel = KernelAvx2;
+        break;
+    case EXPR_BATCH_SSE2:
+        kernel = KernelSse2;
+        break;
+    }
+#endif
+    for (first = 0; first < count; first += EXPR_BATCH_TILE)
+    {
+        n = (count - first < EXPR_BATCH_TILE) ? count - first : EXPR_BATCH_TILE;
+        memcpy(stack[0], &ans[first], n * sizeof(double));
+        for (i = n; i < EXPR_BATCH_TILE; i++)
+        {
+            stack[0][i] = PAD_VALUE;
+        }
+        memset(tile_errors, EXPR_OK, sizeof(tile_errors));
+        kernel(program, stack, tile_errors);
+        for (i = 0; i < n; i++)
+        {
+            errors[first + i] = tile_errors[i];
+            results[first + i] = (tile_errors[i] == EXPR_OK) ? stack[1][i] : 0.0;
+        }
+    }
+}
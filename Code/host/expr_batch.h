@@ -0,0 +1,64 @@
+/*! \file expr_batch.h
+ *
+ * Evaluation of one compiled expression (expression.h) for a whole array
+ * of values of ANS at once, for tabulating on the host, e.g. "Ax2+1" for
+ * a million values.
+ *
+ * ExprEvaluate() interprets the program's steps once per value, so most
+ * of its time goes on deciding what each step is. Here the values are
+ * taken \a EXPR_BATCH_TILE at a time and each step is applied to the
+ * whole tile before the next (column-wise), so a step is decoded once
+ * per tile, and the loop over the tile is an SSE2 or AVX2 vector kernel
+ * where the processor has them (chosen when first called), or plain C
+ * where it has not.
+ *
+ * The results are bit-for-bit those of ExprEvaluate() for each value,
+ * errors included: the same IEEE double operations are done in the same
+ * order (vector additions, multiplications etc. round exactly as scalar
+ * ones do), and each value's error is the first one ExprEvaluate()
+ * would have stopped at. Only the last operation is not recorded.
+ * host/expr_batch_bench.c checks this and measures the speed.
+ *
+ * Build it with expression.c, from the Code directory, e.g.
+ *     gcc -O2 -I. -Ihost my_program.c host/expr_batch.c expression.c
+ */
+
+#ifndef EXPR_BATCH_H
+#define EXPR_BATCH_H
+
+#include "expression.h"
+
+/*! Values taken at a time: small enough that a tile's stack of
+ * \a EXPR_MAX_STEPS columns stays in the L1 cache. */
+#define EXPR_BATCH_TILE 128
+
+//! \name Kernels
+//@{
+#define EXPR_BATCH_SCALAR 0 //!< Plain C, for any processor
+#define EXPR_BATCH_SSE2 1   //!< 2 values per instruction (any x86-64)
+#define EXPR_BATCH_AVX2 2   //!< 4 values per instruction
+//@}
+
+/*! Evaluate a program for many values of ANS.
+ *
+ * \param [in] program A program compiled by ExprCompile() without error.
+ * \param [in] ans The values of ANS.
+ * \param [out] results The value for each; 0.0 where there was an error.
+ * \param [out] errors EXPR_OK, EXPR_ERR_DIV_ZERO or EXPR_ERR_RANGE for each.
+ * \param [in] count Number of values.
+ */
+void ExprEvaluateBatch( const ExprProgram *program, const double *ans, double *results,
+			unsigned char *errors, int count );
+
+/*! \return The kernel ExprEvaluateBatch() uses: one of the
+ * EXPR_BATCH_ constants. */
+int ExprBatchKernel( void );
+
+/*! Use a given kernel (e.g. to compare them), or the best there is if
+ * this processor does not have it.
+ *
+ * \return The kernel now used.
+ */
+int ExprBatchSetKernel( int kernel );
+
+#endif // of #ifndef EXPR_BATCH_H
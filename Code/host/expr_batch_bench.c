@@ -0,0 +1,174 @@
+/* expr_batch_bench.c
+ *
+ * Host (Linux) benchmark and check of the batch evaluator (expr_batch.h):
+ * for several entries it evaluates a million values of ANS one at a time
+ * with ExprEvaluate() (the scalar loop), then with ExprEvaluateBatch()
+ * using each kernel this processor has, and prints millions of values
+ * per second and the speed-up over the scalar loop. Every result and
+ * error from the batch is compared bit for bit with the scalar loop's;
+ * any difference is reported and makes the exit status 1.
+ *
+ * The values include zeros, huge numbers, infinities and NaN, so that
+ * division by zero and range errors occur and are checked too.
+ *
+ * Build and run, from the Code directory:
+ *     gcc -O2 -I. -Ihost -o expr_batch_bench host/expr_batch_bench.c host/expr_batch.c expression.c
+ *     ./expr_batch_bench
+ */
+
+#include "expr_batch.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define VALUES 1000000
+#define MIN_TIME 0.2 // Seconds each measurement runs for, at least
+
+static const char *entries[] = {"Ax2+1", "A/3-A/7x2.5", "1/A", "AxA-2xA+1", "-A/0.5", "Ax1E300",
+                                "A+1.5xA-3/A+AxAx0.25-7.5/2+A", NULL};
+static const char *kernel_names[] = {"scalar", "SSE2", "AVX2"};
+
+static double ans[VALUES];
+static double expected[VALUES];
+static unsigned char expected_errors[VALUES];
+static double results[VALUES];
+static unsigned char errors[VALUES];
+
+static double Now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static void MakeValues(void)
+{
+    int i;
+
+    srand(1);
+    for (i = 0; i < VALUES; i++)
+    {
+        switch (i % 64)
+        {
+        case 7:
+            ans[i] = 0.0;
+            break;
+        case 19:
+            ans[i] = -0.0;
+            break;
+        case 23:
+            ans[i] = 1.5E307 * (rand() % 100);
+            break;
+        case 41:
+            ans[i] = HUGE_VAL;
+            break;
+        case 53:
+            ans[i] = NAN;
+            break;
+        default:
+            ans[i] = (rand() - RAND_MAX / 2) / 1000.0;
+        }
+    }
+}
+
+// Values per second (in millions) of the scalar loop, filling expected[]
+static double TimeScalar(ExprProgram *program)
+{
+    double start = Now();
+    double seconds;
+    long runs = 0;
+    int i;
+
+    do
+    {
+        for (i = 0; i < VALUES; i++)
+        {
+            expected[i] = 0.0;
+            expected_errors[i] = ExprEvaluate(program, ans[i], &expected[i]);
+        }
+        runs++;
+    } while ((seconds = Now() - start) < MIN_TIME);
+    return runs * (VALUES / 1e6) / seconds;
+}
+
+static double TimeBatch(ExprProgram *program)
+{
+    double start = Now();
+    double seconds;
+    long runs = 0;
+
+    do
+    {
+        ExprEvaluateBatch(program, ans, results, errors, VALUES);
+        runs++;
+    } while ((seconds = Now() - start) < MIN_TIME);
+    return runs * (VALUES / 1e6) / seconds;
+}
+
+// Differences from the scalar loop, the first of which is printed
+static int Compare(const char *entry, const char *kernel)
+{
+    int differences = 0;
+    int i;
+
+    for (i = 0; i < VALUES; i++)
+    {
+        if (errors[i] != expected_errors[i] || memcmp(&results[i], &expected[i], sizeof(double)) != 0)
+        {
+            if (differences == 0)
+            {
+                printf("  %s %s: A=%.17g gives %.17g error %d, not %.17g error %d\n", entry, kernel, ans[i],
+                       results[i], errors[i], expected[i], expected_errors[i]);
+            }
+            differences++;
+        }
+    }
+    return differences;
+}
+
+int main(void)
+{
+    ExprProgram program;
+    double scalar_rate;
+    double rate;
+    int failures = 0;
+    int best = ExprBatchSetKernel(EXPR_BATCH_AVX2); // The best there is
+    int kernel;
+    int e;
+
+    MakeValues();
+    printf("%-30s %8s", "Mvalues/s", "loop");
+    for (kernel = EXPR_BATCH_SCALAR; kernel <= best; kernel++)
+    {
+        printf(" %15s", kernel_names[kernel]);
+    }
+    printf("\n");
+    for (e = 0; entries[e] != NULL; e++)
+    {
+        if (ExprCompile(entries[e], &program) != EXPR_OK)
+        {
+            printf("%-30s does not compile\n", entries[e]);
+            failures++;
+            continue;
+        }
+        scalar_rate = TimeScalar(&program);
+        printf("%-30s %8.1f", entries[e], scalar_rate);
+        for (kernel = EXPR_BATCH_SCALAR; kernel <= best; kernel++)
+        {
+            ExprBatchSetKernel(kernel);
+            rate = TimeBatch(&program);
+            printf(" %8.1f (%4.1fx)", rate, rate / scalar_rate);
+            fflush(stdout);
+            if (Compare(entries[e], kernel_names[kernel]) != 0)
+            {
+                failures++;
+            }
+        }
+        printf("\n");
+    }
+    printf(failures ? "%d MISMATCHES\n" : "all results bit-identical to ExprEvaluate()\n", failures);
+    return failures != 0;
+}
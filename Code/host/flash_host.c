@@ -0,0 +1,81 @@
+/* flash_host.c
+ *
+ * Linux stand-in for the answer, macro and statistics functions of the
+ * flash (WriteDoubleToFlash(), WriteMacrosToFlash(), WriteStatsToFlash()
+ * and their Read functions in low_level_funcs_tiva.c), so that
+ * calculator.c, macro.c and stats.c can be run on the host. The "flash" is a buffer in RAM, written at
+ * once, so it is empty each time the program starts, as the board's is
+ * after the block has been erased.
+ *
+ * Example build, from the Code directory:
+ *     gcc -I. -Ihost macro.c stats.c host/flash_host.c my_program.c
+ *
+ * For documentation, see host_sim.h and low_level_funcs_tiva.h.
+ */
+
+#include "low_level_funcs_tiva.h"
+#include "host_sim.h"
+#include <string.h>
+
+static double answer_flash = 0.0; // Returned if nothing has been stored yet
+static unsigned char macro_flash[MACRO_FLASH_MAX_SIZE];
+static int macro_flash_size = 0; // Size of the record written, 0 if none
+static unsigned char stats_flash[STATS_FLASH_MAX_SIZE];
+static int stats_flash_size = 0;
+
+void WriteDoubleToFlash(double number)
+{
+    answer_flash = number;
+} // WriteDoubleToFlash
+
+double ReadDoubleFromFlash(void)
+{
+    return answer_flash;
+} // ReadDoubleFromFlash
+
+void WriteMacrosToFlash(const void *macros, int size)
+{
+    if (size > MACRO_FLASH_MAX_SIZE)
+    {
+        return; // As on the board: would not fit in a slot
+    }
+    memcpy(macro_flash, macros, size);
+    macro_flash_size = size;
+} // WriteMacrosToFlash
+
+int ReadMacrosFromFlash(void *macros, int size)
+{
+    if (macro_flash_size == 0 || (macro_flash_size + 3) / 4 != (size + 3) / 4)
+    {
+        return 0; // None written, or of another size
+    }
+    memcpy(macros, macro_flash, size);
+    return 1;
+} // ReadMacrosFromFlash
+
+void WriteStatsToFlash(const void *stats, int size)
+{
+    if (size > STATS_FLASH_MAX_SIZE)
+    {
+        return;
+    }
+    memcpy(stats_flash, stats, size);
+    stats_flash_size = size;
+} // WriteStatsToFlash
+
+int ReadStatsFromFlash(void *stats, int size)
+{
+    if (stats_flash_size == 0 || (stats_flash_size + 3) / 4 != (size + 3) / 4)
+    {
+        return 0;
+    }
+    memcpy(stats, stats_flash, size);
+    return 1;
+} // ReadStatsFromFlash
+
+void FlashHostErase(void)
+{
+    answer_flash = 0.0;
+    macro_flash_size = 0;
+    stats_flash_size = 0;
+} // FlashHostErase
@@ -0,0 +1,496 @@
+/* fuzz_calc.c
+ *
+ * Host (Linux) harness which runs the calculator's own input handling,
+ * evaluation and display code on arbitrary input, for coverage-guided
+ * fuzzing with libFuzzer and the sanitizers, and as a timing benchmark
+ * over the corpus in host/corpus.
+ *
+ * Each input is one of:
+ * 	E<entry>	An entry, given to the evaluators directly:
+ * 			ExprCompile() and ExprEvaluate() (with ANS), ExprFormat(),
+ * 			CalcEvaluate(), BigEvaluate() if it is short enough to type,
+ * 			and DisplayResult() or DisplayErrorMessage().
+ * 	S<bytes>	Serial mode (Shift then 0), then the bytes as they would
+ * 			arrive at 115200 baud, each put in the receive ring by
+ * 			UART_RxIsr() as the receive interrupt does, then any key
+ * 			to leave the mode. Replies are taken out of the transmit
+ * 			ring as the transmit interrupt does (see SerialWireTask()).
+ * 	<keys>		Anything else: key presses, from the password having been
+ * 			accepted. A byte which is a key's character (0-9 A-D * #)
+ * 			is that key; other bytes below 0x80 are "123A456B789C*0#D"[b & 15]
+ * 			and bytes from 0x80 let (b & 0x7F) x 25 ms pass with no key,
+ * 			so overlays, hints and scrolling time out.
+ * The keys go through calculator.c, as in main.c, with an input
+ * buffer of exactly INPUT_BUFFER_SIZE bytes on the heap, so that
+ * AddressSanitizer sees a write even one byte past it. The LCD is
+ * host/display_host.c, which aborts on anything the real one would get
+ * wrong (a byte while busy, a position off the display, a character
+ * past the end of a line), so those are found as crashes too.
+ *
+ * Every input starts from the same state: decimal mode, answers of 0,
+ * an empty result cache and no timers running. The one exception is
+ * serial mode (Shift 0) left on by the last input, which the first key
+ * ends, as on the calculator.
+ *
+ * Fuzz (clang), from the Code directory:
+ *     clang -g -O1 -fsanitize=fuzzer,address,undefined -DFUZZ_LIBFUZZER -DHOST_SIM -I. -Ihost \
+ *         -o fuzz_calc host/fuzz_calc.c calculator.c \
+ *         high_level_funcs.c mid_level_funcs.c rpn.c bignum.c expression.c grammar.c macro.c radix.c stats.c \
+ *         result_cache.c scheduler.c ring_buffer.c lcd_mirror.c serial_calc.c UART.c event_trace.c \
+ *         mem_guard.c clock_policy.c host/uart_host.c host/stack_host.c host/clock_host.c \
+ *         host/display_host.c host/calculate_answer_host.c host/flash_host.c host/calc_lib.c -lm
+ *     mkdir -p findings && ./fuzz_calc findings host/corpus
+ * New inputs which reach new code go in findings; any which crashed are
+ * left as crash-* files, and can be run again with ./fuzz_calc crash-...
+ *
+ * Without libFuzzer (gcc or clang, with or without sanitizers) the
+ * program's own main() runs files or directories of inputs instead:
+ *     gcc -g -O2 -fsanitize=address,undefined -DHOST_SIM -I. -Ihost \
+ *         -o fuzz_calc host/fuzz_calc.c calculator.c \
+ *         high_level_funcs.c mid_level_funcs.c rpn.c bignum.c expression.c grammar.c macro.c radix.c stats.c \
+ *         result_cache.c scheduler.c ring_buffer.c lcd_mirror.c serial_calc.c UART.c event_trace.c \
+ *         mem_guard.c clock_policy.c host/uart_host.c host/stack_host.c host/clock_host.c \
+ *         host/display_host.c host/calculate_answer_host.c host/flash_host.c host/calc_lib.c -lm
+ *     ./fuzz_calc [-n runs] [-w times.txt] [-b baseline.txt] host/corpus
+ * Each input is run n times (default 200) in each of TIMING_ROUNDS
+ * rounds, and its time per run in its fastest round printed.
+ * -w saves the times; -b compares with times saved earlier (on the same
+ * PC, e.g. before a change) and exits with 1 if any input has become
+ * more than SLOWER_LIMIT times slower. Build without the sanitizers for
+ * timings that mean something.
+ */
+
+#include "high_level_funcs.h"
+#include "mid_level_funcs.h"
+#include "low_level_funcs_tiva.h"
+#include "scheduler.h"
+#include "expression.h"
+#include "result_cache.h"
+#include "bignum.h"
+#include "rpn.h"
+#include "macro.h"
+#include "radix.h"
+#include "stats.h"
+#include "calculate_answer.h"
+#include "calc_lib.h"
+#include "calculator.h"
+#include "clock_policy.h"
+#include "host_sim.h"
+#include "UART.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define INPUT_BUFFER_SIZE 17     // As main.c
+#define KEY_GAP_MICROSEC 50000   // Between key presses: a fast typist
+#define WAIT_STEP_MILLISEC 25    // Time passed per unit of a wait byte
+#define PASS_MICROSEC 10         // Time taken by a pass of the scheduler with work to do, roughly as on the board
+#define SERIAL_FIFO_SIZE 16      // Bytes received per receive interrupt, as the Tiva FIFO holds 16
+#define SERIAL_FIFO_MICROSEC 1389 // Time taken to receive them at 115200 baud
+#define DEFAULT_RUNS 200
+#define TIMING_ROUNDS 5          // of the runs, each timed
+#define SLOWER_LIMIT 1.5         // -b fails an input this many times slower than its baseline
+#define SLOWER_FLOOR_MICROSEC 20 // unless it still takes less than this (timer noise)
+#define MAX_INPUTS 4096
+#define NAME_SIZE 512
+
+static char *input_buffer; // Exactly INPUT_BUFFER_SIZE, on the heap
+static char big_result[BIG_TEXT_SIZE];
+
+// ------------------------ The calculator, as main.c runs it ------------------------
+
+static void HandleEvent(const Event *event)
+{
+    ClockPolicyWake();
+    if (!OverlayEvent(event))
+    {
+        CalculatorEvent(event);
+    }
+}
+
+// Run the scheduler until nothing is left to do, then let time pass
+static void RunFor(unsigned long microsec)
+{
+    unsigned long end = GetTickMicrosec() + microsec;
+
+    do
+    {
+        while (SchedulerPass(HandleEvent) > 0 || DisplayFlushPending())
+        {
+            ClockHostAdvance(PASS_MICROSEC);
+        }
+        ClockHostAdvance(1000);
+    } while ((long)(GetTickMicrosec() - end) < 0);
+}
+
+// The other end of the serial line: takes whatever the calculator sends
+// (serial mode replies, the LCD mirror) out of the transmit ring, as the
+// transmit interrupt would, so the ring never stays full
+static void SerialWireTask(void)
+{
+    unsigned char byte;
+
+    while (UART_TxIsr(&byte))
+    {
+    }
+}
+
+static void RunKeys(const unsigned char *data, size_t size);
+
+static void Start(void)
+{
+    static int started = 0;
+    int i;
+
+    if (!started)
+    {
+        input_buffer = malloc(INPUT_BUFFER_SIZE);
+        if (input_buffer == NULL)
+        {
+            abort();
+        }
+        UART_Init();
+        InitScheduler();
+        AddBackgroundTask(DisplayFlushTask);
+        AddBackgroundTask(SerialModeTask);
+        AddBackgroundTask(SerialWireTask);
+        AddBackgroundTask(ClockPolicyTask);
+        started = 1;
+    }
+    for (i = 0; i < TIMER_COUNT; i++) // Whatever the last input left running
+    {
+        StopTimer(i);
+    }
+    DismissOverlay();
+    memset(input_buffer, 0, INPUT_BUFFER_SIZE);
+    CalculatorInit(input_buffer, INPUT_BUFFER_SIZE); // An answer of 0, no last operation
+    ResultCacheClear();
+    FlashHostErase(); // No macros, none being recorded or replayed, and no points
+    MacroLoad();
+    StatsLoad();
+    MacroCancelRecording();
+    MacroStopReplay();
+    DisplayResult(CalculatorGetAnswer());
+    StartCalculator();
+    while (GetInputNumberMode() != NUMBER_MODE_DECIMAL)
+    {
+        RunKeys((const unsigned char *)"D7", 2); // Shift 7 goes round the modes back to it
+        DismissOverlay();
+        StopTimer(TIMER_OVERLAY);
+    }
+}
+
+static void RunKeys(const unsigned char *data, size_t size)
+{
+    static const char keys[] = "123A456B789C*0#D";
+    size_t i;
+    unsigned char b;
+
+    for (i = 0; i < size; i++)
+    {
+        b = data[i];
+        if (b >= 0x80)
+        {
+            RunFor((b & 0x7F) * WAIT_STEP_MILLISEC * 1000UL);
+            continue;
+        }
+        PostEvent(EVENT_KEY, strchr(keys, b) != NULL && b != '\0' ? b : keys[b & 15]);
+        RunFor(KEY_GAP_MICROSEC);
+    }
+}
+
+// ------------------------ The evaluators on their own ------------------------
+
+static void RunEntry(const unsigned char *data, size_t size)
+{
+    char *entry = malloc(size + 1); // Exactly the size, for AddressSanitizer
+    char text[EXPR_RESULT_SIZE];
+    char output[CALC_OUTPUT_SIZE];
+    ExprProgram program;
+    double result;
+    int error;
+
+    if (entry == NULL)
+    {
+        abort();
+    }
+    memcpy(entry, data, size);
+    entry[size] = '\0';
+
+    error = ExprCompile(entry, &program);
+    if (error == EXPR_OK)
+    {
+        error = ExprEvaluate(&program, 1.5, &result);
+    }
+    if (error == EXPR_OK)
+    {
+        if (!ExprFormat(result, text, sizeof(text)))
+        {
+            fprintf(stderr, "fuzz_calc: %G does not fit EXPR_RESULT_SIZE\n", result);
+            abort();
+        }
+        DisplayResult(result);
+    }
+    else if (error > 0 && error <= EXPR_ERR_TOO_LONG)
+    {
+        DisplayErrorMessage(expr_error_line1[error], expr_error_line2[error]);
+    }
+    else
+    {
+        fprintf(stderr, "fuzz_calc: no such error %d\n", error);
+        abort();
+    }
+    CalcEvaluate(entry, (int)strlen(entry), output, sizeof(output), NULL);
+    if (strlen(entry) < INPUT_BUFFER_SIZE) // Only what can be typed reaches bignum.c
+    {
+        BigEvaluate(entry, big_result, BIG_TEXT_SIZE);
+    }
+    RunFor(KEY_GAP_MICROSEC);
+    free(entry);
+}
+
+// ------------------------ Serial mode ------------------------
+
+static void RunSerial(const unsigned char *data, size_t size)
+{
+    size_t i;
+
+    RunKeys((const unsigned char *)"D0", 2);
+    for (i = 0; i < size; i++)
+    {
+        UART_RxIsr(data[i]); // Lost, and counted, if the receive ring is full
+        if (i % SERIAL_FIFO_SIZE == SERIAL_FIFO_SIZE - 1)
+        {
+            RunFor(SERIAL_FIFO_MICROSEC);
+        }
+    }
+    RunFor(KEY_GAP_MICROSEC);
+    RunKeys((const unsigned char *)"#", 1); // Any key leaves serial mode
+}
+
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size)
+{
+    Start();
+    if (size > 0 && data[0] == 'E')
+    {
+        RunEntry(data + 1, size - 1);
+    }
+    else if (size > 0 && data[0] == 'S')
+    {
+        RunSerial(data + 1, size - 1);
+    }
+    else
+    {
+        RunKeys(data, size);
+    }
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+// ------------------------ Corpus runner and benchmark ------------------------
+
+typedef struct
+{
+    char name[NAME_SIZE];
+    unsigned char *data;
+    size_t size;
+    double microsec; // Per run
+} Input;
+
+static Input inputs[MAX_INPUTS];
+static int input_count = 0;
+
+static void AddFile(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    Input *input;
+    long size;
+
+    if (file == NULL)
+    {
+        perror(path);
+        exit(2);
+    }
+    if (input_count == MAX_INPUTS)
+    {
+        fprintf(stderr, "more than %d inputs\n", MAX_INPUTS);
+        exit(2);
+    }
+    input = &inputs[input_count++];
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    rewind(file);
+    input->data = malloc(size > 0 ? size : 1);
+    input->size = fread(input->data, 1, size, file);
+    snprintf(input->name, NAME_SIZE, "%s", path);
+    fclose(file);
+}
+
+static int CompareNames(const void *a, const void *b)
+{
+    return strcmp(((const Input *)a)->name, ((const Input *)b)->name);
+}
+
+static void AddPath(const char *path)
+{
+    struct stat info;
+    struct dirent *entry;
+    char name[NAME_SIZE];
+    DIR *dir;
+
+    if (stat(path, &info) == 0 && S_ISDIR(info.st_mode))
+    {
+        dir = opendir(path);
+        while (dir != NULL && (entry = readdir(dir)) != NULL)
+        {
+            if (entry->d_name[0] != '.')
+            {
+                snprintf(name, sizeof(name), "%s/%s", path, entry->d_name);
+                AddFile(name);
+            }
+        }
+        if (dir != NULL)
+        {
+            closedir(dir);
+        }
+    }
+    else
+    {
+        AddFile(path);
+    }
+}
+
+static double Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now); // Not the time spent waiting for the CPU
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+// The baseline time of the input with this name, or -1 if there is none
+static double Baseline(FILE *baseline, const char *name)
+{
+    char line[NAME_SIZE + 40];
+    char saved[NAME_SIZE];
+    double microsec;
+
+    rewind(baseline);
+    while (fgets(line, sizeof(line), baseline) != NULL)
+    {
+        if (sscanf(line, "%lf %511s", &microsec, saved) == 2 && strcmp(saved, name) == 0)
+        {
+            return microsec;
+        }
+    }
+    return -1.0;
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *save = NULL;
+    FILE *baseline = NULL;
+    double start;
+    double before;
+    double microsec;
+    double total = 0.0;
+    int runs = DEFAULT_RUNS;
+    int round;
+    int slower = 0;
+    int i;
+    int r;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            runs = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+        {
+            if ((save = fopen(argv[++i], "w")) == NULL)
+            {
+                perror(argv[i]);
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+        {
+            if ((baseline = fopen(argv[++i], "r")) == NULL)
+            {
+                perror(argv[i]);
+                return 2;
+            }
+        }
+        else
+        {
+            AddPath(argv[i]);
+        }
+    }
+    if (input_count == 0 || runs < 1)
+    {
+        fprintf(stderr, "usage: fuzz_calc [-n runs] [-w times.txt] [-b baseline.txt] file|directory...\n");
+        return 2;
+    }
+    qsort(inputs, input_count, sizeof(Input), CompareNames);
+
+    for (i = 0; i < input_count; i++)
+    {
+        LLVMFuzzerTestOneInput(inputs[i].data, inputs[i].size); // Once untimed: the first run of a file warms up
+    }
+    // Each input's time is from its fastest round, as the others were
+    // interrupted. The rounds go round all the inputs, so that each
+    // input's are spread out and a busy moment on the PC spoils only one.
+    for (round = 0; round < TIMING_ROUNDS; round++)
+    {
+        for (i = 0; i < input_count; i++)
+        {
+            start = Now();
+            for (r = 0; r < runs; r++)
+            {
+                LLVMFuzzerTestOneInput(inputs[i].data, inputs[i].size);
+            }
+            microsec = (Now() - start) / runs;
+            if (round == 0 || microsec < inputs[i].microsec)
+            {
+                inputs[i].microsec = microsec;
+            }
+        }
+    }
+    for (i = 0; i < input_count; i++)
+    {
+        total += inputs[i].microsec;
+        printf("%10.2f us  %s", inputs[i].microsec, inputs[i].name);
+        if (baseline != NULL && (before = Baseline(baseline, inputs[i].name)) > 0.0)
+        {
+            printf("  (was %.2f)", before);
+            if (inputs[i].microsec > before * SLOWER_LIMIT && inputs[i].microsec > SLOWER_FLOOR_MICROSEC)
+            {
+                printf("  SLOWER");
+                slower++;
+            }
+        }
+        printf("\n");
+        if (save != NULL)
+        {
+            fprintf(save, "%.2f %s\n", inputs[i].microsec, inputs[i].name);
+        }
+    }
+    printf("%d inputs, %d runs each, %.2f us per pass of all of them\n", input_count, runs, total);
+    if (save != NULL)
+    {
+        fclose(save);
+    }
+    if (slower > 0)
+    {
+        printf("%d inputs more than %.1f times slower than the baseline\n", slower, SLOWER_LIMIT);
+        return 1;
+    }
+    return 0;
+}
+
+#endif // FUZZ_LIBFUZZER
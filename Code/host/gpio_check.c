@@ -0,0 +1,119 @@
+/* gpio_check.c
+ *
+ * Host (Linux) check that the LCD and keypad signal functions in
+ * gpio_pins.c change only their own pins, each with single stores and no
+ * read-modify-write, run against the masked-address model of the ports in
+ * host/gpio_host.c.
+ *
+ * Every other pin of ports A, B, D and E is first set to a pattern (on
+ * port A that includes PA0 and PA1, which belong to UART0), and must
+ * still have it after each call. The number of reads and writes of each
+ * port is checked against what the function should need: a read would
+ * mean a read-modify-write, which an interrupt can undo.
+ *
+ * Any difference is reported and makes the exit status 1.
+ *
+ * Build and run, from the Code directory:
+ *     gcc -O2 -DHOST_SIM -I. -Ihost -o gpio_check host/gpio_check.c gpio_pins.c host/gpio_host.c \
+ *         host/clock_host.c
+ *     ./gpio_check
+ */
+
+#include "low_level_funcs_tiva.h"
+#include "gpio_pins.h"
+#include "host_sim.h"
+#include <stdio.h>
+
+#define UART_PINS 0x03 // PA0 and PA1
+
+static const unsigned long bases[] = {GPIO_PORTA_BASE, GPIO_PORTB_BASE, GPIO_PORTD_BASE, GPIO_PORTE_BASE};
+static const char port_names[] = "ABDE";
+static const unsigned char own_pins[] = {LCD_RS_PIN | LCD_EN_PIN, LCD_DATA_PINS, KEYPAD_COL_PINS, KEYPAD_ROW_PINS};
+
+static unsigned long reads[4];
+static unsigned long writes[4];
+static int failures = 0;
+
+static void Check(int ok, const char *what, int port)
+{
+    if (!ok && failures++ < 20)
+    {
+        printf("FAILED: %s (port %c)\n", what, port_names[port]);
+    }
+}
+
+// Set every pin which is not the LCD's or keypad's to pattern, and note the counts
+static void Start(unsigned char pattern)
+{
+    int p;
+
+    for (p = 0; p < 4; p++)
+    {
+        GpioHostWrite(GPIO_DATA_MASKED(bases[p], (unsigned char)~own_pins[p]), pattern);
+        reads[p] = GpioHostReadCount(bases[p]);
+        writes[p] = GpioHostWriteCount(bases[p]);
+    }
+}
+
+// Check the other pins still have pattern, and each port was read and written as expected
+static void Finish(unsigned char pattern, const unsigned long expect_reads[4], const unsigned long expect_writes[4])
+{
+    int p;
+
+    for (p = 0; p < 4; p++)
+    {
+        Check((GpioHostPins(bases[p]) & ~own_pins[p]) == (pattern & ~own_pins[p]), "other pins left alone", p);
+        Check(GpioHostReadCount(bases[p]) - reads[p] == expect_reads[p], "number of reads", p);
+        Check(GpioHostWriteCount(bases[p]) - writes[p] == expect_writes[p], "number of writes", p);
+    }
+    Check((GpioHostPins(GPIO_PORTA_BASE) & UART_PINS) == (pattern & UART_PINS), "UART pins PA0 and PA1 untouched", 0);
+}
+
+int main(void)
+{
+    static const unsigned char patterns[] = {0x00, 0xFF, 0x55, 0xAA, 0x81};
+    static const unsigned long nibble_reads[4] = {0, 0, 0, 0};
+    static const unsigned long nibble_writes[4] = {3, 1, 0, 0}; // RS, EN high, EN low; the data
+    static const unsigned long col_reads[4] = {0, 0, 0, 0};
+    static const unsigned long col_writes[4] = {0, 0, 1, 0};
+    static const unsigned long row_reads[4] = {0, 0, 0, 1};
+    static const unsigned long row_writes[4] = {0, 0, 0, 0};
+    unsigned char pattern;
+    unsigned char rows;
+    int i;
+    int value;
+
+    for (i = 0; i < (int)sizeof(patterns); i++)
+    {
+        pattern = patterns[i];
+        for (value = 0; value < 32; value++) // Each nibble, as instruction and as data
+        {
+            Start(pattern);
+            SendDisplayNibble(value & 0x0F, value >> 4);
+            Finish(pattern, nibble_reads, nibble_writes);
+            Check(((GpioHostPins(GPIO_PORTB_BASE) & LCD_DATA_PINS) >> LCD_DATA_SHIFT) == (value & 0x0F),
+                  "LCD data pins hold the nibble", 1);
+            Check(((GpioHostPins(GPIO_PORTA_BASE) & LCD_RS_PIN) != 0) == (value >> 4), "RS set as asked", 0);
+            Check((GpioHostPins(GPIO_PORTA_BASE) & LCD_EN_PIN) == 0, "EN low after the pulse", 0);
+        }
+        for (value = 0; value < 16; value++) // Each set of columns
+        {
+            Start(pattern);
+            WriteKeyboardCol(value);
+            Finish(pattern, col_reads, col_writes);
+            Check((GpioHostPins(GPIO_PORTD_BASE) & KEYPAD_COL_PINS) == value, "columns set as asked", 2);
+        }
+        for (value = 0; value < 256; value++) // Every level of every pin of port E, keypad or not
+        {
+            Start(pattern);
+            GpioHostSetInputs(GPIO_PORTE_BASE, 0xFF, value);
+            rows = ReadKeyboardRow();
+            GpioHostSetInputs(GPIO_PORTE_BASE, 0, 0);
+            Finish(pattern, row_reads, row_writes);
+            Check(rows == (value & KEYPAD_ROW_PINS), "rows read, other pins of port E as 0", 3);
+        }
+    }
+
+    printf(failures ? "%d FAILURES\n" : "all GPIO checks passed\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,102 @@
+/* gpio_host.c
+ *
+ * Linux model of the data registers of the GPIO ports used by the LCD and
+ * keypad (A, B, D and E), for code compiled with HOST_SIM defined (see
+ * gpio_pins.h). Each access applies the address mask as the Tiva does:
+ * a write changes only the pins whose bits are set in address bits 9:2,
+ * and a read returns 0 for every other pin. Reads and writes are counted,
+ * so a host program can check that a signal change is a single store and
+ * that pins belonging to something else (e.g. UART0 on PA0 and PA1) are
+ * never changed.
+ *
+ * Example build, from the Code directory:
+ *     gcc -DHOST_SIM -I. -Ihost gpio_pins.c host/gpio_host.c host/clock_host.c my_program.c
+ * (host/gpio_check.c is such a program.)
+ *
+ * For documentation, see host_sim.h and gpio_pins.h.
+ */
+
+#include "gpio_pins.h"
+#include "host_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define GPIO_HOST_PORTS 4
+
+typedef struct
+{
+    unsigned long base;
+    unsigned char latch;      // Last value written to each pin
+    unsigned char input_pins; // Pins driven from outside, by GpioHostSetInputs()
+    unsigned char inputs;     // Their levels
+    unsigned long reads;
+    unsigned long writes;
+} HostPort;
+
+static HostPort ports[GPIO_HOST_PORTS] = {
+    {GPIO_PORTA_BASE, 0, 0, 0, 0, 0},
+    {GPIO_PORTB_BASE, 0, 0, 0, 0, 0},
+    {GPIO_PORTD_BASE, 0, 0, 0, 0, 0},
+    {GPIO_PORTE_BASE, 0, 0, 0, 0, 0}};
+
+// The port whose data register \a address is in. Anything else is a bug in the caller.
+static HostPort *FindPort(unsigned long address)
+{
+    int i;
+
+    for (i = 0; i < GPIO_HOST_PORTS; i++)
+    {
+        if (address >= ports[i].base && address <= ports[i].base + 0x3FC && (address & 3) == 0)
+        {
+            return &ports[i];
+        }
+    }
+    fprintf(stderr, "gpio_host: 0x%08lX is not a GPIO data address\n", address);
+    exit(1);
+} // FindPort
+
+static unsigned char PinLevels(const HostPort *port)
+{
+    return (port->latch & ~port->input_pins) | (port->inputs & port->input_pins);
+} // PinLevels
+
+void GpioHostWrite(unsigned long address, unsigned long value)
+{
+    HostPort *port = FindPort(address);
+    unsigned char mask = (address >> 2) & 0xFF;
+
+    port->latch = (port->latch & ~mask) | (value & mask);
+    port->writes++;
+} // GpioHostWrite
+
+unsigned long GpioHostRead(unsigned long address)
+{
+    HostPort *port = FindPort(address);
+    unsigned char mask = (address >> 2) & 0xFF;
+
+    port->reads++;
+    return PinLevels(port) & mask;
+} // GpioHostRead
+
+void GpioHostSetInputs(unsigned long base, unsigned char pins, unsigned char levels)
+{
+    HostPort *port = FindPort(base);
+
+    port->input_pins = pins;
+    port->inputs = levels & pins;
+} // GpioHostSetInputs
+
+unsigned char GpioHostPins(unsigned long base)
+{
+    return PinLevels(FindPort(base));
+} // GpioHostPins
+
+unsigned long GpioHostReadCount(unsigned long base)
+{
+    return FindPort(base)->reads;
+} // GpioHostReadCount
+
+unsigned long GpioHostWriteCount(unsigned long base)
+{
+    return FindPort(base)->writes;
+} // GpioHostWriteCount
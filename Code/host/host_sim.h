@@ -0,0 +1,127 @@
+/*! \file host_sim.h
+ *
+ * Host (Linux) stand-ins for the Tiva hardware, so that the modules above
+ * the hardware drivers can be compiled and exercised with gcc on a PC.
+ *
+ * Each stand-in replaces the hardware-specific half of a driver and is
+ * linked instead of the corresponding code in low_level_funcs_tiva.c.
+ * The functions declared here have no Tiva equivalent: they let a host
+ * program do what the hardware would do by itself (e.g. raise an
+ * interrupt).
+ */
+
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+//! \name Serial port (host/uart_host.c)
+//@{
+
+/*! Where bytes sent with UART_Write() etc. go on the host. */
+#define UART_HOST_LOOPBACK 0 //!< Straight back into the receive buffer, as if TX were wired to RX
+#define UART_HOST_PTY 1      //!< To a pseudo-terminal, so a terminal program or script can be the other end
+
+/*! Choose the serial stand-in. Call before UART_Init(). Default is loopback.
+ */
+void UART_HostSetMode( int mode );
+
+/*! Name of the slave side of the pseudo-terminal (e.g. /dev/pts/3),
+ * for the other program to open. Only valid in UART_HOST_PTY mode
+ * after UART_Init().
+ */
+const char *UART_HostPtyName( void );
+
+/*! Do what the UART interrupt handler would do: move up to one hardware
+ * FIFO's worth of bytes out of the transmit ring and any waiting input
+ * into the receive ring. Call it wherever the firmware would be
+ * interrupted, e.g. in a polling loop.
+ */
+void UART_HostPoll( void );
+
+//@}
+
+//! \name GPIO ports (host/gpio_host.c)
+//! Reached through gpio_pins.h when it is compiled with HOST_SIM defined.
+//! Ports are named by their base address, e.g. GPIO_PORTA_BASE.
+//@{
+
+/*! Write a masked data address, changing only the pins in its mask. */
+void GpioHostWrite( unsigned long address, unsigned long value );
+
+/*! Read a masked data address: the pins in its mask, the others as 0. */
+unsigned long GpioHostRead( unsigned long address );
+
+/*! Drive input pins from outside, as a key closing would.
+ *
+ * \param [in] base The port.
+ * \param [in] pins The pins driven from outside (bit n for pin n); the
+ * 		others show what was last written to them.
+ * \param [in] levels Their levels.
+ */
+void GpioHostSetInputs( unsigned long base, unsigned char pins, unsigned char levels );
+
+/*! \return The level of each pin of the port (bit n for pin n). */
+unsigned char GpioHostPins( unsigned long base );
+
+/*! \return The number of reads (or writes) of the port since the start. */
+unsigned long GpioHostReadCount( unsigned long base );
+unsigned long GpioHostWriteCount( unsigned long base ); //!< \copydoc GpioHostReadCount
+
+//@}
+
+//! \name Core clock and time (host/clock_host.c)
+//! Virtual time, which only passes when the host program says so.
+//@{
+
+#define CLOCK_HOST_FAST_HZ 80000000 //!< GetCoreClockHz() after SetCoreClock(1)
+#define CLOCK_HOST_SLOW_HZ 16000000 //!< and after SetCoreClock(0)
+
+/*! Let time pass with the core idle, e.g. between key presses. */
+void ClockHostAdvance( unsigned long microsec );
+
+/*! Let time pass with the core working: as long as \a cycles take at
+ * the present clock. */
+void ClockHostRun( unsigned long cycles );
+
+/*! \return The number of times SetCoreClock() has changed the clock. */
+unsigned long ClockHostSwitchCount( void );
+
+//@}
+
+//! \name LCD and keypad (host/display_host.c)
+//! The LCD stand-in aborts, with a message on stderr, on a byte sent
+//! while the last is still executing, a position off the display or a
+//! character printed beyond the end of a line. No key is down unless
+//! KeypadHostSetKey() holds one.
+//@{
+
+/*! Hold a key down on the keypad, or let it go.
+ *
+ * \param [in] key The character on the key, or 0 for none.
+ */
+void KeypadHostSetKey( char key );
+
+/*! \return The number of bytes (instructions and characters) sent to the
+ * LCD since the start. */
+unsigned long DisplayHostByteCount( void );
+
+//@}
+
+//! \name Stack (host/stack_host.c)
+//@{
+
+/*! Size of the pretend stack painted by StackPaint() on the host. */
+#define STACK_HOST_SIZE 16384
+
+//@}
+
+//! \name Flash (host/flash_host.c)
+//@{
+
+/*! Erase the pretend flash, so that ReadDoubleFromFlash() returns 0, and
+ * ReadMacrosFromFlash() and ReadStatsFromFlash() find nothing, as after
+ * power-on with a new board. */
+void FlashHostErase( void );
+
+//@}
+
+#endif // of #ifndef HOST_SIM_H
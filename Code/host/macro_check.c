@@ -0,0 +1,94 @@
+/* macro_check.c
+ *
+ * Host (Linux) check of how macro.c records parameters in each number
+ * mode. An entry is recorded with a parameter marked where a number
+ * starts, and the macro kept is then read back by replaying it, with
+ * MACRO_PARAMETER and MACRO_END_ENTRY put back where replay stops.
+ *
+ * A parameter takes the whole number as the mode's grammar reads it, and
+ * nothing more: an exponent in decimal mode, but the digits A-F (E among
+ * them) in hex mode, 0-7 in octal and 0-1 in binary. A parameter marked
+ * where no number starts is not recorded.
+ *
+ * Any difference is reported and makes the exit status 1.
+ *
+ * Build and run, from the Code directory:
+ *     gcc -O2 -DHOST_SIM -I. -Ihost -o macro_check host/macro_check.c macro.c radix.c host/flash_host.c
+ *     ./macro_check
+ */
+
+#include "macro.h"
+#include "result_cache.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TEXT_SIZE 64
+
+typedef struct
+{
+    int mode;
+    const char *entry;
+    int parameter; // Where it is marked
+    const char *recorded;
+} Case;
+
+static const Case cases[] = {
+    {NUMBER_MODE_DECIMAL, "2.54x3", 0, "?x3="},
+    {NUMBER_MODE_DECIMAL, "1E+5x2", 0, "?x2="},
+    {NUMBER_MODE_DECIMAL, "3x1.5E-2", 2, "3x?="},
+    {NUMBER_MODE_DECIMAL, "5+3", 1, "5+3="},
+    {NUMBER_MODE_INTEGER, "12!x3", 0, "?!x3="},
+    {NUMBER_MODE_HEX, "1E+5", 0, "?+5="},
+    {NUMBER_MODE_HEX, "FF+1", 0, "?+1="},
+    {NUMBER_MODE_HEX, "FF+1", 3, "FF+?="},
+    {NUMBER_MODE_HEX, "A&E0", 2, "A&?="},
+    {NUMBER_MODE_OCTAL, "17x2", 0, "?x2="},
+    {NUMBER_MODE_BINARY, "101+1", 0, "?+1="},
+    {NUMBER_MODE_BINARY, "101+1", 4, "101+?="},
+};
+
+// The text of the macro in slot 1, by replaying it
+static void ReadBack(char *text)
+{
+    text[0] = '\0';
+    MacroStartReplay(1);
+    for (;;)
+    {
+        switch (MacroReplay(text, TEXT_SIZE))
+        {
+        case MACRO_ENTRY:
+            strcat(text, "=");
+            break;
+        case MACRO_PARAMETER_NEEDED:
+            strcat(text, "?");
+            break;
+        default:
+            return;
+        }
+    }
+}
+
+int main(void)
+{
+    char text[TEXT_SIZE];
+    int failures = 0;
+    int i;
+
+    for (i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); i++)
+    {
+        MacroStartRecording();
+        MacroMarkParameter(cases[i].parameter);
+        MacroRecordEntry(cases[i].entry, cases[i].mode);
+        MacroSave(1);
+        ReadBack(text);
+        if (strcmp(text, cases[i].recorded) != 0)
+        {
+            printf("FAILED: \"%s\" (mode %d) with a parameter at %d recorded as \"%s\", not \"%s\"\n", cases[i].entry,
+                   cases[i].mode, cases[i].parameter, text, cases[i].recorded);
+            failures++;
+        }
+    }
+
+    printf(failures ? "%d FAILURES\n" : "all macro parameter checks passed\n", failures);
+    return failures != 0;
+}
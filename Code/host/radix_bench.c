@@ -0,0 +1,200 @@
+/* radix_bench.c
+ *
+ * Host (Linux) check and benchmark of radix.c: the hex, octal and binary
+ * modes.
+ *
+ * RadixFormat() is compared with the C library (%llX and %llo, and a
+ * bit-by-bit loop for binary) on edge values and a million pseudo-random
+ * ones, and timed against it. RadixEvaluate() is checked on entries with
+ * known results, including the wrap-around, signed division, shifts of 64
+ * places or more and numbers too big for 64 bits. On the board, where
+ * printf of a 64-bit number goes through the library's long division,
+ * the table-driven conversion saves more than it does here; the
+ * TRACE_EVAL_START and TRACE_EVAL_END times in the event trace (see
+ * event_trace.h) give the real figures.
+ *
+ * Any difference is reported and makes the exit status 1.
+ *
+ * Build and run, from the Code directory:
+ *     gcc -O2 -I. -o radix_bench host/radix_bench.c radix.c
+ *     ./radix_bench
+ */
+
+#include "radix.h"
+#include "result_cache.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define RANDOM_VALUES 1000000
+#define MIN_TIME 0.1 // Seconds each measurement runs for, at least
+
+static const int modes[] = {NUMBER_MODE_HEX, NUMBER_MODE_OCTAL, NUMBER_MODE_BINARY};
+static const char *const mode_names[] = {"hex", "octal", "binary"};
+
+static const struct
+{
+    const char *text;
+    int mode;
+    int error;
+    uint64_t value;
+} entries[] = {
+    {"FF+1", NUMBER_MODE_HEX, RADIX_OK, 0x100},
+    {"0-1", NUMBER_MODE_HEX, RADIX_OK, 0xFFFFFFFFFFFFFFFFULL},
+    {"FFFFFFFFFFFFFFFF", NUMBER_MODE_HEX, RADIX_OK, 0xFFFFFFFFFFFFFFFFULL},
+    {"10000000000000000", NUMBER_MODE_HEX, RADIX_ERR_TOO_BIG, 0},
+    {"F0|F&3C", NUMBER_MODE_HEX, RADIX_OK, 0xFC},
+    {"F0^FF&F", NUMBER_MODE_HEX, RADIX_OK, 0xFF},
+    {"1<4+1", NUMBER_MODE_HEX, RADIX_OK, 0x20},
+    {"~0>3C", NUMBER_MODE_HEX, RADIX_OK, 0xF},
+    {"1<40", NUMBER_MODE_HEX, RADIX_OK, 0},
+    {"1<3F", NUMBER_MODE_HEX, RADIX_OK, 0x8000000000000000ULL},
+    {"-7/2", NUMBER_MODE_HEX, RADIX_OK, (uint64_t)-3},
+    {"-7%2", NUMBER_MODE_HEX, RADIX_OK, (uint64_t)-1},
+    {"8000000000000000/-1", NUMBER_MODE_HEX, RADIX_OK, 0x8000000000000000ULL},
+    {"8000000000000000%-1", NUMBER_MODE_HEX, RADIX_OK, 0},
+    {"5/0", NUMBER_MODE_HEX, RADIX_ERR_DIV_ZERO, 0},
+    {"5%0", NUMBER_MODE_HEX, RADIX_ERR_DIV_ZERO, 0},
+    {"ABCDEFx10", NUMBER_MODE_HEX, RADIX_OK, 0xABCDEF0},
+    {"--~5", NUMBER_MODE_HEX, RADIX_OK, (uint64_t)~5},
+    {"5+", NUMBER_MODE_HEX, RADIX_ERR_SYNTAX, 0},
+    {"777+1", NUMBER_MODE_OCTAL, RADIX_OK, 0x200},
+    {"1777777777777777777777", NUMBER_MODE_OCTAL, RADIX_OK, 0xFFFFFFFFFFFFFFFFULL},
+    {"2000000000000000000000", NUMBER_MODE_OCTAL, RADIX_ERR_TOO_BIG, 0},
+    {"8", NUMBER_MODE_OCTAL, RADIX_ERR_SYNTAX, 0},
+    {"1011x11", NUMBER_MODE_BINARY, RADIX_OK, 33},
+    {"1010&~10", NUMBER_MODE_BINARY, RADIX_OK, 8},
+    {"2", NUMBER_MODE_BINARY, RADIX_ERR_SYNTAX, 0},
+    {"A", NUMBER_MODE_DECIMAL, RADIX_ERR_SYNTAX, 0},
+    {NULL, 0, 0, 0}};
+
+static double Now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+// The same as RadixFormat() should give, the slow way
+static void Reference(uint64_t value, int m, char *text)
+{
+    int i = 0;
+    int bit;
+
+    if (modes[m] == NUMBER_MODE_HEX)
+    {
+        sprintf(text, "%llX", (unsigned long long)value);
+    }
+    else if (modes[m] == NUMBER_MODE_OCTAL)
+    {
+        sprintf(text, "%llo", (unsigned long long)value);
+    }
+    else
+    {
+        for (bit = 63; bit > 0 && ((value >> bit) & 1) == 0; bit--)
+        {
+        }
+        for (; bit >= 0; bit--)
+        {
+            text[i++] = '0' + ((value >> bit) & 1);
+        }
+        text[i] = '\0';
+    }
+}
+
+// Next pseudo-random value (xorshift64), with a spread of lengths
+static uint64_t Random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state >> (*state & 63);
+}
+
+// Nanoseconds per conversion of values, with RadixFormat() or the reference
+static double TimeFormat(const uint64_t *values, int count, int m, int radix)
+{
+    char text[RADIX_TEXT_SIZE];
+    double start = Now();
+    double seconds;
+    long runs = 0;
+    int i;
+
+    do
+    {
+        for (i = 0; i < count; i++)
+        {
+            if (radix)
+            {
+                RadixFormat(values[i], modes[m], text);
+            }
+            else
+            {
+                Reference(values[i], m, text);
+            }
+        }
+        runs += count;
+    } while ((seconds = Now() - start) < MIN_TIME);
+    return seconds * 1e9 / runs;
+}
+
+int main(void)
+{
+    static const uint64_t edges[] = {0, 1, 7, 8, 15, 16, 0x7FFFFFFFFFFFFFFFULL, 0x8000000000000000ULL,
+                                     0xFFFFFFFFFFFFFFFFULL};
+    static uint64_t values[1000];
+    char text[RADIX_TEXT_SIZE];
+    char expected[RADIX_TEXT_SIZE];
+    uint64_t state = 88172645463325252ULL;
+    uint64_t value;
+    uint64_t round_trip;
+    int failures = 0;
+    int error;
+    int m;
+    int e;
+    long i;
+
+    for (m = 0; m < 3; m++)
+    {
+        for (i = 0; i < RANDOM_VALUES + (long)(sizeof(edges) / sizeof(edges[0])); i++)
+        {
+            value = (i < (long)(sizeof(edges) / sizeof(edges[0]))) ? edges[i] : Random(&state);
+            RadixFormat(value, modes[m], text);
+            Reference(value, m, expected);
+            error = RadixEvaluate(text, modes[m], &round_trip);
+            if (strcmp(text, expected) != 0 || error != RADIX_OK || round_trip != value)
+            {
+                if (failures++ < 10)
+                {
+                    printf("%s %016llX gives \"%s\", not \"%s\" (read back: error %d, %016llX)\n", mode_names[m],
+                           (unsigned long long)value, text, expected, error, (unsigned long long)round_trip);
+                }
+            }
+        }
+    }
+
+    for (e = 0; entries[e].text != NULL; e++)
+    {
+        value = 0;
+        error = RadixEvaluate(entries[e].text, entries[e].mode, &value);
+        if (error != entries[e].error || (error == RADIX_OK && value != entries[e].value))
+        {
+            printf("%s gives error %d, %016llX, not error %d, %016llX\n", entries[e].text, error,
+                   (unsigned long long)value, entries[e].error, (unsigned long long)entries[e].value);
+            failures++;
+        }
+    }
+
+    for (i = 0; i < 1000; i++)
+    {
+        values[i] = Random(&state);
+    }
+    printf("%-7s %12s %12s\n", "base", "library ns", "radix.c ns");
+    for (m = 0; m < 3; m++)
+    {
+        printf("%-7s %12.1f %12.1f\n", mode_names[m], TimeFormat(values, 1000, m, 0), TimeFormat(values, 1000, m, 1));
+    }
+    printf(failures ? "%d FAILURES\n" : "all conversions and entries correct\n", failures);
+    return failures != 0;
+}
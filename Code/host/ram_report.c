@@ -0,0 +1,141 @@
+/* ram_report.c
+ *
+ * Host (Linux) program which reports how much static RAM each module of
+ * the firmware uses, largest first, and how much of the TM4C123's
+ * 32 kbytes is left over.
+ *
+ * It reads either the Keil linker's map file (the "Image component sizes"
+ * table, in which RAM is RW Data + ZI Data) or the output of GNU size for
+ * the object files (in which it is data + bss):
+ *     ram_report Objects/calculator.map
+ *     size *.o | ram_report
+ *
+ * In the map file the stack is the ZI data of startup.o, so it appears
+ * as a module of its own and what is left over is unused; size of the
+ * project's own objects leaves it out, so what is left over is the most
+ * the stack could be. How much of the stack is actually used is measured
+ * on the board by mem_guard.c (?M in serial mode).
+ *
+ * Build, from the Code directory:
+ *     gcc -O2 -o ram_report host/ram_report.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RAM_BYTES 32768 // TM4C123GH6PM
+#define MAX_MODULES 100
+#define LINE_SIZE 256
+
+typedef struct
+{
+    char name[64];
+    unsigned long ram; // Bytes of static RAM: initialised plus zeroed
+} Module;
+
+static Module modules[MAX_MODULES];
+static int module_count = 0;
+
+static void AddModule(const char *name, unsigned long ram)
+{
+    if (module_count < MAX_MODULES)
+    {
+        snprintf(modules[module_count].name, sizeof(modules[module_count].name), "%s", name);
+        modules[module_count].ram = ram;
+        module_count++;
+    }
+}
+
+static int CompareModules(const void *a, const void *b)
+{
+    unsigned long ram_a = ((const Module *)a)->ram;
+    unsigned long ram_b = ((const Module *)b)->ram;
+
+    return (ram_a < ram_b) - (ram_a > ram_b); // Largest first
+}
+
+// One row of the Keil table: Code, (inc. data), RO Data, RW Data, ZI Data, Debug, Object Name
+static int ReadKeilRow(const char *line)
+{
+    unsigned long code, inc_data, ro, rw, zi, debug;
+    char name[64];
+
+    if (sscanf(line, "%lu %lu %lu %lu %lu %lu %63s", &code, &inc_data, &ro, &rw, &zi, &debug, name) != 7)
+    {
+        return 0;
+    }
+    AddModule(name, rw + zi);
+    return 1;
+}
+
+// One row of GNU size: text, data, bss, dec, hex, filename
+static int ReadSizeRow(const char *line)
+{
+    unsigned long text, data, bss, dec;
+    char hex[16];
+    char name[64];
+
+    if (sscanf(line, "%lu %lu %lu %lu %15s %63s", &text, &data, &bss, &dec, hex, name) != 6)
+    {
+        return 0;
+    }
+    AddModule(name, data + bss);
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *input = stdin;
+    char line[LINE_SIZE];
+    int in_keil_table = 0;
+    int keil_map = 0; // 1 once the Keil table has been seen: no size output follows
+    unsigned long total = 0;
+    int i;
+
+    if (argc > 1 && (input = fopen(argv[1], "r")) == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), input) != NULL)
+    {
+        if (strstr(line, "Object Name") != NULL) // Heading of the Keil table of object files
+        {
+            in_keil_table = !keil_map; // Only the first table: the next is of library members
+            keil_map = 1;
+        }
+        else if (in_keil_table)
+        {
+            if (strstr(line, "Object Totals") != NULL)
+            {
+                in_keil_table = 0;
+            }
+            else
+            {
+                ReadKeilRow(line);
+            }
+        }
+        else if (!keil_map)
+        {
+            ReadSizeRow(line);
+        }
+    }
+    if (module_count == 0)
+    {
+        fprintf(stderr, "no module sizes found (expected a Keil .map file or the output of size)\n");
+        return 1;
+    }
+
+    qsort(modules, module_count, sizeof(modules[0]), CompareModules);
+    printf("   bytes      %%  module\n");
+    for (i = 0; i < module_count; i++)
+    {
+        printf("%8lu %6.1f  %s\n", modules[i].ram, 100.0 * modules[i].ram / RAM_BYTES, modules[i].name);
+        total += modules[i].ram;
+    }
+    printf("%8lu %6.1f  total static RAM\n", total, 100.0 * total / RAM_BYTES);
+    printf("%8ld %6.1f  left over\n", (long)RAM_BYTES - (long)total,
+           100.0 * ((long)RAM_BYTES - (long)total) / RAM_BYTES);
+    return 0;
+}
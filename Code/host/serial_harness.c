@@ -0,0 +1,163 @@
+/* serial_harness.c
+ *
+ * Host (Linux) program which drives the calculator's serial batch mode
+ * (serial_calc.h) with thousands of expressions and checks the replies.
+ *
+ * Put the calculator in serial mode (Shift then 0), then run
+ *     serial_harness /dev/ttyACM0 [count] [window]
+ * where count is the number of expressions (default 10000) and window is
+ * how many may be outstanding (sent but not answered) at once (default 4).
+ * A window above 1 is what keeps the link busy: the next expression is
+ * already arriving while the previous reply is being sent. Keep
+ * window x 17 below the calculator's receive buffer (UART_RX_BUFFER_SIZE).
+ *
+ * Every expression has a known answer, so each reply is checked, which
+ * also proves that replies come back in order. One expression in 50 is
+ * a division by zero and must give an ERR reply.
+ *
+ * Build, from the Code directory:
+ *     gcc -O2 -o serial_harness host/serial_harness.c
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LINE_SIZE 40
+
+static int port;
+
+static void OpenPort(const char *path)
+{
+    struct termios settings;
+
+    port = open(path, O_RDWR | O_NOCTTY);
+    if (port < 0)
+    {
+        perror(path);
+        exit(1);
+    }
+    if (tcgetattr(port, &settings) == 0) // A pseudo-terminal accepts these too
+    {
+        cfmakeraw(&settings);
+        cfsetispeed(&settings, B115200);
+        cfsetospeed(&settings, B115200);
+        tcsetattr(port, TCSANOW, &settings);
+    }
+}
+
+static void MakeExpression(long n, char *text, char *expected)
+{
+    // n + (n mod 97) x 3, or a division by zero every 50th line.
+    // All the answers are whole numbers below 10^6, which %G shows exactly.
+    long a = n % 100000;
+    long b = n % 97;
+
+    if (n % 50 == 49)
+    {
+        sprintf(text, "%ld/0\n", a);
+        strcpy(expected, "ERR");
+    }
+    else
+    {
+        sprintf(text, "%ld+%ldx3\n", a, b);
+        sprintf(expected, "%ld", a + b * 3);
+    }
+}
+
+static int ReadLine(char *line)
+{
+    static char pending[4096];
+    static int used;
+    char *end;
+    int count;
+
+    while ((end = memchr(pending, '\n', used)) == 0)
+    {
+        count = read(port, pending + used, sizeof(pending) - used);
+        if (count <= 0)
+        {
+            return 0;
+        }
+        used += count;
+    }
+    count = end - pending + 1;
+    memcpy(line, pending, count);
+    line[count] = '\0';
+    line[strcspn(line, "\r\n")] = '\0'; // Strip the line end
+    memmove(pending, pending + count, used - count);
+    used -= count;
+    return 1;
+}
+
+static double Now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+int main(int argc, char *argv[])
+{
+    long count = (argc > 2) ? atol(argv[2]) : 10000;
+    long window = (argc > 3) ? atol(argv[3]) : 4;
+    char (*expected)[LINE_SIZE];
+    char text[LINE_SIZE];
+    char reply[LINE_SIZE];
+    long sent = 0;
+    long received = 0;
+    long wrong = 0;
+    double start;
+    double seconds;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s serial-device [count] [window]\n", argv[0]);
+        return 2;
+    }
+    OpenPort(argv[1]);
+    expected = malloc(count * sizeof(*expected));
+
+    // Start the calculator's own count from zero
+    write(port, "?\n", 2);
+    ReadLine(reply);
+
+    start = Now();
+    while (received < count)
+    {
+        while (sent < count && sent - received < window) // Keep the window full
+        {
+            MakeExpression(sent, text, expected[sent]);
+            write(port, text, strlen(text));
+            sent++;
+        }
+        if (!ReadLine(reply))
+        {
+            fprintf(stderr, "serial port closed after %ld replies\n", received);
+            return 1;
+        }
+        if (strncmp(reply, expected[received], strlen(expected[received])) != 0 ||
+            (expected[received][0] != 'E' && strcmp(reply, expected[received]) != 0))
+        {
+            if (wrong++ < 10)
+            {
+                fprintf(stderr, "line %ld: expected %s, got %s\n", received, expected[received], reply);
+            }
+        }
+        received++;
+    }
+    seconds = Now() - start;
+
+    write(port, "?\n", 2); // The calculator's own measurement
+    ReadLine(reply);
+
+    printf("%ld expressions, %ld wrong or out of order\n", count, wrong);
+    printf("host:       %.3f s, %.0f expressions/s\n", seconds, count / seconds);
+    printf("calculator: %s\n", reply);
+    return wrong != 0;
+}
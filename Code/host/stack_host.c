@@ -0,0 +1,33 @@
+/* stack_host.c
+ *
+ * Linux stand-in for GetStackLimits() (low_level_funcs_tiva.c), so that
+ * mem_guard.c can paint and measure a stack on the host. There is no
+ * stack area of a fixed size here, so it pretends the stack starts just
+ * below the first caller (StackPaint(), first thing in main()) and is
+ * STACK_HOST_SIZE bytes long. The host's real stack is far bigger, so
+ * painting that much below the stack pointer is safe; the high-water
+ * mark is then how far below main() the program has reached.
+ *
+ * Example build, from the Code directory:
+ *     gcc -I. -Ihost mem_guard.c host/stack_host.c my_program.c
+ *
+ * For documentation, see host_sim.h and low_level_funcs_tiva.h.
+ */
+
+#include "low_level_funcs_tiva.h"
+#include "host_sim.h"
+#include <stdint.h>
+
+static unsigned char *host_top = 0; // Fixed by the first call
+
+void GetStackLimits(unsigned char **bottom, unsigned char **top)
+{
+    unsigned char here;
+
+    if (host_top == 0)
+    {
+        host_top = &here;
+    }
+    *bottom = (unsigned char *)((uintptr_t)host_top - STACK_HOST_SIZE); // Outside here, so worked out as a number
+    *top = host_top;
+} // GetStackLimits
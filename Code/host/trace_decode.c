@@ -0,0 +1,208 @@
+/* trace_decode.c
+ *
+ * Host (Linux) program which turns a dump of the calculator's event trace
+ * (event_trace.h) into a readable timeline.
+ *
+ * Put the calculator in serial mode (Shift then 0), capture what it sends
+ * and ask for the trace:
+ *     cat /dev/ttyACM0 > trace.txt &
+ *     printf '?T\n' > /dev/ttyACM0
+ * then, once END has arrived,
+ *     trace_decode trace.txt
+ * Anything before the TRACE line (replies, the boot trace) is skipped, so
+ * a whole session's capture can be given. Without a file it reads stdin.
+ *
+ * Times are from the first entry dumped, to the microsecond. The
+ * timestamps wrap every 71.6 minutes, so a gap longer than that would be
+ * shown short by a multiple of it.
+ *
+ * Build, from the Code directory:
+ *     gcc -O2 -I. -o trace_decode host/trace_decode.c
+ */
+
+#include "event_trace.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LINE_SIZE 128
+
+static const char *eval_names[] = {"decimal", "integer", "repeat", "radix"};
+
+// What an LCD instruction does (HD44780 instruction set)
+static void DescribeLcdCommand(unsigned int byte, char *text)
+{
+    if (byte & 0x80)
+    {
+        sprintf(text, "position line %u col %u", (byte & 0x40) ? 2 : 1, (byte & 0x3F) + 1);
+    }
+    else if (byte & 0x40)
+    {
+        sprintf(text, "CGRAM address %u", byte & 0x3F);
+    }
+    else if (byte & 0x20)
+    {
+        sprintf(text, "function set");
+    }
+    else if (byte & 0x10)
+    {
+        sprintf(text, "shift");
+    }
+    else if (byte & 0x08)
+    {
+        sprintf(text, "display %s, cursor %s", (byte & 0x04) ? "on" : "off", (byte & 0x02) ? "on" : "off");
+    }
+    else if (byte & 0x04)
+    {
+        sprintf(text, "entry mode");
+    }
+    else if (byte & 0x02)
+    {
+        sprintf(text, "home");
+    }
+    else if (byte & 0x01)
+    {
+        sprintf(text, "clear");
+    }
+    else
+    {
+        sprintf(text, "nothing");
+    }
+}
+
+static void Describe(unsigned int type, unsigned int data, char *text)
+{
+    char lcd[40];
+
+    switch (type)
+    {
+    case TRACE_START:
+        sprintf(text, "start");
+        break;
+    case TRACE_KEY_SCAN:
+        sprintf(text, "scan      column %u rows %c%c%c%c", (data >> 4) + 1, (data & 1) ? '1' : '-',
+                (data & 2) ? '2' : '-', (data & 4) ? '3' : '-', (data & 8) ? '4' : '-');
+        break;
+    case TRACE_KEY:
+        sprintf(text, "KEY       %c", data);
+        break;
+    case TRACE_KEY_REPEAT:
+        sprintf(text, "KEY       %c (repeat)", data);
+        break;
+    case TRACE_LCD_COMMAND:
+        DescribeLcdCommand(data, lcd);
+        sprintf(text, "lcd       %02X %s", data, lcd);
+        break;
+    case TRACE_EVAL_START:
+        sprintf(text, "calculate %s", (data < 4) ? eval_names[data] : "?");
+        break;
+    case TRACE_EVAL_END:
+        if (data == 0)
+        {
+            sprintf(text, "done");
+        }
+        else if (data >= TRACE_EXPR_ERROR)
+        {
+            sprintf(text, "done      expression error %u", data - TRACE_EXPR_ERROR);
+        }
+        else
+        {
+            sprintf(text, "done      error %u", data);
+        }
+        break;
+    case TRACE_FLASH_ERASE:
+        sprintf(text, "flash     erase%s", ((data & TRACE_FLASH_MACROS) == TRACE_FLASH_MACROS) ? " macros"
+                                            : ((data & 0xE0) == TRACE_FLASH_STATS)             ? " statistics"
+                                            : (data & TRACE_FLASH_SESSION)                     ? " session"
+                                                                                               : "");
+        break;
+    case TRACE_FLASH_WRITE:
+        if ((data & TRACE_FLASH_MACROS) == TRACE_FLASH_MACROS)
+        {
+            sprintf(text, "flash     write macros slot %u", data & ~TRACE_FLASH_MACROS);
+        }
+        else if ((data & 0xE0) == TRACE_FLASH_STATS)
+        {
+            sprintf(text, "flash     write statistics slot %u", data & ~TRACE_FLASH_STATS);
+        }
+        else
+        {
+            sprintf(text, "flash     write %sslot %u", (data & TRACE_FLASH_SESSION) ? "session " : "",
+                    data & ~TRACE_FLASH_SESSION);
+        }
+        break;
+    case TRACE_CLOCK:
+        sprintf(text, "clock     %s", data ? "fast" : "slow");
+        break;
+    case TRACE_POWER:
+        sprintf(text, "power     %s", data ? "down" : "woken");
+        break;
+    default:
+        sprintf(text, "type %u data %02X", type, data);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *input = stdin;
+    char line[LINE_SIZE];
+    char text[80];
+    int count;
+    unsigned long rate_hz; // Timestamps per second
+    unsigned long stamp, type, data;
+    unsigned long last_stamp = 0;
+    double time_ms = 0.0;
+    double gap_ms;
+    int first = 1;
+    int found = 0;
+    int entries = 0;
+
+    if (argc > 1 && (input = fopen(argv[1], "r")) == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), input) != NULL)
+    {
+        if (!found)
+        {
+            found = sscanf(line, "TRACE %d %lu", &count, &rate_hz) == 2 && rate_hz > 0;
+            if (found)
+            {
+                printf("%d entries\n\n     time ms      gap ms  event\n", count);
+            }
+            continue;
+        }
+        if (strncmp(line, "END", 3) == 0)
+        {
+            break;
+        }
+        if (sscanf(line, "%lx %lx %lx", &stamp, &type, &data) != 3)
+        {
+            continue; // Something else interleaved with the dump, e.g. a reply
+        }
+        if (first)
+        {
+            gap_ms = 0.0;
+            first = 0;
+        }
+        else
+        {
+            gap_ms = ((stamp - last_stamp) & 0xFFFFFFFFUL) * 1000.0 / rate_hz; // Right across a wrap
+        }
+        time_ms += gap_ms;
+        Describe(type, data, text);
+        printf("%12.3f %11.3f  %s\n", time_ms, gap_ms, text);
+        last_stamp = stamp;
+        entries++;
+    }
+    if (!found)
+    {
+        fprintf(stderr, "no TRACE line found\n");
+        return 1;
+    }
+    if (entries != count)
+    {
+        fprintf(stderr, "%d of %d entries decoded (is the capture complete?)\n", entries, count);
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+/* uart_host.c
+ *
+ * Linux stand-in for the hardware half of the UART driver (the part in
+ * low_level_funcs_tiva.c). It is linked with the unchanged UART.c and
+ * ring_buffer.c so that the buffering, overrun counting and high-water
+ * marks behave as they do on the board.
+ *
+ * Example build, from the Code directory:
+ *     gcc -I. -Ihost UART.c ring_buffer.c host/uart_host.c my_program.c
+ *
+ * For documentation, see host_sim.h and UART.h.
+ */
+
+#define _XOPEN_SOURCE 600 // For posix_openpt() and friends
+#include "UART.h"
+#include "host_sim.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define UART_HOST_FIFO_SIZE 16 // Bytes moved per "interrupt", as the Tiva FIFO holds 16
+
+static int host_mode = UART_HOST_LOOPBACK;
+static int pty_fd = -1;
+
+void UART_HostSetMode(int mode)
+{
+    host_mode = mode;
+} // UART_HostSetMode
+
+const char *UART_HostPtyName(void)
+{
+    return (pty_fd >= 0) ? ptsname(pty_fd) : 0;
+} // UART_HostPtyName
+
+void UART_Init(void)
+{
+    UART_InitBuffers();
+    if (host_mode == UART_HOST_PTY && pty_fd < 0)
+    {
+        pty_fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if (pty_fd >= 0)
+        {
+            grantpt(pty_fd);
+            unlockpt(pty_fd);
+            fcntl(pty_fd, F_SETFL, fcntl(pty_fd, F_GETFL) | O_NONBLOCK); // Never block, like the hardware
+        }
+    }
+} // UART_Init
+
+void UART_StartTx(void)
+{
+    // Nothing to arm: UART_HostPoll() plays the part of the transmit interrupt.
+} // UART_StartTx
+
+void UART_HostPoll(void)
+{
+    unsigned char fifo[UART_HOST_FIFO_SIZE];
+    int count = 0;
+    int i;
+
+    // Transmit side: one FIFO's worth per call
+    while (count < UART_HOST_FIFO_SIZE && UART_TxIsr(&fifo[count]))
+    {
+        count++;
+    }
+    if (host_mode == UART_HOST_LOOPBACK)
+    {
+        for (i = 0; i < count; i++)
+        {
+            UART_RxIsr(fifo[i]);
+        }
+    }
+    else if (pty_fd >= 0)
+    {
+        if (count > 0 && write(pty_fd, fifo, count) < 0)
+        {
+            // Nobody has the slave side open; the bytes are lost, as on an unplugged cable
+        }
+
+        // Receive side: whatever the other end has sent
+        count = read(pty_fd, fifo, sizeof(fifo));
+        for (i = 0; i < count; i++)
+        {
+            UART_RxIsr(fifo[i]);
+        }
+    }
+} // UART_HostPoll
@@ -0,0 +1,134 @@
+/* uart_loopback.c
+ *
+ * Host (Linux) check of the interrupt-driven UART path: UART.c and
+ * ring_buffer.c, linked with host/uart_host.c in loopback mode, so that
+ * every byte written goes through the transmit ring, the pretend transmit
+ * interrupt (UART_HostPoll()), the receive interrupt and the receive ring.
+ *
+ * Checked:
+ * 	- A line comes back whole and in order.
+ * 	- 100000 lines, read as they arrive, so both rings and their 16-bit
+ * 		free-running counters wrap round many times.
+ * 	- A full transmit ring: UART_Write() queues what fits and counts the
+ * 		rest, and UART_WriteString() is all or nothing.
+ * 	- A full receive ring: the interrupt drops what does not fit and
+ * 		counts it, and the bytes kept are the oldest, in order.
+ *
+ * Any difference is reported and makes the exit status 1.
+ *
+ * Build and run, from the Code directory:
+ *     gcc -O2 -I. -Ihost -o uart_loopback host/uart_loopback.c UART.c ring_buffer.c host/uart_host.c
+ *     ./uart_loopback
+ */
+
+#include "UART.h"
+#include "host_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LINES 100000
+#define LINE_SIZE 24
+
+static int failures = 0;
+
+static void Check(int ok, const char *what)
+{
+    if (!ok && failures++ < 10)
+    {
+        printf("FAILED: %s\n", what);
+    }
+}
+
+// Poll until the transmit ring is empty, reading what arrives into text
+static int Receive(char *text, int size)
+{
+    unsigned char byte;
+    int length = 0;
+    int polls;
+
+    for (polls = 0; polls < 1000 && (UART_TxSpace() < UART_TX_BUFFER_SIZE || UART_RxCount() > 0); polls++)
+    {
+        UART_HostPoll();
+        while (UART_GetChar(&byte))
+        {
+            if (length < size - 1)
+            {
+                text[length++] = byte;
+            }
+        }
+    }
+    text[length] = '\0';
+    return length;
+}
+
+int main(void)
+{
+    static unsigned char big[UART_TX_BUFFER_SIZE + 100];
+    char line[LINE_SIZE];
+    char received[LINE_SIZE * 2];
+    unsigned char byte;
+    UART_Stats stats;
+    long n;
+    int i;
+
+    UART_HostSetMode(UART_HOST_LOOPBACK);
+    UART_Init();
+
+    // One line
+    Check(UART_WriteString("1+2x3\n") == 1, "line queued");
+    Receive(received, sizeof(received));
+    Check(strcmp(received, "1+2x3\n") == 0, "line comes back as sent");
+
+    // Many lines: the rings wrap every few lines, the counters every 3000 or so
+    for (n = 0; n < LINES; n++)
+    {
+        sprintf(line, "%ld+%ld\n", n, n % 97);
+        if (!UART_WriteString(line))
+        {
+            Check(0, "line queued in an empty ring");
+            break;
+        }
+        Receive(received, sizeof(received));
+        if (strcmp(received, line) != 0)
+        {
+            Check(0, "line comes back as sent, after wrapping");
+            printf("    line %ld: sent \"%s\", received \"%s\"\n", n, line, received);
+        }
+    }
+    UART_GetStats(&stats);
+    Check(stats.rx_overruns == 0 && stats.tx_overruns == 0 && stats.rx_hw_overruns == 0,
+          "nothing lost while reading as bytes arrive");
+
+    // Full transmit ring
+    UART_InitBuffers();
+    for (i = 0; i < (int)sizeof(big); i++)
+    {
+        big[i] = (unsigned char)i;
+    }
+    Check(UART_Write(big, sizeof(big)) == UART_TX_BUFFER_SIZE, "UART_Write() queues what fits");
+    Check(UART_TxSpace() == 0, "transmit ring full");
+    Check(UART_WriteString("x") == 0, "UART_WriteString() refused when full");
+    Check(UART_PutChar('x') == 0, "UART_PutChar() refused when full");
+    UART_GetStats(&stats);
+    Check(stats.tx_overruns == sizeof(big) - UART_TX_BUFFER_SIZE + 2, "transmit overruns counted");
+    Check(stats.tx_high_water == UART_TX_BUFFER_SIZE, "transmit high-water mark");
+
+    // Full receive ring: nobody reads while the interrupt delivers all of it
+    for (i = 0; i < UART_TX_BUFFER_SIZE; i++)
+    {
+        UART_HostPoll();
+    }
+    UART_GetStats(&stats);
+    Check(UART_TxSpace() == UART_TX_BUFFER_SIZE, "transmit ring drained");
+    Check(UART_RxCount() == UART_RX_BUFFER_SIZE, "receive ring full");
+    Check(stats.rx_overruns == UART_TX_BUFFER_SIZE - UART_RX_BUFFER_SIZE, "receive overruns counted");
+    Check(stats.rx_high_water == UART_RX_BUFFER_SIZE, "receive high-water mark");
+    for (i = 0; UART_GetChar(&byte); i++)
+    {
+        Check(byte == big[i], "receive ring keeps the oldest bytes, in order");
+    }
+    Check(i == UART_RX_BUFFER_SIZE, "whole receive ring read back");
+
+    printf(failures ? "%d FAILURES\n" : "all UART loopback checks passed\n", failures);
+    return failures != 0;
+}
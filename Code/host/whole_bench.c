@@ -0,0 +1,171 @@
+/* whole_bench.c
+ *
+ * Host (Linux) benchmark and check of the whole-number path of
+ * expression.c (ExprEvaluateWhole() and the integer printing in
+ * ExprFormat()) against the double path it replaces, on a typical mix
+ * of entries: mostly whole numbers, with some decimals, divisions with
+ * a remainder and values too big for it, which fall back to doubles.
+ *
+ * For each entry it prints the time per evaluation and per format with
+ * doubles and with the whole-number path, and how many calls to the
+ * double library routines (__aeabi_dadd, __aeabi_dcmpgt, ...) the double
+ * path makes on the board, where each one costs tens to hundreds of
+ * cycles and the whole-number path makes none. The host has hardware
+ * for doubles, so the evaluation times here understate the saving; the
+ * printing times (the C library's %G against integer arithmetic) are
+ * much like the board's. On the board, the TRACE_EVAL_START and
+ * TRACE_EVAL_END times in the event trace (see event_trace.h) give the
+ * real figures.
+ *
+ * Every result is also compared bit for bit with the double path's;
+ * any difference is reported and makes the exit status 1.
+ *
+ * Build and run, from the Code directory:
+ *     gcc -O2 -I. -o whole_bench host/whole_bench.c expression.c -lm
+ *     ./whole_bench
+ */
+
+#include "expression.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define MIN_TIME 0.1 // Seconds each measurement runs for, at least
+#define BATCH 1000   // Calls between looks at the clock
+
+static const struct
+{
+    const char *text;
+    double ans;
+} entries[] = {{"12+34", 0.0},        {"250x4", 0.0},       {"1000-275", 0.0},  {"144/12", 0.0},
+               {"7x8x9", 0.0},        {"365x24x60", 0.0},   {"A+1", 41.0},      {"Ax2-100", 512.0},
+               {"19.99x3", 0.0},      {"100/7", 0.0},       {"1.5E3+20", 0.0},  {"A/3", 1.0 / 3.0},
+               {"99999x99999x9", 0.0}, {"123456x1000", 0.0}, {NULL, 0.0}};
+
+static double Now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+// Nanoseconds per evaluation of the program, with or without the whole-number path
+static double TimeEvaluate(const ExprProgram *compiled, double ans, int whole, double *result)
+{
+    ExprProgram program = *compiled;
+    double start = Now();
+    double seconds;
+    long runs = 0;
+    int i;
+
+    program.whole = whole;
+    do
+    {
+        for (i = 0; i < BATCH; i++)
+        {
+            ExprEvaluate(&program, ans, result);
+        }
+        runs += BATCH;
+    } while ((seconds = Now() - start) < MIN_TIME);
+    return seconds * 1e9 / runs;
+}
+
+// Nanoseconds per format of the value: with %G, or with ExprFormat()
+static double TimeFormat(double value, int whole, char *text)
+{
+    double start = Now();
+    double seconds;
+    long runs = 0;
+    int i;
+
+    do
+    {
+        for (i = 0; i < BATCH; i++)
+        {
+            if (whole)
+            {
+                ExprFormat(value, text, EXPR_RESULT_SIZE);
+            }
+            else
+            {
+                snprintf(text, EXPR_RESULT_SIZE, "%G", value); // ExprFormat() without the whole-number printing
+            }
+        }
+        runs += BATCH;
+    } while ((seconds = Now() - start) < MIN_TIME);
+    return seconds * 1e9 / runs;
+}
+
+// Calls the double path makes to the library: one per operation, three
+// for the range check after it (NaN, too big, too small), one more for
+// the check of a divisor, and two for the final range check
+static int DoubleCalls(const ExprProgram *program)
+{
+    int calls = 2;
+    int i;
+
+    for (i = 0; i < program->length; i++)
+    {
+        switch (program->steps[i].op)
+        {
+        case STEP_DIV:
+            calls++;
+            // fall through
+        case STEP_ADD:
+        case STEP_SUB:
+        case STEP_MUL:
+            calls += 4;
+            break;
+        }
+    }
+    return calls;
+}
+
+int main(void)
+{
+    ExprProgram program;
+    ExprProgram whole_program;
+    double double_result;
+    double whole_result;
+    double double_ns;
+    double whole_ns;
+    double total_double = 0.0;
+    double total_whole = 0.0;
+    char double_text[EXPR_RESULT_SIZE];
+    char whole_text[EXPR_RESULT_SIZE];
+    int failures = 0;
+    int used;
+    int e;
+
+    printf("%-15s %-9s %10s %10s %10s %10s %6s\n", "entry", "path", "eval ns", "", "format ns", "", "calls");
+    printf("%-15s %-9s %10s %10s %10s %10s %6s\n", "", "", "double", "whole", "%G", "whole", "saved");
+    for (e = 0; entries[e].text != NULL; e++)
+    {
+        if (ExprCompile(entries[e].text, &program) != EXPR_OK)
+        {
+            printf("%-15s does not compile\n", entries[e].text);
+            failures++;
+            continue;
+        }
+        whole_program = program;
+        used = ExprEvaluateWhole(&whole_program, entries[e].ans, &whole_result);
+        double_ns = TimeEvaluate(&program, entries[e].ans, 0, &double_result);
+        whole_ns = TimeEvaluate(&program, entries[e].ans, program.whole, &whole_result);
+        total_double += double_ns + TimeFormat(double_result, 0, double_text);
+        total_whole += whole_ns + TimeFormat(whole_result, 1, whole_text);
+        printf("%-15s %-9s %10.1f %10.1f %10.1f %10.1f %6d\n", entries[e].text, used ? "whole" : "double", double_ns,
+               whole_ns, TimeFormat(double_result, 0, double_text), TimeFormat(whole_result, 1, whole_text),
+               used ? DoubleCalls(&program) : 0);
+        if (memcmp(&whole_result, &double_result, sizeof(double)) != 0 || strcmp(whole_text, double_text) != 0)
+        {
+            printf("  %s gives %.17g \"%s\", not %.17g \"%s\"\n", entries[e].text, whole_result, whole_text,
+                   double_result, double_text);
+            failures++;
+        }
+    }
+    printf("whole mix: %.1f ns with doubles, %.1f ns with the whole-number path (%.2fx)\n", total_double, total_whole,
+           total_double / total_whole);
+    printf(failures ? "%d MISMATCHES\n" : "all results bit-identical to the double path\n", failures);
+    return failures != 0;
+}
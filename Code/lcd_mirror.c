@@ -0,0 +1,151 @@
+/* lcd_mirror.c
+ *
+ * Mirror of the LCD on an ANSI serial terminal, sending only the
+ * characters which have changed.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "TExaS.h"
+#include "lcd_mirror.h"
+#include "low_level_funcs_tiva.h"
+#include "UART.h"
+
+#define MIRROR_FRAME_SIZE 224 // Worst case frame: clear, box and both lines in full
+#define MIRROR_MIN_GAP 4      // Unchanged cells shorter than this are resent rather than
+                              // starting a new run (an escape sequence costs 6-7 bytes)
+#define MIRROR_PI ((char)0xA3) // The code PrintChar() displays as pi
+
+static int mirror_on = 0;                       // 1 while the mirror is enabled
+static int full_redraw = 0;                     // 1 when the terminal must be cleared and redrawn
+static char sent[2][DISPLAY_WIDTH];             // What the terminal is showing
+static unsigned long sent_changes;              // GetDisplayChangeCount() when it was last sent
+static unsigned long last_frame_millisec;       // GetTickMillisec() when it was last sent
+
+static int AppendText(char *frame, int used, const char *text)
+{
+    int length = strlen(text);
+
+    memcpy(frame + used, text, length);
+    return used + length;
+}
+
+static int AppendCell(char *frame, int used, char ch)
+{
+    // The LCD's special characters are sent as their UTF-8 equivalents
+    if (ch == MIRROR_PI)
+    {
+        return AppendText(frame, used, "\xCF\x80"); // pi
+    }
+    if (ch == '$')
+    {
+        return AppendText(frame, used, "\xE2\x88\x9A"); // square root
+    }
+    if (ch < ' ' || ch > '~')
+    {
+        ch = '?'; // Anything else the terminal might not show
+    }
+    frame[used] = ch;
+    return used + 1;
+}
+
+static int AppendLine(char *frame, int used, short int line)
+{
+    const char *shadow = GetDisplayShadow(line);
+    char *previous = sent[line - 1];
+    char escape[12]; // ESC [ row ; col H, each at most 3 digits
+    int col = 0;
+    int run_end;
+    int gap;
+
+    while (col < DISPLAY_WIDTH)
+    {
+        if (shadow[col] == previous[col])
+        {
+            col++; // Unchanged: nothing to send
+            continue;
+        }
+
+        // Start of a changed run. Extend it over short unchanged gaps, which
+        // are cheaper to resend than a new cursor-addressing sequence.
+        run_end = col + 1;
+        gap = 0;
+        while (run_end + gap < DISPLAY_WIDTH && gap < MIRROR_MIN_GAP)
+        {
+            if (shadow[run_end + gap] != previous[run_end + gap])
+            {
+                run_end += gap + 1;
+                gap = 0;
+            }
+            else
+            {
+                gap++;
+            }
+        }
+
+        // Terminal rows 2 and 3, columns 2 to 17: inside the box
+        snprintf(escape, sizeof(escape), "\x1B[%d;%dH", (unsigned char)(line + 1), (unsigned char)(col + 2));
+        used = AppendText(frame, used, escape);
+        for (; col < run_end; col++)
+        {
+            used = AppendCell(frame, used, shadow[col]);
+            previous[col] = shadow[col];
+        }
+    }
+    return used;
+}
+
+void LcdMirrorEnable(int on)
+{
+    mirror_on = (on != 0);
+    full_redraw = mirror_on;
+} // LcdMirrorEnable
+
+int LcdMirrorIsEnabled(void)
+{
+    return mirror_on;
+} // LcdMirrorIsEnabled
+
+void LcdMirrorPoll(void)
+{
+    char frame[MIRROR_FRAME_SIZE];
+    int used = 0;
+    unsigned long now;
+    unsigned long changes;
+
+    if (!mirror_on)
+    {
+        return;
+    }
+    changes = GetDisplayChangeCount();
+    if (changes == sent_changes && !full_redraw)
+    {
+        return; // Nothing new to show
+    }
+    now = GetTickMillisec();
+    if (!full_redraw && now - last_frame_millisec < LCD_MIRROR_INTERVAL_MS)
+    {
+        return; // Too soon: let more changes pile up and send them together
+    }
+    if (UART_TxSpace() < MIRROR_FRAME_SIZE)
+    {
+        return; // Link busy: try again later rather than sending half a frame
+    }
+
+    if (full_redraw)
+    {
+        // Clear the terminal, draw the box and treat the terminal as blank
+        used = AppendText(frame, used, "\x1B[2J\x1B[H+----------------+\r\n");
+        used = AppendText(frame, used, "|                |\r\n|                |\r\n");
+        used = AppendText(frame, used, "+----------------+");
+        memset(sent, ' ', sizeof(sent));
+        full_redraw = 0;
+    }
+    used = AppendLine(frame, used, 1);
+    used = AppendLine(frame, used, 2);
+    used = AppendText(frame, used, "\x1B[5;1H"); // Park the terminal cursor below the box
+
+    UART_Write((const unsigned char *)frame, used); // Room was checked above
+    sent_changes = changes;
+    last_frame_millisec = now;
+} // LcdMirrorPoll
@@ -0,0 +1,49 @@
+/*! \file lcd_mirror.h
+ *
+ * Optional mirror of the LCD on a serial terminal (e.g. PuTTY or screen
+ * on the PC end of UART0), for when the board is out of sight.
+ *
+ * The terminal shows the two 16-character lines in a box. Only the
+ * characters which have changed since the last frame are sent, each run
+ * of them preceded by an ANSI cursor-addressing escape sequence. Frames
+ * are sent at most every \a LCD_MIRROR_INTERVAL_MS, and only when the
+ * transmit buffer has room for a whole frame; any changes made in the
+ * meantime (e.g. a burst of PrintString() calls) are simply compared
+ * with the last frame sent, so they coalesce into one update.
+ *
+ * The LCD functions themselves are not slowed down: they only update the
+ * copy of the screen (see GetDisplayShadow()), and all the comparing and
+ * sending is done by LcdMirrorPoll() when the program is waiting anyway.
+ */
+
+#ifndef LCD_MIRROR_H
+#define LCD_MIRROR_H
+
+/*! Minimum time between frames. 50 ms is 20 frames/s: fast enough to
+ * look immediate, and even a full redraw then uses under a fifth of the
+ * 115200-baud link.
+ */
+#define LCD_MIRROR_INTERVAL_MS 50
+
+/*! Turn the mirror on or off.
+ *
+ * \param [in] on 0 for off, any non-zero quantity for on.
+ *
+ * Turning it on clears the terminal and redraws the whole screen at the
+ * next LcdMirrorPoll().
+ */
+void LcdMirrorEnable( int on );
+
+/*! \return 1 if the mirror is on, 0 if it is off.
+ */
+int LcdMirrorIsEnabled( void );
+
+/*! Send the changes to the terminal, if any are due. Does not wait.
+ *
+ * Call this often from anywhere the program is idle (e.g. while waiting
+ * for a key). It returns at once if the mirror is off, nothing has
+ * changed, the last frame was too recent or the serial link is busy.
+ */
+void LcdMirrorPoll( void );
+
+#endif // of #ifndef LCD_MIRROR_H
@@ -11,8 +11,12 @@
 #include "TExaS.h"
 #include "low_level_funcs_tiva.h"
 #include "PLL.h" // For PLL and SysTick
-#include "uart.h"
+#include "UART.h"
+#include "boot_trace.h"
+#include "gpio_pins.h"
+#include "event_trace.h"
 #include <stdio.h>
+#include <string.h>
 
 // =========================== CONSTANTS ============================
 
@@ -133,18 +137,11 @@
  * the port access this bit directly? It is your decision.
  */
 
-#define LCD_RS (*((volatile unsigned long *)0x40004020))   /* PA3                                  \ \
-                                                            * The single port bit connected to the \ \
-                                                            * RS (Register Select) pin of the LCD. \ \
-                                                            */
-#define LCD_EN (*((volatile unsigned long *)0x40004010))   /* PA2                                       \ \
-                                                            * The single port bit connected to the      \ \
-                                                            * EN (ENable data transfer) pin of the LCD. \ \
-                                                            */
-#define LCD_DATA (*((volatile unsigned long *)0x400050F0)) /* PORT B[2:5]                             \ \
-                                                            * The set of four adjacent bits connected \ \
-                                                            * to the four data transfer bits (DB4 to  \ \
-                                                            * DB7) of the LCD. */
+/* LCD_RS (PA3), LCD_EN (PA2) and LCD_DATA (PORT B[2:5]) are the masked 
+ * data addresses which reach just those bits. They are defined in 
+ * gpio_pins.h, with the keypad's, and the functions which use them are 
+ * in gpio_pins.c, so that the host simulator can run them too.
+ */
 
 /* Incidentlly, a  comment on C-writing technique:
  * You will have noticed that the comments above use to old C 
@@ -178,11 +175,67 @@
 #define UART_LCRH_WLEN_8 0x00000060 // 8 bit word length
 #define UART_LCRH_FEN 0x00000010    // UART Enable FIFOs
 #define UART_CTL_UARTEN 0x00000001  // UART Enable
+#define UART0_IFLS_R (*((volatile unsigned long *)0x4000C034))
+#define UART0_IM_R (*((volatile unsigned long *)0x4000C038))
+#define UART0_MIS_R (*((volatile unsigned long *)0x4000C040))
+#define UART0_ICR_R (*((volatile unsigned long *)0x4000C044))
+#define UART_DR_OE 0x00000800        // UART Overrun Error (per received byte)
+#define UART_IFLS_RX4_8 0x00000010   // RX interrupt at FIFO >= 1/2 full
+#define UART_IFLS_TX1_8 0x00000000   // TX interrupt at FIFO <= 1/8 full
+#define UART_IM_RXIM 0x00000010      // UART Receive Interrupt Mask
+#define UART_IM_TXIM 0x00000020      // UART Transmit Interrupt Mask
+#define UART_IM_RTIM 0x00000040      // UART Receive Time-Out Interrupt Mask
+#define UART_MIS_TXMIS 0x00000020    // UART Transmit Masked Interrupt Status
+#define UART_ICR_RXIC 0x00000010     // Receive Interrupt Clear
+#define UART_ICR_TXIC 0x00000020     // Transmit Interrupt Clear
+#define UART_ICR_RTIC 0x00000040     // Receive Time-Out Interrupt Clear
+#define NVIC_EN0_R (*((volatile unsigned long *)0xE000E100))
+#define NVIC_PRI1_R (*((volatile unsigned long *)0xE000E404))
+#define NVIC_EN0_INT5 0x00000020     // Interrupt 5 (UART0) enable
+
+// ================== CYCLE COUNTER ================ //
+#define NVIC_DBG_DEMCR_R (*((volatile unsigned long *)0xE000EDFC)) // Debug Exception and Monitor Control
+#define DWT_CTRL_R (*((volatile unsigned long *)0xE0001000))       // Data Watchpoint and Trace control
+#define DWT_CYCCNT_R (*((volatile unsigned long *)0xE0001004))     // DWT cycle counter
+#define NVIC_DBG_DEMCR_TRCENA 0x01000000 // Enable DWT
+#define DWT_CTRL_CYCCNTENA 0x00000001    // Enable cycle counter
+#define CORE_CLOCK_HZ 80000000           // Once PLL_Init() has run (16 MHz before)
+#define SLOW_CLOCK_HZ 16000000           // The crystal, with the PLL bypassed (see SetCoreClock())
+#define UART_BAUD 115200
+#define UART_FR_BUSY 0x00000008          // UART Busy (still sending)
+#define NVIC_SYS_PRI3_R (*((volatile unsigned long *)0xE000ED20)) // SysTick priority is bits 31:29
 #define SYSCTL_RCGC1_R (*((volatile unsigned long *)0x400FE104))
+#define FLASH_FMA_R (*((volatile unsigned long *)0x400FD000)) // Flash Memory Address
+#define FLASH_FMD_R (*((volatile unsigned long *)0x400FD004)) // Flash Memory Data
+#define FLASH_FMC_R (*((volatile unsigned long *)0x400FD008)) // Flash Memory Control
+#define FLASH_FMC_WRKEY 0xA4420000 // Write key (BOOTCFG KEY bit at its default)
+#define FLASH_FMC_ERASE 0x00000002 // Erase a 1 KB block
+#define FLASH_FMC_WRITE 0x00000001 // Write one 32-bit word
+#define FLASH_BLOCK_SIZE 1024      // Erase block size
 #define SYSCTL_RCGC2_R (*((volatile unsigned long *)0x400FE108))
 #define SYSCTL_RCGC1_UART0 0x00000001 // UART0 Clock Gating Control
 #define SYSCTL_RCGC2_GPIOA 0x00000001 // port A Clock Gating Control
 
+// ================== DEEP SLEEP ================ //
+#define GPIO_PORTE_IS_R (*((volatile unsigned long *)0x40024404))  // Interrupt Sense (0 = edge)
+#define GPIO_PORTE_IBE_R (*((volatile unsigned long *)0x40024408)) // Interrupt Both Edges
+#define GPIO_PORTE_IEV_R (*((volatile unsigned long *)0x4002440C)) // Interrupt Event (1 = rising)
+#define GPIO_PORTE_IM_R (*((volatile unsigned long *)0x40024410))  // Interrupt Mask
+#define GPIO_PORTE_ICR_R (*((volatile unsigned long *)0x4002441C)) // Interrupt Clear
+#define NVIC_DIS0_R (*((volatile unsigned long *)0xE000E180))
+#define NVIC_EN0_INT4 0x00000010      // Interrupt 4 (GPIO Port E) enable
+#define NVIC_SYS_CTRL_R (*((volatile unsigned long *)0xE000ED10)) // System Control
+#define NVIC_SYS_CTRL_SLEEPDEEP 0x00000004 // WFI enters deep sleep, not sleep
+#define SYSCTL_RCC_ACG 0x08000000      // Auto Clock Gating: DCGCn choose what runs in deep sleep
+#define SYSCTL_DCGC2_R (*((volatile unsigned long *)0x400FE128))  // Deep-sleep clock gating, GPIO
+#define SYSCTL_DCGC2_KEYPAD 0x00000018 // Ports D (columns) and E (rows)
+#define SYSCTL_DSLPCLKCFG_R (*((volatile unsigned long *)0x400FE144)) // Deep-sleep clock configuration
+#define SYSCTL_DSLPCLKCFG_LFIOSC 0x00000030  // Deep-sleep clock: the 30 kHz low frequency oscillator
+#define SYSCTL_DSLPCLKCFG_PIOSCPD 0x00000002 // Power down the 16 MHz PIOSC in deep sleep
+#define SYSCTL_DSLPPWRCFG_R (*((volatile unsigned long *)0x400FE18C)) // Deep-sleep power configuration
+#define SYSCTL_DSLPPWRCFG_LOW 0x00000023     // Flash and SRAM in their low power modes
+#define KEYPAD_SETTLE_MICROSEC 50            // Time for the rows to follow the columns
+
 // =========================== FUNCTIONS ============================
 
 // ------------------------ Keyboard functions ------------------------
@@ -195,83 +248,116 @@ void InitKeyboardPorts(void)
     GPIO_PORTD_LOCK_R = 0x4C4F434B; // 2) unlock PortD
     GPIO_PORTE_LOCK_R = 0x4C4F434B; // 2) unlock PortE
 
-    GPIO_PORTD_CR_R = 0x0F; // allow changes to PD3-0
-    GPIO_PORTE_CR_R = 0x0F; // allow changes to PE3-0
+    // Only the keypad's own pins are changed, so anything else on the ports is left alone
+    GPIO_PORTD_CR_R |= KEYPAD_COL_PINS; // allow changes to PD3-0
+    GPIO_PORTE_CR_R |= KEYPAD_ROW_PINS; // allow changes to PE3-0
 
-    GPIO_PORTD_DEN_R = 0x0F;
-    GPIO_PORTE_DEN_R = 0x0F;
+    GPIO_PORTD_DEN_R |= KEYPAD_COL_PINS;
+    GPIO_PORTE_DEN_R |= KEYPAD_ROW_PINS;
 
-    GPIO_PORTD_AMSEL_R = 0x00; // 3) disable analog function
-    GPIO_PORTE_AMSEL_R = 0x00; // 3) disable analog function
+    GPIO_PORTD_AMSEL_R &= ~KEYPAD_COL_PINS; // 3) disable analog function
+    GPIO_PORTE_AMSEL_R &= ~KEYPAD_ROW_PINS; // 3) disable analog function
 
-    GPIO_PORTD_PCTL_R = 0x00000000; // 4) GPIO clear bit PCTL
-    GPIO_PORTE_PCTL_R = 0x00000000; // 4) GPIO clear bit PCTL
+    GPIO_PORTD_PCTL_R &= ~0x0000FFFF; // 4) GPIO clear bit PCTL (4 bits per pin)
+    GPIO_PORTE_PCTL_R &= ~0x0000FFFF; // 4) GPIO clear bit PCTL
 
-    GPIO_PORTD_DIR_R = 0xFF; // 5) PD[0:3] output, others output
-    GPIO_PORTE_DIR_R = 0xF0; // 5) PE[0:3] input, others output
+    GPIO_PORTD_DIR_R |= KEYPAD_COL_PINS;  // 5) PD[0:3] output
+    GPIO_PORTE_DIR_R &= ~KEYPAD_ROW_PINS; // 5) PE[0:3] input
 
-    GPIO_PORTD_AFSEL_R = 0x00; // 6) no alternate function
-    GPIO_PORTE_AFSEL_R = 0x00; // 6) no alternate function
+    GPIO_PORTD_AFSEL_R &= ~KEYPAD_COL_PINS; // 6) no alternate function
+    GPIO_PORTE_AFSEL_R &= ~KEYPAD_ROW_PINS; // 6) no alternate function
 
-    GPIO_PORTE_PDR_R = 0x0F; // enable pulldown resistors on PE0-3 rows
+    GPIO_PORTE_PDR_R |= KEYPAD_ROW_PINS; // enable pulldown resistors on PE0-3 rows
 } // InitKeyboardPorts
 
-void WriteKeyboardCol(unsigned char nibble)
-{
-    // Port D is columns
-    // When a nibble (e.g. 0010) is written, the column where the 1 is will be made high.
-    // When polling the columns, the row that is high (pressed) can be used to determine
-    // which button has been pressed
-    // By AND'ing Port D with the nibble
+// WriteKeyboardCol() and ReadKeyboardRow() are in gpio_pins.c
 
-    GPIO_PORTD_DATA_R = nibble & 0x0F; // Read 4 LSB
-                                       // Nibble chooses which row in mid level
-} // WriteKeyboardCol
+// ------------------------ Display functions ------------------------
 
-unsigned char ReadKeyboardRow(void)
-{
-    // Port E is rows
-    // When a button is pressed, and a column is made high by
-    // WriteKeyboardCol, the row of the row/column combination
-    // will be made high
-    // (due to pull down resistors - positive logic)
-    // By selectively making columns high, reading the row/column
-    // combination allows the pressed button to be deduced
-    // All this function has to do is read the value from the rows to
-    // check which row is high.
+// Copy of what is on the display, kept up to date by ClearDisplay(),
+// SetPrintPosition() and PrintChar(). Costs a couple of stores per
+// character, which is nothing beside the 37 us the LCD needs.
+static char display_shadow[2][DISPLAY_WIDTH]; // Characters as passed to PrintChar()
+static short int shadow_line = 0;             // Current print position (0 = top line)
+static short int shadow_col = 0;              // Current print position (0 = leftmost)
+static unsigned long display_changes = 0;     // Incremented on every change
+static short int shadow_cursor_on = 0;        // 1 while the cursor is shown
+static unsigned long display_ready_cycles = 0; // ReadCycleCounter() value when the LCD will be ready again
 
-    return GPIO_PORTE_DATA_R;
-} // ReadKeyboardRow
+#define LCD_BYTE_MICROSEC 37     // Time the LCD takes to execute most instructions and data
+#define LCD_HOME_MICROSEC 1520   // Time for Clear Display and Return Home
 
-// ------------------------ Display functions ------------------------
+// SendDisplayNibble() is in gpio_pins.c
 
-void SendDisplayNibble(unsigned char byte, unsigned char instruction_or_data)
+void SendDisplayByte(unsigned char byte, unsigned char instruction_or_data)
 {
-    // Check whether sending instruction or data first
-    if (instruction_or_data == 0)
-    {
-        GPIO_PORTA_DATA_R &= ~0x8; // Set RS to 0 if instruction
+    while (DisplayBusy())
+    { // A byte sent without waiting may still be executing
     }
-    else
-    {
-        GPIO_PORTA_DATA_R = 0x8; // Set RS to 1 if data
+    SendDisplayByteNoWait(byte, instruction_or_data); // Send both nibbles
+    while (DisplayBusy())
+    { // Wait 37 us (or 1.52 ms for clear/home)
     }
-
-    GPIO_PORTB_DATA_R = (byte) << 2; // Set Port B[2:5] with byte (by left bit-shifting by 2)
-    GPIO_PORTA_DATA_R |= 0x04;       // Set EN
-    Wait_12_5_Nanosec(36);           //wait for 450 ns (36*12.5ns) i.e. Pulse line for 450 ns
-    GPIO_PORTA_DATA_R &= ~0x04;      // Disable EN by clearing bit
 } // SendDisplayInstruction
 
-void SendDisplayByte(unsigned char byte, unsigned char instruction_or_data)
+void SendDisplayByteNoWait(unsigned char byte, unsigned char instruction_or_data)
 {
+    unsigned long execution_time = LCD_BYTE_MICROSEC;
+
+    if (instruction_or_data == 0 && (byte == 0x01 || byte == 0x02)) // Clear Display, Return Home
+    {
+        execution_time = LCD_HOME_MICROSEC;
+    }
+    if (instruction_or_data == 0)
+    {
+        TraceRecord(TRACE_LCD_COMMAND, byte);
+    }
     SendDisplayNibble(byte >> 4, instruction_or_data); // Send MSB first (bit shift)
     SendDisplayNibble(byte, instruction_or_data);      // Send LSB last
-    WaitMicrosec(37);                                  // Wait 37 us
+                                                       // Note when the LCD will have finished with it
+    display_ready_cycles = ReadCycleCounter() + execution_time * (GetCoreClockHz() / 1000000);
+} // SendDisplayByteNoWait
 
-} // SendDisplayInstruction
+int DisplayBusy(void)
+{
+    // Signed difference, so it is right across the counter wrapping
+    return (long)(ReadCycleCounter() - display_ready_cycles) < 0;
+} // DisplayBusy
+
+// The LCD's power-on sequence, sent one step at a time by DisplayInitTask().
+// Nibble steps are followed by the given wait; byte steps by the usual
+// 37 us (1.52 ms for the clear), as set by SendDisplayByteNoWait().
+static const struct
+{
+    unsigned char value;         // Nibble or byte to send
+    unsigned char is_nibble;     // 1 for a nibble, 0 for a whole byte
+    unsigned short wait_microsec; // Wait after a nibble
+} display_init_steps[] = {
+    {0x03, 1, 5000}, // Function set; wait for more than 4.1 ms
+    {0x03, 1, 110},  // Function set; wait for more than 100 us
+    {0x02, 1, LCD_BYTE_MICROSEC},
+    {0x0C, 0, 0}, // Function set
+    {0x08, 0, 0}, // Set interface to be 4 bits long
+    {0x01, 0, 0}, // Clear LCD
+    {0x0C, 0, 0}, // Cursor off
+    {0x0E, 0, 0}, // Turn LCD On
+};
+#define DISPLAY_INIT_STEPS (sizeof(display_init_steps) / sizeof(display_init_steps[0]))
+#define DISPLAY_POWER_UP_MICROSEC 16000 // wait for more than 15 ms before the first step
+
+static int display_init_step = -1; // Next step to send; -1 before StartDisplayInit(),
+                                   // DISPLAY_INIT_STEPS + 1 once the LCD is ready
 
 void InitDisplayPort(void)
+{
+    StartDisplayInit();
+    while (!DisplayReady())
+    { // Send the sequence, waiting as needed
+        DisplayInitTask();
+    }
+} // InitDisplayPort
+
+void StartDisplayInit(void)
 {
     // Initialise the various parameters required to interface with the LCD
     // REGISTER INITIALISATION
@@ -280,62 +366,106 @@ void InitDisplayPort(void)
     unsigned long delay;
     delay = SYSCTL_RCGC2_R; //allow time for clock to start
 
-    GPIO_PORTA_DEN_R = 0x0C; // 1) Enable digital on pins 2 & 3
-    GPIO_PORTB_DEN_R = 0x3C; // 1) Enable digital on pins 2 to 5
+    // Only the LCD's own pins are changed: PA0 and PA1 are UART0's
+    GPIO_PORTA_DEN_R |= LCD_RS_PIN | LCD_EN_PIN; // 1) Enable digital on pins 2 & 3
+    GPIO_PORTB_DEN_R |= LCD_DATA_PINS;           // 1) Enable digital on pins 2 to 5
 
     GPIO_PORTA_LOCK_R = 0x4C4F434B; // 2) unlock PortA
     GPIO_PORTB_LOCK_R = 0x4C4F434B; // 2) unlock PortB
 
-    GPIO_PORTA_CR_R = 0x0C; // 3) allow changes to PA2&3
-    GPIO_PORTB_CR_R = 0x3C; // 3) allow changes to PB2-5
+    GPIO_PORTA_CR_R |= LCD_RS_PIN | LCD_EN_PIN; // 3) allow changes to PA2&3
+    GPIO_PORTB_CR_R |= LCD_DATA_PINS;           // 3) allow changes to PB2-5
 
-    GPIO_PORTA_AMSEL_R = 0x00; // 4) disable analog function
-    GPIO_PORTB_AMSEL_R = 0x00; // 4) disable analog function
+    GPIO_PORTA_AMSEL_R &= ~(LCD_RS_PIN | LCD_EN_PIN); // 4) disable analog function
+    GPIO_PORTB_AMSEL_R &= ~LCD_DATA_PINS;             // 4) disable analog function
 
-    GPIO_PORTA_PCTL_R = 0x00000000; // 5) GPIO clear bit PCTL
-    GPIO_PORTB_PCTL_R = 0x00000000; // 5) GPIO clear bit PCTL
+    GPIO_PORTA_PCTL_R &= ~0x0000FF00; // 5) GPIO clear bit PCTL for PA2&3 (4 bits per pin)
+    GPIO_PORTB_PCTL_R &= ~0x00FFFF00; // 5) GPIO clear bit PCTL for PB2-5
 
-    GPIO_PORTA_DIR_R = 0xFF; // 6) All ports set to output (none as input)
-    GPIO_PORTB_DIR_R = 0xFF; // 6) All ports set to output (none as input)
+    GPIO_PORTA_DIR_R |= LCD_RS_PIN | LCD_EN_PIN; // 6) Outputs
+    GPIO_PORTB_DIR_R |= LCD_DATA_PINS;           // 6) Outputs
 
-    GPIO_PORTA_AFSEL_R = 0x00; // 7) no alternate function
-    GPIO_PORTB_AFSEL_R = 0x00; // 7) no alternate function
+    GPIO_PORTA_AFSEL_R &= ~(LCD_RS_PIN | LCD_EN_PIN); // 7) no alternate function
+    GPIO_PORTB_AFSEL_R &= ~LCD_DATA_PINS;             // 7) no alternate function
 
-    // SENDING DATA TO LCD TO INITIALISE DISPLAY
-    WaitMillisec(16);           // wait for more than 15 ms
-    SendDisplayNibble(0x03, 0); // Function set
-    WaitMillisec(5);            // Wait for more than 4.1 ms
-    SendDisplayNibble(0x03, 0); // Function set
-    WaitMicrosec(110);          // Wait for more than 100 us
-    SendDisplayNibble(0x02, 0);
+    // SENDING DATA TO LCD TO INITIALISE DISPLAY is left to DisplayInitTask().
+    // The first step must wait until the LCD has been powered for 15 ms.
+    display_ready_cycles = ReadCycleCounter() + DISPLAY_POWER_UP_MICROSEC * (GetCoreClockHz() / 1000000);
+    display_init_step = 0;
+} // StartDisplayInit
 
-    SendDisplayByte(0x0C, 0); // Function set
-    SendDisplayByte(0x08, 0); // Set interface to be 4 bits long
+void DisplayInitTask(void)
+{
+    if (display_init_step < 0 || display_init_step > (int)DISPLAY_INIT_STEPS || DisplayBusy())
+    {
+        return; // Not started, already finished, or waiting
+    }
+    if (display_init_step == DISPLAY_INIT_STEPS) // The last step has finished
+    {
+        memset(display_shadow, ' ', sizeof(display_shadow)); // The clear left it blank
+        shadow_cursor_on = 1;                                 // 0x0E shows the cursor
+        display_init_step++;
+        BootTraceMark("lcd ready");
+        return;
+    }
 
-    SendDisplayByte(0x01, 0); // Clear LCD
-		SendDisplayByte(0x0C, 0); // Cursor off
-    //SendDisplayByte(0x06, 0); // Not required
-    SendDisplayByte(0x0E, 0); // Turn LCD On
-} // InitDisplayPort
+    if (display_init_steps[display_init_step].is_nibble)
+    {
+        SendDisplayNibble(display_init_steps[display_init_step].value, 0);
+        display_ready_cycles = ReadCycleCounter() + display_init_steps[display_init_step].wait_microsec * (GetCoreClockHz() / 1000000);
+    }
+    else
+    {
+        SendDisplayByteNoWait(display_init_steps[display_init_step].value, 0);
+    }
+    display_init_step++;
+} // DisplayInitTask
+
+int DisplayReady(void)
+{
+    return display_init_step == DISPLAY_INIT_STEPS + 1;
+} // DisplayReady
 
 void ClearDisplay()
 {
     SendDisplayByte(0x01, 0); // Clear display
     WaitMicrosec(37);
+
+    memset(display_shadow, ' ', sizeof(display_shadow)); // The LCD fills with spaces
+    shadow_line = 0;                                       // and returns home
+    shadow_col = 0;
+    display_changes++;
 } // ClearDisplay
 
 void TurnCursorOnOff(short int On)
+{
+    while (DisplayBusy())
+    { // A byte sent without waiting may still be executing
+    }
+    TurnCursorOnOffNoWait(On);
+    while (DisplayBusy())
+    { // Wait for the LCD to take it
+    }
+    WaitMicrosec(37);
+} // TurnCursorOnOff
+
+void TurnCursorOnOffNoWait(short int On)
 {
     if (On == 0)
     {
-        SendDisplayByte(0x0C, 0); // Cursor off
+        SendDisplayByteNoWait(0x0C, 0); // Cursor off
     }
     else
     {
-        SendDisplayByte(0x0F, 0); // Cursor on
+        SendDisplayByteNoWait(0x0F, 0); // Cursor on
     }
-    WaitMicrosec(37);
-} // TurnCursorOnOff
+    shadow_cursor_on = (On != 0);
+} // TurnCursorOnOffNoWait
+
+short int GetCursorOnOff(void)
+{
+    return shadow_cursor_on;
+} // GetCursorOnOff
 
 void SetPrintPosition(short int line, short int char_pos)
 {
@@ -363,80 +493,487 @@ void SetPrintPosition(short int line, short int char_pos)
         SendDisplayByte(0x14, 0); // Shift cursor right
     }
     WaitMicrosec(40);
+
+    shadow_line = (line == 2) ? 1 : 0;              // Follow the LCD's own position
+    shadow_col = (char_pos > 1) ? char_pos - 1 : 0; // (counting from 0)
     // SetPrintPosition
 }
 
 void PrintChar(char ch)
 {
-		// Switch to determine what character to print to display
+    PrintCharNoWait(ch); // Send the character
+    while (DisplayBusy())
+    { // Wait for the LCD to take it
+    }
+    WaitMicrosec(37); // Small wait to allow for processing
+} // PrintChar
+
+void PrintCharNoWait(char ch)
+{
+    // Switch to determine what character to print to display
     switch (ch)
     {
-    case '':                     // Must be unused character so doesn't affect normal strings
-        SendDisplayByte(0xF7, 1); // Send hex for PI
+    case '':                          // Must be unused character so doesn't affect normal strings
+        SendDisplayByteNoWait(0xF7, 1); // Send hex for PI
         break;
 
-    case '$':                     // Must be unused character so doesn't affect normal strings
-        SendDisplayByte(0xE8, 1); // Send hex for square root sign
+    case '$':                           // Must be unused character so doesn't affect normal strings
+        SendDisplayByteNoWait(0xE8, 1); // Send hex for square root sign
         break;
-		
-    default: // If a special character isn't required to be displayed
-        SendDisplayByte(ch, 1); // Send character to display
+
+    default:                          // If a special character isn't required to be displayed
+        SendDisplayByteNoWait(ch, 1); // Send character to display
     }
-    WaitMicrosec(37); // Small wait to allow for processing
-} // PrintChar
+
+    if (shadow_col < DISPLAY_WIDTH) // Characters beyond the end are not visible
+    {
+        display_shadow[shadow_line][shadow_col] = ch;
+        display_changes++;
+    }
+    shadow_col++; // The LCD auto-increments its address
+} // PrintCharNoWait
+
+void SetPrintPositionNoWait(short int line, short int char_pos)
+{
+    // One Set DDRAM Address instruction (37 us) rather than Return Home
+    // and a series of cursor shifts. Line 2 starts at address 0x40.
+    if (char_pos < 1)
+    {
+        char_pos = 1;
+    }
+    if (char_pos > DISPLAY_WIDTH + 1) // One beyond the end is allowed, as after printing a full line
+    {
+        char_pos = DISPLAY_WIDTH + 1;
+    }
+    SendDisplayByteNoWait(0x80 | ((line == 2) ? 0x40 : 0x00) | (char_pos - 1), 0);
+
+    shadow_line = (line == 2) ? 1 : 0;
+    shadow_col = char_pos - 1;
+} // SetPrintPositionNoWait
+
+void GetDisplayShadowPosition(short int *line, short int *char_pos)
+{
+    *line = shadow_line + 1;   // Counting from 1, like SetPrintPosition()
+    *char_pos = shadow_col + 1;
+} // GetDisplayShadowPosition
+
+const char *GetDisplayShadow(short int line)
+{
+    return display_shadow[(line == 2) ? 1 : 0];
+} // GetDisplayShadow
+
+unsigned long GetDisplayChangeCount(void)
+{
+    return display_changes;
+} // GetDisplayChangeCount
+
+void TurnDisplayOnOff(short int On)
+{
+    while (DisplayBusy())
+    { // A byte sent without waiting may still be executing
+    }
+    if (On == 0)
+    {
+        SendDisplayByteNoWait(0x08, 0); // Display off: contents and cursor position are kept
+    }
+    else
+    {
+        TurnCursorOnOffNoWait(shadow_cursor_on); // Display on, with the cursor as it was
+    }
+    while (DisplayBusy())
+    { // Wait for the LCD to take it
+    }
+} // TurnDisplayOnOff
 
 // ------------------------ Flash memory functions ------------------------
 
+/* The answer is kept in a 1 KB flash block used as a log of 8-byte
+ * slots: each write goes into the next empty (all ones) slot, and the
+ * latest answer is the last slot used. The block only has to be erased
+ * when all 128 slots are full, which saves both time (an erase takes
+ * milliseconds, a write microseconds) and wear.
+ *
+ * Writing is done in the background by FlashTask(), one flash operation
+ * per call, so the rest of the program keeps running. The core stalls
+ * on instruction fetches while an operation is in progress, but only
+ * for that one operation.
+ *
+ * The saved session, the macros and the statistics each have a block of
+ * their own, a RecordLog: a log of records in the same way, in slots of
+ * slot_size bytes. The first word of a slot is written last, as
+ * RECORD_VALID with the length in words, so a slot whose first word is
+ * anything else is incomplete (or cleared: flash bits can be written
+ * from 1 to 0 without an erase, so a session is cleared by writing its
+ * first word to 0).
+ * A log with a snapshot buffer copies the record into it as its write
+ * starts, so the caller may go on changing the record meanwhile.
+ */
+#define ANSWER_SLOT_COUNT (FLASH_BLOCK_SIZE / 8) // Doubles that fit in the block
+#define RECORD_VALID 0x5E550000                  // First word of a complete record, or'ed with its words
+
+typedef struct
+{
+    unsigned long address;        // Its erase block
+    int slot_size;                // Bytes in each slot: a record and its first word
+    unsigned char trace;          // Added to the trace data of its erases and writes
+    const unsigned char *data;    // Record asked for (the caller's, not copied)
+    int size;                     // Its size in bytes
+    unsigned char *snapshot;      // Copy of the record being written, or 0 to write from data
+    const unsigned char *writing; // The record being written: data or snapshot
+    int write_pending;            // 1 if it has not been started
+    int clear_pending;            // 1 if a clear (ClearSessionInFlash()) has not been done
+    int word;                     // Word of the slot being written (0 is the first word, written last)
+    int next_slot;                // First empty slot, or -1 before FindRecordSlot()
+} RecordLog;
+
+static enum
+{
+    FLASH_IDLE,            // Nothing in progress
+    FLASH_ERASING,         // Erasing the block because every slot was used
+    FLASH_WRITING_LOW,     // Writing the first word of a slot
+    FLASH_WRITING_HIGH,    // Writing the second word of a slot
+    FLASH_RECORD_ERASING,  // Erasing record_log's block because every slot was used
+    FLASH_RECORD_WRITING,  // Writing word record_log->word of a record slot
+    FLASH_RECORD_CLEARING  // Writing the first word of record_log's last record to 0
+} flash_state = FLASH_IDLE;
+static unsigned long flash_pending[2];   // Latest double asked for, as two words
+static int flash_write_pending = 0;      // 1 if flash_pending has not been started
+static unsigned long flash_writing[2];   // Double being written now
+static int flash_next_slot = 0;          // First empty slot in the block
+static unsigned char stats_snapshot[STATS_FLASH_MAX_SIZE];
+static RecordLog session_log = {SESSION_FLASH_ADDRESS, SESSION_MAX_SIZE + 4, TRACE_FLASH_SESSION, 0, 0, 0, 0, 0, 0, 0, -1};
+static RecordLog macro_log = {MACRO_FLASH_ADDRESS, MACRO_FLASH_MAX_SIZE + 4, TRACE_FLASH_MACROS, 0, 0, 0, 0, 0, 0, 0, -1};
+static RecordLog stats_log = {STATS_FLASH_ADDRESS, STATS_FLASH_MAX_SIZE + 4, TRACE_FLASH_STATS, 0, 0, stats_snapshot, 0, 0, 0, 0, -1};
+static RecordLog *record_log;            // The log FlashTask() is working on, in the FLASH_RECORD_ states
+
+static unsigned long AnswerSlotAddress(int slot)
+{
+    return ANSWER_FLASH_ADDRESS + slot * 8;
+}
+
+static int FlashSlotEmpty(int slot)
+{
+    const unsigned long *word = (const unsigned long *)AnswerSlotAddress(slot);
+
+    return word[0] == 0xFFFFFFFF && word[1] == 0xFFFFFFFF; // Erased flash reads as all ones
+}
+
+static void StartFlashOperation(unsigned long address, unsigned long data, unsigned long command)
+{
+    FLASH_FMA_R = address;                  // where
+    FLASH_FMD_R = data;                     // what (ignored for an erase)
+    FLASH_FMC_R = FLASH_FMC_WRKEY | command; // start it
+}
+
+static unsigned long RecordSlotAddress(const RecordLog *log, int slot)
+{
+    return log->address + slot * log->slot_size;
+}
+
+// Find the first empty slot of a log. A slot is only empty if every word
+// is, since a write cut short leaves its first word erased.
+static void FindRecordSlot(RecordLog *log)
+{
+    const unsigned long *word;
+    int i;
+
+    for (log->next_slot = FLASH_BLOCK_SIZE / log->slot_size; log->next_slot > 0; log->next_slot--)
+    {
+        word = (const unsigned long *)RecordSlotAddress(log, log->next_slot - 1);
+        for (i = 0; i < log->slot_size / 4 && word[i] == 0xFFFFFFFF; i++)
+        {
+        }
+        if (i < log->slot_size / 4)
+        {
+            break; // The last slot used
+        }
+    }
+}
+
+// Word of the record slot being written: the data, then the first word
+static unsigned long RecordWord(const RecordLog *log, int word)
+{
+    unsigned long value = 0;
+    int offset = (word - 1) * 4;
+
+    if (word == 0)
+    {
+        return RECORD_VALID | ((log->size + 3) / 4);
+    }
+    memcpy(&value, log->writing + offset, (log->size - offset < 4) ? log->size - offset : 4);
+    return value;
+}
+
+// Start the next operation on a log, if one is waiting. Returns 1 if one
+// was started.
+static int StartRecordOperation(RecordLog *log)
+{
+    if (log->next_slot < 0)
+    {
+        FindRecordSlot(log);
+    }
+    record_log = log;
+    if (log->clear_pending)
+    {
+        log->clear_pending = 0;
+        if (log->next_slot == 0)
+        {
+            return 0; // Nothing to clear
+        }
+        StartFlashOperation(RecordSlotAddress(log, log->next_slot - 1), 0, FLASH_FMC_WRITE);
+        flash_state = FLASH_RECORD_CLEARING;
+        return 1;
+    }
+    if (!log->write_pending)
+    {
+        return 0;
+    }
+    if (log->next_slot >= FLASH_BLOCK_SIZE / log->slot_size) // Block full: erase it first
+    {
+        TraceRecord(TRACE_FLASH_ERASE, log->trace);
+        StartFlashOperation(log->address, 0, FLASH_FMC_ERASE);
+        flash_state = FLASH_RECORD_ERASING;
+        return 1;
+    }
+    log->write_pending = 0;
+    log->writing = log->data;
+    if (log->snapshot != 0) // Taken now, so later changes wait for the next write
+    {
+        memcpy(log->snapshot, log->data, log->size);
+        log->writing = log->snapshot;
+    }
+    log->word = 1;
+    TraceRecord(TRACE_FLASH_WRITE, log->trace + log->next_slot);
+    StartFlashOperation(RecordSlotAddress(log, log->next_slot) + 4, RecordWord(log, 1), FLASH_FMC_WRITE);
+    flash_state = FLASH_RECORD_WRITING;
+    return 1;
+}
+
+static void WriteRecord(RecordLog *log, const void *record, int size)
+{
+    if (size > log->slot_size - 4)
+    {
+        return; // Would not fit in a slot
+    }
+    log->data = (const unsigned char *)record;
+    log->size = size;
+    log->write_pending = 1;
+}
+
+static int ReadRecord(RecordLog *log, void *record, int size)
+{
+    const unsigned long *slot;
+
+    if (log->next_slot < 0)
+    {
+        FindRecordSlot(log);
+    }
+    if (log->next_slot == 0 || size > log->slot_size - 4)
+    {
+        return 0; // None written since the block was erased
+    }
+    slot = (const unsigned long *)RecordSlotAddress(log, log->next_slot - 1);
+    if (slot[0] != (RECORD_VALID | ((size + 3) / 4)))
+    {
+        return 0; // Incomplete, cleared, or of another size
+    }
+    memcpy(record, slot + 1, size);
+    return 1;
+}
+
 void InitFlash()
 {
-    // Write your code here.
+    // Find the first empty slot: everything before it has been written
+    flash_next_slot = 0;
+    while (flash_next_slot < ANSWER_SLOT_COUNT && !FlashSlotEmpty(flash_next_slot))
+    {
+        flash_next_slot++;
+    }
+    FindRecordSlot(&session_log);
+    FindRecordSlot(&macro_log);
+    FindRecordSlot(&stats_log);
 } // InitFlash
 
 void WriteDoubleToFlash(double number)
 {
-    // Write your code here.
+    // Only note it here: FlashTask() does the writing. If several answers
+    // arrive while a write is in progress only the last is kept.
+    memcpy(flash_pending, &number, sizeof(flash_pending));
+    flash_write_pending = 1;
 } // WriteFloatToFlash
 
 double ReadDoubleFromFlash()
 {
-    // Write your code here.
+    double number = 0.0; // Returned if nothing has been stored yet
+
+    if (flash_next_slot > 0)
+    {
+        memcpy(&number, (const void *)AnswerSlotAddress(flash_next_slot - 1), sizeof(number));
+    }
+    return number;
 } // ReadFloatFromFlash
 
+void FlashTask(void)
+{
+    if (FLASH_FMC_R & (FLASH_FMC_WRITE | FLASH_FMC_ERASE))
+    {
+        return; // Previous operation still in progress
+    }
+
+    switch (flash_state)
+    {
+    case FLASH_IDLE:
+        if (!flash_write_pending)
+        {
+            // If there is one: the answer comes first, then the session
+            if (!StartRecordOperation(&session_log) && !StartRecordOperation(&macro_log))
+            {
+                StartRecordOperation(&stats_log);
+            }
+            break;
+        }
+        if (flash_next_slot >= ANSWER_SLOT_COUNT) // Block full: erase it first
+        {
+            TraceRecord(TRACE_FLASH_ERASE, 0);
+            StartFlashOperation(ANSWER_FLASH_ADDRESS, 0, FLASH_FMC_ERASE);
+            flash_state = FLASH_ERASING;
+            break;
+        }
+        flash_writing[0] = flash_pending[0]; // Take the latest value
+        flash_writing[1] = flash_pending[1];
+        flash_write_pending = 0;
+        TraceRecord(TRACE_FLASH_WRITE, flash_next_slot);
+        StartFlashOperation(AnswerSlotAddress(flash_next_slot), flash_writing[0], FLASH_FMC_WRITE);
+        flash_state = FLASH_WRITING_LOW;
+        break;
+
+    case FLASH_ERASING:
+        flash_next_slot = 0;      // Every slot is empty again
+        flash_state = FLASH_IDLE; // The write starts on the next call
+        break;
+
+    case FLASH_WRITING_LOW:
+        StartFlashOperation(AnswerSlotAddress(flash_next_slot) + 4, flash_writing[1], FLASH_FMC_WRITE);
+        flash_state = FLASH_WRITING_HIGH;
+        break;
+
+    case FLASH_WRITING_HIGH:
+        flash_next_slot++; // The slot now holds the latest answer
+        flash_state = FLASH_IDLE;
+        break;
+
+    case FLASH_RECORD_ERASING:
+        record_log->next_slot = 0;
+        flash_state = FLASH_IDLE;
+        break;
+
+    case FLASH_RECORD_WRITING:
+        if (record_log->word == 0)
+        {
+            record_log->next_slot++; // The first word is written: the record is complete
+            flash_state = FLASH_IDLE;
+            break;
+        }
+        record_log->word = (record_log->word * 4 < record_log->size) ? record_log->word + 1 : 0;
+        StartFlashOperation(RecordSlotAddress(record_log, record_log->next_slot) + record_log->word * 4,
+                            RecordWord(record_log, record_log->word), FLASH_FMC_WRITE);
+        break;
+
+    case FLASH_RECORD_CLEARING:
+        flash_state = FLASH_IDLE;
+        break;
+    }
+} // FlashTask
+
+int FlashWritePending(void)
+{
+    return flash_state != FLASH_IDLE || flash_write_pending || session_log.write_pending ||
+           session_log.clear_pending || macro_log.write_pending || stats_log.write_pending;
+} // FlashWritePending
+
+void WriteSessionToFlash(const void *session, int size)
+{
+    WriteRecord(&session_log, session, size);
+} // WriteSessionToFlash
+
+int ReadSessionFromFlash(void *session, int size)
+{
+    return ReadRecord(&session_log, session, size);
+} // ReadSessionFromFlash
+
+void ClearSessionInFlash(void)
+{
+    session_log.write_pending = 0;
+    session_log.clear_pending = 1;
+} // ClearSessionInFlash
+
+void WriteMacrosToFlash(const void *macros, int size)
+{
+    WriteRecord(&macro_log, macros, size);
+} // WriteMacrosToFlash
+
+int ReadMacrosFromFlash(void *macros, int size)
+{
+    return ReadRecord(&macro_log, macros, size);
+} // ReadMacrosFromFlash
+
+void WriteStatsToFlash(const void *stats, int size)
+{
+    WriteRecord(&stats_log, stats, size);
+} // WriteStatsToFlash
+
+int ReadStatsFromFlash(void *stats, int size)
+{
+    return ReadRecord(&stats_log, stats, size);
+} // ReadStatsFromFlash
+
 // ------------------------ Sundry functions ------------------------
+static unsigned long core_clock_hz = 16000000; // The precision internal oscillator until PLL_Init()
+static int uart_ready = 0;                     // 1 once UART_Init() has run (its registers can be used)
+
+static void SetUartBaud(void);
+
 void InitAllOther()
 {
-    PLL_Init();     // Initialise phase lock loop
+    InitCycleCounter(); // Initialise free-running timestamp counter (first, so the boot trace times everything)
+    BootTraceMark("start");
+    PLL_Init(); // Initialise phase lock loop
+    BootTraceMark("pll");
     SysTick_Init(); // Initialise System Tick
-    InitFlash();    // Initialise flash
 } // InitAllOther
 
 void InitAllHardware()
 {
     InitAllOther();      // Complete Tiva initialisations above
-    InitDisplayPort();   // Initialise LCD
     InitKeyboardPorts(); // Initialise keyboard
+    BootTraceMark("keypad ports");
+    StartDisplayInit(); // Initialise LCD: DisplayInitTask() does the rest, in the background
+    BootTraceMark("lcd ports");
 } // InitAllHardware
 
-void WaitMicrosec(long int wait_microsecs) // 80 MHz PLL (12.5 ns per cycle)
+void InitDeferredHardware()
 {
-    NVIC_ST_RELOAD_R = (wait_microsecs * 80) - 1; // number of counts to wait
-    NVIC_ST_CURRENT_R = 0;                        // any value written to CURRENT clears
-    while ((NVIC_ST_CTRL_R & 0x00010000) == 0)
-    { // wait for count flag
-    }
+    UART_Init(); // Initialise serial port (after the LCD, which also sets up Port A)
+    InitFlash(); // Initialise flash
+    BootTraceMark("uart, flash");
+} // InitDeferredHardware
+
+void WaitMicrosec(long int wait_microsecs)
+{
+    // SysTick is now the 1 ms system tick, so waits count cycles instead,
+    // at whatever the clock is now (see SetCoreClock())
+    Wait_12_5_Nanosec(wait_microsecs * (long)(core_clock_hz / 1000000)); // number of counts to wait
 } // WaitMicrosec
 
 // =============== CUSTOM AND EXTRA FUNCTIONS ================= //
 void WaitMillisec(long int wait_millisecs)
 {
     /*
-	 * The NVIC_ST_RELOAD register is a 24 bit register meaning
-	 * the max value it can hold is 2^24-1 = 16777215.
-	 * Running with a clock cycle time of 12.5 ns (80 MHz),
-	 * the max time that this function can be used for is 
-	 * (16777215*12.5 ns) = 0.2097 s ~ 200 ms
-	 * I have thus chosen the maximum value that can be input here
-	 * to be 200, preventing the register from overflowing
+	 * The waits used to be timed by loading the 24 bit NVIC_ST_RELOAD
+	 * register, whose maximum of 2^24-1 counts at 12.5 ns is ~200 ms.
+	 * They now count cycles of the 32 bit cycle counter instead, but
+	 * the 200 ms limit is kept: nothing should wait that long now
+	 * that the program is event driven (see scheduler.h).
 	 */
     if (wait_millisecs > 200)
     { // Limit wait to 200 ms
@@ -458,15 +995,34 @@ void WaitSec(long int wait_secs)
         WaitMillisec(200);
     }
 }
+
+void InitCycleCounter(void)
+{
+    // SysTick only counts milliseconds. The Cortex-M4 debug unit has a
+    // separate 32-bit counter which counts every core clock cycle; turn it on.
+    NVIC_DBG_DEMCR_R |= NVIC_DBG_DEMCR_TRCENA; // enable the DWT unit
+    DWT_CYCCNT_R = 0;                          // start from zero
+    DWT_CTRL_R |= DWT_CTRL_CYCCNTENA;          // start counting
+} // InitCycleCounter
+
+unsigned long ReadCycleCounter(void)
+{
+    return DWT_CYCCNT_R;
+} // ReadCycleCounter
+
+unsigned long GetCoreClockHz(void)
+{
+    return core_clock_hz;
+} // GetCoreClockHz
 void Wait_12_5_Nanosec(long int wait_nanosecs) // Waits 12.5ns
 {
     // As clock is running at 80 MHz, the smallest time increment that can
-    // be measured is 12.5 ns
+    // be measured is 12.5 ns. At the slow clock each count is 62.5 ns, so
+    // a wait is longer than asked for, never shorter.
 
-    NVIC_ST_RELOAD_R = (wait_nanosecs)-1; // number of counts to wait
-    NVIC_ST_CURRENT_R = 0;                // any value written to CURRENT clears
-    while ((NVIC_ST_CTRL_R & 0x00010000) == 0)
-    { // wait for count flag
+    unsigned long start = ReadCycleCounter(); // Unsigned difference below is right across a wrap
+    while (ReadCycleCounter() - start < (unsigned long)wait_nanosecs)
+    { // wait for the count
     }
 } // Wait 12.5Nanosec
 
@@ -493,29 +1049,238 @@ void PLL_Init(void)
     }; // wait for PLLRIS bit
     // 6) enable use of PLL by clearing BYPASS
     SYSCTL_RCC2_R &= ~0x00000800;
+    core_clock_hz = CORE_CLOCK_HZ;
+}
+
+void SetCoreClock(int fast)
+{
+    unsigned long uart_interrupts = 0;
+
+    if (fast == (core_clock_hz == CORE_CLOCK_HZ))
+    {
+        return; // Already there
+    }
+    // Times already set in cycles of the present clock must run out first
+    while (DisplayBusy())
+    { // At most 1.52 ms
+    }
+    if (uart_ready)
+    {
+        // Stop the transmit interrupt refilling the FIFO, and let what is
+        // in it go at the old rate (at most 16 bytes, 1.4 ms)
+        uart_interrupts = UART0_IM_R;
+        UART0_IM_R = uart_interrupts & ~UART_IM_TXIM;
+        while (UART0_FR_R & UART_FR_BUSY)
+        {
+        }
+    }
+
+    // The PLL stays powered and locked when bypassed, so there is no wait to switch back
+    if (fast)
+    {
+        SYSCTL_RCC2_R &= ~0x00000800; // Clear BYPASS2: the PLL, divided down to 80 MHz
+        core_clock_hz = CORE_CLOCK_HZ;
+    }
+    else
+    {
+        SYSCTL_RCC2_R |= 0x00000800; // Set BYPASS2: the 16 MHz crystal, undivided
+        core_clock_hz = SLOW_CLOCK_HZ;
+    }
+
+    // Everything timed by the clock follows it. The tick in progress restarts,
+    // so the millisecond count slips by less than a millisecond per switch.
+    NVIC_ST_RELOAD_R = core_clock_hz / 1000 - 1;
+    NVIC_ST_CURRENT_R = 0;
+    if (uart_ready)
+    {
+        SetUartBaud();
+        UART0_IM_R = uart_interrupts; // A transmit interrupt missed meanwhile is still pending
+    }
+    TraceRecord(TRACE_CLOCK, fast);
+} // SetCoreClock
+
+void GPIOPortE_Handler(void)
+{
+    // Only here to wake the core from SleepUntilKey(): a key went down
+    GPIO_PORTE_ICR_R = KEYPAD_ROW_PINS; // acknowledge
 }
+
+void SleepUntilKey(void)
+{
+    unsigned char columns = KEYPAD_GET_COLS(); // The column being scanned, put back afterwards
+
+    KEYPAD_SET_COLS(KEYPAD_COL_PINS); // Every column high, so any key raises its row
+    WaitMicrosec(KEYPAD_SETTLE_MICROSEC);
+
+    // Rising edges on the rows interrupt
+    GPIO_PORTE_IS_R &= ~KEYPAD_ROW_PINS;
+    GPIO_PORTE_IBE_R &= ~KEYPAD_ROW_PINS;
+    GPIO_PORTE_IEV_R |= KEYPAD_ROW_PINS;
+    GPIO_PORTE_ICR_R = KEYPAD_ROW_PINS;
+    GPIO_PORTE_IM_R |= KEYPAD_ROW_PINS;
+    NVIC_EN0_R = NVIC_EN0_INT4;
+
+    // In deep sleep only the keypad ports are clocked, from the 30 kHz oscillator
+    SYSCTL_DCGC2_R = SYSCTL_DCGC2_KEYPAD;
+    SYSCTL_RCC_R |= SYSCTL_RCC_ACG;
+    SYSCTL_DSLPCLKCFG_R = SYSCTL_DSLPCLKCFG_LFIOSC | SYSCTL_DSLPCLKCFG_PIOSCPD;
+    SYSCTL_DSLPPWRCFG_R = SYSCTL_DSLPPWRCFG_LOW;
+    NVIC_ST_CTRL_R = 0; // No tick: it would only wake the core again
+
+    // With interrupts masked, a key pressed after the rows are read still
+    // wakes the core (WFI returns on a pending interrupt), so none is missed
+    NVIC_SYS_CTRL_R |= NVIC_SYS_CTRL_SLEEPDEEP;
+    __disable_irq();
+    while (ReadKeyboardRow() == 0)
+    {
+        __wfi();
+        __enable_irq(); // Let the interrupt (whichever it was) be handled
+        __disable_irq();
+    }
+    __enable_irq();
+    NVIC_SYS_CTRL_R &= ~NVIC_SYS_CTRL_SLEEPDEEP;
+
+    // The core wakes on the run mode clock, as SetCoreClock() left it
+    GPIO_PORTE_IM_R &= ~KEYPAD_ROW_PINS;
+    NVIC_DIS0_R = NVIC_EN0_INT4;
+    NVIC_ST_CURRENT_R = 0;
+    NVIC_ST_CTRL_R = 0x00000007; // The tick again, as SysTick_Init() set it
+    KEYPAD_SET_COLS(columns);
+    WaitMicrosec(KEYPAD_SETTLE_MICROSEC); // So the next scan does not see every column
+} // SleepUntilKey
 // =========== EXTRA FUNCTIONS (Not written by me) ============== //
 void SysTick_Init(void)
 {
-    NVIC_ST_CTRL_R = 0;            // disable SysTick during setup
-    NVIC_ST_RELOAD_R = 0x00FFFFFF; // maximum reload value
-    NVIC_ST_CURRENT_R = 0;         // any write to current clears it
-    NVIC_ST_CTRL_R = 0x00000005;   // enable SysTick with core clock
+    NVIC_ST_CTRL_R = 0;                           // disable SysTick during setup
+    NVIC_ST_RELOAD_R = core_clock_hz / 1000 - 1;  // interrupt every 1 ms (was free-running for the waits)
+    NVIC_ST_CURRENT_R = 0;                        // any write to current clears it
+    NVIC_SYS_PRI3_R = (NVIC_SYS_PRI3_R & 0x00FFFFFF) | 0x60000000; // priority 3 (below UART0)
+    NVIC_ST_CTRL_R = 0x00000007;                  // enable SysTick with core clock and interrupts
+}
+
+// =========== SYSTEM TICK ============== //
+static volatile unsigned long tick_millisec = 0; // Milliseconds since SysTick_Init()
+
+void SysTick_Handler(void)
+{
+    tick_millisec++;
 }
 
+unsigned long GetTickMillisec(void)
+{
+    return tick_millisec;
+} // GetTickMillisec
+
+unsigned long GetTickMicrosec(void)
+{
+    unsigned long millisec;
+    unsigned long current;
+
+    do // Again if the tick interrupt came in between
+    {
+        millisec = tick_millisec;
+        current = NVIC_ST_CURRENT_R; // Counts down from RELOAD to 0 each millisecond
+    } while (millisec != tick_millisec);
+    return millisec * 1000 + (NVIC_ST_RELOAD_R - current) / (core_clock_hz / 1000000);
+} // GetTickMicrosec
+
+// =========== STACK ============== //
+// The linker's names for the start and end of the STACK area of startup.s
+extern unsigned char STACK$$Base[];
+extern unsigned char STACK$$Limit[];
+
+void GetStackLimits(unsigned char **bottom, unsigned char **top)
+{
+    *bottom = STACK$$Base;
+    *top = STACK$$Limit; // The initial stack pointer: the stack grows down from here
+} // GetStackLimits
+
 void UART_Init(void)
 {
     SYSCTL_RCGC1_R |= SYSCTL_RCGC1_UART0; // activate UART0
     SYSCTL_RCGC2_R |= SYSCTL_RCGC2_GPIOA; // activate port A
+    UART_InitBuffers();                   // empty the software ring buffers (UART.c)
     UART0_CTL_R &= ~UART_CTL_UARTEN;      // disable UART
-    UART0_IBRD_R = 43;                    // IBRD = int(80,000,000 / (16 * 115200)) = int(43.402778)
-    UART0_FBRD_R = 26;                    // FBRD = round(0.402778 * 64) = 26
-                                          // 8 bit word length (no parity bits, one stop bit, FIFOs)
-    UART0_LCRH_R = (UART_LCRH_WLEN_8 | UART_LCRH_FEN);
+    SetUartBaud();                        // Divisors for the present clock; also sets LCRH
+                                          // interrupt when RX FIFO half full, TX FIFO nearly empty
+    UART0_IFLS_R = (UART0_IFLS_R & ~0x3F) | UART_IFLS_RX4_8 | UART_IFLS_TX1_8;
+    UART0_IM_R = UART_IM_RXIM | UART_IM_RTIM; // arm RX (and timeout for odd bytes); TX armed by UART_StartTx()
     UART0_CTL_R |= UART_CTL_UARTEN; // enable UART
     GPIO_PORTA_AFSEL_R |= 0x03;     // enable alt funct on PA1-0
     GPIO_PORTA_DEN_R |= 0x03;       // enable digital I/O on PA1-0
                                     // configure PA1-0 as UART
     GPIO_PORTA_PCTL_R = (GPIO_PORTA_PCTL_R & 0xFFFFFF00) + 0x00000011;
     GPIO_PORTA_AMSEL_R &= ~0x03; // disable analog functionality on PA
+    NVIC_PRI1_R = (NVIC_PRI1_R & 0xFFFF00FF) | 0x00004000; // UART0 is interrupt 5, priority 2
+    NVIC_EN0_R = NVIC_EN0_INT5;                            // enable interrupt 5 in NVIC
+    uart_ready = 1;
+}
+
+static void SetUartBaud(void)
+{
+    // Divisor = clock / (16 * baud), as an integer part and 64ths, rounded:
+    // 43 + 26/64 at 80 MHz, 8 + 44/64 at 16 MHz
+    unsigned long divisor_64ths = (core_clock_hz * 8 / UART_BAUD + 1) / 2;
+    unsigned long enabled = UART0_CTL_R & UART_CTL_UARTEN;
+
+    UART0_CTL_R &= ~UART_CTL_UARTEN; // The divisors may only be changed with the UART disabled
+    UART0_IBRD_R = divisor_64ths / 64;
+    UART0_FBRD_R = divisor_64ths % 64;
+    // 8 bit word length (no parity bits, one stop bit, FIFOs). Writing LCRH is
+    // also what makes the new divisors take effect.
+    UART0_LCRH_R = (UART_LCRH_WLEN_8 | UART_LCRH_FEN);
+    UART0_CTL_R |= enabled;
+} // SetUartBaud
+
+// =========== INTERRUPT-DRIVEN UART (buffering is in UART.c) ============== //
+static void CopyTxRingToFifo(void)
+{
+    unsigned char data;
+
+    // Fill the hardware FIFO as far as it will go. Each byte taken here is
+    // one less that the program could ever have to wait for.
+    while ((UART0_FR_R & UART_FR_TXFF) == 0 && UART_TxIsr(&data))
+    {
+        UART0_DR_R = data;
+    }
+}
+
+void UART_StartTx(void)
+{
+    // Called by the program after queuing bytes. The transmit interrupt is
+    // disarmed while we use the ring from here, so only one side consumes it.
+    // (The handler only ever clears TXIM, so this read-modify-write is safe.)
+    UART0_IM_R &= ~UART_IM_TXIM;
+    CopyTxRingToFifo();
+    if (UART_TxSpace() < UART_TX_BUFFER_SIZE) // Still more than the FIFO could take
+    {
+        UART0_IM_R |= UART_IM_TXIM; // Let the interrupt send the rest as the FIFO drains
+    }
+}
+
+void UART0_Handler(void)
+{
+    unsigned long data;
+
+    // Receive: FIFO half full, or bytes sitting there for 32 bit-times
+    while ((UART0_FR_R & UART_FR_RXFE) == 0)
+    {
+        data = UART0_DR_R;
+        if (data & UART_DR_OE) // Hardware FIFO overflowed before this byte
+        {
+            UART_RxHwOverrun();
+        }
+        UART_RxIsr((unsigned char)data);
+    }
+    UART0_ICR_R = UART_ICR_RXIC | UART_ICR_RTIC; // acknowledge
+
+    if (UART0_MIS_R & UART_MIS_TXMIS) // Transmit FIFO has drained to 1/8
+    {
+        UART0_ICR_R = UART_ICR_TXIC; // acknowledge
+        CopyTxRingToFifo();
+        if (UART_TxSpace() == UART_TX_BUFFER_SIZE) // Ring empty: nothing more to do
+        {
+            UART0_IM_R &= ~UART_IM_TXIM; // disarm until UART_StartTx() is called again
+        }
+    }
 }
\ No newline at end of file
@@ -156,6 +156,27 @@ void SendDisplayByte( unsigned char byte, unsigned char instruction_or_data );
  */
 void InitDisplayPort( void );
 
+/*! \name Display start-up without waiting
+ * 
+ * InitDisplayPort() takes over 20 ms, almost all of it waiting for the 
+ * LCD. StartDisplayInit() sets up the port and returns at once; 
+ * DisplayInitTask() (a scheduler task) then sends each step of the LCD's 
+ * start-up sequence when it is due. Nothing may be sent to the LCD until 
+ * DisplayReady() returns 1.
+ */
+//@{
+
+/*! Set up the LCD port and start the LCD's start-up sequence. */
+void StartDisplayInit( void );
+
+/*! Send the next step of the start-up sequence, if it is due. */
+void DisplayInitTask( void );
+
+/*! \return 1 once the start-up sequence is complete, else 0. */
+int DisplayReady( void );
+
+//@}
+
 /*! Clear the display.
  * 
  * The only real requirement is that there is no information left on the 
@@ -198,6 +219,79 @@ void TurnCursorOnOff( short int On );
  */
 void PrintChar( char ch );
 
+/*! \name Display functions which do not wait
+ * 
+ * These send to the LCD and return at once. The caller must not send 
+ * anything else until DisplayBusy() returns 0. They let a background 
+ * task keep the display up to date without holding up the program for 
+ * the 37 us (or 1.52 ms) each byte takes.
+ */
+//@{
+
+/*! \return 1 while the LCD is still executing the last byte sent, else 0. */
+int DisplayBusy( void );
+
+/*! As SendDisplayByte(), but without the wait afterwards. */
+void SendDisplayByteNoWait( unsigned char byte, unsigned char instruction_or_data );
+
+/*! As PrintChar(), but without the wait afterwards. */
+void PrintCharNoWait( char ch );
+
+/*! As TurnCursorOnOff(), but without the wait afterwards. */
+void TurnCursorOnOffNoWait( short int On );
+
+/*! \return 1 if the cursor is being shown, else 0. */
+short int GetCursorOnOff( void );
+
+/*! As SetPrintPosition(), but a single instruction and without the wait.
+ * \a char_pos may also be 17, the position after a full line.
+ */
+void SetPrintPositionNoWait( short int line, short int char_pos );
+
+/*! Where the next character sent to the LCD will appear.
+ * 
+ * \param [out] line The line number, 1 for top or 2 for bottom.
+ * \param [out] char_pos The character position, counting from 1. May be 
+ * 		beyond 16 after printing at the end of a line.
+ */
+void GetDisplayShadowPosition( short int *line, short int *char_pos );
+
+//@}
+
+/*! Number of character positions on each display line. */
+#define DISPLAY_WIDTH 16
+
+/*! Read one line of the copy of the display kept by the display functions.
+ *
+ * \param [in] line The line number, 1 for top or 2 for bottom.
+ * \return Pointer to the \a DISPLAY_WIDTH characters on that line (not a
+ * 		C-format string: there is no trailing null). Special characters
+ * 		are held as the code passed to PrintChar(), not the LCD code.
+ *
+ * ClearDisplay(), SetPrintPosition() and PrintChar() keep this copy up to
+ * date as they drive the LCD, so other modules (e.g. the serial mirror)
+ * can see what is on the screen without reading the LCD back.
+ */
+const char *GetDisplayShadow( short int line );
+
+/*! Count of changes made to the display since power-on.
+ *
+ * \return A number which changes whenever the display contents change.
+ * 		Compare it with an earlier value to see if there is anything new.
+ */
+unsigned long GetDisplayChangeCount( void );
+
+/*! Turn the whole display off or on (the HD44780 Display On/Off 
+ * instruction), e.g. to save power.
+ * 
+ * \param [in] On 0 for off, any non-zero quantity for on.
+ * 
+ * The LCD keeps its contents and cursor position while it is off, so 
+ * turning it on again brings back exactly what it showed, with the 
+ * cursor as it was (see GetCursorOnOff()).
+ */
+void TurnDisplayOnOff( short int On );
+
 // End of Display functions
 //@}
 
@@ -209,8 +303,10 @@ void PrintChar( char ch );
 /*! Address in flash where the previous answer is stored.
  * 
  * It is up to the prorammer to choose a value for this.
+ * It is the start of a 1 KB erase block (the last one of the 256 KB
+ * flash, well clear of the program) which holds a log of answers.
  */
-#define ANSWER_FLASH_ADDRESS	0x00
+#define ANSWER_FLASH_ADDRESS	0x0003FC00
 
 /*! Initialise flash memory.
  */
@@ -221,6 +317,8 @@ void InitFlash( void );
  * \param [in] number The number to store.
  * 
  * Store it in the address ANSWER_FLASH_ADDRESS.
+ * This returns at once: the writing is done in the background by 
+ * FlashTask(), which must be called regularly (it is a scheduler task).
  */
 void WriteDoubleToFlash( double number );
 
@@ -232,6 +330,113 @@ void WriteDoubleToFlash( double number );
  */
 double ReadDoubleFromFlash( void );
 
+/*! Do the next step of any flash write started by WriteDoubleToFlash(), 
+ * WriteSessionToFlash(), ClearSessionInFlash(), WriteMacrosToFlash() or 
+ * WriteStatsToFlash(), without waiting. Each call starts at most one 
+ * flash operation. Answers are written first, then the session, then 
+ * the macros, then the statistics.
+ */
+void FlashTask( void );
+
+/*! \return 1 while a flash write asked for has not finished, else 0.
+ */
+int FlashWritePending( void );
+
+/*! Address in flash where the saved session (see power_down.h) is stored:
+ * the 1 KB erase block below the answers, used as a log of records in 
+ * the same way.
+ */
+#define SESSION_FLASH_ADDRESS	0x0003F800
+
+/*! Largest session, in bytes, that WriteSessionToFlash() can store. */
+#define SESSION_MAX_SIZE 252
+
+/*! Write a saved session to flash, in the background (see FlashTask()).
+ * 
+ * \param [in] session The session: any data of up to SESSION_MAX_SIZE 
+ * 		bytes. It is not copied, so it must stay unchanged until 
+ * 		FlashWritePending() returns 0.
+ * \param [in] size Its size, in bytes.
+ * 
+ * The record is only marked valid once every word of it is written, so 
+ * a reset part way through leaves no session rather than half of one.
+ */
+void WriteSessionToFlash( const void *session, int size );
+
+/*! Read the session last written by WriteSessionToFlash().
+ * 
+ * \param [out] session Where to put it.
+ * \param [in] size Its size, in bytes.
+ * \return 1 if there is a complete session of that size which has not 
+ * 		been cleared since, else 0 (and \a session is unchanged).
+ * 
+ * May be called before InitFlash().
+ */
+int ReadSessionFromFlash( void *session, int size );
+
+/*! Mark the session in flash as used, so that ReadSessionFromFlash() 
+ * no longer finds it, in the background. A WriteSessionToFlash() not 
+ * yet started is cancelled.
+ */
+void ClearSessionInFlash( void );
+
+/*! Address in flash where the keystroke macros (see macro.h) are stored: 
+ * the 1 KB erase block below the session, used in the same way.
+ */
+#define MACRO_FLASH_ADDRESS	0x0003F400
+
+/*! Largest table of macros, in bytes, that WriteMacrosToFlash() can store. */
+#define MACRO_FLASH_MAX_SIZE 508
+
+/*! Write the macros to flash, in the background (see FlashTask()), in 
+ * the same way as WriteSessionToFlash().
+ * 
+ * \param [in] macros The macros: any data of up to MACRO_FLASH_MAX_SIZE 
+ * 		bytes. It is not copied, so it must stay unchanged until 
+ * 		FlashWritePending() returns 0.
+ * \param [in] size Its size, in bytes.
+ */
+void WriteMacrosToFlash( const void *macros, int size );
+
+/*! Read the macros last written by WriteMacrosToFlash().
+ * 
+ * \param [out] macros Where to put them.
+ * \param [in] size Their size, in bytes.
+ * \return 1 if there are macros of that size, else 0 (and \a macros is 
+ * 		unchanged).
+ */
+int ReadMacrosFromFlash( void *macros, int size );
+
+/*! Address in flash where the statistics (see stats.h) are stored: the 
+ * 1 KB erase block below the macros, used in the same way. Each point 
+ * entered is written, so with 8 slots in the block and 100,000 erases 
+ * it lasts for 800,000 points.
+ */
+#define STATS_FLASH_ADDRESS	0x0003F000
+
+/*! Largest set of statistics, in bytes, that WriteStatsToFlash() can store. */
+#define STATS_FLASH_MAX_SIZE 124
+
+/*! Write the statistics to flash, in the background (see FlashTask()), in 
+ * the same way as WriteSessionToFlash(), except that they are copied 
+ * when the write starts: they may change at any time, and the latest 
+ * are written next.
+ * 
+ * \param [in] stats The statistics: any data of up to STATS_FLASH_MAX_SIZE 
+ * 		bytes, of the same size each time.
+ * \param [in] size Its size, in bytes.
+ */
+void WriteStatsToFlash( const void *stats, int size );
+
+/*! Read the statistics last written by WriteStatsToFlash().
+ * 
+ * \param [out] stats Where to put them.
+ * \param [in] size Their size, in bytes.
+ * \return 1 if there are statistics of that size, else 0 (and \a stats 
+ * 		is unchanged).
+ */
+int ReadStatsFromFlash( void *stats, int size );
+
  // End of Flash memory functions
 //@}
 
@@ -249,9 +454,20 @@ void InitAllOther( void );
  * 
  * This will probably call other init functions 
  * rather than handling the hardware itself.
+ * 
+ * Only what is needed to read the keypad and start the LCD is done here, 
+ * so that the calculator responds as soon as possible after reset. 
+ * The LCD start-up finishes in the background (see StartDisplayInit()), 
+ * and the rest is left to InitDeferredHardware().
  */
 void InitAllHardware( void );
 
+/*! Initialise what InitAllHardware() left until later: the serial port 
+ * and flash. Call it once the first screen is shown, and before using 
+ * either.
+ */
+void InitDeferredHardware( void );
+
 /*! Wait a specified number of microseconds.
  * 
  * \param [in] wait_microsecs The time (in microseconds) to delay.
@@ -282,9 +498,80 @@ void Wait_12_5_Nanosec( long int wait_nanosecs );
  * number of times to acheive the required wait
  */
 void WaitSec( long int wait_secs );
+
+/*! Start the free-running cycle counter read by ReadCycleCounter().
+ * Called by InitAllOther().
+ */
+void InitCycleCounter( void );
+
+/*! Read the free-running cycle counter.
+ *
+ * \return The number of core clock cycles since InitCycleCounter(),
+ * 		modulo 2^32. It wraps about every 53 s at 80 MHz, so take the
+ * 		difference of two readings (as unsigned long) to time an
+ * 		interval shorter than that.
+ */
+unsigned long ReadCycleCounter( void );
+
+/*! The core clock frequency, in Hz, for converting cycle counts to time.
+ * 16 MHz until PLL_Init() has run, then 80 MHz, or 16 MHz while the
+ * PLL is bypassed by SetCoreClock().
+ */
+unsigned long GetCoreClockHz( void );
+
+/*! Switch the core clock between the PLL (80 MHz) and the crystal
+ * (16 MHz), for clock_policy.c. The PLL is left running, so switching
+ * is immediate either way.
+ *
+ * \param [in] fast 1 for 80 MHz, 0 for 16 MHz.
+ *
+ * Waits for the LCD's current instruction and the UART's current byte
+ * to finish, then reprograms SysTick (so GetTickMillisec() still counts
+ * milliseconds) and the UART baud rate divisors. The waits (WaitMicrosec()
+ * etc.) always use the clock in force.
+ */
+void SetCoreClock( int fast );
+
+/*! Milliseconds since power-on, counted by the SysTick interrupt.
+ * 
+ * \return The count, modulo 2^32 (it wraps after 49 days), so compare 
+ * 		two readings by unsigned difference.
+ */
+unsigned long GetTickMillisec( void );
+
+/*! Microseconds since power-on, from the tick and the SysTick counter.
+ * Unlike a difference of ReadCycleCounter() values, this is right
+ * whatever clock changes happen in between.
+ *
+ * \return The count, modulo 2^32 (it wraps after 71 minutes).
+ */
+unsigned long GetTickMicrosec( void );
+
+/*! Put the core into deep sleep until a key is pressed.
+ * 
+ * Every keypad column is made high and the rows are armed to interrupt 
+ * on a rising edge, which is what wakes the core. In deep sleep the core, 
+ * SysTick and every peripheral but the keypad ports are stopped, the 
+ * clock comes from the 30 kHz internal oscillator and the flash and SRAM 
+ * are in their low power modes, so the RAM (and with it the whole 
+ * program state) is kept. No flash write may be in progress; anything 
+ * the UART is still sending waits until the core wakes.
+ * 
+ * Returns, with the clock, the tick and the keypad columns as they were, 
+ * once the core has woken. Returns at once if a key is already down. 
+ * The tick does not count the time asleep.
+ */
+void SleepUntilKey( void );
+
+/*! Find the stack (the STACK area of startup.s), e.g. to paint it.
+ *
+ * \param [out] bottom Its lowest address.
+ * \param [out] top One past its highest address: the stack pointer at reset.
+ */
+void GetStackLimits( unsigned char **bottom, unsigned char **top );
 // ========== EXTRA FUNCTIONS (NOT written by myself) ==========  //
 
-/*! Initialise SysTick
+/*! Initialise SysTick as a 1 ms periodic interrupt (see GetTickMillisec())
 */
 void SysTick_Init(void);
 
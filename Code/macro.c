@@ -0,0 +1,233 @@
+/* macro.c
+ *
+ * Keystroke macros: recording, replay and keeping them in flash.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "macro.h"
+#include "low_level_funcs_tiva.h"
+#include "radix.h"
+#include "result_cache.h" // For the NUMBER_MODE_ constants
+#include <string.h>
+
+static char macros[MACRO_COUNT][MACRO_SIZE]; // The macros, "" for an empty slot: MacroSave() writes all of them to flash
+static char recording[MACRO_SIZE];           // The macro being recorded
+static int recording_active = 0;             // 1 while recording (boolean)
+static int parameters[MACRO_MAX_PARAMETERS]; // Where the parameters marked in the entry being typed start
+static int parameter_count = 0;              // How many there are
+static const char *replay_next = 0;          // Next character of the macro being replayed, or 0 if none
+static int replay_waiting = 0;               // 1 while the replay waits for a parameter (boolean)
+
+static int IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+} // IsDigit
+
+// Index just past the number starting at entry[i], or i if none starts there.
+// In decimal mode: digits [. digits] [E [+|-] digits], as expression.c reads
+// it; in integer mode, digits; in hex, octal and binary, digits of the base
+// (so in hex, E is a digit, and 1E+5 is 1E plus 5)
+static int SkipNumber(const char *entry, int i, int number_mode)
+{
+    if (RadixDigitBits(number_mode) != 0)
+    {
+        while (RadixIsDigit(entry[i], number_mode))
+        {
+            i++;
+        }
+        return i;
+    }
+    if (number_mode == NUMBER_MODE_INTEGER)
+    {
+        while (IsDigit(entry[i]))
+        {
+            i++;
+        }
+        return i;
+    }
+    while (IsDigit(entry[i]) || entry[i] == '.')
+    {
+        i++;
+    }
+    if (entry[i] == 'E')
+    {
+        i++;
+        if (entry[i] == '+' || entry[i] == '-')
+        {
+            i++;
+        }
+        while (IsDigit(entry[i]))
+        {
+            i++;
+        }
+    }
+    return i;
+} // SkipNumber
+
+// 1 if a parameter was marked where entry[i] is
+static int IsParameter(int i)
+{
+    int p;
+
+    for (p = 0; p < parameter_count; p++)
+    {
+        if (parameters[p] == i)
+        {
+            return 1;
+        }
+    }
+    return 0;
+} // IsParameter
+
+void MacroLoad(void)
+{
+    if (!ReadMacrosFromFlash(macros, sizeof(macros)))
+    {
+        memset(macros, 0, sizeof(macros)); // None saved yet (or by a version with another MACRO_SIZE)
+    }
+} // MacroLoad
+
+void MacroStartRecording(void)
+{
+    recording[0] = '\0';
+    recording_active = 1;
+    parameter_count = 0;
+    MacroStopReplay();
+} // MacroStartRecording
+
+int MacroRecording(void)
+{
+    return recording_active;
+} // MacroRecording
+
+void MacroMarkParameter(int position)
+{
+    if (recording_active && parameter_count < MACRO_MAX_PARAMETERS && !IsParameter(position))
+    {
+        parameters[parameter_count++] = position;
+    }
+} // MacroMarkParameter
+
+void MacroRubout(int length)
+{
+    int p = 0;
+
+    while (p < parameter_count)
+    {
+        if (parameters[p] >= length) // Its number is gone
+        {
+            parameters[p] = parameters[--parameter_count];
+        }
+        else
+        {
+            p++;
+        }
+    }
+} // MacroRubout
+
+int MacroRecordEntry(const char *entry, int number_mode)
+{
+    int length = strlen(recording);
+    int i = 0;
+
+    if (!recording_active)
+    {
+        return 1;
+    }
+    while (entry[i] != '\0')
+    {
+        if (length + 2 >= MACRO_SIZE) // No room for this, the end of the entry and the null
+        {
+            recording_active = 0;
+            parameter_count = 0;
+            return 0;
+        }
+        if (IsParameter(i) && SkipNumber(entry, i, number_mode) > i)
+        {
+            recording[length++] = MACRO_PARAMETER; // In place of the number typed
+            i = SkipNumber(entry, i, number_mode);
+        }
+        else
+        {
+            recording[length++] = entry[i++];
+        }
+    }
+    recording[length++] = MACRO_END_ENTRY;
+    recording[length] = '\0';
+    parameter_count = 0; // The next entry has its own
+    return 1;
+} // MacroRecordEntry
+
+int MacroSave(int slot)
+{
+    if (!recording_active || slot < 1 || slot > MACRO_COUNT)
+    {
+        return 0;
+    }
+    recording_active = 0;
+    if (recording[0] == '\0')
+    {
+        return 0; // No entry was ended
+    }
+    strcpy(macros[slot - 1], recording);
+    WriteMacrosToFlash(macros, sizeof(macros)); // All of them: the flash block is written as one record
+    return 1;
+} // MacroSave
+
+void MacroCancelRecording(void)
+{
+    recording_active = 0;
+    parameter_count = 0;
+} // MacroCancelRecording
+
+int MacroStartReplay(int slot)
+{
+    if (slot < 1 || slot > MACRO_COUNT || macros[slot - 1][0] == '\0')
+    {
+        return 0;
+    }
+    replay_next = macros[slot - 1];
+    replay_waiting = 0;
+    return 1;
+} // MacroStartReplay
+
+int MacroReplaying(void)
+{
+    return replay_waiting;
+} // MacroReplaying
+
+int MacroReplay(char *input_buffer, int input_buffer_size)
+{
+    int length = strlen(input_buffer);
+    char c;
+
+    replay_waiting = 0;
+    while (replay_next != 0 && *replay_next != '\0')
+    {
+        c = *replay_next++;
+        if (c == MACRO_END_ENTRY)
+        {
+            return MACRO_ENTRY;
+        }
+        if (c == MACRO_PARAMETER)
+        {
+            replay_waiting = 1;
+            return MACRO_PARAMETER_NEEDED;
+        }
+        if (length + 1 >= input_buffer_size)
+        {
+            break; // The entry no longer fits (the numbers typed were longer): stop
+        }
+        input_buffer[length++] = c;
+        input_buffer[length] = '\0';
+    }
+    replay_next = 0;
+    return MACRO_DONE;
+} // MacroReplay
+
+void MacroStopReplay(void)
+{
+    replay_next = 0;
+    replay_waiting = 0;
+} // MacroStopReplay
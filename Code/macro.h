@@ -0,0 +1,133 @@
+/*! \file macro.h
+ *
+ * Keystroke macros: a sequence of entries, recorded once and replayed
+ * with a key, for conversions and other calculations done again and
+ * again (e.g. inches to centimetres to metres).
+ *
+ * Shift twice (D D) gives a second layer of shifted keys, shown on
+ * line 2:
+ * 	- * starts recording. Each entry is then recorded as it is ended
+ * 		with *, after any Rubouts, and calculated as usual.
+ * 	- While recording, A makes the next number typed a parameter: it
+ * 		is used this time, but on replay the user is asked for it.
+ * 		1 to 9 saves the macro in that slot (its name), and # drops
+ * 		it.
+ * 	- Otherwise 1 to 9 replays the macro in that slot.
+ *
+ * A macro is kept as text: the entries, each ended by \a MACRO_END_ENTRY,
+ * with \a MACRO_PARAMETER in place of each parameter, e.g. "?x2.54=/100="
+ * for inches to metres. Replay puts each entry in the input buffer and
+ * has it calculated directly, without going through the keypad scanning
+ * and debouncing, so a macro of ten entries takes no longer than
+ * calculating them. It carries on from whatever has been typed, so
+ * "12" then the macro gives "12x2.54" as its first entry. At a parameter
+ * it stops, with what there is of the entry on line 1, for the user to
+ * type the number and press *; an error stops it.
+ *
+ * Macros are kept in flash (see WriteMacrosToFlash()), so they stay
+ * when the power is off. They are replayed in whatever number mode is
+ * in use.
+ */
+
+#ifndef MACRO_H
+#define MACRO_H
+
+/*! Number of macros: one for each of the keys 1 to 9. */
+#define MACRO_COUNT 9
+
+/*! Longest macro, in characters, including the trailing null. All of
+ * them must fit in MACRO_FLASH_MAX_SIZE (see low_level_funcs_tiva.h). */
+#define MACRO_SIZE 56
+
+/*! Most parameters in one entry. */
+#define MACRO_MAX_PARAMETERS 4
+
+//! \name Characters in a macro besides those of the entries
+//@{
+#define MACRO_END_ENTRY '=' //!< End Input (*): calculate the entry
+#define MACRO_PARAMETER '?' //!< A number which the user types on replay
+//@}
+
+//! \name Values returned by MacroReplay()
+//@{
+#define MACRO_DONE 0             //!< The macro has finished (or stopped)
+#define MACRO_ENTRY 1            //!< An entry is ready in the input buffer: calculate it
+#define MACRO_PARAMETER_NEEDED 2 //!< The user must type a number, then *; call MacroReplay() again after
+//@}
+
+/*! Read the macros from flash. Call once at start-up.
+ */
+void MacroLoad( void );
+
+/*! Start recording a new macro. Any replay is stopped.
+ */
+void MacroStartRecording( void );
+
+/*! \return 1 while a macro is being recorded, else 0.
+ */
+int MacroRecording( void );
+
+/*! Make the number which starts at \a position of the entry being typed
+ * a parameter.
+ *
+ * \param [in] position Index in the input buffer where it will start,
+ * 		i.e. the number of characters typed so far.
+ */
+void MacroMarkParameter( int position );
+
+/*! The entry being typed has been cut back (by Rubout): forget any
+ * parameters marked beyond its new end.
+ *
+ * \param [in] length The number of characters left.
+ */
+void MacroRubout( int length );
+
+/*! Add an entry just ended with * to the macro being recorded.
+ *
+ * \param [in] entry The entry, a C-format string.
+ * \param [in] number_mode The number mode it was typed in (one of the
+ * 		NUMBER_MODE_ constants in result_cache.h), which says what a
+ * 		parameter's number is: e.g. in hex mode FF is one, and in
+ * 		1E+5 only 1E.
+ * \return 1 if it fitted, else 0: the recording is then dropped.
+ */
+int MacroRecordEntry( const char *entry, int number_mode );
+
+/*! Stop recording, and keep the macro.
+ *
+ * \param [in] slot Where to keep it, from 1 to \a MACRO_COUNT.
+ * \return 1 if it was kept (and is being written to flash), 0 if
+ * 		nothing was recorded.
+ */
+int MacroSave( int slot );
+
+/*! Stop recording, and drop the macro.
+ */
+void MacroCancelRecording( void );
+
+/*! Start replaying a macro. Then call MacroReplay().
+ *
+ * \param [in] slot Which, from 1 to \a MACRO_COUNT.
+ * \return 1 if there is a macro there, else 0.
+ */
+int MacroStartReplay( int slot );
+
+/*! \return 1 while a replay is waiting for a parameter, else 0.
+ */
+int MacroReplaying( void );
+
+/*! Carry on replaying: add the macro's next characters to the input
+ * buffer, after what is there already.
+ *
+ * \param [in,out] input_buffer The input buffer, a C-format string.
+ * \param [in] input_buffer_size Its size. If the entry does not fit, the
+ * 		replay stops, leaving what did fit.
+ * \return One of the MACRO_ values above.
+ */
+int MacroReplay( char *input_buffer, int input_buffer_size );
+
+/*! Stop replaying, e.g. after an error.
+ */
+void MacroStopReplay( void );
+
+#endif // of #ifndef MACRO_H
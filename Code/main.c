@@ -49,10 +49,28 @@
  */
 #define INPUT_BUFFER_SIZE	17
 #define PASSWORD "1234" // Variable to hold the value of the password (not using flash)
+#define FAST_BOOT 1     // 1: go straight to the password prompt at power-on;
+                        // 0: show the welcome animation first (a key skips it)
 
 #include "high_level_funcs.h"
+#include "mid_level_funcs.h"
 #include "low_level_funcs_tiva.h"
 #include "calculate_answer.h"
+#include "expression.h"
+#include "result_cache.h"
+#include "rpn.h"
+#include "bignum.h"
+#include "scheduler.h"
+#include "lcd_mirror.h"
+#include "boot_trace.h"
+#include "mem_guard.h"
+#include "event_trace.h"
+#include "clock_policy.h"
+#include "power_down.h"
+#include "macro.h"
+#include "radix.h"
+#include "stats.h"
+#include "calculator.h"
 
 /*! The entry point when the program is run.
  * 
@@ -102,48 +120,311 @@
  * Improved commenting
 */
 
+/* CHANGES from 4.0:
+ * UART.c, serial_calc.c, lcd_mirror.c
+ * - Interrupt-driven serial port, serial batch mode (Shift 0) and
+ * - 		serial mirror of the display (Shift 9)
+ * scheduler.c
+ * - The program is event-driven: nothing waits. main() hands over to
+ * - 		RunScheduler(), which scans the keys, updates the display and
+ * - 		writes flash in the background and passes each event to
+ * - 		HandleEvent() below
+ * high_level_funcs.c
+ * - Each screen is a state machine, with timers instead of waits
+ * - Error messages, DISPLAY FULL and the password messages are
+ * - 		overlays, which the next key press dismisses (and is still
+ * - 		used as input); a key press skips the welcome animation
+ * boot_trace.c
+ * - Fast boot (FAST_BOOT): the keypad is read within a millisecond of
+ * - 		reset and the password prompt appears as soon as the LCD has
+ * - 		started (about 25 ms). The serial port and flash are
+ * - 		initialised after that, and the times of each stage are sent
+ * - 		over the serial port
+ * expression.c
+ * - ANS (Shift 4) is the previous answer at full precision, and an 
+ * - 		entry starting with an operator continues from it. = on its 
+ * - 		own repeats the last operation (constant mode)
+ * result_cache.c
+ * - Results of recent entries are cached, so an entry typed again 
+ * - 		is not evaluated again
+ * rpn.c
+ * - RPN entry mode with an X/Y/Z/T stack (Shift 8)
+ * bignum.c
+ * - Exact integer mode (Shift 7), with factorial and remainder, for 
+ * - 		results of any length; long ones scroll along line 2
+ * mem_guard.c
+ * - The stack is painted at power-on, so the most of it ever used 
+ * - 		can be found, and in debug builds (MEM_GUARD) canaries after 
+ * - 		the buffers catch overflows. Both are reported by ?M in 
+ * - 		serial mode
+ * high_level_funcs.c
+ * - DisplayResult() and ClearInputBuffer() no longer write past the 
+ * - 		end of their buffers
+ * mid_level_funcs.c
+ * - Each key has its own integrating debouncer (8 ms), in place of 
+ * - 		the 200 ms hold-off, so keys can be typed as fast as wanted; 
+ * - 		Rubout held down repeats, faster and faster
+ * gpio_pins.h
+ * - The LCD and keypad signals are each changed by one store to a 
+ * - 		masked data address, so nothing else on their ports (such 
+ * - 		as the serial port on PA0 and PA1) is disturbed
+ * event_trace.c
+ * - The last 256 key scans, keys, LCD instructions, calculations and 
+ * - 		flash writes are recorded with their times, and sent over 
+ * - 		the serial port by ?T (decoded by host/trace_decode.c)
+ * clock_policy.c
+ * - The core runs at 16 MHz while waiting for keys and at 80 MHz 
+ * - 		for each event and the drawing after it; the tick, waits, 
+ * - 		baud rate and trace follow the clock. ?C reports the time 
+ * - 		and estimated energy at each speed
+ * expression.c
+ * - Reentrant (no compiler state in statics), so host/calc_lib.c can 
+ * - 		evaluate entries on many threads; host/calc_batch.c checks 
+ * - 		files of entries in bulk, in input order
+ * host/expr_batch.c
+ * - One compiled entry evaluated for many values of ANS at once, with 
+ * - 		SSE2/AVX2 kernels, bit-identical to ExprEvaluate()
+ * host/fuzz_calc.c
+ * - Fuzzing harness (libFuzzer, AddressSanitizer, UBSan) for key 
+ * - 		sequences and entries, run through the real input, display 
+ * - 		and evaluation code; its corpus (host/corpus) is also a 
+ * - 		timing benchmark with a baseline check
+ * high_level_funcs.c
+ * - A constant (Shift 1-3) inserted after 9 characters no longer 
+ * - 		writes its trailing null past the end of the input buffer
+ * host/accuracy_oracle.c
+ * - Results and the digits DisplayResult() shows are checked against 
+ * - 		113-bit reference arithmetic, over random and adversarial 
+ * - 		entries, with ULP histograms, timings and an accuracy budget 
+ * - 		for trying faster (e.g. single-precision) arithmetic
+ * power_down.c
+ * - Left alone for a minute, the calculator saves its session (input, 
+ * - 		cursor, mode, Shift, answer, screen) to flash, turns the LCD 
+ * - 		off and goes into deep sleep. A key brings the same screen 
+ * - 		back at once, without the welcome screen or the password 
+ * - 		(see POWER_RELOCK); after a power cut the session is 
+ * - 		resumed from flash
+ * grammar.c
+ * - Each key is checked against the grammar as it is typed: a key 
+ * - 		which cannot come next (e.g. a second point, or * after 
+ * - 		an operator or a bare E) is refused at once, with a hint 
+ * - 		on line 2, instead of a syntax error after *
+ * expression.c
+ * - Whole-number entries are evaluated in 64-bit integers, and their 
+ * - 		results printed without printf, falling back to doubles 
+ * - 		on a fraction, a remainder or a value over 2^53; results 
+ * - 		are bit-identical (host/whole_bench.c times both paths)
+ * macro.c
+ * - Keystroke macros: Shift twice then * records the entries typed, 
+ * - 		with parameters (Shift twice then A) for numbers typed on 
+ * - 		replay, into one of 9 slots kept in flash; Shift twice then 
+ * - 		1-9 replays one, calculating its entries directly
+ * radix.c
+ * - Hex, octal and binary modes (Shift 7 after integer mode), in 
+ * - 		64-bit two's complement, with & | ^ ~ and shifts (Shift C) 
+ * - 		and the digits A-F (Shift 1-6). Conversion is by table, 
+ * - 		without doubles or printf; = on its own shows the last 
+ * - 		result in the base now in use, and long binary results 
+ * - 		scroll
+ * stats.c
+ * - Statistics mode (Shift 6 in decimal mode): each * adds a point 
+ * - 		x or x,y to streaming accumulators (Welford, Kahan) kept 
+ * - 		in flash, giving the mean, standard deviation, least, 
+ * - 		greatest, sum and the regression line of the pairs
+ * calculator.c
+ * - Entries, macro replay, and RPN and statistics modes moved here from 
+ * - 		main.c, so that host/fuzz_calc.c runs the same code as the 
+ * - 		calculator instead of a copy
+*/
+
 // =================================================== //
 
-int main()
+static char	input_buffer [GUARDED_SIZE(INPUT_BUFFER_SIZE)];
+static int	app_state = APP_WELCOME;	/* APP_INPUT while the 
+					 * calculator has the events 
+					 * (CalculatorState() says which of 
+					 * its states it is in). */
+static int	boot_complete = 0;	/* 1 once the first screen has been 
+					 * shown and the rest initialised. */
+static PowerSession	session;	/* Saved at power-down (see 
+					 * power_down.h). */
+static int	resume_pending = 0;	/* 1 while the password must be 
+					 * entered before the session is 
+					 * resumed. */
+static int	flash_loaded = 0;	/* 1 once the answer, macros and 
+					 * statistics have been read from 
+					 * flash (see LoadFlashState()). */
+
+/* Save everything needed to carry on where the user left off, and let 
+ * the calculator power down (see power_down.h). */
+static void SaveSession(void)
+{
+	session.version = POWER_SESSION_VERSION;
+	CalculatorSaveState( &session );
+	if (app_state != APP_INPUT)	/* The welcome screen or the 
+					 * password. */
+		session.app_state = app_state;
+	GetScreenState( &session.screen );
+	PowerDownSave( &session );
+} // SaveSession
+
+/* Carry on from the saved session, with the screen exactly as it was. */
+static void ResumeSession(void)
 {
-	double	answer = 0.0;	/* Initialise in case 
-				 * ReadFloatFromFlash() does nothing. */
+	resume_pending = 0;
+	if (!CalculatorResume( &session )) {
+		/* The welcome screen or the password: ask for the 
+		 * password afresh. */
+		StartCheckPassword( PASSWORD );
+		app_state = APP_PASSWORD;
+		return;
+	}
+	SetScreenState( &session.screen );
+	app_state = APP_INPUT;
+} // ResumeSession
 
+/* Start the serial port and flash, and read the answer, the macros and 
+ * the statistics from flash. This is put off until the first screen is 
+ * up, unless a session is resumed at power-on: that must start from 
+ * what is in flash, and then set the answer and the screen itself. */
+static void LoadFlashState(void)
+{
+	if (flash_loaded)
+		return;
+	InitDeferredHardware();	// In low_level_funcs_tiva.
+	CalculatorSetAnswer( ReadDoubleFromFlash() ); // See note at top.
+	MacroLoad();
+	StatsLoad();
+	BootTraceMark( "answer read" );
+	flash_loaded = 1;
+} // LoadFlashState
+
+/* Resume the session, after the password if relock is 1. */
+static void StartResume(int relock)
+{
+	if (!relock) {
+		ResumeSession();
+		return;
+	}
+	StopTimer( TIMER_SCREEN );	// E.g. a long result scrolling
+	DismissOverlay();
+	StartCheckPassword( PASSWORD );
+	app_state = APP_PASSWORD;
+	resume_pending = 1;
+} // StartResume
+
+/* The program's event handler: passes each event to the state machine 
+ * for whatever is on the screen, and moves on when that finishes. */
+static void HandleEvent(const Event *event)
+{
+	ClockPolicyWake();	/* Full speed for the event and whatever 
+				 * drawing follows it. */
+	if (!boot_complete && event->type == EVENT_LCD_FLUSH) {
+		/* The first screen is up, so the user can see the calculator 
+		 * is ready. Now do what was put off to get there sooner. */
+		BootTraceMark( "first screen" );
+		LoadFlashState();	/* Done already if a session was 
+					 * resumed. */
+		BootTraceDump();
+		boot_complete = 1;
+		ClockPolicyRelease();
+	}
+
+	switch (event->type) {
+	case EVENT_KEY:
+	case EVENT_UART_LINE:
+		PowerDownActivity();	// Not idle: start the time again
+		break;
+	case EVENT_POWER_DOWN:
+		SaveSession();
+		return;
+	case EVENT_POWER_WAKE:
+		/* The screen is back already. The key which woke the 
+		 * calculator comes next, and is used as usual. */
+		if (POWER_RELOCK == POWER_RELOCK_ALWAYS && 
+		    app_state == APP_INPUT)
+			StartResume( 1 );
+		return;
+	}
+
+	if (OverlayEvent( event ))	/* Error messages, hints etc. 
+					 * see it first. */
+		return;
+
+	switch (app_state) {
+	case APP_WELCOME:
+		if (WelcomeScreenEvent( event )) {
+			DisplayResult( CalculatorGetAnswer() ); /* In 
+							 * high_level_funcs. */
+			StartCheckPassword( PASSWORD );
+			app_state = APP_PASSWORD;
+			if (event->type == EVENT_KEY) /* The key which skipped 
+						       * the welcome screen. */
+				CheckPasswordEvent( event );
+		}
+		break;
+	case APP_PASSWORD:
+		if (CheckPasswordEvent( event )) {
+			if (resume_pending)
+				ResumeSession();	/* Where the user 
+							 * left off. */
+			else {
+				StartCalculator();
+				app_state = APP_INPUT;
+			}
+		}
+		break;
+	case APP_INPUT:	/* Entries, RPN mode and statistics mode: see 
+			 * calculator.h. */
+		CalculatorEvent( event );
+		break;
+	}
+} // HandleEvent
+
+int main()
+{
+	StackPaint();	/* First, so that all the stack used from 
+			 * now on is measured. */
 	InitAllHardware();	// In low_level_funcs_tiva.
-	WelcomeScreen();
-	
-	answer = ReadDoubleFromFlash(); // See note at top.
-	DisplayResult( answer ); // In high_level_funcs.
-	char	password_buffer [5];
-	//TurnCursorOnOff(0); // Turn cursor off
-        //ClearDisplay();
-	//PrintString(1, 1, "Enter Password:");
-	//WaitSec(4);
-
-	CheckPassword(PASSWORD,password_buffer);
-	
-	
-	while (1) {
-	char	input_buffer [INPUT_BUFFER_SIZE];
-	int	error_ref_no = 0;	/* Init in case just = is emtered 
-					 * as the first entry. */
-		
-		ReadAndEchoInput( input_buffer, INPUT_BUFFER_SIZE ); /* In
-							high_level_funcs. */
-		/* If the user typed equals immediately (indicated by an empty 
-		 * buffer), we leave the previous answer to be displayed. 
-		 * Otherwise we calculate it. */
-		if (input_buffer[0] != '\0')
-			answer = CalculateAnswer( input_buffer, 
-				INPUT_BUFFER_SIZE,  &error_ref_no ); /* In 
-							calculate_answer. */
-		if (error_ref_no == 0) { // meaning no error.
-			DisplayResult( answer ); // In high_level_funcs.
-			WriteDoubleToFlash( answer ); // See note at top.
-		} else	DisplayErrorMessage( error_message_line1[error_ref_no], 
-				error_message_line2[error_ref_no] ); /* In
-						high_level_funcs. */
-	} // while
+	InitScheduler();
+	TraceRecord( TRACE_START, 0 );	// The tick is running now
+	ClockPolicyHold();	/* Full speed until started; released in 
+				 * HandleEvent(). */
+	MemGuardRegister( input_buffer, INPUT_BUFFER_SIZE, "input_buffer" );
+	CalculatorInit( input_buffer, INPUT_BUFFER_SIZE );
+
+	AddBackgroundTask( KeyboardTask );	// Posts EVENT_KEY
+	AddBackgroundTask( DisplayInitTask );	// Finishes starting the LCD
+	AddBackgroundTask( DisplayFlushTask );	// Posts EVENT_LCD_FLUSH
+	AddBackgroundTask( FlashTask );		// Writes answers to flash
+	AddBackgroundTask( SerialModeTask );	// Posts EVENT_UART_LINE
+	AddBackgroundTask( LcdMirrorPoll );
+	AddBackgroundTask( BootTraceTask );
+	AddBackgroundTask( MemGuardTask );	// Checks the canaries
+	AddBackgroundTask( TraceTask );		// Sends the event trace (?T)
+	AddBackgroundTask( ClockPolicyTask );	// Slows the clock when idle
+	AddBackgroundTask( PowerDownTask );	// Sleeps when left alone
+
+	/* The first screen is drawn into the frame now, and appears as 
+	 * soon as the LCD is ready. Keys are read from the first pass 
+	 * of the scheduler. */
+	if (PowerDownFindSession( &session )) {
+		/* Power was lost while powered down: carry on from 
+		 * there. The saved state in flash is read first, so 
+		 * that it does not overwrite the session's answer, 
+		 * and the statistics are there to be shown. */
+		LoadFlashState();
+		StartResume( POWER_RELOCK != POWER_RELOCK_NEVER );
+	} else {
+#if FAST_BOOT
+		StartCheckPassword( PASSWORD );
+		app_state = APP_PASSWORD;
+#else
+		StartWelcomeScreen();
+#endif
+	}
+	BootTraceMark( "keypad ready" );
+	RunScheduler( HandleEvent );	// Never returns
 		
 	/* Normally you would have a return 0; command here.
 	 * Like most embedded processor programs, this one never exits 
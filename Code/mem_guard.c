@@ -0,0 +1,184 @@
+/* mem_guard.c
+ *
+ * Stack painting and buffer canaries.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "TExaS.h"
+#include "mem_guard.h"
+#include "low_level_funcs_tiva.h"
+#include "UART.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#define STACK_PAINT_BYTE 0xA5 // Unlikely to be a return address, a small integer or a character
+
+static unsigned char *stack_bottom; // Lowest address of the stack (0 until StackPaint())
+static unsigned char *stack_top;    // One past the highest
+
+#if MEM_GUARD
+static const unsigned char canary[MEM_GUARD_BYTES] = {0xDE, 0xAD, 0xBE, 0xEF}; // Not text, and not a null
+
+typedef struct
+{
+    unsigned char *end; // First canary byte, just past the buffer
+    const char *name;
+    int damaged;        // 1 once found damaged
+    int reported;       // 1 once reported over the serial port
+} GuardedBuffer;
+
+static GuardedBuffer guarded[MEM_GUARD_MAX_BUFFERS];
+static int guarded_count = 0;
+static unsigned long last_check_millisec = 0;
+#endif
+
+void StackPaint(void)
+{
+    unsigned char here; // Its address is (about) the stack pointer
+    uintptr_t limit;    // As a number: a pointer may not point outside here
+    unsigned char *p;
+
+    GetStackLimits(&stack_bottom, &stack_top);
+    limit = (uintptr_t)&here - STACK_PAINT_MARGIN;
+    for (p = stack_bottom; (uintptr_t)p < limit; p++)
+    {
+        *p = STACK_PAINT_BYTE;
+    }
+} // StackPaint
+
+unsigned long StackSizeBytes(void)
+{
+    return stack_top - stack_bottom;
+} // StackSizeBytes
+
+unsigned long StackHighWaterBytes(void)
+{
+    unsigned char *p = stack_bottom;
+
+    if (p == 0)
+    {
+        return 0; // Not painted
+    }
+    while (p < stack_top && *p == STACK_PAINT_BYTE)
+    {
+        p++;
+    }
+    return stack_top - p;
+} // StackHighWaterBytes
+
+#if MEM_GUARD
+void MemGuardRegister(void *buffer, int size, const char *name)
+{
+    unsigned char *end = (unsigned char *)buffer + size;
+    int index;
+    int i;
+
+    for (index = 0; index < guarded_count && guarded[index].end != end; index++)
+    {
+    }
+    if (index == guarded_count)
+    {
+        if (guarded_count >= MEM_GUARD_MAX_BUFFERS)
+        {
+            return;
+        }
+        guarded_count++;
+    }
+    guarded[index].end = end;
+    guarded[index].name = name;
+    guarded[index].damaged = 0;
+    guarded[index].reported = 0;
+    for (i = 0; i < MEM_GUARD_BYTES; i++)
+    {
+        end[i] = canary[i];
+    }
+} // MemGuardRegister
+#endif
+
+int MemGuardCheck(void)
+{
+    int count = 0;
+#if MEM_GUARD
+    int index;
+    int i;
+
+    for (index = 0; index < guarded_count; index++)
+    {
+        for (i = 0; i < MEM_GUARD_BYTES; i++)
+        {
+            if (guarded[index].end[i] != canary[i])
+            {
+                guarded[index].damaged = 1; // Stays damaged: the overflow may have done other harm
+            }
+        }
+        count += guarded[index].damaged;
+    }
+#endif
+    return count;
+} // MemGuardCheck
+
+const char *MemGuardFirstDamaged(void)
+{
+#if MEM_GUARD
+    int index;
+
+    for (index = 0; index < guarded_count; index++)
+    {
+        if (guarded[index].damaged)
+        {
+            return guarded[index].name;
+        }
+    }
+#endif
+    return 0;
+} // MemGuardFirstDamaged
+
+void MemGuardTask(void)
+{
+#if MEM_GUARD
+    char line[40];
+    int index;
+
+    if (GetTickMillisec() - last_check_millisec < MEM_GUARD_INTERVAL_MILLISEC)
+    {
+        return;
+    }
+    last_check_millisec = GetTickMillisec();
+    MemGuardCheck();
+    for (index = 0; index < guarded_count; index++)
+    {
+        if (guarded[index].damaged && !guarded[index].reported)
+        {
+            snprintf(line, sizeof(line), "GUARD %s\r\n", guarded[index].name);
+            if (UART_WriteString(line)) // All or nothing: try again next time if there is no room
+            {
+                guarded[index].reported = 1;
+            }
+        }
+    }
+#endif
+} // MemGuardTask
+
+void MemGuardReport(char *text, int text_size)
+{
+    int damaged = MemGuardCheck();
+    int registered = 0;
+    int length;
+
+#if MEM_GUARD
+    registered = guarded_count;
+#endif
+    length = snprintf(text, text_size, "MEM stack %lu/%lu guard ", StackHighWaterBytes(), StackSizeBytes());
+    if (length >= 0 && length < text_size)
+    {
+        if (damaged == 0)
+        {
+            snprintf(text + length, text_size - length, "%d ok", registered);
+        }
+        else
+        {
+            snprintf(text + length, text_size - length, "%d/%d %s", damaged, registered, MemGuardFirstDamaged());
+        }
+    }
+} // MemGuardReport
@@ -0,0 +1,112 @@
+/*! \file mem_guard.h
+ *
+ * Checks on the use of RAM: how much of the stack has ever been used,
+ * and whether anything has been written past the end of a buffer.
+ *
+ * The stack is only as big as startup.s makes it (the \a Stack constant),
+ * and nothing stops it growing down into the static variables below it.
+ * StackPaint(), called first thing in main(), fills the unused part of
+ * the stack with a pattern; StackHighWaterBytes() finds how much of the
+ * pattern has since been overwritten, i.e. the deepest the stack has been.
+ *
+ * In debug builds (\a MEM_GUARD 1) each registered buffer is followed by
+ * \a MEM_GUARD_BYTES canary bytes, which MemGuardTask() checks once a
+ * second. A damaged canary is reported once over the serial port:
+ *
+ * 	GUARD input_buffer
+ *
+ * Declare a guarded buffer with GUARDED_SIZE(), e.g.
+ * 	static char line[GUARDED_SIZE(LINE_SIZE)];
+ * and register it with MemGuardRegister(line, LINE_SIZE, "line").
+ * With \a MEM_GUARD 0 both compile to nothing extra.
+ *
+ * The report (MemGuardReport()) is the reply to "?M" in serial batch
+ * mode. How much static RAM each module uses is in the linker's map
+ * file; host/ram_report.c totals it per module.
+ */
+
+#ifndef MEM_GUARD_H
+#define MEM_GUARD_H
+
+#ifndef MEM_GUARD
+#define MEM_GUARD 1 //!< 1 in debug builds: canaries after registered buffers; 0 in release builds
+#endif
+
+/*! Canary bytes after each guarded buffer. */
+#if MEM_GUARD
+#define MEM_GUARD_BYTES 4
+#else
+#define MEM_GUARD_BYTES 0
+#endif
+
+/*! Size to declare a guarded buffer of \a size bytes with. */
+#define GUARDED_SIZE(size) ((size) + MEM_GUARD_BYTES)
+
+/*! Maximum number of guarded buffers. Any more are not checked. */
+#define MEM_GUARD_MAX_BUFFERS 8
+
+/*! Milliseconds between checks of the canaries by MemGuardTask(). */
+#define MEM_GUARD_INTERVAL_MILLISEC 1000
+
+/*! Bytes left unpainted below StackPaint()'s own frame. */
+#define STACK_PAINT_MARGIN 64
+
+/*! Fill the unused part of the stack with a pattern. Call it first in
+ * main(), before the stack has been used much. The top
+ * \a STACK_PAINT_MARGIN bytes below its own frame are left alone.
+ */
+void StackPaint( void );
+
+/*! \return The size of the stack, in bytes.
+ */
+unsigned long StackSizeBytes( void );
+
+/*! \return The most of the stack ever used, in bytes: everything above
+ * 		the lowest byte of the pattern to have been overwritten.
+ * 		Scans the stack, so takes about a cycle per byte unused.
+ */
+unsigned long StackHighWaterBytes( void );
+
+/*! Write the canary after a buffer and check it from now on. Registering
+ * the same buffer again just rewrites its canary.
+ *
+ * \param [in] buffer The buffer, declared GUARDED_SIZE(\a size) long.
+ * \param [in] size Size of the buffer the program uses.
+ * \param [in] name Name for reports. It must be a string constant (only
+ * 		the pointer is kept).
+ */
+#if MEM_GUARD
+void MemGuardRegister( void *buffer, int size, const char *name );
+#else
+#define MemGuardRegister(buffer, size, name) ((void)0)
+#endif
+
+/*! Check every canary now.
+ *
+ * \return The number of guarded buffers whose canary has been damaged
+ * 		(always 0 with \a MEM_GUARD 0).
+ */
+int MemGuardCheck( void );
+
+/*! \return The name of the first buffer found damaged, or 0 if none.
+ */
+const char *MemGuardFirstDamaged( void );
+
+/*! Background task (see scheduler.h) which checks the canaries every
+ * \a MEM_GUARD_INTERVAL_MILLISEC and sends a line over the serial port
+ * for each buffer newly found damaged.
+ */
+void MemGuardTask( void );
+
+/*! Write a one-line report, e.g.
+ * 	MEM stack 412/512 guard 5 ok
+ * 	MEM stack 512/512 guard 1/5 input_buffer
+ * (stack bytes used/size; guarded buffers damaged/registered and the
+ * first damaged one).
+ *
+ * \param [out] text The report, without a line ending.
+ * \param [in] text_size Size of \a text, including the trailing null.
+ */
+void MemGuardReport( char *text, int text_size );
+
+#endif // of #ifndef MEM_GUARD_H
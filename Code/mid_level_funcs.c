@@ -11,6 +11,42 @@
 #include "TExaS.h"
 #include "mid_level_funcs.h"
 #include "low_level_funcs_tiva.h"
+#include "lcd_mirror.h"
+#include "scheduler.h"
+#include "event_trace.h"
+#include <string.h>
+
+#define KEY_SETTLE_MICROSEC 50 // Time from writing a column to reading the rows
+#define KEY_COUNT 16           // Keys on the keypad
+
+// Keypad scanning state for KeyboardTask()
+static int scan_col = 0;                // Column being scanned (counting from 0)
+static int scan_col_written = 0;        // 1 once that column has been made high
+static unsigned long scan_col_microsec;     // GetTickMicrosec() when it was made high
+static unsigned long col_sampled_microsec[4]; // GetTickMicrosec() when each column was last read
+static unsigned char col_rows[4];       // Rows read in each column last time (for the trace)
+
+// Debouncer and typematic repeat (see KeyboardTask()); keys are numbered (row - 1) * 4 + column - 1
+static unsigned short key_integrator[KEY_COUNT]; // Microseconds more pressed than released, 0 to KEY_DEBOUNCE_MILLISEC
+static unsigned char key_down[KEY_COUNT];        // 1 once the key has been reported pressed
+static int repeat_key = -1;                      // Key being repeated (-1 for none)
+static unsigned long repeat_due;                 // GetTickMillisec() when it repeats next
+static unsigned long repeat_interval;            // Milliseconds until the repeat after that
+
+// The frame: what the LCD should show (see mid_level_funcs.h)
+static char frame[2][DISPLAY_WIDTH] = {
+    {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '},
+    {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '}};
+static short int cursor_line = 1;       // Where the cursor should be left
+static short int cursor_pos = 1;
+static short int cursor_on = 0;         // 1 if the cursor should be shown
+static int flush_pending = 0;           // 1 while the LCD may not match the frame
+static unsigned long flushed_changes;   // GetDisplayChangeCount() when it last matched
+
+// The overlay (see mid_level_funcs.h)
+static int overlay_active = 0;                     // 1 while an overlay is shown
+static unsigned char overlay_covers[2][DISPLAY_WIDTH]; // 1 for each cell the overlay covers
+static char overlay_saved[2][DISPLAY_WIDTH];       // What the frame holds under the overlay
 
 // ------------------------ Keyboard functions ------------------------
 
@@ -70,6 +106,7 @@ void KeyboardReadRowCol(int *row, int *col)
             break;
         }
         WaitMillisec(1); // Short wait
+        LcdMirrorPoll(); // Nothing else to do while waiting: update the serial mirror if it is on
 
         if (i == 3)
         {
@@ -160,34 +197,361 @@ char KeyboardRowCol2Char(int row, int col)
     }
 } // KeyboardRowCol2Char
 
+int KeyboardKeyDown()
+{
+    WriteKeyboardCol(0x0F); // Make all columns high, so a key in any column will drive its row
+    WaitMicrosec(10);       // Short wait for the rows to settle
+
+    return (ReadKeyboardRow() & 0x0F) != 0; // Any row high means a key is down
+} // KeyboardKeyDown
+
+// Report a key as pressed (again), and trace it as \a trace_type. 0 if the event queue is full.
+static int PostKey(int key, unsigned char trace_type)
+{
+    char character = KeyboardRowCol2Char(key / 4 + 1, key % 4 + 1);
+
+    if (!PostEvent(EVENT_KEY, character))
+    {
+        return 0;
+    }
+    TraceRecord(trace_type, character);
+    return 1;
+} // PostKey
+
+void KeyboardTask()
+{
+    unsigned char columns[] = {0x01, 0x02, 0x04, 0x08}; // Array to hold the different valid columns
+    unsigned long microsec = GetTickMicrosec(); // Not cycles: the clock may have changed since (clock_policy.h)
+    unsigned long now = GetTickMillisec();
+    unsigned long elapsed; // Microseconds since this column was last read
+    unsigned char rows;
+    int row;
+    int key;
+
+    if (!scan_col_written)
+    {
+        WriteKeyboardCol(columns[scan_col]); // Make this column high...
+        scan_col_microsec = microsec;
+        scan_col_written = 1;
+        return; // ...and come back when the rows have settled
+    }
+    if (microsec - scan_col_microsec < KEY_SETTLE_MICROSEC)
+    {
+        return; // Not settled yet
+    }
+    scan_col_written = 0;
+    rows = ReadKeyboardRow() & 0x0F; // One bit per row: every key down in this column
+    elapsed = microsec - col_sampled_microsec[scan_col];
+    col_sampled_microsec[scan_col] = microsec;
+    if (rows != col_rows[scan_col]) // Changes only, bounces included, or the trace would fill in a moment
+    {
+        TraceRecord(TRACE_KEY_SCAN, (scan_col << 4) | rows);
+        col_rows[scan_col] = rows;
+    }
+    if (elapsed > KEY_SCAN_PERIOD_MICROSEC)
+    {
+        elapsed = KEY_SCAN_PERIOD_MICROSEC; // E.g. after a long pause in scanning: still one reading's worth
+    }
+
+    // Integrate each key in the column: the time it has been read as pressed counts
+    // up and the time read as released counts down, so a bounce only delays the
+    // change, however often it happens. The key changes state only at the ends.
+    for (row = 0; row < 4; row++)
+    {
+        key = row * 4 + scan_col;
+        if (rows & (1 << row))
+        {
+            key_integrator[key] = (key_integrator[key] + elapsed < KEY_DEBOUNCE_MILLISEC * 1000)
+                                      ? key_integrator[key] + elapsed
+                                      : KEY_DEBOUNCE_MILLISEC * 1000;
+            if (key_integrator[key] == KEY_DEBOUNCE_MILLISEC * 1000 && !key_down[key] && PostKey(key, TRACE_KEY))
+            {
+                key_down[key] = 1; // (If the queue was full, it is tried again next time)
+                repeat_key = (strchr(KEY_REPEAT_KEYS, KeyboardRowCol2Char(row + 1, scan_col + 1)) != NULL) ? key : -1;
+                repeat_due = now + KEY_REPEAT_DELAY_MILLISEC;
+                repeat_interval = KEY_REPEAT_START_MILLISEC;
+            }
+        }
+        else
+        {
+            key_integrator[key] = (key_integrator[key] > elapsed) ? key_integrator[key] - elapsed : 0;
+            if (key_integrator[key] == 0 && key_down[key])
+            {
+                key_down[key] = 0;
+                if (key == repeat_key)
+                {
+                    repeat_key = -1;
+                }
+            }
+        }
+    }
+
+    // Typematic repeat of the last key pressed, if it repeats and is still down:
+    // after a delay, then faster and faster
+    if (repeat_key >= 0 && (long)(now - repeat_due) >= 0 && PostKey(repeat_key, TRACE_KEY_REPEAT))
+    {
+        repeat_due = now + repeat_interval;
+        repeat_interval = (repeat_interval * 3 / 4 > KEY_REPEAT_MIN_MILLISEC) ? repeat_interval * 3 / 4
+                                                                              : KEY_REPEAT_MIN_MILLISEC;
+    }
+    scan_col = (scan_col + 1) & 3; // On to the next column
+} // KeyboardTask
+
 // ------------------------ Display functions ------------------------
 
 void PrintString(short int line, short int char_pos, const char *string)
 {
-    int length = strlen(string);      // Variable to store the length of the string
-    SetPrintPosition(line, char_pos); // function already rejects invalid line/char pos
+    int l = (line == 2) ? 1 : 0; // Any other line number means line 1, as SetPrintPosition()
 
-    if (length <= 16) // If string length can fit on screen
-                      // Prevents any string being printed beyond the screen
+    if (char_pos < 1) // Reject invalid character positions
     {
-        for (int i = 0; i < length; i++)
+        char_pos = 1;
+    }
+    // Only the characters which fit on the line are stored.
+    // Any beyond the end are ignored.
+    while (*string != '\0' && char_pos <= DISPLAY_WIDTH)
+    {
+        if (overlay_covers[l][char_pos - 1])
+        {
+            overlay_saved[l][char_pos - 1] = *string; // Hidden until the overlay goes
+        }
+        else
         {
-            PrintChar(string[i]);             // Print character in position
-            char_pos += 1;                    // Increment position to be written to
-            SetPrintPosition(line, char_pos); // Move cursor to next position
+            frame[l][char_pos - 1] = *string; // Put character in position
         }
+        string++;
+        char_pos++; // Increment position to be written to
     }
-    else
-    { // If string is longer than 16 chars, only print 16 chars
-        for (int i = 0; i < 16; i++)
+    SetCursorPosition(line, char_pos); // Leave the cursor after the string
+} // PrintString
+
+void ClearScreen()
+{
+    int l;
+    int i;
+
+    for (l = 0; l < 2; l++)
+    {
+        for (i = 0; i < DISPLAY_WIDTH; i++)
         {
-            PrintChar(string[i]);             // Print character in position
-            char_pos += 1;                    // Increment position to be written to
-            SetPrintPosition(line, char_pos); // Move cursor to next position
+            if (overlay_covers[l][i])
+            {
+                overlay_saved[l][i] = ' '; // Cleared underneath the overlay
+            }
+            else
+            {
+                frame[l][i] = ' '; // The LCD's own clear fills it with spaces
+            }
         }
     }
-}
-// PrintString
+    SetCursorPosition(1, 1); // and returns home
+} // ClearScreen
+
+void SetCursorPosition(short int line, short int char_pos)
+{
+    // Keep the cursor on the display, as SetPrintPosition() does
+    if (char_pos < 1)
+    {
+        char_pos = 1;
+    }
+    if (char_pos > DISPLAY_WIDTH)
+    {
+        char_pos = DISPLAY_WIDTH;
+    }
+    cursor_line = (line == 2) ? 2 : 1;
+    cursor_pos = char_pos;
+    flush_pending = 1;
+} // SetCursorPosition
+
+void SetCursorOnOff(short int on)
+{
+    cursor_on = (on != 0);
+    flush_pending = 1;
+} // SetCursorOnOff
+
+void DisplayFlushTask()
+{
+    const char *shown; // What the LCD shows on a line
+    short int line;    // Where the LCD will put the next character
+    short int pos;
+    short int show_cursor = cursor_on && !overlay_active;
+    int l;
+    int i;
+
+    if (!flush_pending && GetDisplayChangeCount() == flushed_changes)
+    {
+        return; // Nothing drawn, and nothing has changed the LCD behind our back
+    }
+    if (!DisplayReady() || DisplayBusy())
+    {
+        return; // Still starting up, or still executing the last byte
+    }
+
+    // 0) Hide the cursor first, so it is not seen moving about as cells change
+    if (!show_cursor && GetCursorOnOff())
+    {
+        TurnCursorOnOffNoWait(0);
+        return;
+    }
+
+    // 1) If the LCD is already at a cell which needs changing, just send it.
+    //    Characters in a row need no repositioning, as the LCD moves on itself.
+    GetDisplayShadowPosition(&line, &pos);
+    if (pos <= DISPLAY_WIDTH && GetDisplayShadow(line)[pos - 1] != frame[line - 1][pos - 1])
+    {
+        PrintCharNoWait(frame[line - 1][pos - 1]);
+        return;
+    }
+
+    // 2) Otherwise move to the first cell which differs
+    for (l = 1; l <= 2; l++)
+    {
+        shown = GetDisplayShadow(l);
+        for (i = 0; i < DISPLAY_WIDTH; i++)
+        {
+            if (shown[i] != frame[l - 1][i])
+            {
+                SetPrintPositionNoWait(l, i + 1);
+                return;
+            }
+        }
+    }
+
+    // 3) All the characters match: put the cursor where it should be,
+    //    and show it if it should be shown
+    if (line != cursor_line || pos != cursor_pos)
+    {
+        SetPrintPositionNoWait(cursor_line, cursor_pos);
+        return;
+    }
+    if (show_cursor && !GetCursorOnOff())
+    {
+        TurnCursorOnOffNoWait(1);
+        return;
+    }
+
+    // 4) Done
+    flushed_changes = GetDisplayChangeCount();
+    if (flush_pending)
+    {
+        flush_pending = 0;
+        PostEvent(EVENT_LCD_FLUSH, 0);
+    }
+} // DisplayFlushTask
+
+int DisplayFlushPending()
+{
+    return flush_pending;
+} // DisplayFlushPending
+
+void GetScreenState(ScreenState *state)
+{
+    int l;
+    int i;
+
+    for (l = 0; l < 2; l++)
+    {
+        for (i = 0; i < DISPLAY_WIDTH; i++)
+        {
+            state->text[l][i] = overlay_covers[l][i] ? overlay_saved[l][i] : frame[l][i]; // What is underneath
+        }
+    }
+    state->cursor_line = cursor_line;
+    state->cursor_pos = cursor_pos;
+    state->cursor_on = cursor_on;
+} // GetScreenState
+
+void SetScreenState(const ScreenState *state)
+{
+    DismissOverlay();
+    memcpy(frame, state->text, sizeof(frame));
+    SetCursorPosition(state->cursor_line, state->cursor_pos); // Checks them, and sets flush_pending
+    SetCursorOnOff(state->cursor_on);
+} // SetScreenState
+
+// ------------------------ Overlay functions ------------------------
+
+void OpenOverlay(unsigned long duration_ms)
+{
+    DismissOverlay(); // Only one at a time
+    overlay_active = 1;
+    StartTimer(TIMER_OVERLAY, duration_ms);
+    flush_pending = 1; // Hides the cursor
+} // OpenOverlay
+
+void OverlayString(short int line, short int char_pos, const char *string)
+{
+    int l = (line == 2) ? 1 : 0; // As PrintString()
+
+    if (!overlay_active)
+    {
+        return; // OpenOverlay() first
+    }
+    if (char_pos < 1)
+    {
+        char_pos = 1;
+    }
+    while (*string != '\0' && char_pos <= DISPLAY_WIDTH)
+    {
+        if (!overlay_covers[l][char_pos - 1])
+        {
+            overlay_saved[l][char_pos - 1] = frame[l][char_pos - 1]; // Save the cell the first time it is covered
+            overlay_covers[l][char_pos - 1] = 1;
+        }
+        frame[l][char_pos - 1] = *string;
+        string++;
+        char_pos++;
+    }
+    flush_pending = 1;
+} // OverlayString
+
+void DismissOverlay()
+{
+    int l;
+    int i;
+
+    if (!overlay_active)
+    {
+        return;
+    }
+    for (l = 0; l < 2; l++)
+    {
+        for (i = 0; i < DISPLAY_WIDTH; i++)
+        {
+            if (overlay_covers[l][i])
+            {
+                frame[l][i] = overlay_saved[l][i]; // Put back only the covered cells
+                overlay_covers[l][i] = 0;
+            }
+        }
+    }
+    overlay_active = 0;
+    StopTimer(TIMER_OVERLAY);
+    flush_pending = 1; // Also brings the cursor back
+} // DismissOverlay
+
+int OverlayActive()
+{
+    return overlay_active;
+} // OverlayActive
+
+int OverlayEvent(const Event *event)
+{
+    if (!overlay_active)
+    {
+        return 0;
+    }
+    if (event->type == EVENT_TIMER && event->data == TIMER_OVERLAY)
+    {
+        DismissOverlay(); // Time up
+        return 1;
+    }
+    if (event->type == EVENT_KEY)
+    {
+        DismissOverlay(); // The key is then dealt with as usual
+    }
+    return 0;
+} // OverlayEvent
 
 /* DEBUG Functions
  * These functions were created to test the functionality of the
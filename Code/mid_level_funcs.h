@@ -35,6 +35,9 @@
 #ifndef MID_LEVEL_FUNCS_H
 #define MID_LEVEL_FUNCS_H
 
+#include "scheduler.h"
+#include "low_level_funcs_tiva.h" // For DISPLAY_WIDTH
+
 //! \name Keyboard functions
 //@{
 
@@ -93,6 +96,61 @@ void KeyboardReadRowCol( int *row, int *col );
  */
 char KeyboardRowCol2Char( int row, int col );
 
+/*! Check, without waiting, whether any key is being pressed.
+ *
+ * \return 1 if at least one key is down, 0 if none is.
+ *
+ * Used by loops which have other work to do and must not sit in
+ * GetKeyboardChar() until a key arrives.
+ */
+int KeyboardKeyDown( void );
+
+/*! Time, in milliseconds, a key must read as pressed (or released) for
+ * longer than it reads the other way before it counts as pressed (or
+ * released). At most 65.
+ */
+#define KEY_DEBOUNCE_MILLISEC 8
+
+/*! Time between reads of a key when the keypad is scanned as usual. One
+ * reading never counts for more than this in the debouncer, however
+ * long it has been since the last (e.g. after a flash erase, a long
+ * calculation or a clock switch has held up the scan), so a key still
+ * needs \a KEY_DEBOUNCE_MILLISEC worth of readings to change state.
+ */
+#define KEY_SCAN_PERIOD_MICROSEC 1000
+
+/*! Keys which repeat while held down (typematic): Rubout. */
+#define KEY_REPEAT_KEYS "#"
+
+//! \name Typematic repeat times, in milliseconds
+//@{
+#define KEY_REPEAT_DELAY_MILLISEC 500 //!< From the press to the first repeat
+#define KEY_REPEAT_START_MILLISEC 150 //!< Between the first repeats
+#define KEY_REPEAT_MIN_MILLISEC 40    //!< Shortest time between repeats
+//@}
+
+/*! Background task which scans the keypad without waiting (see scheduler.h).
+ * 
+ * Each call looks at one column, if its rows have had time to settle, 
+ * and moves on to the next, so every key is read about every 
+ * millisecond. Each key has its own integrating debouncer: the time it 
+ * reads as pressed counts up and the time it reads as released counts 
+ * down, between 0 and \a KEY_DEBOUNCE_MILLISEC, and it only changes 
+ * state at the ends. Each reading counts for at most 
+ * \a KEY_SCAN_PERIOD_MICROSEC, so a hold-up in scanning cannot make one 
+ * reading (perhaps a bounce) decide the key. Bounces therefore delay a press by a few 
+ * milliseconds but never report it twice, and keys can be typed as fast 
+ * as the fingers go.
+ * 
+ * When a key goes down it posts an EVENT_KEY with the character marked 
+ * on the key. A key in \a KEY_REPEAT_KEYS which is held down is 
+ * reported again after \a KEY_REPEAT_DELAY_MILLISEC, then every 
+ * \a KEY_REPEAT_START_MILLISEC, each repeat a quarter sooner than the 
+ * one before down to \a KEY_REPEAT_MIN_MILLISEC. Other keys are 
+ * reported once per press.
+ */
+void KeyboardTask( void );
+
 //@}
 // End of Keyboard functions
 
@@ -121,7 +179,124 @@ char KeyboardRowCol2Char( int row, int col );
  */
 void PrintString( short int line, short int char_pos, const char *string );
 
+/* Display frame
+ * 
+ * PrintString() no longer drives the LCD itself. It writes into a copy of 
+ * the screen (the frame), which takes microseconds, and DisplayFlushTask() 
+ * then brings the LCD into line with it in the background, one byte at a 
+ * time. Only characters which differ are sent. As with the LCD itself, 
+ * PrintString() leaves the cursor just after the string it printed.
+ * 
+ * Anything which changes the LCD directly (e.g. ClearDisplay()) is 
+ * put right by the flush, since it compares the frame with what the LCD 
+ * actually shows (GetDisplayShadow()).
+ */
+
+/*! Clear the frame and put the cursor at the top left.
+ */
+void ClearScreen( void );
+
+/*! Put the cursor at a position in the frame (shown once flushed).
+ * 
+ * \param [in] line The line number, 1 for top or 2 for bottom.
+ * \param [in] char_pos The character position, counting from 1 at the 
+ * 		left to 16 at the right.
+ */
+void SetCursorPosition( short int line, short int char_pos );
+
+/*! Show or hide the cursor (shown once flushed).
+ * 
+ * \param [in] on 0 for off, any non-zero quantity for on.
+ * 
+ * Use this rather than TurnCursorOnOff(), so that the cursor can be 
+ * hidden while an overlay is shown and come back afterwards.
+ */
+void SetCursorOnOff( short int on );
+
+/*! Background task which sends the next byte needed to make the LCD 
+ * match the frame, if the LCD is ready for it. When the LCD matches, 
+ * it posts one EVENT_LCD_FLUSH.
+ */
+void DisplayFlushTask( void );
+
+/*! \return 1 if the frame has changes not yet on the LCD, else 0.
+ */
+int DisplayFlushPending( void );
+
+/*! Everything the screen shows: the frame and the cursor. */
+typedef struct
+{
+    char text[2][DISPLAY_WIDTH]; //!< The frame, line 1 then line 2
+    short int cursor_line;       //!< As SetCursorPosition()
+    short int cursor_pos;
+    short int cursor_on;         //!< As SetCursorOnOff()
+} ScreenState;
+
+/*! Copy the screen, e.g. to save it (see power_down.h).
+ * 
+ * \param [out] state The screen. If an overlay is shown, it is what the 
+ * 		overlay covers.
+ */
+void GetScreenState( ScreenState *state );
+
+/*! Put back a screen copied by GetScreenState() (shown once flushed). 
+ * Any overlay is dismissed first.
+ */
+void SetScreenState( const ScreenState *state );
+
 //@}
 // End of Display functions
 
+//! \name Overlay functions
+//@{
+
+/* Overlays
+ * 
+ * An overlay is a short message (an error, a warning, a hint) drawn over 
+ * whatever is on the screen. The frame cells it covers are saved, and 
+ * when it is dismissed only those cells are put back, so the screen 
+ * underneath need not be redrawn. While it is shown the cursor is hidden, 
+ * and anything printed under it goes into the saved cells, so it appears 
+ * when the overlay goes.
+ * 
+ * An overlay is dismissed when its time is up or when a key is pressed. 
+ * The key is not used up: it is then dealt with as usual, so the user 
+ * can carry straight on without waiting for the message to go.
+ */
+
+/*! Start a new overlay, dismissing any overlay already shown.
+ * 
+ * \param [in] duration_ms How long it is shown if no key is pressed.
+ * 
+ * Then call OverlayString() to draw it.
+ */
+void OpenOverlay( unsigned long duration_ms );
+
+/*! Draw a string in the overlay, as PrintString() does.
+ * 
+ * Only the cells the string covers are hidden. To hide a whole line, 
+ * pad the string with spaces to \a DISPLAY_WIDTH characters.
+ */
+void OverlayString( short int line, short int char_pos, const char *string );
+
+/*! Remove the overlay (if any) and restore the cells it covered.
+ */
+void DismissOverlay( void );
+
+/*! \return 1 while an overlay is shown, else 0.
+ */
+int OverlayActive( void );
+
+/*! Give an event to the overlay before anything else sees it.
+ * 
+ * \param [in] event The event.
+ * \return 1 if the overlay used the event up (its own timer), so it 
+ * 		must not be passed on, else 0. A key dismisses the overlay 
+ * 		but is not used up.
+ */
+int OverlayEvent( const Event *event );
+
+//@}
+// End of Overlay functions
+
 #endif // of #ifndef MID_LEVEL_FUNCS_H
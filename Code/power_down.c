@@ -0,0 +1,83 @@
+/* power_down.c
+ *
+ * Power-down when idle, and instant resume.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "TExaS.h"
+#include "power_down.h"
+#include "low_level_funcs_tiva.h"
+#include "mid_level_funcs.h"
+#include "clock_policy.h"
+#include "scheduler.h"
+#include "event_trace.h"
+
+static enum
+{
+    POWER_AWAKE,  // In use, or not idle for long enough yet
+    POWER_SAVING, // EVENT_POWER_DOWN posted: waiting for PowerDownSave()
+    POWER_WRITING // Waiting for the session to reach flash and the LCD to catch up
+} power_state = POWER_AWAKE;
+static unsigned long last_activity_millisec; // GetTickMillisec() at the last key or serial line
+
+void PowerDownActivity(void)
+{
+    last_activity_millisec = GetTickMillisec();
+    if (power_state == POWER_WRITING)
+    {
+        ClearSessionInFlash(); // In use again: a reset from now on starts afresh
+    }
+    power_state = POWER_AWAKE;
+} // PowerDownActivity
+
+void PowerDownTask(void)
+{
+    switch (power_state)
+    {
+    case POWER_AWAKE:
+        if (!ClockPolicyHeld() && GetTickMillisec() - last_activity_millisec >= POWER_IDLE_MILLISEC &&
+            PostEvent(EVENT_POWER_DOWN, 0))
+        {
+            power_state = POWER_SAVING;
+        }
+        break;
+
+    case POWER_SAVING:
+        break; // Until PowerDownSave()
+
+    case POWER_WRITING:
+        if (FlashWritePending() || DisplayFlushPending())
+        {
+            break;
+        }
+        TraceRecord(TRACE_POWER, 1);
+        TurnDisplayOnOff(0);
+        SleepUntilKey();
+        TurnDisplayOnOff(1); // Exactly as it was
+        TraceRecord(TRACE_POWER, 0);
+        PowerDownActivity(); // Also clears the session in flash: RAM has it all
+        PostEvent(EVENT_POWER_WAKE, 0);
+        break;
+    }
+} // PowerDownTask
+
+void PowerDownSave(const PowerSession *session)
+{
+    if (power_state != POWER_SAVING)
+    {
+        return; // A key came first
+    }
+    WriteSessionToFlash(session, sizeof(*session));
+    power_state = POWER_WRITING;
+} // PowerDownSave
+
+int PowerDownFindSession(PowerSession *session)
+{
+    if (!ReadSessionFromFlash(session, sizeof(*session)) || session->version != POWER_SESSION_VERSION)
+    {
+        return 0;
+    }
+    ClearSessionInFlash();
+    return 1;
+} // PowerDownFindSession
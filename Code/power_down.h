@@ -0,0 +1,103 @@
+/*! \file power_down.h
+ *
+ * Powers the calculator down when it is left alone, and brings it back,
+ * exactly as it was, when a key is pressed.
+ *
+ * After \a POWER_IDLE_MILLISEC with no key pressed (and no line over the
+ * serial port), PowerDownTask() posts EVENT_POWER_DOWN. The program then
+ * gathers everything needed to carry on (a PowerSession) and passes it
+ * to PowerDownSave(), which writes it to flash. Once it is written and
+ * the LCD is up to date, the LCD is turned off and the core goes into
+ * deep sleep (see SleepUntilKey()) until a key is pressed.
+ *
+ * On waking the LCD, which kept its contents, is turned on again, so the
+ * screen is back within about a hundred microseconds with nothing
+ * redrawn, and EVENT_POWER_WAKE is posted. The key which woke it follows
+ * as an ordinary EVENT_KEY, so it is not lost. Neither the welcome
+ * screen nor the password is shown again, unless \a POWER_RELOCK says so.
+ *
+ * RAM holds everything again once awake, so the session in flash is
+ * cleared then. If power is lost while asleep, PowerDownFindSession()
+ * finds it at the next power-on and the program resumes from it instead
+ * of starting afresh.
+ *
+ * Nothing is powered down while ClockPolicyHold() is in force (e.g.
+ * while starting up and in serial batch mode).
+ *
+ * PowerDownTask() does not return while the core is asleep, which is
+ * the one exception to the rule that tasks never wait (see scheduler.h):
+ * there is nothing else to do.
+ *
+ * The hibernation module, which uses less power still, is not used: it
+ * loses the RAM, and it can only be woken by its WAKE pin or its clock,
+ * and the keypad is not wired to the WAKE pin.
+ */
+
+#ifndef POWER_DOWN_H
+#define POWER_DOWN_H
+
+#include "mid_level_funcs.h"
+#include "high_level_funcs.h"
+#include "rpn.h"
+#include "stats.h"
+
+/*! Milliseconds without a key (or serial line) before powering down. */
+#define POWER_IDLE_MILLISEC 60000
+
+//! \name Re-lock policies: when the password must be entered again
+//@{
+#define POWER_RELOCK_NEVER 0    //!< Never: the session simply carries on
+#define POWER_RELOCK_ON_RESET 1 //!< Only when resuming from flash after power was lost
+#define POWER_RELOCK_ALWAYS 2   //!< After every power-down
+//@}
+
+/*! The re-lock policy in force. */
+#define POWER_RELOCK POWER_RELOCK_ON_RESET
+
+/*! Changed whenever PowerSession changes, so that a session saved by
+ * another version of the program is not misread. */
+#define POWER_SESSION_VERSION 2
+
+/*! Everything needed to carry on where the user left off. */
+typedef struct
+{
+    unsigned long version; //!< POWER_SESSION_VERSION
+    int app_state;         //!< What the program was doing (its own numbering)
+    double answer;         //!< The answer (ANS)
+    double last_operand;   //!< The last operation, which = repeats (see expression.h)
+    char last_op;
+    ScreenState screen;    //!< What the screen showed
+    InputSession input;    //!< The input being typed
+    RpnSession rpn;        //!< RPN mode
+    StatsSession stats;    //!< Statistics mode (the points are in flash already)
+} PowerSession;
+
+/*! Restart the time to power-down. Called for each key and serial line.
+ */
+void PowerDownActivity( void );
+
+/*! Background task (see scheduler.h) which powers down when the time is
+ * up, once the program has saved its session, and wakes up again.
+ */
+void PowerDownTask( void );
+
+/*! Write the session to flash, in answer to EVENT_POWER_DOWN. The core
+ * goes to sleep once it is written.
+ *
+ * \param [in] session The session. It is not copied, so it must stay
+ * 		unchanged until EVENT_POWER_WAKE.
+ *
+ * Ignored if a key has been pressed since EVENT_POWER_DOWN was posted.
+ */
+void PowerDownSave( const PowerSession *session );
+
+/*! Look for a session left in flash by a power-down which was ended by
+ * power being lost, rather than by a key. Call at power-on.
+ *
+ * \param [out] session The session, if there is one.
+ * \return 1 if there is, else 0. It is then cleared from flash, so it
+ * 		is only resumed once.
+ */
+int PowerDownFindSession( PowerSession *session );
+
+#endif // of #ifndef POWER_DOWN_H
@@ -0,0 +1,250 @@
+/* radix.c
+ *
+ * Hexadecimal, octal and binary modes: 64-bit evaluator and table-driven
+ * conversion.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "radix.h"
+#include "result_cache.h"
+
+#define NOT_DIGIT 0xFF
+
+const char *radix_error_line1[] = {"", "Syntax error    ", "Division by zero", "Number too big  "};
+const char *radix_error_line2[] = {"", "Press any key   ", "Press any key   ", "64 bits at most "};
+
+static const char digit_char[16] = {'0', '1', '2', '3', '4', '5', '6', '7',
+                                    '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+
+// Value of each character from '0' to 'F', or NOT_DIGIT
+static const unsigned char digit_value['F' - '0' + 1] = {
+    0,         1,         2,         3,         4,         5,         6,         7,         8, 9, // 0 to 9
+    NOT_DIGIT, NOT_DIGIT, NOT_DIGIT, NOT_DIGIT, NOT_DIGIT, NOT_DIGIT, NOT_DIGIT,                 // : to @
+    10,        11,        12,        13,        14,        15};                                  // A to F
+
+static const char *next; // Next character to evaluate
+static int digit_bits;    // Bits in one digit of the base in use
+
+int RadixDigitBits(int number_mode)
+{
+    switch (number_mode)
+    {
+    case NUMBER_MODE_HEX:
+        return 4;
+    case NUMBER_MODE_OCTAL:
+        return 3;
+    case NUMBER_MODE_BINARY:
+        return 1;
+    default:
+        return 0;
+    }
+} // RadixDigitBits
+
+// Value of c as a digit of the base in use, or NOT_DIGIT
+static unsigned char DigitValue(char c)
+{
+    unsigned char value;
+
+    if (c < '0' || c > 'F')
+    {
+        return NOT_DIGIT;
+    }
+    value = digit_value[c - '0'];
+    return (value < (1U << digit_bits)) ? value : NOT_DIGIT;
+} // DigitValue
+
+int RadixIsDigit(char c, int number_mode)
+{
+    int bits = RadixDigitBits(number_mode);
+
+    return bits != 0 && c >= '0' && c <= 'F' && digit_value[c - '0'] < (1U << bits);
+} // RadixIsDigit
+
+// How tightly a binary operator binds, as in C, or 0 if c is not one
+static int Precedence(char c)
+{
+    switch (c)
+    {
+    case '|':
+        return 1;
+    case '^':
+        return 2;
+    case '&':
+        return 3;
+    case '<':
+    case '>':
+        return 4;
+    case '+':
+    case '-':
+        return 5;
+    case 'x':
+    case '/':
+    case '%':
+        return 6;
+    default:
+        return 0;
+    }
+} // Precedence
+
+// number := digit {digit}
+static int EvaluateNumber(uint64_t *value)
+{
+    unsigned char digit;
+    const char *start = next;
+
+    *value = 0;
+    while ((digit = DigitValue(*next)) != NOT_DIGIT)
+    {
+        if ((*value >> (64 - digit_bits)) != 0) // Shifting it along would lose bits
+        {
+            return RADIX_ERR_TOO_BIG;
+        }
+        *value = (*value << digit_bits) | digit;
+        next++;
+    }
+    return (next == start) ? RADIX_ERR_SYNTAX : RADIX_OK;
+} // EvaluateNumber
+
+// unary := {-|+|~} number
+static int EvaluateUnary(uint64_t *value)
+{
+    char op = *next;
+    int error;
+
+    if (op == '-' || op == '+' || op == '~')
+    {
+        next++;
+        error = EvaluateUnary(value);
+        if (op == '-')
+        {
+            *value = 0 - *value;
+        }
+        else if (op == '~')
+        {
+            *value = ~*value;
+        }
+        return error;
+    }
+    return EvaluateNumber(value);
+} // EvaluateUnary
+
+// Quotient or remainder of signed 64-bit numbers, rounded towards zero,
+// without the overflow of the most negative number divided by -1
+static uint64_t Divide(uint64_t a, uint64_t b, char op)
+{
+    int negative_a = (a >> 63) != 0;
+    int negative_b = (b >> 63) != 0;
+    uint64_t magnitude_a = negative_a ? 0 - a : a;
+    uint64_t magnitude_b = negative_b ? 0 - b : b;
+    uint64_t result;
+
+    if (op == '/')
+    {
+        result = magnitude_a / magnitude_b;
+        return (negative_a != negative_b) ? 0 - result : result;
+    }
+    result = magnitude_a % magnitude_b;
+    return negative_a ? 0 - result : result; // The sign of a, as in C
+} // Divide
+
+// binary := unary {op binary}, taking only operators which bind at least
+// as tightly as min_precedence (precedence climbing: one function for
+// all six levels, and left to right within each)
+static int EvaluateBinary(int min_precedence, uint64_t *value)
+{
+    uint64_t right;
+    char op;
+    int precedence;
+    int error = EvaluateUnary(value);
+
+    while (error == RADIX_OK && (precedence = Precedence(*next)) != 0 && precedence >= min_precedence)
+    {
+        op = *next++;
+        error = EvaluateBinary(precedence + 1, &right);
+        if (error != RADIX_OK)
+        {
+            break;
+        }
+        switch (op)
+        {
+        case '|':
+            *value |= right;
+            break;
+        case '^':
+            *value ^= right;
+            break;
+        case '&':
+            *value &= right;
+            break;
+        case '<':
+            *value = (right < 64) ? *value << right : 0;
+            break;
+        case '>':
+            *value = (right < 64) ? *value >> right : 0;
+            break;
+        case '+':
+            *value += right;
+            break;
+        case '-':
+            *value -= right;
+            break;
+        case 'x':
+            *value *= right;
+            break;
+        default: // / and %
+            if (right == 0)
+            {
+                return RADIX_ERR_DIV_ZERO;
+            }
+            *value = Divide(*value, right, op);
+        }
+    }
+    return error;
+} // EvaluateBinary
+
+int RadixEvaluate(const char *input, int number_mode, uint64_t *value)
+{
+    uint64_t result;
+    int error;
+
+    digit_bits = RadixDigitBits(number_mode);
+    if (digit_bits == 0)
+    {
+        return RADIX_ERR_SYNTAX;
+    }
+    next = input;
+    error = EvaluateBinary(1, &result);
+    if (error == RADIX_OK && *next != '\0')
+    {
+        error = RADIX_ERR_SYNTAX;
+    }
+    if (error == RADIX_OK)
+    {
+        *value = result;
+    }
+    return error;
+} // RadixEvaluate
+
+void RadixFormat(uint64_t value, int number_mode, char *text)
+{
+    int bits = RadixDigitBits(number_mode);
+    unsigned mask = (1U << bits) - 1;
+    int shift;
+
+    if (bits == 0)
+    {
+        text[0] = '\0';
+        return;
+    }
+    shift = ((64 + bits - 1) / bits - 1) * bits; // Of the top digit there can be
+    while (shift > 0 && (value >> shift) == 0)   // Skip leading zeroes
+    {
+        shift -= bits;
+    }
+    for (; shift >= 0; shift -= bits)
+    {
+        *text++ = digit_char[(value >> shift) & mask];
+    }
+    *text = '\0';
+} // RadixFormat
@@ -0,0 +1,89 @@
+/*! \file radix.h
+ *
+ * Hexadecimal, octal and binary modes, for register and bitmask work.
+ *
+ * Numbers are 64-bit two's complement: + - x wrap around as a 64-bit
+ * register would, / and % treat both operands as signed (rounding
+ * towards zero, as in C), and a negative result is shown as its bit
+ * pattern, e.g. 0-1 is FFFFFFFFFFFFFFFF in hex mode. A number typed may
+ * have any value that fits in 64 bits.
+ *
+ * The operators, loosest first, as in C:
+ * 	- | (or)
+ * 	- ^ (exclusive or)
+ * 	- & (and)
+ * 	- < and > (shift left and right by a number of places; > is a
+ * 		logical shift, filling with zeroes, and either gives 0 for
+ * 		64 places or more)
+ * 	- + -
+ * 	- x / %
+ * 	- unary - + and ~ (not). The LCD's character set has no ~, so it
+ * 		shows as an arrow.
+ *
+ * On the keypad (with Shift 7 going on from integer mode to hex, octal,
+ * binary and back to decimal), Shift then 1 to 6 enters the hex digits
+ * A to F and Shift then C gives the operators (see high_level_funcs.h).
+ *
+ * Conversion to and from text is table-driven: each base is a power of
+ * two, so a digit is a shift, a mask and a table lookup, with no division,
+ * no double and no printf. A binary result is up to 64 digits long, and
+ * scrolls along line 2 (see DisplayRadixResult()).
+ */
+
+#ifndef RADIX_H
+#define RADIX_H
+
+#include <stdint.h>
+
+/*! Size of a buffer for any number written by RadixFormat(): 64 binary
+ * digits and the trailing null.
+ */
+#define RADIX_TEXT_SIZE 65
+
+//! \name Error numbers
+//@{
+#define RADIX_OK 0           //!< No error
+#define RADIX_ERR_SYNTAX 1   //!< Not a valid expression in the base
+#define RADIX_ERR_DIV_ZERO 2 //!< Division (or remainder) by zero
+#define RADIX_ERR_TOO_BIG 3  //!< A number typed does not fit in 64 bits
+//@}
+
+/*! Error messages for the error numbers above, one per display line. */
+extern const char *radix_error_line1[];
+extern const char *radix_error_line2[]; //!< \copydoc radix_error_line1
+
+/*! \param [in] number_mode One of the NUMBER_MODE_ constants (see result_cache.h).
+ * \return The bits in one digit: 4 in hex mode, 3 in octal and 1 in
+ * 		binary, or 0 if \a number_mode is not one of them.
+ */
+int RadixDigitBits( int number_mode );
+
+/*! \param [in] c A character.
+ * \param [in] number_mode As RadixDigitBits().
+ * \return 1 if \a c is a digit of the base of \a number_mode (e.g. 0-9
+ * 		and A-F in hex mode), else 0; always 0 outside hex, octal
+ * 		and binary modes.
+ */
+int RadixIsDigit( char c, int number_mode );
+
+/*! Evaluate an expression in a base.
+ *
+ * \param [in] input A C-format string: numbers in the base, with the
+ * 		hex digits in upper case, and the operators above.
+ * \param [in] number_mode NUMBER_MODE_HEX, NUMBER_MODE_OCTAL or
+ * 		NUMBER_MODE_BINARY.
+ * \param [out] value The result, if there was no error.
+ * \return RADIX_OK or an error number.
+ */
+int RadixEvaluate( const char *input, int number_mode, uint64_t *value );
+
+/*! Write a number in a base, with no leading zeroes (0 is "0").
+ *
+ * \param [in] value The number, as a 64-bit pattern.
+ * \param [in] number_mode As RadixEvaluate().
+ * \param [out] text A C-format string, of at most \a RADIX_TEXT_SIZE
+ * 		characters including the trailing null.
+ */
+void RadixFormat( uint64_t value, int number_mode, char *text );
+
+#endif // of #ifndef RADIX_H
@@ -0,0 +1,250 @@
+/* result_cache.c
+ *
+ * Cache of recent results: a small array searched by hash, with the
+ * least recently used entry replaced when it is full.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "TExaS.h"
+#include "result_cache.h"
+#include "expression.h"
+#include "calculate_answer.h"
+#include <string.h>
+
+typedef struct
+{
+    unsigned long hash;              // Of key and mode
+    char key[RESULT_CACHE_KEY_SIZE]; // Normalised entry, or the entry as typed if it did not compile
+    unsigned char mode;
+    unsigned char normalised;        // 1 if key was normalised (the entry compiled)
+    unsigned char valid;             // 1 if the entry is in use
+    unsigned char uses_ans;          // 1 if the result depends on the answer
+    unsigned long last_used;         // use_clock when last looked up or stored
+    CalcResult result;
+} CacheEntry;
+
+static CacheEntry entries[RESULT_CACHE_SIZE];
+static unsigned long use_clock; // Counts lookups, to find the least recently used entry
+static ResultCacheStats stats;
+
+static int IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+} // IsDigit
+
+// Copy input to key, dropping leading zeros and trailing fractional zeros
+// from each number. Only for entries which ExprCompile() has accepted: the
+// syntax is not checked, so "1E2.0" would become "1E2". Returns 0 if the
+// result does not fit.
+static int Normalise(const char *input, char *key)
+{
+    int length = 0;
+    int number_start;
+    int point; // Position of the decimal point in key, or -1
+
+    while (*input != '\0')
+    {
+        if (IsDigit(*input) || *input == '.')
+        {
+            number_start = length;
+            point = -1;
+            while (*input == '0' && IsDigit(input[1])) // Leading zeros, but not the last digit
+            {
+                input++;
+            }
+            while ((IsDigit(*input) || *input == '.') && length < RESULT_CACHE_KEY_SIZE - 1)
+            {
+                if (*input == '.' && point < 0)
+                {
+                    point = length;
+                }
+                key[length++] = *input++;
+            }
+            if (point >= 0) // Trailing zeros after the point, then the point itself
+            {
+                while (length > point + 1 && key[length - 1] == '0')
+                {
+                    length--;
+                }
+                if (length == point + 1)
+                {
+                    length--;
+                }
+                if (length == number_start) // ".0" or "."
+                {
+                    key[length++] = '0';
+                }
+            }
+        }
+        else if (length < RESULT_CACHE_KEY_SIZE - 1)
+        {
+            key[length++] = *input++;
+        }
+        if (length >= RESULT_CACHE_KEY_SIZE - 1 && *input != '\0')
+        {
+            return 0; // Too long to cache
+        }
+    }
+    key[length] = '\0';
+    return 1;
+} // Normalise
+
+// 32-bit FNV-1a hash of the key and mode
+static unsigned long Hash(const char *key, int mode)
+{
+    unsigned long hash = 2166136261UL;
+
+    while (*key != '\0')
+    {
+        hash = ((hash ^ (unsigned char)*key++) * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return ((hash ^ (unsigned char)mode) * 16777619UL) & 0xFFFFFFFFUL;
+} // Hash
+
+// Evaluate an entry (a cache miss), already compiled into program with
+// compile_error as the result
+static void Evaluate(char *input, int input_size, double ans, ExprProgram *program, int compile_error,
+                     CalcResult *result)
+{
+    double value;
+    int compiled = (compile_error == EXPR_OK);
+
+    result->error_ref_no = 0;
+    result->last_op = 0;
+    result->last_operand = 0.0;
+    if (ExprUsesAns(input))
+    {
+        // Uses the binary answer, so calculated here rather than by
+        // CalculateAnswer(), which only sees the text
+        result->expr_error = compile_error;
+        if (result->expr_error == EXPR_OK)
+        {
+            result->expr_error = ExprEvaluate(program, ans, &result->value);
+        }
+    }
+    else
+    {
+        result->expr_error = EXPR_OK;
+        // Whole numbers all the way are exact, so give what CalculateAnswer()
+        // would, without its double arithmetic
+        if (!compiled || !ExprEvaluateWhole(program, ans, &result->value))
+        {
+            result->value = CalculateAnswer(input, input_size, &result->error_ref_no);
+            // Evaluated as well, only to find its last operation
+            if (result->error_ref_no != 0 || !compiled || ExprEvaluate(program, ans, &value) != EXPR_OK)
+            {
+                return; // Nothing to repeat
+            }
+        }
+    }
+    if (result->expr_error == EXPR_OK)
+    {
+        result->last_op = program->last_op;
+        result->last_operand = program->last_operand;
+    }
+} // Evaluate
+
+void ResultCacheClear(void)
+{
+    int i;
+
+    for (i = 0; i < RESULT_CACHE_SIZE; i++)
+    {
+        entries[i].valid = 0;
+    }
+    stats.hits = 0;
+    stats.misses = 0;
+    stats.evictions = 0;
+    stats.invalidations = 0;
+} // ResultCacheClear
+
+void ResultCacheCalculate(char *input, int input_size, int mode, double ans, CalcResult *result)
+{
+    char key[RESULT_CACHE_KEY_SIZE];
+    ExprProgram program;
+    int compile_error;
+    int normalised;
+    int fits;
+    unsigned long hash;
+    CacheEntry *entry;
+    int i;
+
+    // Only an entry which compiles is normalised, so one with a syntax error
+    // (e.g. "1E2.0" from the serial line, which the keypad grammar would have
+    // refused) never shares a key with a valid one ("1E2"): it is keyed as typed
+    compile_error = ExprCompile(input, &program);
+    normalised = (compile_error == EXPR_OK);
+    if (normalised)
+    {
+        fits = Normalise(input, key);
+    }
+    else
+    {
+        fits = (strlen(input) < RESULT_CACHE_KEY_SIZE);
+        if (fits)
+        {
+            strcpy(key, input);
+        }
+    }
+    if (!fits)
+    {
+        stats.misses++;
+        Evaluate(input, input_size, ans, &program, compile_error, result); // Too long to cache
+        return;
+    }
+    hash = Hash(key, mode);
+    use_clock++;
+
+    // Look for it, noting the least recently used entry as we go
+    entry = &entries[0];
+    for (i = 0; i < RESULT_CACHE_SIZE; i++)
+    {
+        if (entries[i].valid && entries[i].hash == hash && entries[i].mode == mode &&
+            entries[i].normalised == normalised && strcmp(entries[i].key, key) == 0)
+        {
+            entries[i].last_used = use_clock;
+            *result = entries[i].result;
+            stats.hits++;
+            return;
+        }
+        if (entry->valid && (!entries[i].valid || entries[i].last_used < entry->last_used))
+        {
+            entry = &entries[i];
+        }
+    }
+
+    stats.misses++;
+    Evaluate(input, input_size, ans, &program, compile_error, result);
+    if (entry->valid)
+    {
+        stats.evictions++;
+    }
+    entry->hash = hash;
+    strcpy(entry->key, key);
+    entry->mode = mode;
+    entry->normalised = normalised;
+    entry->uses_ans = ExprUsesAns(input);
+    entry->last_used = use_clock;
+    entry->result = *result;
+    entry->valid = 1;
+} // ResultCacheCalculate
+
+void ResultCacheInvalidateAns(void)
+{
+    int i;
+
+    for (i = 0; i < RESULT_CACHE_SIZE; i++)
+    {
+        if (entries[i].valid && entries[i].uses_ans)
+        {
+            entries[i].valid = 0;
+            stats.invalidations++;
+        }
+    }
+} // ResultCacheInvalidateAns
+
+void ResultCacheGetStats(ResultCacheStats *stats_out)
+{
+    *stats_out = stats;
+} // ResultCacheGetStats
@@ -0,0 +1,91 @@
+/*! \file result_cache.h
+ *
+ * Cache of recent results, so that an expression entered again (a price
+ * times a rate, a unit conversion, ...) is not evaluated again.
+ *
+ * Each entry is keyed by the entry text, normalised so that equal
+ * numbers written differently share an entry (leading zeros and trailing
+ * fractional zeros are dropped: "02.50x4" is stored as "2.5x4"), and by
+ * the number mode. Only entries which ExprCompile() accepts are
+ * normalised; any other is keyed as typed, so an entry with a syntax
+ * error (e.g. "1E2.0" from the serial line) can never find the result of
+ * a valid one ("1E2"). The key is found by a hash, and the text is then
+ * compared in full, so a hash collision can never give a wrong result.
+ *
+ * The cache holds \a RESULT_CACHE_SIZE entries in a fixed array. When it
+ * is full, the entry used least recently is replaced.
+ *
+ * Results of entries which use ANS (see expression.h) depend on the
+ * answer as well as the text, so they must be dropped, with
+ * ResultCacheInvalidateAns(), whenever the answer changes.
+ */
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+/*! Number of entries. Each takes about 64 bytes. */
+#define RESULT_CACHE_SIZE 8
+
+/*! Longest normalised entry which can be cached, including the
+ * trailing null. The same as the keypad input buffer.
+ */
+#define RESULT_CACHE_KEY_SIZE 17
+
+//! \name Number modes (part of the key)
+//@{
+#define NUMBER_MODE_DECIMAL 0 //!< Decimal infix entry
+#define NUMBER_MODE_INTEGER 1 //!< Exact integers (see bignum.h); not cached, as the results are text
+#define NUMBER_MODE_HEX 2     //!< Hexadecimal, 64 bits (see radix.h); not cached either
+#define NUMBER_MODE_OCTAL 3   //!< Octal, as hex
+#define NUMBER_MODE_BINARY 4  //!< Binary, as hex
+//@}
+
+/*! Everything that evaluating an entry gives. */
+typedef struct
+{
+    double value;        // The result (not valid if there was an error)
+    int error_ref_no;    // Error from CalculateAnswer(), 0 if none
+    int expr_error;      // Error from expression.c, EXPR_OK if none
+    char last_op;        // Last operation, for constant mode (see ExprRepeat()), or 0
+    double last_operand; // Its right-hand operand
+} CalcResult;
+
+/*! Counters since ResultCacheClear(). */
+typedef struct
+{
+    unsigned long hits;          // Lookups which found the entry
+    unsigned long misses;        // Lookups which had to evaluate it
+    unsigned long evictions;     // Entries replaced to make room
+    unsigned long invalidations; // Entries dropped because the answer changed
+} ResultCacheStats;
+
+/*! Empty the cache and zero the counters.
+ */
+void ResultCacheClear( void );
+
+/*! Evaluate an entry, or find its result in the cache.
+ *
+ * \param [in] input A C-format string, as typed.
+ * \param [in] input_size Size of the buffer holding it (for CalculateAnswer()).
+ * \param [in] mode One of the NUMBER_MODE_ constants.
+ * \param [in] ans The current answer, for entries which use ANS.
+ * \param [out] result The result.
+ *
+ * The entry is compiled first, to decide how it is keyed (see above).
+ * On a miss, entries which use ANS are evaluated by expression.c, and so
+ * are others which ExprEvaluateWhole() can do in whole numbers. The rest
+ * go to CalculateAnswer() (and are compiled as well, only to find their
+ * last operation). The result, including any error, is then cached.
+ */
+void ResultCacheCalculate( char *input, int input_size, int mode, double ans,
+                           CalcResult *result );
+
+/*! Drop the entries which use ANS. Call whenever the answer changes.
+ */
+void ResultCacheInvalidateAns( void );
+
+/*! Copy the counters.
+ */
+void ResultCacheGetStats( ResultCacheStats *stats );
+
+#endif // of #ifndef RESULT_CACHE_H
@@ -0,0 +1,82 @@
+/* ring_buffer.c
+ *
+ * Single-producer, single-consumer byte ring buffer.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "ring_buffer.h"
+
+// Stops the compiler moving memory accesses across it. The data array is
+// not volatile, so without it the data store could legally be moved after
+// the volatile head store. The Cortex-M4 itself makes stores in order, so
+// no barrier instruction is needed.
+#if defined(__CC_ARM)
+#define COMPILER_BARRIER() __memory_changed()
+#else
+#define COMPILER_BARRIER() __asm__ __volatile__("" ::: "memory")
+#endif
+
+void RingBufferInit(RingBuffer *ring, unsigned char *storage, unsigned short size)
+{
+    ring->data = storage;
+    ring->mask = size - 1; // Size is a power of two, so this masks an index into range
+    ring->head = 0;
+    ring->tail = 0;
+    ring->high_water = 0;
+    ring->overruns = 0;
+} // RingBufferInit
+
+int RingBufferPut(RingBuffer *ring, unsigned char byte)
+{
+    unsigned short head = ring->head; // Only this side writes head, so one read is enough
+    unsigned short count = (unsigned short)(head - ring->tail); // Free-running counters: difference is the fill
+
+    if (count > ring->mask) // Full (count == size)
+    {
+        ring->overruns++;
+        return 0;
+    }
+    ring->data[head & ring->mask] = byte;   // Store the data before publishing it...
+    COMPILER_BARRIER();
+    ring->head = (unsigned short)(head + 1); // ...so the consumer never sees a half-written byte
+
+    if (count + 1 > ring->high_water)
+    {
+        ring->high_water = count + 1; // Record the deepest the buffer has been
+    }
+    return 1;
+} // RingBufferPut
+
+int RingBufferGet(RingBuffer *ring, unsigned char *byte)
+{
+    unsigned short tail = ring->tail;
+
+    if (tail == ring->head) // Empty
+    {
+        return 0;
+    }
+    *byte = ring->data[tail & ring->mask];
+    COMPILER_BARRIER();
+    ring->tail = (unsigned short)(tail + 1); // Release the slot only after the byte has been read
+    return 1;
+} // RingBufferGet
+
+int RingBufferPeek(const RingBuffer *ring, unsigned short offset)
+{
+    if (offset >= RingBufferCount(ring))
+    {
+        return -1;
+    }
+    return ring->data[(unsigned short)(ring->tail + offset) & ring->mask];
+} // RingBufferPeek
+
+unsigned short RingBufferCount(const RingBuffer *ring)
+{
+    return (unsigned short)(ring->head - ring->tail);
+} // RingBufferCount
+
+unsigned short RingBufferSpace(const RingBuffer *ring)
+{
+    return (unsigned short)(ring->mask + 1 - RingBufferCount(ring));
+} // RingBufferSpace
@@ -0,0 +1,69 @@
+/*! \file ring_buffer.h
+ *
+ * Fixed-size byte ring buffer for passing data between an interrupt
+ * handler and the main program.
+ *
+ * Each buffer has exactly one producer and one consumer (e.g. the UART
+ * receive interrupt puts, the main loop gets). With that restriction no
+ * interrupt masking is needed: the producer only ever writes \a head and
+ * the consumer only ever writes \a tail, and both are 16-bit stores which
+ * the Cortex-M4 performs atomically.
+ *
+ * The storage is supplied by the caller so that each buffer can be sized
+ * separately. The size must be a power of two (so that wrapping is a mask,
+ * not a division) and no more than 32768.
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+/*! State of one ring buffer. Treat the fields as private to ring_buffer.c,
+ * except \a high_water and \a overruns which may be read for statistics.
+ */
+typedef struct
+{
+    unsigned char *data;              // Caller-supplied storage
+    unsigned short mask;              // Size - 1 (size is a power of two)
+    volatile unsigned short head;     // Free-running count of bytes put (written by producer only)
+    volatile unsigned short tail;     // Free-running count of bytes got (written by consumer only)
+    unsigned short high_water;        // Most bytes ever held at once
+    volatile unsigned long overruns;  // Bytes refused because the buffer was full
+} RingBuffer;
+
+/*! Initialise (empty) a ring buffer.
+ *
+ * \param [out] ring The buffer to initialise.
+ * \param [in] storage Array of \a size bytes to hold the data.
+ * \param [in] size Size of \a storage. Must be a power of two.
+ */
+void RingBufferInit( RingBuffer *ring, unsigned char *storage, unsigned short size );
+
+/*! Add one byte to the buffer (producer side).
+ *
+ * \return 1 if the byte was stored, 0 if the buffer was full.
+ * 		A refused byte is counted in \a overruns.
+ */
+int RingBufferPut( RingBuffer *ring, unsigned char byte );
+
+/*! Remove the oldest byte from the buffer (consumer side).
+ *
+ * \param [out] byte Where to put the byte. Unchanged if the buffer is empty.
+ * \return 1 if a byte was read, 0 if the buffer was empty.
+ */
+int RingBufferGet( RingBuffer *ring, unsigned char *byte );
+
+/*! Look at the byte \a offset places from the oldest without removing it.
+ *
+ * \return The byte, or -1 if fewer than \a offset+1 bytes are held.
+ */
+int RingBufferPeek( const RingBuffer *ring, unsigned short offset );
+
+/*! Number of bytes currently held.
+ */
+unsigned short RingBufferCount( const RingBuffer *ring );
+
+/*! Number of bytes which can be put before the buffer is full.
+ */
+unsigned short RingBufferSpace( const RingBuffer *ring );
+
+#endif // of #ifndef RING_BUFFER_H
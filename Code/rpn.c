@@ -0,0 +1,315 @@
+/* rpn.c
+ *
+ * Reverse Polish entry mode: each key acts on the X/Y/Z/T stack at once.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "TExaS.h"
+#include "rpn.h"
+#include "high_level_funcs.h"
+#include "mid_level_funcs.h"
+#include "low_level_funcs_tiva.h"
+#include "expression.h"
+#include "mem_guard.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define X 0 // Stack levels
+#define Y 1
+#define Z 2
+#define T 3
+
+#define ENTRY_SIZE RPN_ENTRY_SIZE // Number being typed, including the trailing null
+
+static double stack[RPN_STACK_SIZE];
+static char entry[GUARDED_SIZE(ENTRY_SIZE)]; // Number being typed into X
+static int entry_length;                     // Characters in entry; 0 when not typing a number
+static int lift_enabled;                     // 1 if the next number typed lifts the stack first
+static int shifted;                          // 1 when the Shift key (D) has just been pressed
+
+static void ShowStack(void)
+{
+    char line[ENTRY_SIZE];
+
+    ClearScreen();
+    sprintf(line, "%16.9G", stack[Y]); // At most 16 characters, e.g. -1.23456789E-100
+    PrintString(1, 1, line);
+    if (entry_length > 0)
+    {
+        PrintString(2, 1, entry); // Leaves the cursor after it
+        SetCursorOnOff(1);
+    }
+    else
+    {
+        sprintf(line, "%16.9G", stack[X]);
+        PrintString(2, 1, line);
+        SetCursorOnOff(0);
+    }
+} // ShowStack
+
+static void Lift(void)
+{
+    stack[T] = stack[Z];
+    stack[Z] = stack[Y];
+    stack[Y] = stack[X];
+} // Lift
+
+static void Drop(void)
+{
+    stack[Y] = stack[Z];
+    stack[Z] = stack[T]; // T stays as it was
+} // Drop
+
+// If a number is being typed, it is complete: put it in X
+static void FinishEntry(void)
+{
+    if (entry_length > 0)
+    {
+        stack[X] = strtod(entry, NULL); // Takes as much as makes sense, e.g. 0 for "."
+        entry_length = 0;
+        lift_enabled = 1;
+    }
+} // FinishEntry
+
+// Add a character to the number being typed, starting it if need be
+static void AddToEntry(char c)
+{
+    if (entry_length == 0)
+    {
+        if (lift_enabled)
+        {
+            Lift();
+        }
+        if (c == 'E') // An exponent on its own means 1 times ten to it
+        {
+            entry[entry_length++] = '1';
+        }
+    }
+    else if ((c == '.' && (strchr(entry, '.') != NULL || strchr(entry, 'E') != NULL)) ||
+             (c == 'E' && strchr(entry, 'E') != NULL))
+    {
+        return; // A second point or exponent makes no sense
+    }
+    if (entry_length >= ENTRY_SIZE - 1)
+    {
+        PrintDisplayFull();
+        return;
+    }
+    entry[entry_length++] = c;
+    entry[entry_length] = '\0';
+} // AddToEntry
+
+// Change the sign of the exponent being typed if there is one, else of the number
+static void ChangeEntrySign(void)
+{
+    char *sign = strchr(entry, 'E');
+    int pos;
+
+    sign = (sign != NULL) ? sign + 1 : entry;
+    pos = sign - entry;
+    if (*sign == '-')
+    {
+        memmove(sign, sign + 1, entry_length - pos); // Includes the trailing null
+        entry_length--;
+    }
+    else if (entry_length < ENTRY_SIZE - 1)
+    {
+        memmove(sign + 1, sign, entry_length - pos + 1);
+        *sign = '-';
+        entry_length++;
+    }
+} // ChangeEntrySign
+
+static void Operate(char op)
+{
+    double result;
+    int error;
+
+    FinishEntry();
+    error = ExprApply(op, stack[Y], stack[X], &result);
+    if (error != EXPR_OK)
+    {
+        DisplayErrorMessage(expr_error_line1[error], expr_error_line2[error]); // Stack unchanged
+        return;
+    }
+    stack[X] = result;
+    Drop();
+    lift_enabled = 1;
+} // Operate
+
+static void PushConstant(double value)
+{
+    FinishEntry();
+    if (lift_enabled)
+    {
+        Lift();
+    }
+    stack[X] = value;
+    lift_enabled = 1;
+} // PushConstant
+
+void StartRpnMode(double x)
+{
+    int i;
+
+    for (i = 0; i < RPN_STACK_SIZE; i++)
+    {
+        stack[i] = 0.0;
+    }
+    stack[X] = x;
+    MemGuardRegister(entry, ENTRY_SIZE, "rpn entry");
+    entry_length = 0;
+    lift_enabled = 1; // A number typed now pushes x up to Y
+    shifted = 0;
+    ShowStack();
+} // StartRpnMode
+
+int RpnEvent(const Event *event)
+{
+    double swap;
+    char key;
+
+    if (event->type != EVENT_KEY)
+    {
+        return 0;
+    }
+    key = event->data;
+
+    if (shifted)
+    {
+        shifted = 0; // Shift only applies to one key
+        switch (key)
+        {
+        case 'A':
+            Operate('x');
+            break;
+        case 'B':
+            Operate('/');
+            break;
+        case 'C':
+            AddToEntry('E');
+            break;
+        case '*':
+            FinishEntry();
+            Lift();
+            lift_enabled = 0; // The next number replaces the copy in X
+            break;
+        case '#': // Clear all
+            StartRpnMode(0.0);
+            lift_enabled = 0;
+            break;
+        case '1':
+            PushConstant(3.14159265358979);
+            break;
+        case '2':
+            PushConstant(2.71828182845905);
+            break;
+        case '3':
+            PushConstant(1.41421356237310);
+            break;
+        case '5': // Swap X and Y
+            FinishEntry();
+            swap = stack[X];
+            stack[X] = stack[Y];
+            stack[Y] = swap;
+            lift_enabled = 1;
+            break;
+        case '6': // Roll down
+            FinishEntry();
+            swap = stack[X];
+            stack[X] = stack[Y];
+            Drop();
+            stack[T] = swap;
+            lift_enabled = 1;
+            break;
+        case '7': // Change sign
+            if (entry_length > 0)
+            {
+                ChangeEntrySign();
+            }
+            else
+            {
+                stack[X] = -stack[X];
+            }
+            break;
+        case '8': // Leave RPN mode
+            FinishEntry();
+            SetCursorOnOff(0);
+            return 1;
+        default: // Including D again, which cancels the shift
+            break;
+        }
+    }
+    else
+    {
+        switch (key)
+        {
+        case 'D':
+            PrintString(1, 1, "5xy 6R 7+/- 8= ^"); // Shift functions, over Y until the next key
+            shifted = 1;
+            return 0;
+        case 'A':
+            Operate('+');
+            break;
+        case 'B':
+            Operate('-');
+            break;
+        case 'C':
+            AddToEntry('.');
+            break;
+        case '*': // ENTER
+            FinishEntry();
+            Lift();
+            lift_enabled = 0; // The next number replaces the copy in X
+            break;
+        case '#':
+            if (entry_length > 0) // Rubout
+            {
+                entry[--entry_length] = '\0';
+                if (entry_length == 0) // Rubbed out altogether: X is zero until something is typed
+                {
+                    stack[X] = 0.0;
+                    lift_enabled = 0;
+                }
+            }
+            else // Clear X
+            {
+                stack[X] = 0.0;
+                lift_enabled = 0;
+            }
+            break;
+        default: // Digits
+            AddToEntry(key);
+        }
+    }
+    ShowStack();
+    return 0;
+} // RpnEvent
+
+double RpnGetX(void)
+{
+    return stack[X];
+} // RpnGetX
+
+void RpnSaveState(RpnSession *saved)
+{
+    memcpy(saved->stack, stack, sizeof(saved->stack));
+    memcpy(saved->entry, entry, ENTRY_SIZE);
+    saved->entry_length = entry_length;
+    saved->lift_enabled = lift_enabled;
+    saved->shifted = shifted;
+} // RpnSaveState
+
+void RpnResume(const RpnSession *saved)
+{
+    StartRpnMode(saved->stack[X]);
+    memcpy(stack, saved->stack, sizeof(stack));
+    entry_length = (saved->entry_length < ENTRY_SIZE) ? saved->entry_length : 0;
+    memcpy(entry, saved->entry, entry_length);
+    entry[entry_length] = '\0';
+    lift_enabled = saved->lift_enabled;
+    shifted = saved->shifted;
+    ShowStack();
+} // RpnResume
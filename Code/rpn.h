@@ -0,0 +1,80 @@
+/*! \file rpn.h
+ *
+ * Reverse Polish (RPN) entry mode, with the classic four-level X/Y/Z/T
+ * stack. Shift then 8 switches between this and ordinary entry.
+ *
+ * There is no expression buffer and nothing is parsed: a number is
+ * typed into X, and each operator acts on the stack as soon as its key
+ * is pressed, so a chain of any length needs no more memory than the
+ * stack itself. Y is shown on the top line and X on the bottom line.
+ *
+ * 	| Key	| Unshifted	| Shifted |
+ * 	| :--:	| :--:		| :--:		|
+ * 	| A	| +		| x		|
+ * 	| B	| -		| /		|
+ * 	| C	| .		| E		|
+ * 	| *	| ENTER		| ENTER		|
+ * 	| #	| Rubout, or clear X	| Clear all	|
+ * 	| 1 2 3	| digits	| pi, e, root 2	|
+ * 	| 5	| 5		| Swap X and Y	|
+ * 	| 6	| 6		| Roll down	|
+ * 	| 7	| 7		| Change sign	|
+ * 	| 8	| 8		| Leave RPN mode	|
+ *
+ * The stack behaves as on the classic calculators: ENTER copies X into
+ * Y (lifting Y to Z and Z to T) and the next number typed replaces X;
+ * an operator combines Y and X into X and drops the stack, with T
+ * copied down from the top; after an operation the next number lifts
+ * the stack first.
+ */
+
+#ifndef RPN_H
+#define RPN_H
+
+#include "scheduler.h"
+#include "low_level_funcs_tiva.h" // For DISPLAY_WIDTH
+
+/*! Number of stack levels (X, Y, Z and T). */
+#define RPN_STACK_SIZE 4
+
+/*! Size of the number being typed, including the trailing null. */
+#define RPN_ENTRY_SIZE (DISPLAY_WIDTH + 1)
+
+/*! Start RPN mode and show the stack.
+ *
+ * \param [in] x Initial value of X (normally the last answer). The other
+ * 		levels start at zero.
+ */
+void StartRpnMode( double x );
+
+/*! Deal with one event in RPN mode.
+ *
+ * \param [in] event The event.
+ * \return 1 when the user has left RPN mode (Shift then 8), else 0.
+ */
+int RpnEvent( const Event *event );
+
+/*! \return The value in X. When RPN mode is left, this becomes the answer.
+ */
+double RpnGetX( void );
+
+/*! The state of RPN mode, for saving a session (see power_down.h). */
+typedef struct
+{
+    double stack[RPN_STACK_SIZE]; //!< X, Y, Z and T
+    char entry[RPN_ENTRY_SIZE];   //!< Number being typed into X
+    unsigned char entry_length;   //!< Its length; 0 when not typing a number
+    unsigned char lift_enabled;   //!< 1 if the next number typed lifts the stack first
+    unsigned char shifted;        //!< 1 if Shift has just been pressed
+} RpnSession;
+
+/*! \param [out] saved The state of RPN mode. */
+void RpnSaveState( RpnSession *saved );
+
+/*! As StartRpnMode(), but carry on from a saved state.
+ *
+ * \param [in] saved State saved by RpnSaveState().
+ */
+void RpnResume( const RpnSession *saved );
+
+#endif // of #ifndef RPN_H
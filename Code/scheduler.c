@@ -0,0 +1,122 @@
+/* scheduler.c
+ *
+ * Cooperative run-to-completion scheduler: background tasks, software
+ * timers and an event queue.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "scheduler.h"
+#include "ring_buffer.h"
+#include "low_level_funcs_tiva.h"
+
+// The queue holds each event as two bytes (type, then data). Events are
+// only posted and taken from the main program, never from interrupts.
+static unsigned char event_storage[EVENT_QUEUE_SIZE * 2];
+static RingBuffer event_queue;
+
+static void (*tasks[MAX_TASKS])(void); // Background tasks, called in turn
+static int task_count;                 // Number of tasks added
+
+static unsigned long timer_expiry[TIMER_COUNT]; // GetTickMillisec() value at which each timer expires
+static unsigned char timer_running[TIMER_COUNT]; // 1 while a timer is counting
+
+static unsigned long lost_events; // Events refused because the queue was full
+
+void InitScheduler(void)
+{
+    int i;
+
+    RingBufferInit(&event_queue, event_storage, sizeof(event_storage));
+    task_count = 0;
+    for (i = 0; i < TIMER_COUNT; i++)
+    {
+        timer_running[i] = 0;
+    }
+    lost_events = 0;
+} // InitScheduler
+
+int AddBackgroundTask(void (*task)(void))
+{
+    if (task_count >= MAX_TASKS)
+    {
+        return 0;
+    }
+    tasks[task_count++] = task;
+    return 1;
+} // AddBackgroundTask
+
+int PostEvent(unsigned char type, unsigned char data)
+{
+    if (RingBufferSpace(&event_queue) < 2) // Both bytes or neither
+    {
+        lost_events++;
+        return 0;
+    }
+    RingBufferPut(&event_queue, type);
+    RingBufferPut(&event_queue, data);
+    return 1;
+} // PostEvent
+
+void StartTimer(unsigned char timer, unsigned long delay_ms)
+{
+    timer_expiry[timer] = GetTickMillisec() + delay_ms;
+    timer_running[timer] = 1;
+} // StartTimer
+
+void StopTimer(unsigned char timer)
+{
+    timer_running[timer] = 0;
+} // StopTimer
+
+int TimerRunning(unsigned char timer)
+{
+    return timer_running[timer];
+} // TimerRunning
+
+unsigned long GetLostEventCount(void)
+{
+    return lost_events;
+} // GetLostEventCount
+
+int SchedulerPass(void (*handler)(const Event *event))
+{
+    Event event;
+    unsigned long now;
+    int handled = 0;
+    int i;
+
+    // 1) Timers. Signed difference, so expiry is right across the tick wrapping.
+    now = GetTickMillisec();
+    for (i = 0; i < TIMER_COUNT; i++)
+    {
+        if (timer_running[i] && (long)(now - timer_expiry[i]) >= 0 && PostEvent(EVENT_TIMER, i))
+        {
+            timer_running[i] = 0; // Left running if the queue was full, to be posted on the next pass
+        }
+    }
+
+    // 2) One small step of each background task
+    for (i = 0; i < task_count; i++)
+    {
+        tasks[i]();
+    }
+
+    // 3) Every waiting event, in order, each run to completion.
+    //    Events posted by the handler are dealt with in this pass too.
+    while (RingBufferGet(&event_queue, &event.type))
+    {
+        RingBufferGet(&event_queue, &event.data);
+        handler(&event);
+        handled++;
+    }
+    return handled;
+} // SchedulerPass
+
+void RunScheduler(void (*handler)(const Event *event))
+{
+    while (1)
+    {
+        SchedulerPass(handler);
+    }
+} // RunScheduler
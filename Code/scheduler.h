@@ -0,0 +1,120 @@
+/*! \file scheduler.h
+ *
+ * A small cooperative, run-to-completion scheduler.
+ *
+ * Nothing in the program waits any more. Instead:
+ * 	- Background tasks (keypad scanning, flushing the display, flash
+ * 		writing, the serial port, ...) are called over and over. Each
+ * 		does a small piece of work, if there is any, and returns.
+ * 	- When a task (or a timer) has something to report, it posts an
+ * 		event. Events are queued and passed, one at a time and in order,
+ * 		to the program's event handler, which deals with each completely
+ * 		(runs it to completion) and returns.
+ * 	- Anything which used to be a wait (e.g. showing a message for two
+ * 		seconds) becomes a timer: the handler starts it and returns, and
+ * 		gets an EVENT_TIMER when it expires.
+ *
+ * So while one part of the program is "waiting", keys are still scanned,
+ * serial data still flows and flash is still written.
+ *
+ * Tasks and handlers must never wait for long; a few hundred
+ * microseconds is the most any of them should take.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+//! \name Event types
+//@{
+#define EVENT_KEY 1       //!< A key was pressed. \a data is the character marked on it.
+#define EVENT_TIMER 2     //!< A timer expired. \a data is the timer number.
+#define EVENT_LCD_FLUSH 3 //!< The LCD now shows everything drawn so far.
+#define EVENT_UART_LINE 4 //!< A line received over the serial port has been dealt with.
+#define EVENT_POWER_DOWN 5 //!< Idle long enough to power down: save the session (see power_down.h).
+#define EVENT_POWER_WAKE 6 //!< Woken from power-down by a key, which follows as an EVENT_KEY.
+//@}
+
+//! \name Timer numbers
+//@{
+#define TIMER_SCREEN 0    //!< Timed screens: animation, messages, hints
+#define TIMER_OVERLAY 1   //!< Expiry of the overlay (see mid_level_funcs.h)
+#define TIMER_COUNT 4     //!< Number of timers
+//@}
+
+/*! Maximum number of background tasks. */
+#define MAX_TASKS 12
+
+/*! Number of events which can be waiting at once. */
+#define EVENT_QUEUE_SIZE 16
+
+/*! One event. */
+typedef struct
+{
+    unsigned char type; // One of the EVENT_ constants
+    unsigned char data; // Depends on the type (see above)
+} Event;
+
+/*! Empty the event queue, stop all timers and remove all tasks.
+ */
+void InitScheduler( void );
+
+/*! Add a function to be called repeatedly by RunScheduler().
+ *
+ * \param [in] task The function. It must do only a little work per call.
+ * \return 1 if added, 0 if there were already \a MAX_TASKS.
+ */
+int AddBackgroundTask( void (*task)(void) );
+
+/*! Queue an event for the handler.
+ *
+ * \param [in] type One of the EVENT_ constants.
+ * \param [in] data Depends on the type.
+ * \return 1 if queued, 0 if the queue was full (the event is lost and
+ * 		counted; see GetLostEventCount()).
+ *
+ * Only call this from tasks and handlers, not from interrupt handlers.
+ */
+int PostEvent( unsigned char type, unsigned char data );
+
+/*! Start (or restart) a timer. An EVENT_TIMER for it will be posted
+ * after \a delay_ms milliseconds, or as soon after as there is room for it
+ * in the queue: a timer's event is never lost.
+ *
+ * \param [in] timer One of the TIMER_ constants.
+ * \param [in] delay_ms Time until it expires.
+ */
+void StartTimer( unsigned char timer, unsigned long delay_ms );
+
+/*! Stop a timer without its event being posted.
+ */
+void StopTimer( unsigned char timer );
+
+/*! \return 1 if the timer has been started and its event has not yet
+ * 		been posted, nor the timer stopped, else 0.
+ */
+int TimerRunning( unsigned char timer );
+
+/*! \return Number of times an event was refused because the queue was
+ * 		full. A timer's event is tried again on each pass, and counted
+ * 		each time it does not fit.
+ */
+unsigned long GetLostEventCount( void );
+
+/*! Run the program: call the tasks, post timer events and pass every
+ * event to \a handler, for ever.
+ *
+ * \param [in] handler The program's event handler.
+ */
+void RunScheduler( void (*handler)(const Event *event) );
+
+/*! One pass of RunScheduler()'s loop: post the timers which have expired,
+ * call each task once and pass every waiting event to \a handler. For a
+ * host program (e.g. host/fuzz_calc.c) which runs the calculator a step
+ * at a time.
+ *
+ * \param [in] handler The program's event handler.
+ * \return The number of events passed to it.
+ */
+int SchedulerPass( void (*handler)(const Event *event) );
+
+#endif // of #ifndef SCHEDULER_H
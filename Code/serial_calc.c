@@ -0,0 +1,199 @@
+/* serial_calc.c
+ *
+ * Serial batch-evaluation mode. Calls CalculateAnswer() for each line
+ * received over UART0 and queues the replies for the UART interrupt.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "TExaS.h"
+#include "serial_calc.h"
+#include "calculate_answer.h"
+#include "expression.h"
+#include "result_cache.h"
+#include "mem_guard.h"
+#include "event_trace.h"
+#include "clock_policy.h"
+#include "low_level_funcs_tiva.h"
+#include "UART.h"
+#include <string.h>
+
+#define SERIAL_REPLY_SIZE 80 // Longest reply line, e.g. "CLK fast 4294967.3s 637802648mJ slow 4294967.3s 212600882mJ sw 4294967295\r\n"
+
+static char line[GUARDED_SIZE(SERIAL_LINE_SIZE)];   // Expression being received
+static int line_length;                             // Characters in line so far
+static int line_too_long;                           // 1 once the line has overflowed (rest of it is discarded)
+static char reply[GUARDED_SIZE(SERIAL_REPLY_SIZE)]; // Reply waiting for room in the transmit ring
+static int reply_pending;                           // 1 while reply[] has not been queued
+
+static SerialCalcStats stats;       // Counters for the current batch
+static int batch_started;           // 1 once the first line of the batch has started
+static unsigned long last_microsec;  // GetTickMicrosec() when elapsed time was last brought up to date
+static unsigned long spare_microsec; // Microseconds not yet counted in stats.elapsed_ms
+
+static void UpdateElapsed(void)
+{
+    // Convert microsecond differences to milliseconds as we go, so that
+    // batches longer than the count's 71 minute wrap are still timed correctly.
+    // (Not the cycle counter, whose rate changes with the clock.)
+    unsigned long now = GetTickMicrosec();
+
+    spare_microsec += now - last_microsec; // Unsigned difference is right across a wrap
+    last_microsec = now;
+    stats.elapsed_ms += spare_microsec / 1000;
+    spare_microsec %= 1000;
+}
+
+static void ResetBatch(void)
+{
+    stats.expressions = 0;
+    stats.errors = 0;
+    stats.rejected = 0;
+    stats.elapsed_ms = 0;
+    batch_started = 0;
+}
+
+static void FinishLine(void)
+{
+    double answer;
+    int error_ref_no = 0;
+    CalcResult result;
+    ResultCacheStats cache_stats;
+
+    line[line_length] = '\0'; // Make it a C-format string
+
+    if (line_too_long)
+    {
+        strcpy(reply, "ERR LONG\r\n");
+        stats.rejected++;
+    }
+    else if (line_length == 1 && line[0] == '?') // Report and start a new batch
+    {
+        ResultCacheGetStats(&cache_stats);
+        sprintf(reply, "#%lu %lu/s %lu/%lu\r\n", stats.expressions, SerialCalcRate(),
+                cache_stats.hits, cache_stats.hits + cache_stats.misses);
+        ResetBatch();
+    }
+    else if (line_length == 2 && line[0] == '?' && line[1] == 'M') // Memory report
+    {
+        MemGuardReport(reply, SERIAL_REPLY_SIZE - 2);
+        strcat(reply, "\r\n");
+    }
+    else if (line_length == 2 && line[0] == '?' && line[1] == 'C') // Clock report
+    {
+        ClockPolicyReport(reply, SERIAL_REPLY_SIZE - 2);
+        strcat(reply, "\r\n");
+    }
+    else if (line_length == 2 && line[0] == '?' && line[1] == 'T') // Event trace
+    {
+        TraceDump(); // Sent by TraceTask(); that is the reply
+        reply[0] = '\0';
+    }
+    else
+    {
+        if (ExprUsesAns(line)) // There is no answer to continue from here, so as typed
+        {
+            answer = CalculateAnswer(line, SERIAL_LINE_SIZE, &error_ref_no);
+        }
+        else // The same engine and cache as the keypad
+        {
+            ResultCacheCalculate(line, SERIAL_LINE_SIZE, NUMBER_MODE_DECIMAL, 0.0, &result);
+            answer = result.value;
+            error_ref_no = result.error_ref_no;
+        }
+        if (error_ref_no == 0)
+        {
+            ExprFormat(answer, reply, SERIAL_REPLY_SIZE - 2); // The same format as DisplayResult()
+            strcat(reply, "\r\n");
+        }
+        else
+        {
+            sprintf(reply, "ERR %d\r\n", error_ref_no);
+            stats.errors++;
+        }
+        stats.expressions++;
+    }
+    reply_pending = 1;
+    line_length = 0;
+    line_too_long = 0;
+}
+
+void SerialCalcInit(void)
+{
+    line_length = 0;
+    line_too_long = 0;
+    reply_pending = 0;
+    ResetBatch();
+    MemGuardRegister(line, SERIAL_LINE_SIZE, "serial line");
+    MemGuardRegister(reply, SERIAL_REPLY_SIZE, "serial reply");
+} // SerialCalcInit
+
+int SerialCalcPoll(void)
+{
+    unsigned char ch;
+
+    // 1) Pass the previous reply to the transmit interrupt. Until there is room
+    //    for it we read nothing more, so replies stay in input order.
+    if (reply_pending)
+    {
+        if (!UART_WriteString(reply))
+        {
+            return 0; // Transmit ring still full: the interrupt is busy sending
+        }
+        reply_pending = 0;
+        if (batch_started) // (Not after a ? reply, which starts a new batch)
+        {
+            UpdateElapsed(); // The batch has lasted until this reply
+        }
+        return 1;
+    }
+
+    // 2) Assemble the next line from whatever has been received.
+    //    This overlaps with the interrupt sending the previous reply.
+    if (!UART_GetChar(&ch))
+    {
+        return 0;
+    }
+    if (!batch_started) // Time the batch from the first byte of its first line
+    {
+        batch_started = 1;
+        last_microsec = GetTickMicrosec();
+        spare_microsec = 0;
+    }
+
+    // Consume the rest of the line (or all that has arrived so far)
+    do
+    {
+        if (ch == LF || ch == CR)
+        {
+            if (line_length > 0 || line_too_long) // Ignore blank lines and the LF of CR LF
+            {
+                FinishLine(); // 3) Evaluate it and build the reply
+                return 1;
+            }
+        }
+        else if (line_length < SERIAL_LINE_SIZE - 1) // Leave room for the trailing null
+        {
+            line[line_length++] = (ch == '*') ? 'x' : ch; // Accept the usual computer multiply sign too
+        }
+        else
+        {
+            line_too_long = 1;
+        }
+    } while (UART_GetChar(&ch));
+    return 1;
+} // SerialCalcPoll
+
+void SerialCalcGetStats(SerialCalcStats *stats_out)
+{
+    *stats_out = stats;
+} // SerialCalcGetStats
+
+unsigned long SerialCalcRate(void)
+{
+    if (stats.elapsed_ms == 0)
+    {
+        return 0;
+    }
+    return (unsigned long)((stats.expressions * 1000ULL) / stats.elapsed_ms); // 64 bits: 32 overflow after 4.29M expressions
+} // SerialCalcRate
@@ -0,0 +1,78 @@
+/*! \file serial_calc.h
+ *
+ * Serial batch-evaluation mode: the calculator as a calculation server.
+ *
+ * Expressions arrive over UART0 as lines of text, one per line, written
+ * with the characters the keypad puts in the input buffer (digits,
+ * + - x / . E). Each is evaluated by CalculateAnswer(), exactly as if it
+ * had been typed, and one reply line goes back per expression, in the
+ * same order:
+ * 	- the result, in the same %G format as DisplayResult(), or
+ * 	- ERR followed by the error number from CalculateAnswer(), or
+ * 	- ERR LONG if the line would not fit in the input buffer.
+ *
+ * A line containing just ? is not evaluated; the reply is the number of
+ * expressions and the throughput (expressions per second) since the
+ * previous ? (or since entering the mode), and the counts start again.
+ * It ends with the result cache's hits and lookups (since power-on), as
+ * hits/lookups; the results of lines sent before are taken from the
+ * cache (see result_cache.h) rather than evaluated again.
+ *
+ * A line containing just ?M is not evaluated either; the reply is the
+ * memory report of MemGuardReport() (see mem_guard.h). The reply to ?C
+ * is the time and estimated energy at each clock speed (see
+ * clock_policy.h), and to ?T a dump of the event trace (see
+ * event_trace.h).
+ *
+ * The work is pipelined: replies are queued in the UART transmit ring and
+ * sent by its interrupt while the next line is being received and
+ * evaluated, so the line is kept busy in both directions.
+ *
+ * These functions do not wait for anything. SerialCalcPoll() must be
+ * called repeatedly by whatever loop is running.
+ */
+
+#ifndef SERIAL_CALC_H
+#define SERIAL_CALC_H
+
+/*! Longest expression accepted, including the trailing null.
+ * The same as the keypad input buffer, so anything which can be sent
+ * can also be typed.
+ */
+#define SERIAL_LINE_SIZE 17
+
+/*! Counters for the current batch (since the last ? line). */
+typedef struct
+{
+    unsigned long expressions; // Lines evaluated (including those giving an error)
+    unsigned long errors;      // Lines for which CalculateAnswer() reported an error
+    unsigned long rejected;    // Lines too long to evaluate
+    unsigned long elapsed_ms;  // From the start of the first line to the latest reply
+} SerialCalcStats;
+
+/*! Start serial mode: discard any partial line and zero the counters.
+ * UART_Init() must already have been called.
+ */
+void SerialCalcInit( void );
+
+/*! Do the next piece of serial-mode work, without waiting.
+ *
+ * \return 1 if anything was done (bytes read, a line evaluated or a
+ * 		reply queued), 0 if there was nothing to do. A caller can use
+ * 		0 as a cue to do its own slow work, e.g. update the LCD.
+ *
+ * At most one expression is evaluated per call. If the transmit ring
+ * has no room for a reply, the reply is held and no more input is read
+ * until it has been queued, so replies can never get out of order.
+ */
+int SerialCalcPoll( void );
+
+/*! Copy the counters for the current batch.
+ */
+void SerialCalcGetStats( SerialCalcStats *stats );
+
+/*! Throughput of the current batch, in expressions per second.
+ */
+unsigned long SerialCalcRate( void );
+
+#endif // of #ifndef SERIAL_CALC_H
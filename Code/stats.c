@@ -0,0 +1,375 @@
+/* stats.c
+ *
+ * Statistics mode: streaming accumulators (Welford, Kahan) for a series
+ * of points, kept in flash.
+ *
+ * For documentation, see the corresponding .h file.
+ */
+
+#include "TExaS.h"
+#include "stats.h"
+#include "high_level_funcs.h"
+#include "mid_level_funcs.h"
+#include "low_level_funcs_tiva.h"
+#include "expression.h"
+#include "mem_guard.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ENTRY_SIZE STATS_ENTRY_SIZE // Point being typed, including the trailing null
+
+// Everything kept about the points. Written to flash as it is, so a
+// change to it must change its size (ReadStatsFromFlash() then finds none).
+typedef struct
+{
+    double mean;        // Welford over x: the mean so far
+    double m2;          // and the sum of squares of differences from it
+    double min;         // Least x
+    double max;         // Greatest x
+    double sum;         // Kahan: the sum of x
+    double sum_error;   // and what rounding has lost from it, to be taken off the next addition
+    double pair_mean_x; // Welford over the pairs: the means of x and y,
+    double pair_mean_y;
+    double pair_m2_x;   // the sums of squares of their differences from them,
+    double pair_m2_y;
+    double pair_c;      // and the sum of products of the differences of x and y
+    unsigned long count; // Points
+    unsigned long pairs; // Points with a y
+} Accumulators;
+
+// What each shifted digit shows, and its label on line 2 (none for 6, which leaves)
+static const char *const labels[10] = {"c=", "n=", "Av=", "Sd=", "Lo=", "Hi=", 0, "Sx=", "m=", "r="};
+
+static Accumulators acc;
+static char entry[GUARDED_SIZE(ENTRY_SIZE)]; // Point being typed
+static int entry_length;                     // Characters in entry
+static int shifted;                          // 1 when the Shift key (D) has just been pressed
+static char shown;                           // Key of the result on line 2, or 0
+
+static int InRange(double value)
+{
+    return value == value && value <= DBL_MAX && value >= -DBL_MAX; // Not NaN or infinite
+} // InRange
+
+// Work out the result for a shifted digit. Returns 0, or why there is
+// none (for line 2 of an error message).
+static const char *Result(char key, double *value)
+{
+    double slope = 0.0;
+
+    switch (key)
+    {
+    case '1':
+        *value = acc.count;
+        return 0;
+    case '7':
+        *value = acc.sum;
+        return 0;
+    case '2':
+    case '4':
+    case '5':
+        if (acc.count < 1)
+        {
+            return "Need a point    ";
+        }
+        *value = (key == '2') ? acc.mean : (key == '4') ? acc.min : acc.max;
+        return 0;
+    case '3':
+        if (acc.count < 2)
+        {
+            return "Need 2 points   ";
+        }
+        *value = sqrt(acc.m2 / (acc.count - 1));
+        break;
+    case '8':
+    case '9':
+    case '0':
+        if (acc.pairs < 2)
+        {
+            return "Need 2 x,y pairs";
+        }
+        if (acc.pair_m2_x <= 0.0 || (key == '9' && acc.pair_m2_y <= 0.0))
+        {
+            return (key == '9') ? "x or y all same " : "x all the same  ";
+        }
+        slope = acc.pair_c / acc.pair_m2_x;
+        *value = (key == '8') ? slope
+                 : (key == '0') ? acc.pair_mean_y - slope * acc.pair_mean_x
+                                : acc.pair_c / sqrt(acc.pair_m2_x * acc.pair_m2_y);
+        break;
+    default:
+        return "No such result  ";
+    }
+    return InRange(*value) ? 0 : expr_error_line1[EXPR_ERR_RANGE];
+} // Result
+
+static void ShowStats(void)
+{
+    char line[32]; // Room for two counts of up to 10 digits, cut to the display's width
+    char text[EXPR_RESULT_SIZE];
+    double value;
+
+    ClearScreen();
+    if (shown == 0)
+    {
+        sprintf(line, "x or x,y then *");
+    }
+    else if (Result(shown, &value) == 0)
+    {
+        ExprFormat(value, text, sizeof(text)); // At most 13 characters, after a label of at most 3
+        sprintf(line, "%s%s", labels[shown - '0'], text);
+    }
+    else
+    {
+        sprintf(line, "%s--", labels[shown - '0']);
+    }
+    PrintString(2, 1, line);
+    if (entry_length > 0)
+    {
+        PrintString(1, 1, entry); // Leaves the cursor after it
+        SetCursorOnOff(1);
+    }
+    else
+    {
+        if (acc.pairs > 0)
+        {
+            sprintf(line, "n=%lu xy=%lu", acc.count, acc.pairs);
+        }
+        else
+        {
+            sprintf(line, "n=%lu", acc.count);
+        }
+        line[DISPLAY_WIDTH] = '\0';
+        PrintString(1, 1, line);
+        SetCursorOnOff(0);
+    }
+} // ShowStats
+
+// Add a character to the point being typed, if it makes sense there
+static void AddToEntry(char c)
+{
+    const char *part = strrchr(entry, ','); // The number being typed: y if there is a comma, else x
+    char last = (entry_length > 0) ? entry[entry_length - 1] : ',';
+    int one = (c == 'E' && (last == ',' || last == '-')); // An exponent on its own means 1 times ten to it
+
+    part = (part != NULL) ? part + 1 : entry;
+    if ((c == '.' && (strchr(part, '.') != NULL || strchr(part, 'E') != NULL)) ||
+        (c == 'E' && strchr(part, 'E') != NULL) || (c == '-' && last != ',' && last != 'E') ||
+        (c == ',' && (part != entry || !((last >= '0' && last <= '9') || last == '.'))))
+    {
+        return; // A second point, exponent or comma, or a sign in the middle, makes no sense
+    }
+    if (entry_length + one >= ENTRY_SIZE - 1)
+    {
+        PrintDisplayFull();
+        return;
+    }
+    if (one)
+    {
+        entry[entry_length++] = '1';
+    }
+    entry[entry_length++] = c;
+    entry[entry_length] = '\0';
+} // AddToEntry
+
+// Add the point typed to the accumulators
+static void AddPoint(void)
+{
+    char *end;
+    char *y_end;
+    double x;
+    double y = 0.0;
+    double dx;
+    double dy;
+    double sum;
+    int error = EXPR_OK;
+
+    x = strtod(entry, &end);
+    if (end == entry)
+    {
+        error = EXPR_ERR_SYNTAX; // e.g. "." or ",5"
+    }
+    else if (*end == ',')
+    {
+        y = strtod(end + 1, &y_end);
+        error = (y_end == end + 1 || *y_end != '\0') ? EXPR_ERR_SYNTAX : EXPR_OK;
+    }
+    else if (*end != '\0')
+    {
+        error = EXPR_ERR_SYNTAX;
+    }
+    if (error == EXPR_OK && (!InRange(x) || !InRange(y)))
+    {
+        error = EXPR_ERR_RANGE; // e.g. 1E999
+    }
+    if (error != EXPR_OK)
+    {
+        DisplayErrorMessage(expr_error_line1[error], expr_error_line2[error]); // The point stays, to be put right
+        return;
+    }
+
+    acc.count++;
+    dx = x - acc.mean;
+    acc.mean += dx / acc.count;
+    acc.m2 += dx * (x - acc.mean);
+    if (acc.count == 1 || x < acc.min)
+    {
+        acc.min = x;
+    }
+    if (acc.count == 1 || x > acc.max)
+    {
+        acc.max = x;
+    }
+    dx = x - acc.sum_error; // Kahan: put back what the last addition lost
+    sum = acc.sum + dx;
+    acc.sum_error = (sum - acc.sum) - dx;
+    acc.sum = sum;
+
+    if (*end == ',')
+    {
+        acc.pairs++;
+        dx = x - acc.pair_mean_x;
+        dy = y - acc.pair_mean_y;
+        acc.pair_mean_x += dx / acc.pairs;
+        acc.pair_mean_y += dy / acc.pairs;
+        acc.pair_m2_x += dx * (x - acc.pair_mean_x);
+        acc.pair_m2_y += dy * (y - acc.pair_mean_y);
+        acc.pair_c += dx * (y - acc.pair_mean_y);
+    }
+    WriteStatsToFlash(&acc, sizeof(acc)); // Copied when the write starts
+    entry_length = 0;
+    entry[0] = '\0';
+} // AddPoint
+
+static void ClearPoints(void)
+{
+    memset(&acc, 0, sizeof(acc));
+    WriteStatsToFlash(&acc, sizeof(acc));
+    shown = 0;
+} // ClearPoints
+
+void StatsLoad(void)
+{
+    if (!ReadStatsFromFlash(&acc, sizeof(acc)))
+    {
+        memset(&acc, 0, sizeof(acc)); // None saved yet
+    }
+} // StatsLoad
+
+void StartStatsMode(void)
+{
+    MemGuardRegister(entry, ENTRY_SIZE, "stats entry");
+    entry_length = 0;
+    entry[0] = '\0';
+    shifted = 0;
+    shown = 0;
+    ShowStats();
+} // StartStatsMode
+
+int StatsEvent(const Event *event)
+{
+    const char *reason;
+    double value;
+    char key;
+
+    if (event->type != EVENT_KEY)
+    {
+        return 0;
+    }
+    key = event->data;
+
+    if (shifted)
+    {
+        shifted = 0; // Shift only applies to one key
+        switch (key)
+        {
+        case 'C':
+            AddToEntry('E');
+            break;
+        case '#': // Clear all the points
+            ClearPoints();
+            break;
+        case '6': // Leave statistics mode
+            SetCursorOnOff(0);
+            return 1;
+        case 'A':
+        case 'B':
+        case '*':
+        case 'D': // Shift again cancels it
+            break;
+        default: // A result
+            reason = Result(key, &value);
+            if (reason != 0)
+            {
+                DisplayErrorMessage("Not enough data ", reason);
+            }
+            else
+            {
+                shown = key;
+            }
+        }
+    }
+    else
+    {
+        switch (key)
+        {
+        case 'D':
+            PrintString(1, 1, "2Av 3Sd 4Lo 5Hi^"); // Shift functions, until the next key
+            PrintString(2, 1, "6= 7Sx 8m 9r 0c ");
+            shifted = 1;
+            return 0;
+        case 'A':
+            AddToEntry(',');
+            break;
+        case 'B':
+            AddToEntry('-');
+            break;
+        case 'C':
+            AddToEntry('.');
+            break;
+        case '*':
+            if (entry_length > 0)
+            {
+                AddPoint();
+            }
+            break;
+        case '#': // Rubout
+            if (entry_length > 0)
+            {
+                entry[--entry_length] = '\0';
+            }
+            break;
+        default: // Digits
+            AddToEntry(key);
+        }
+    }
+    ShowStats();
+    return 0;
+} // StatsEvent
+
+int StatsGetResult(double *value)
+{
+    return shown != 0 && Result(shown, value) == 0;
+} // StatsGetResult
+
+void StatsSaveState(StatsSession *saved)
+{
+    memcpy(saved->entry, entry, ENTRY_SIZE);
+    saved->entry_length = entry_length;
+    saved->shifted = shifted;
+    saved->shown = shown;
+} // StatsSaveState
+
+void StatsResume(const StatsSession *saved)
+{
+    StartStatsMode();
+    entry_length = (saved->entry_length < ENTRY_SIZE) ? saved->entry_length : 0;
+    memcpy(entry, saved->entry, entry_length);
+    entry[entry_length] = '\0';
+    shifted = saved->shifted;
+    shown = (saved->shown >= '0' && saved->shown <= '9' && saved->shown != '6') ? saved->shown : 0;
+    ShowStats();
+} // StatsResume
@@ -0,0 +1,97 @@
+/*! \file stats.h
+ *
+ * Statistics mode: a series of measurements is typed in, one at a time,
+ * and their mean, standard deviation, least and greatest, total, and
+ * the straight line through x,y pairs are there at any point. Shift then
+ * 6 in decimal mode switches between this and ordinary entry.
+ *
+ * Each point is a number x, or a pair x,y (A types the comma); * adds
+ * it. Nothing is kept of the points themselves, only accumulators which
+ * are updated as each is added, so memory stays the same however many
+ * are entered:
+ * 	- Welford's method for the mean and variance of x: the running
+ * 		mean, and the sum of squares of differences from it, so a
+ * 		long series of large, close values (e.g. 10000.1, 10000.3,
+ * 		...) keeps its accuracy, where the sum of squares would
+ * 		lose it all to cancellation.
+ * 	- A Kahan-compensated sum of x, which carries what each addition
+ * 		loses to rounding into the next.
+ * 	- The same updates over the pairs for the regression: the means of
+ * 		x and y, their sums of squares of differences, and the sum of
+ * 		products of differences.
+ * The accumulators are written to flash after each point (see
+ * WriteStatsToFlash()), so they survive the power being turned off.
+ *
+ * Line 1 shows the number being typed, or how many points (and pairs)
+ * there are; line 2 shows the result last asked for, brought up to date
+ * as points are added.
+ *
+ * 	| Key	| Unshifted	| Shifted |
+ * 	| :--:	| :--:		| :--:		|
+ * 	| A	| , (between x and y)	| 	|
+ * 	| B	| - (sign)	| 		|
+ * 	| C	| .		| E		|
+ * 	| *	| Add the point	| 		|
+ * 	| #	| Rubout	| Clear all the points	|
+ * 	| 1	| 1		| n, the number of points	|
+ * 	| 2	| 2		| Mean of x	|
+ * 	| 3	| 3		| Standard deviation of x (of a sample: n-1)	|
+ * 	| 4	| 4		| Least x	|
+ * 	| 5	| 5		| Greatest x	|
+ * 	| 6	| 6		| Leave statistics mode	|
+ * 	| 7	| 7		| Sum of x	|
+ * 	| 8	| 8		| Slope m of the line y = mx + c through the pairs	|
+ * 	| 9	| 9		| Correlation coefficient r of the pairs	|
+ * 	| 0	| 0		| Intercept c of the line	|
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "scheduler.h"
+#include "low_level_funcs_tiva.h" // For DISPLAY_WIDTH
+
+/*! Size of the point being typed, including the trailing null. */
+#define STATS_ENTRY_SIZE (DISPLAY_WIDTH + 1)
+
+/*! Read the accumulators from flash. Call once at start-up.
+ */
+void StatsLoad( void );
+
+/*! Start statistics mode, carrying on with the points entered before.
+ */
+void StartStatsMode( void );
+
+/*! Deal with one event in statistics mode.
+ *
+ * \param [in] event The event.
+ * \return 1 when the user has left statistics mode (Shift then 6), else 0.
+ */
+int StatsEvent( const Event *event );
+
+/*! \param [out] value The result on line 2, if there is one. When
+ * 		statistics mode is left, this becomes the answer.
+ * \return 1 if there is one, else 0.
+ */
+int StatsGetResult( double *value );
+
+/*! The state of statistics mode, for saving a session (see power_down.h).
+ * The accumulators are in flash already. */
+typedef struct
+{
+    char entry[STATS_ENTRY_SIZE]; //!< Point being typed
+    unsigned char entry_length;   //!< Its length
+    unsigned char shifted;        //!< 1 if Shift has just been pressed
+    char shown;                   //!< Key of the result on line 2, or 0
+} StatsSession;
+
+/*! \param [out] saved The state of statistics mode. */
+void StatsSaveState( StatsSession *saved );
+
+/*! As StartStatsMode(), but carry on from a saved state.
+ *
+ * \param [in] saved State saved by StatsSaveState().
+ */
+void StatsResume( const StatsSession *saved );
+
+#endif // of #ifndef STATS_H